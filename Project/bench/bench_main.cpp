@@ -0,0 +1,243 @@
+/**
+ * @file           bench_main.cpp
+ * @brief          ELibのホットパスのベンチマークスイート (env:bench, env:native_bench)
+ * @details        結果はシリアル (ホストでは標準出力) にJSON Linesで出力する。bench/compare.pyで2回分の結果を比較し、bench/size_report.pyでクラスごとのコードサイズを集計する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "Elib.h"
+#include "EJ_Bench.h"
+#ifdef EJ_NATIVE
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+#endif
+
+/* ベンチマークに使うピン (ビルドフラグで変更できる) */
+#ifndef EJ_BENCH_MOTOR_PIN1
+#define EJ_BENCH_MOTOR_PIN1 13
+#endif
+#ifndef EJ_BENCH_MOTOR_PIN2
+#define EJ_BENCH_MOTOR_PIN2 14
+#endif
+#ifndef EJ_BENCH_MOTOR_EN
+#define EJ_BENCH_MOTOR_EN 27
+#endif
+#ifndef EJ_BENCH_PHOTO_PIN
+#define EJ_BENCH_PHOTO_PIN 36
+#endif
+#ifndef EJ_BENCH_SERVO_PIN
+#define EJ_BENCH_SERVO_PIN 19
+#endif
+#ifndef EJ_BENCH_RMT_SERVO_PIN
+#define EJ_BENCH_RMT_SERVO_PIN 26
+#endif
+#ifndef EJ_BENCH_SDA
+#define EJ_BENCH_SDA 32
+#endif
+#ifndef EJ_BENCH_SCL
+#define EJ_BENCH_SCL 33
+#endif
+
+/*
+ * EJ_BENCH_LOOPBACK_PINを定義し、そのピンをEJ_BENCH_RMT_SERVO_PIN (RMTが使えない場合はEJ_BENCH_SERVO_PIN) に配線すると、
+ * サーボのパルスの周期の誤差 (ジッタ) を立ち上がりエッジの割り込みで計測する。値には割り込みの応答時間のばらつきも含まれる
+ */
+
+/* CRTP化する前の仮想関数によるインタフェースを再現し、呼び出しのコストを比較する */
+class VirtualActuator
+{
+public:
+    virtual ~VirtualActuator() {}
+    virtual void setOutput(int32_t value) = 0;
+};
+
+class VirtualDCMotor : public VirtualActuator
+{
+public:
+    explicit VirtualDCMotor(EJ_DCMotor *motor) : _motor(motor) {}
+    virtual void setOutput(int32_t value) { _motor->setPWM((int16_t)constrain(value, -100, 100)); }
+
+private:
+    EJ_DCMotor *_motor;
+};
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(EJ_BENCH_LOOPBACK_PIN)
+static volatile uint32_t edges[EJ_BENCH_MAX_SAMPLES + 1];
+static volatile uint16_t edgeCount = 0;
+
+static void IRAM_ATTR onEdge()
+{
+    if (edgeCount <= EJ_BENCH_MAX_SAMPLES) {
+        edges[edgeCount++] = ESP.getCycleCount();
+    }
+}
+
+/* 出力中のサーボのパルス幅を書き換え続けながら、パルスの周期とEJ_SERVO_RMT_PERIODの差を計測する */
+static void benchServoJitter(const char *name, EJ_ServoMotor *servo)
+{
+    static uint32_t errors[EJ_BENCH_MAX_SAMPLES];
+    uint32_t nominal = (uint32_t)EJ_SERVO_RMT_PERIOD * getCpuFrequencyMhz();
+    edgeCount = 0;
+    attachInterrupt(EJ_BENCH_LOOPBACK_PIN, onEdge, RISING);
+    int angle = 0;
+    while (edgeCount <= EJ_BENCH_MAX_SAMPLES) {
+        servo->write(angle);
+        angle = (angle + 1) % 180;
+    }
+    detachInterrupt(EJ_BENCH_LOOPBACK_PIN);
+    for (uint16_t i = 0; i < EJ_BENCH_MAX_SAMPLES; i++) {
+        uint32_t period = edges[i + 1] - edges[i];
+        errors[i] = period > nominal ? period - nominal : nominal - period;
+    }
+    EJ_Bench::record(name, errors, EJ_BENCH_MAX_SAMPLES);
+}
+#endif
+
+static void benchManagers()
+{
+    EJ_Bench::run("manager.getMotor", [] { EJ_Bench::keep(EJ_DCMotor_Manager::getMotor(0)); }, 256, 16);
+    /* 存在しないidの取得はエラーの記録を含む */
+    EJ_Bench::run("manager.getMotor.invalid", [] { EJ_Bench::keep(EJ_DCMotor_Manager::getMotor(EJ_DCMOTOR_MAX_INSTANCES)); }, 256, 16);
+    EJ_Bench::run("manager.at", [] { EJ_Bench::keep(&EJ_DCMotor_Manager::at(0)); }, 256, 16);
+    EJ_Bench::run("manager.getServo", [] { EJ_Bench::keep(EJ_ServoMotor_Manager::getServo(0)); }, 256, 16);
+    EJ_Bench::run("manager.getPhotoInterrupter", [] { EJ_Bench::keep(EJ_PhotoInterrupter_Manager::getPhotoInterrupter(0)); }, 256, 16);
+    EJ_Bench::run("manager.getToFUnit", [] { EJ_Bench::keep(EJ_ToFUnit_Manager::getToFUnit(0)); }, 256, 16);
+}
+
+static void benchMotor()
+{
+    static EJ_DCMotor *motor = EJ_DCMotor_Manager::createMotor(EJ_BENCH_MOTOR_PIN1, EJ_BENCH_MOTOR_PIN2, EJ_BENCH_MOTOR_EN, 0);
+    if (motor == NULL) {
+        EJ_Bench::skip("dcmotor.setPWM", "create failed");
+        return;
+    }
+    static int16_t duty = 0;
+    /* 正転と逆転を交互に指令し、方向ピンの書き込みも含める */
+    EJ_Bench::run("dcmotor.setPWM", [] { duty = duty > 0 ? -30 : 30; motor->setPWM(duty); });
+    EJ_Bench::run("dcmotor.setPWM.same", [] { motor->setPWM(30); });
+
+    static VirtualDCMotor wrapped(motor);
+    static VirtualActuator *volatile actuator = &wrapped;
+    EJ_Bench::run("dcmotor.setOutput.virtual", [] { actuator->setOutput(30); });
+    EJ_Bench::run("dcmotor.setOutput.crtp", [] { motor->setOutput(30); });
+    motor->stop();
+}
+
+static void benchPhotoInterrupter()
+{
+    static EJ_PhotoInterrupter *photo = EJ_PhotoInterrupter_Manager::createPhotoInterrupter(EJ_BENCH_PHOTO_PIN, 0);
+    if (photo == NULL) {
+        EJ_Bench::skip("photo.isInterrupted", "create failed");
+        return;
+    }
+    EJ_Bench::run("photo.isInterrupted", [] { EJ_Bench::keep(photo->isInterrupted()); });
+    EJ_Bench::run("photo.getState", [] { EJ_Bench::keep(photo->getState()); });
+}
+
+static void benchServo()
+{
+    static EJ_ServoMotor *servo = EJ_ServoMotor_Manager::createServo(EJ_BENCH_SERVO_PIN, 0);
+    if (servo == NULL) {
+        EJ_Bench::skip("servo.write", "create failed");
+        return;
+    }
+    static int angle = 0;
+    EJ_Bench::run("servo.write", [] { angle = (angle + 7) % 180; servo->write(angle); });
+    EJ_Bench::run("servo.writeMicroseconds", [] { servo->writeMicroseconds(1500); });
+
+    EJ_ServoMotor *rmt = EJ_ServoMotor_Manager::createRMTServo(EJ_BENCH_RMT_SERVO_PIN, 1);
+    if (rmt == NULL) {
+        EJ_Bench::skip("servo_rmt.write", "RMT not available");
+    } else {
+        static EJ_ServoMotor *rmtServo = rmt;
+        EJ_Bench::run("servo_rmt.write", [] { angle = (angle + 7) % 180; rmtServo->write(angle); });
+    }
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(EJ_BENCH_LOOPBACK_PIN)
+    if (rmt != NULL) {
+        benchServoJitter("servo_rmt.period_error", rmt);
+    } else {
+        benchServoJitter("servo_ledc.period_error", servo);
+    }
+#else
+    EJ_Bench::skip("servo.period_error", "EJ_BENCH_LOOPBACK_PIN not defined");
+#endif
+}
+
+static void benchToFUnit()
+{
+#ifdef EJ_NATIVE
+    static EJ_SimVL53L0X model;
+    model.setRange(300);
+    model.setNoise(2.0f);
+    Wire.begin();
+#else
+    Wire.begin(EJ_BENCH_SDA, EJ_BENCH_SCL);
+#endif
+    static EJ_ToFUnit *tof = EJ_ToFUnit_Manager::createToFUnit(0);
+    if (tof == NULL) {
+        EJ_Bench::skip("tof.read", "sensor not found");
+        return;
+    }
+    /* 測距の完了待ちを含む1回の読み出し */
+    EJ_Bench::run("tof.read", [] { EJ_Bench::keep(tof->read()); }, 32);
+    /* 測距中に制御ループから呼ぶ非ブロッキングの確認 */
+    EJ_Bench::run("tof.poll", [] { EJ_Bench::keep(tof->poll()); });
+}
+
+static void benchMapping()
+{
+    static EJ_Odometry odometry(10.0f, 120.0f);
+    static long count = 0;
+    EJ_Bench::run("odometry.update", [] { count += 3; EJ_Bench::keep(odometry.update(count, count + 1)); });
+
+    static EJ_OccupancyGrid grid(7, 7, 50);
+    if (grid.getMemorySize() == 0) {
+        EJ_Bench::skip("occupancy.integrateRange", "allocation failed");
+        return;
+    }
+    static Pose2D pose = {0.0f, 0.0f, 0.0f};
+    static const Pose2D mount = {50.0f, 0.0f, 0.0f};
+    EJ_Bench::run("occupancy.integrateRange", [] {
+        pose.theta += 0.05f;
+        grid.integrateRange(pose, mount, 1200);
+    }, 128);
+}
+
+static void reportSizes()
+{
+    EJ_Bench::size("EJ_DCMotor", sizeof(EJ_DCMotor));
+    EJ_Bench::size("EJ_EncoderMotor", sizeof(EJ_EncoderMotor));
+    EJ_Bench::size("EJ_ServoMotor", sizeof(EJ_ServoMotor));
+    EJ_Bench::size("EJ_PhotoInterrupter", sizeof(EJ_PhotoInterrupter));
+    EJ_Bench::size("EJ_ToFUnit", sizeof(EJ_ToFUnit));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+#ifdef EJ_NATIVE
+    /* 測距の待ち時間とI2Cの転送時間を仮想時間で進める */
+    EJ_Sim::begin(1000);
+#endif
+    EJ_Bench::begin(Serial, "elib");
+    benchMotor();
+    benchPhotoInterrupter();
+    benchServo();
+    benchToFUnit();
+    benchManagers();
+    benchMapping();
+    reportSizes();
+    EJ_Bench::end();
+#ifdef EJ_NATIVE
+    EJ_HAL::stop(0);
+#endif
+}
+
+void loop()
+{
+    delay(1000);
+}
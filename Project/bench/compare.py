@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""EJ_Benchの結果 (JSON Lines) を2つ比較し、中央値が閾値を超えて悪化したベンチマークを報告する
+
+usage: compare.py BASE.jsonl NEW.jsonl [--threshold 10] [--min-delta 2] [--metric p50]
+変化率がthresholdを超え、かつ差がmin-deltaを超えて悪化したベンチマークがあれば終了コード1を返す
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue  # シリアルに混ざったログは読み飛ばす
+            try:
+                entry = json.loads(line)
+            except ValueError:
+                continue
+            if "bench" in entry and "skipped" not in entry:
+                results[entry["bench"]] = entry
+            elif "size" in entry:
+                results["size:" + entry["size"]] = {"p50": entry["bytes"], "unit": "bytes"}
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0, help="悪化とみなす変化率 [%%]")
+    parser.add_argument("--min-delta", type=float, default=2.0, help="悪化とみなす最小の差 (数サイクルの計測誤差を除く)")
+    parser.add_argument("--metric", default="p50", choices=["min", "p50", "p90", "p99", "max", "mean"])
+    args = parser.parse_args()
+
+    base = load(args.base)
+    new = load(args.new)
+    regressions = 0
+    print("%-32s %12s %12s %9s" % ("bench", "base", "new", "change"))
+    for name in sorted(set(base) | set(new)):
+        if name not in base or name not in new:
+            print("%-32s %12s %12s %9s" % (name, base.get(name, {}).get(args.metric, "-"),
+                                           new.get(name, {}).get(args.metric, "-"), "n/a"))
+            continue
+        metric = args.metric if not name.startswith("size:") else "p50"
+        before = float(base[name][metric])
+        after = float(new[name][metric])
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        mark = ""
+        if change > args.threshold and after - before > args.min_delta:
+            mark = "  REGRESSION"
+            regressions += 1
+        print("%-32s %12.1f %12.1f %+8.1f%%%s" % (name, before, after, change, mark))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
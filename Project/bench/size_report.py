@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""ファームウェアのELFのシンボルをクラス (EJ_XXX) ごとに集計し、コードサイズをJSON Linesで出力する
+
+usage: size_report.py .pio/build/bench/firmware.elf [--nm xtensa-esp32-elf-nm]
+EJ_XXX_Managerやテンプレートの実体化 (EJ_Manager<EJ_XXX, N>) はEJ_XXXに含める
+"""
+import argparse
+import json
+import re
+import subprocess
+import sys
+
+# 特定の機能に属さない共通のクラス
+GENERIC = {"EJ_Manager", "EJ_ManagerBase", "EJ_Actuator", "EJ_RangeSensor", "EJ_BinarySensor"}
+SECTIONS = {"t": "text", "w": "text", "r": "rodata", "d": "data", "b": "bss"}
+
+
+def feature(symbol):
+    names = re.findall(r"EJ_[A-Za-z0-9]+", symbol)
+    for name in names:
+        if name not in GENERIC:
+            return name
+    return names[0] if names else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="nm", help="nmコマンド (ESP32: xtensa-esp32-elf-nm)")
+    args = parser.parse_args()
+
+    output = subprocess.run([args.nm, "-C", "-S", "--size-sort", args.elf],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    sizes = {}
+    for line in output.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) < 4:
+            continue
+        size, kind, symbol = int(fields[1], 16), fields[2].lower(), fields[3]
+        section = SECTIONS.get(kind)
+        name = feature(symbol)
+        if section is None or name is None:
+            continue
+        entry = sizes.setdefault(name, {"text": 0, "rodata": 0, "data": 0, "bss": 0})
+        entry[section] += size
+
+    for name in sorted(sizes):
+        entry = {"size": name, "bytes": sizes[name]["text"] + sizes[name]["rodata"] + sizes[name]["data"]}
+        entry.update(sizes[name])
+        print(json.dumps(entry))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
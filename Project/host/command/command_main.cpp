@@ -0,0 +1,41 @@
+/**
+ * @file           command_main.cpp
+ * @brief          EJ_Commandをホストで動かすスケッチ (env:native_command)
+ * @details        デバイスを生成してSerialでコマンドを受信する。tools/command.py --exec .pio/build/native_command/program で擬似端末につないで操作し、tools/test_command.pyで往復を検証する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include "Elib.h"
+
+/* コマンドの宛先になるデバイス (dcmotor 0, encodermotor 0, servo 0, photo 0) */
+constexpr DeviceDef DEVICES[] = {
+    EJ_DeviceTable::dcMotor(0, 13, 14, 27),
+    EJ_DeviceTable::encoderMotor(0, 25, 26, 35, 36, 4),
+    EJ_DeviceTable::servo(0, 19),
+    EJ_DeviceTable::photoInterrupter(0, 34),
+};
+EJ_CHECK_DEVICE_TABLE(DEVICES);
+
+void setup()
+{
+    Serial.begin(921600);
+    if (!EJ_DeviceTable::createAll(DEVICES)) {
+        EJ_ErrorLog::drain(Serial);
+        EJ_HAL::stop(1);
+        return;
+    }
+    /* 実機のmain.cppと同じ周期処理を、タイマの代わりにloop()から駆動する */
+    EJ_Executive::begin(1000);
+    EJ_Executive::addUpdate<EJ_EncoderMotor_Manager>("motor", 1000);
+    EJ_Executive::addUpdate<EJ_ServoMotor_Manager>("servo", 50);
+    EJ_Command::begin(Serial);
+}
+
+void loop()
+{
+    EJ_Command::poll();
+    EJ_Executive::poll();
+    delay(1);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file           telemetry_main.cpp
+ * @brief          EJ_Telemetryをホストで動かすスケッチ (env:native_telemetry)
+ * @details        EJ_SimDCMotorにつないだエンコーダ付きモーターを仮想時刻で1秒間動かし、Duty比と位置を1msごとにSerialへ送信して終了する。tools/telemetry_decode.py --exec .pio/build/native_telemetry/program で復号し、tools/test_telemetry.pyで往復を検証する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include "Elib.h"
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+
+constexpr DeviceDef DEVICES[] = {
+    EJ_DeviceTable::encoderMotor(0, 25, 26, 35, 36, 4),
+};
+EJ_CHECK_DEVICE_TABLE(DEVICES);
+
+/* 小型ギヤードモータ相当の物理パラメータ (6V, 2Ω, 1回転360カウント) */
+static const SimDCMotorDef MOTOR_DEF = {6.0f, 2.0f, 0.05f, 2e-5f, 1e-5f, 0.002f, 0.05f, 360.0f};
+
+/* 送信する時間と、Duty比を0に戻す時刻 (単位: us) */
+static const uint64_t DURATION = 1000000;
+static const uint64_t STEP_END = 500000;
+
+static EJ_EncoderMotor *motor = NULL;
+static int16_t duty = 0;
+
+void setup()
+{
+    Serial.begin(921600);
+    EJ_Sim::begin();
+    if (!EJ_DeviceTable::createAll(DEVICES)) {
+        EJ_HAL::stop(1);
+        return;
+    }
+    motor = EJ_EncoderMotor_Manager::getEncoderMotor(0);
+    static EJ_SimDCMotor plant(25, 26, 4, 35, MOTOR_DEF);
+    EJ_Sim::addPlant(&plant);
+
+    EJ_Telemetry::addChannel("duty", EJ_TELEMETRY_INT16, &duty);
+    EJ_Telemetry::addRead("position", motor);
+    EJ_Telemetry::begin(Serial);
+}
+
+void loop()
+{
+    if (EJ_Sim::now() >= DURATION) {
+        /* 追記中のブロックも送信してから終了する */
+        EJ_Telemetry::end();
+        EJ_HAL::stop();
+        return;
+    }
+    duty = EJ_Sim::now() < STEP_END ? 60 : 0;
+    motor->setPWM(duty);
+    EJ_Telemetry::sample();
+    EJ_Telemetry::update();
+    delay(1);
+}
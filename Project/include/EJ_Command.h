@@ -0,0 +1,173 @@
+/**
+ * @file           EJ_Command.h
+ * @brief          シリアル経由でデバイスを操作するバイナリコマンドを処理するEJ_Commandクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJCOMMAND
+#define EJCOMMAND
+#include <Arduino.h>
+#include "EJ_Framing.h"
+
+/**
+ * @brief 1フレームに含められるコマンドの最大数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_COMMAND_MAX_BATCH
+#define EJ_COMMAND_MAX_BATCH 16
+#endif
+
+/**
+ * @brief フレームの種類 (フレームの先頭1バイト)
+ */
+#define EJ_COMMAND_FRAME_REQUEST 0x43
+#define EJ_COMMAND_FRAME_ACK 0x41
+
+/**
+ * @brief コマンドと応答の状態の大きさ (単位: byte)
+ */
+#define EJ_COMMAND_SIZE 7
+#define EJ_COMMAND_STATE_SIZE 10
+
+/**
+ * @brief 受信・送信バッファの大きさ (単位: byte、COBSで符号化した長さ)
+ */
+#define EJ_COMMAND_REQUEST_SIZE (3 + EJ_COMMAND_MAX_BATCH * EJ_COMMAND_SIZE + 2)
+#define EJ_COMMAND_ACK_SIZE (5 + EJ_COMMAND_MAX_BATCH * EJ_COMMAND_STATE_SIZE + 2)
+
+/**
+ * @enum EJ_CommandTarget
+ * @brief コマンドの宛先のマネージャ
+ */
+typedef enum
+{
+    EJ_COMMAND_DCMOTOR = 0,        /**< EJ_DCMotor_Manager */
+    EJ_COMMAND_SERVO,              /**< EJ_ServoMotor_Manager */
+    EJ_COMMAND_ENCODERMOTOR,       /**< EJ_EncoderMotor_Manager */
+    EJ_COMMAND_PHOTOINTERRUPTER,   /**< EJ_PhotoInterrupter_Manager */
+    EJ_COMMAND_TARGETS
+} EJ_CommandTarget;
+
+/**
+ * @enum EJ_CommandOperation
+ * @brief コマンドの操作と引数 (value)
+ */
+typedef enum
+{
+    EJ_COMMAND_QUERY = 0,          /**< 状態を取得するだけで操作しない (全デバイス) */
+    EJ_COMMAND_STOP,               /**< 停止する (DCMotor, EncoderMotor: stop(), Servo: stopMotion()) */
+    EJ_COMMAND_SET_PWM,            /**< Duty比を設定する (DCMotor, EncoderMotor、value: -100~100、PWM無効のモーターは対象外) */
+    EJ_COMMAND_SET_ANGLE,          /**< 角度を設定する (Servo、value: 0~18000 [0.01deg]) */
+    EJ_COMMAND_SET_TARGET,         /**< 目標位置を設定する (EncoderMotor、value: カウント) */
+    EJ_COMMAND_SET_POSITION,       /**< 現在位置を書き換える (EncoderMotor、value: カウント) */
+    EJ_COMMAND_OPERATIONS
+} EJ_CommandOperation;
+
+/**
+ * @enum EJ_CommandStatus
+ * @brief 応答の結果
+ */
+typedef enum
+{
+    EJ_COMMAND_OK = 0,             /**< 全コマンドを適用した */
+    EJ_COMMAND_MALFORMED,          /**< フレームの長さ、種類、コマンド数が不正 */
+    EJ_COMMAND_INVALID_DEVICE,     /**< 宛先のマネージャまたはidのデバイスがない */
+    EJ_COMMAND_INVALID_OPERATION,  /**< デバイスが対応していない操作 */
+    EJ_COMMAND_INVALID_VALUE       /**< 引数が範囲外 */
+} EJ_CommandStatus;
+
+/**
+ * @brief シリアルで受信したバイナリコマンドをマネージャ経由でデバイスに適用するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details フレームはEJ_Framing (COBS、CRC-16) で区切る。要求と応答の形式 (数値はリトルエンディアン)
+ * - 要求: 'C', 通し番号 (u8), コマンド数 (u8), {宛先 (u8), id (u8), 操作 (u8), 引数 (i32)}..., CRC (u16)
+ * - 応答: 'A', 通し番号 (u8), 結果 (u8), 不正なコマンドの番号 (u8、0xFF: なし), 状態の数 (u8), {宛先 (u8), id (u8), 値1 (i32), 値2 (i32)}..., CRC (u16)
+ * - 状態の値 DCMotor: Duty比, 0 / Servo: 現在角度, 指令角度 [0.01deg] / EncoderMotor: 位置, Duty比 / PhotoInterrupter: 遮光 (1/0), 0
+ * @details 1フレームのコマンドは全て検証してから適用するため、1つでも不正なコマンドがあれば何も適用しない。適用中はEJ_Executive::lock()で周期処理を止めるため、周期処理からは1フレーム分のコマンドが同時に適用されたように見える。poll()は周期処理と同じコアのloop()などから呼ぶ
+ * @details 受信はバイト単位で進め、動的なメモリ確保はしない。CRCが一致しないフレームは応答せずに捨てる (送信側はタイムアウトで再送する)。応答の状態はEJ_SensorLogに記録せずに読む
+ */
+class EJ_Command
+{
+private:
+    /**
+     * @brief EJ_Commandクラスはインスタンス化しない
+     */
+    EJ_Command();
+
+public:
+    /**
+     * @brief 受信を開始する
+     * @param io コマンドを受信し、応答を送信するストリーム (Serialなど)
+     */
+    static void begin(Stream &io);
+
+    /**
+     * @brief 受信済みのバイトを処理し、完了したフレームのコマンドを適用して応答する
+     * @return 適用したフレームの数
+     */
+    static uint8_t poll();
+
+    /**
+     * @brief 1バイトを処理する
+     * @details ストリーム以外から受信する場合に使う。応答はbegin()で指定したストリームに送信する
+     * @return true: フレームを適用した / false: フレームの途中、または適用しなかった
+     */
+    static bool feed(uint8_t c);
+
+    /**
+     * @brief 適用したフレームの数を取得する
+     */
+    static uint32_t getAppliedCount();
+
+    /**
+     * @brief 検証に失敗して適用しなかったフレームの数を取得する
+     */
+    static uint32_t getRejectedCount();
+
+    /**
+     * @brief 破損 (COBS、CRC、長すぎるフレーム) で捨てたフレームの数を取得する
+     */
+    static uint32_t getCorruptedCount();
+
+private:
+    static void process(size_t length);
+    static EJ_CommandStatus validate(uint8_t target, uint8_t id, uint8_t operation, int32_t value);
+    static void apply(uint8_t target, uint8_t id, uint8_t operation, int32_t value);
+    static void getState(uint8_t target, uint8_t id, int32_t &value1, int32_t &value2);
+    static void reply(uint8_t sequence, EJ_CommandStatus status, uint8_t index, const uint8_t *commands, uint8_t count);
+
+private:
+    static const char* _classname;
+    static Stream *_io;
+    static uint8_t _buffer[EJ_COBS_MAX_ENCODED(EJ_COMMAND_REQUEST_SIZE)];
+    static size_t _length;
+    static bool _overflow;
+    static uint8_t _reply[EJ_COBS_MAX_ENCODED(EJ_COMMAND_ACK_SIZE)];
+    static uint32_t _applied;
+    static uint32_t _rejected;
+    static uint32_t _corrupted;
+};
+
+#endif // EJCOMMAND
@@ -30,6 +30,27 @@
 #ifndef EJDCMOTOR
 #define EJDCMOTOR
 #include <Arduino.h>
+#include "EJ_Manager.h"
+#include "EJ_Peripheral.h"
+#include "EJ_Device.h"
+
+/**
+ * @brief EJ_DCMotorの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_DCMOTOR_MAX_INSTANCES
+#define EJ_DCMOTOR_MAX_INSTANCES 4
+#endif
+
+/**
+ * @brief PWMの周波数[Hz]と分解能[bit] (ビルドフラグで変更できる)
+ * @details 全てのモーターが同じ設定のため、2つのモーターで1つのLEDCタイマを共有する
+ */
+#ifndef EJ_DCMOTOR_PWM_FREQUENCY
+#define EJ_DCMOTOR_PWM_FREQUENCY 1000
+#endif
+#ifndef EJ_DCMOTOR_PWM_RESOLUTION
+#define EJ_DCMOTOR_PWM_RESOLUTION 8
+#endif
 
 /**
  * @struct MotorDef
@@ -46,8 +67,10 @@ typedef struct
 /**
  * @brief DCモーターを制御するクラス
  * @details *注意:本クラスのインスタンスはEJ_DCMotor_Managerクラス以外からは生成できない
+ * @details PWMのLEDCチャンネルはEJ_Peripheralから割り当てを受ける
+ * @details EJ_Actuatorとしての出力値はDuty比 (単位: %)
  */
-class EJ_DCMotor
+class EJ_DCMotor : public EJ_Actuator<EJ_DCMotor>
 {
 protected:
     /**
@@ -59,6 +82,18 @@ protected:
     EJ_DCMotor(uint8_t pin1 = 0, uint8_t pin2 = 0, int8_t en = -1);
 
     friend class EJ_DCMotor_Manager;
+    template <typename, size_t> friend class EJ_Manager;
+    friend class EJ_Actuator<EJ_DCMotor>;
+
+    /**
+     * @brief EJ_Actuatorの出力値 (Duty比[%]) を設定する
+     */
+    void writeOutput(int32_t value) { setPWM((int16_t)constrain(value, -100, 100)); }
+
+    /**
+     * @brief EJ_Actuatorの出力値 (Duty比[%]) を取得する
+     */
+    int32_t readOutput() { return _duty; }
 
 private:
     /**
@@ -105,6 +140,18 @@ public:
      */
     int16_t getPWM();
 
+    /**
+     * @brief 割り当てられたLEDCチャンネルを取得する
+     * @return LEDCチャンネル (-1: PWM無効または割り当て失敗)
+     */
+    int8_t getPWMChannel();
+
+    /**
+     * @brief PWM制御が有効か取得する
+     * @return true: 有効 (setPWMで出力を変えられる), false: 無効
+     */
+    bool isPWMEnabled();
+
 protected:
     bool _enablePWM;
 
@@ -112,49 +159,35 @@ private:
     static const char* _classname;
     uint8_t _pin1;
     uint8_t _pin2;
-    uint8_t _en;
+    int8_t _en;
     int8_t _duty;
+    int8_t _channel;
 };
 
 /**
  * @brief EJ_DCMotorクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_DCMotorクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_DCMOTOR_MAX_INSTANCES個まで生成される
  */
-class EJ_DCMotor_Manager
+class EJ_DCMotor_Manager : public EJ_Manager<EJ_DCMotor, EJ_DCMOTOR_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_DCMotor_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_DCMotorの最大インスタンス数の定義
+     * @brief EJ_DCMotor_Managerクラスはインスタンス化しない
      */
-    EJ_DCMotor_Manager(size_t maxInstanceSize);
-
-private:
-    /**
-     * @brief EJ_DCMotor_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_DCMotor_Managerのsingletonを指すポインタ
-     */
-    static EJ_DCMotor_Manager* getInstance();
-
-public:
-    /**
-     * @brief EJ_DCMotor_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_DCMotorクラスのインスタンスをすべて解放する
-     */
-    ~EJ_DCMotor_Manager();
+    EJ_DCMotor_Manager();
 
 public:
     /**
-     * @brief EJ_DCMotor_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_DCMotorの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_DCMOTOR_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_DCMotorの最大インスタンス数
+     * @return true: EJ_DCMOTOR_MAX_INSTANCES以下 / false: EJ_DCMOTOR_MAX_INSTANCESを超える
      */
     static bool configure(size_t maxInstanceSize);
 
     /**
      * @brief EJ_DCMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetMotor関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetMotor関数で取得できるように静的な領域に生成する
      * @param MotorDef 参照
      * @return EJ_DCMotorクラスのインスタンスを指すポインタ
      */
@@ -162,7 +195,7 @@ public:
 
     /**
      * @brief EJ_DCMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetMotor関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetMotor関数で取得できるように静的な領域に生成する
      * @param pin1 モータの接続ピン1
      * @param pin2 モータの接続ピン2
      * @param en PWM設定ピン (負値: PWM無効)
@@ -189,9 +222,10 @@ public:
 
 private:
     static const char* _classname;
-    static EJ_DCMotor_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_DCMotor **_instanceList;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_DCMotor.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_DCMotor, EJ_DCMOTOR_MAX_INSTANCES>::_classname;
+
 #endif // EJDCMOTOR
\ No newline at end of file
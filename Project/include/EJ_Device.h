@@ -0,0 +1,192 @@
+/**
+ * @file           EJ_Device.h
+ * @brief          デバイスの共通インターフェース (アクチュエータ、距離センサ、2値センサ) を静的ポリモーフィズムで定義するクラステンプレートの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJDEVICE
+#define EJDEVICE
+#include <Arduino.h>
+
+/**
+ * @brief 距離センサが測距に失敗したときの距離
+ */
+#define EJ_RANGE_INVALID 65535
+
+/**
+ * @brief アクチュエータの共通インターフェース
+ * @details CRTPで静的に派生クラスの実装を呼び出すため、仮想関数テーブルを経由せずインライン展開される
+ * @details 派生クラスは writeOutput(int32_t) と readOutput() を実装し、本クラスをfriendにする。出力値の単位は派生クラスによる (EJ_DCMotor: Duty比[%], EJ_ServoMotor: 角度[度])
+ * @tparam Derived 派生クラス
+ */
+template <typename Derived>
+class EJ_Actuator
+{
+public:
+    /**
+     * @brief 出力値を設定する
+     * @param value 出力値
+     */
+    void setOutput(int32_t value)
+    {
+        derived().writeOutput(value);
+    }
+
+    /**
+     * @brief 現在の出力値を取得する
+     */
+    int32_t getOutput()
+    {
+        return derived().readOutput();
+    }
+
+protected:
+    EJ_Actuator() {}
+    ~EJ_Actuator() {}
+
+private:
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+};
+
+/**
+ * @brief 距離センサの共通インターフェース
+ * @details 派生クラスは readRange() を実装し、本クラスをfriendにする
+ * @tparam Derived 派生クラス
+ */
+template <typename Derived>
+class EJ_RangeSensor
+{
+public:
+    /**
+     * @brief 距離を取得する
+     * @return 距離 (単位: mm, EJ_RANGE_INVALID: 測距失敗)
+     */
+    uint16_t getRange()
+    {
+        return derived().readRange();
+    }
+
+protected:
+    EJ_RangeSensor() {}
+    ~EJ_RangeSensor() {}
+
+private:
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+};
+
+/**
+ * @brief 2値センサの共通インターフェース
+ * @details 派生クラスは readState() を実装し、本クラスをfriendにする
+ * @tparam Derived 派生クラス
+ */
+template <typename Derived>
+class EJ_BinarySensor
+{
+public:
+    /**
+     * @brief センサの状態を取得する
+     * @return true: 検出 / false: 非検出
+     */
+    bool getState()
+    {
+        return derived().readState();
+    }
+
+protected:
+    EJ_BinarySensor() {}
+    ~EJ_BinarySensor() {}
+
+private:
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+};
+
+/* 種類の異なるデバイスをまとめて扱う関数 (引数の型ごとに展開されるため、呼び出しは全てインライン化できる) */
+
+/**
+ * @brief 複数のアクチュエータに同じ出力値を設定する
+ * @param value 出力値
+ * @param actuator アクチュエータ (EJ_Actuatorの派生クラス、種類は混在してよい)
+ */
+template <typename Derived>
+inline void EJ_setOutputs(int32_t value, EJ_Actuator<Derived> &actuator)
+{
+    actuator.setOutput(value);
+}
+
+template <typename Derived, typename... Rest>
+inline void EJ_setOutputs(int32_t value, EJ_Actuator<Derived> &actuator, Rest &... rest)
+{
+    actuator.setOutput(value);
+    EJ_setOutputs(value, rest...);
+}
+
+/**
+ * @brief 複数の距離センサのうち最も近い距離を取得する
+ * @param sensor 距離センサ (EJ_RangeSensorの派生クラス、種類は混在してよい)
+ * @return 最も近い距離 (単位: mm, EJ_RANGE_INVALID: 全て測距失敗)
+ */
+template <typename Derived>
+inline uint16_t EJ_nearestRange(EJ_RangeSensor<Derived> &sensor)
+{
+    return sensor.getRange();
+}
+
+template <typename Derived, typename... Rest>
+inline uint16_t EJ_nearestRange(EJ_RangeSensor<Derived> &sensor, Rest &... rest)
+{
+    uint16_t range = sensor.getRange();
+    uint16_t others = EJ_nearestRange(rest...);
+    return range < others ? range : others;
+}
+
+/**
+ * @brief 複数の2値センサの状態をビットマスクにまとめる
+ * @details 最初の引数のセンサが最下位ビットになる
+ * @param sensor 2値センサ (EJ_BinarySensorの派生クラス、種類は混在してよい)
+ * @return 状態のビットマスク (1: 検出)
+ */
+template <typename Derived>
+inline uint32_t EJ_stateMask(EJ_BinarySensor<Derived> &sensor)
+{
+    return sensor.getState() ? 1U : 0U;
+}
+
+template <typename Derived, typename... Rest>
+inline uint32_t EJ_stateMask(EJ_BinarySensor<Derived> &sensor, Rest &... rest)
+{
+    return (sensor.getState() ? 1U : 0U) | (EJ_stateMask(rest...) << 1);
+}
+
+#endif // EJDEVICE
@@ -0,0 +1,417 @@
+/**
+ * @file           EJ_DeviceTable.h
+ * @brief          ロボット全体のデバイス構成をコンパイル時に検証するデバイステーブルと、テーブルから全デバイスを生成するEJ_DeviceTableクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJDEVICETABLE
+#define EJDEVICETABLE
+#include <Arduino.h>
+#include "EJ_DCMotor.h"
+#include "EJ_EncoderMotor.h"
+#include "EJ_ServoMotor.h"
+#include "EJ_PhotoInterrupter.h"
+#include "EJ_ToFUnit.h"
+#include "EJ_I2CHub.h"
+#include "EJ_PCA9685.h"
+#include "EJ_Peripheral.h"
+
+/**
+ * @brief ピンを使わないことを表す値
+ */
+#define EJ_NO_PIN 0xFF
+
+/**
+ * @brief デバイステーブルの1要素あたりのピンの数
+ */
+#define EJ_DEVICE_PINS 5
+
+/**
+ * @brief デバイスの種類
+ */
+enum EJ_DeviceType
+{
+    EJ_DEVICE_DCMOTOR,          /**< DCモータ (pins: pin1, pin2, en) */
+    EJ_DEVICE_ENCODERMOTOR,     /**< エンコーダ付きモータ (pins: pin1, pin2, en, enc1, enc2) */
+    EJ_DEVICE_SERVO,            /**< LEDCで出力するサーボ (pins: pin) */
+    EJ_DEVICE_SERVO_RMT,        /**< RMTで出力するサーボ (pins: pin) */
+    EJ_DEVICE_SERVO_PCA9685,    /**< PCA9685に接続したサーボ (address: PCA9685の識別番号, channel: チャンネル) */
+    EJ_DEVICE_PHOTOINTERRUPTER, /**< フォトインタラプタ (pins: pin) */
+    EJ_DEVICE_TOFUNIT,          /**< ToFセンサユニット (address: I2Cアドレス) */
+    EJ_DEVICE_I2CHUB,           /**< I2CHub (address: I2Cアドレス) */
+    EJ_DEVICE_PCA9685           /**< PCA9685 (address: I2Cアドレス, hub: I2CHubの識別番号, channel: I2CHubのチャンネル) */
+};
+
+/**
+ * @struct DeviceDef
+ * @brief デバイステーブルの1要素 (1つのデバイス) を定義する構造体
+ * @details 直接初期化せず、EJ_DeviceTable::dcMotor()などのconstexpr関数で作る
+ */
+typedef struct
+{
+    uint8_t type;                  /**< デバイスの種類 (EJ_DeviceType) */
+    uint8_t id;                    /**< デバイスの識別番号 (種類ごとのマネージャでの識別番号) */
+    uint8_t pins[EJ_DEVICE_PINS];  /**< 使用するGPIO (EJ_NO_PIN: 未使用) */
+    uint8_t address;               /**< I2Cアドレス、または接続先のPCA9685の識別番号 */
+    uint8_t hub;                   /**< 接続先のI2CHubの識別番号 (EJ_PCA9685_NO_HUB: 直結) */
+    uint8_t channel;               /**< 接続先のI2CHubまたはPCA9685のチャンネル */
+} DeviceDef;
+
+/**
+ * @brief ロボット全体のデバイス構成を1つのテーブルで定義し、コンパイル時に検証して、起動時に一括で生成するクラス
+ * @details テーブルはconstexprの配列として定義する。constexprの配列は.rodata (フラッシュ) に置かれ、RAMを消費しない
+ * @details EJ_CHECK_DEVICE_TABLE()マクロで、存在しないGPIO、入力専用GPIO (34~39) への出力、ピンの重複、LEDC/RMTのチャンネル数、識別番号の範囲と重複、I2Cアドレス (ToFセンサを含む) の重複、PCA9685のチャンネルの重複、接続先の存在をコンパイル時に検証する
+ * @details 検証用の関数はC++11のconstexprの制約 (本体はreturn文1つ) の範囲で書き、再帰は範囲を2分割して深さをlog2(要素数)に抑えている
+ * @code
+ * constexpr DeviceDef DEVICES[] = {
+ *     EJ_DeviceTable::encoderMotor(0, 25, 26, 35, 36),
+ *     EJ_DeviceTable::servo(0, 19),
+ * };
+ * EJ_CHECK_DEVICE_TABLE(DEVICES);
+ *
+ * void setup() {
+ *     EJ_DeviceTable::createAll(DEVICES);
+ * }
+ * @endcode
+ */
+class EJ_DeviceTable
+{
+public:
+    /**
+     * @brief DCモータの定義を作る
+     * @param id モーターの識別番号
+     * @param pin1 モーターの接続ピン1
+     * @param pin2 モーターの接続ピン2
+     * @param en PWM設定ピン (default: EJ_NO_PIN: PWM無効)
+     */
+    static constexpr DeviceDef dcMotor(uint8_t id, uint8_t pin1, uint8_t pin2, uint8_t en = EJ_NO_PIN)
+    {
+        return DeviceDef{EJ_DEVICE_DCMOTOR, id, {pin1, pin2, en, EJ_NO_PIN, EJ_NO_PIN}, 0, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief エンコーダ付きモータの定義を作る
+     * @param id モーターの識別番号
+     * @param pin1 モーターの接続ピン1
+     * @param pin2 モーターの接続ピン2
+     * @param enc1 エンコーダの接続ピン1
+     * @param enc2 エンコーダの接続ピン2
+     * @param en PWM設定ピン (default: EJ_NO_PIN: PWM無効)
+     */
+    static constexpr DeviceDef encoderMotor(uint8_t id, uint8_t pin1, uint8_t pin2, uint8_t enc1, uint8_t enc2, uint8_t en = EJ_NO_PIN)
+    {
+        return DeviceDef{EJ_DEVICE_ENCODERMOTOR, id, {pin1, pin2, en, enc1, enc2}, 0, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief LEDCで出力するサーボの定義を作る
+     * @param id サーボモータの識別番号
+     * @param pin サーボモータの接続ピン
+     */
+    static constexpr DeviceDef servo(uint8_t id, uint8_t pin)
+    {
+        return DeviceDef{EJ_DEVICE_SERVO, id, {pin, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, 0, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief RMTで出力するサーボの定義を作る
+     * @param id サーボモータの識別番号
+     * @param pin サーボモータの接続ピン
+     */
+    static constexpr DeviceDef rmtServo(uint8_t id, uint8_t pin)
+    {
+        return DeviceDef{EJ_DEVICE_SERVO_RMT, id, {pin, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, 0, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief PCA9685に接続したサーボの定義を作る
+     * @param id サーボモータの識別番号
+     * @param expander 接続先のPCA9685の識別番号
+     * @param channel 接続先のPCA9685のチャンネル (0~15)
+     */
+    static constexpr DeviceDef expanderServo(uint8_t id, uint8_t expander, uint8_t channel)
+    {
+        return DeviceDef{EJ_DEVICE_SERVO_PCA9685, id, {EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, expander, EJ_PCA9685_NO_HUB, channel};
+    }
+
+    /**
+     * @brief フォトインタラプタの定義を作る
+     * @param id フォトインタラプタの識別番号
+     * @param pin フォトインタラプタの接続ピン
+     */
+    static constexpr DeviceDef photoInterrupter(uint8_t id, uint8_t pin)
+    {
+        return DeviceDef{EJ_DEVICE_PHOTOINTERRUPTER, id, {pin, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, 0, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief ToFセンサユニットの定義を作る
+     * @param id ToFセンサユニットの識別番号
+     * @param address ToFセンサユニットのI2Cアドレス (default: 0x29)
+     */
+    static constexpr DeviceDef tofUnit(uint8_t id, uint8_t address = 0x29)
+    {
+        return DeviceDef{EJ_DEVICE_TOFUNIT, id, {EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, address, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief I2CHubの定義を作る
+     * @param id I2CHubの識別番号
+     * @param address I2CHubのI2Cアドレス (default: 0x70)
+     */
+    static constexpr DeviceDef i2cHub(uint8_t id, uint8_t address = 0x70)
+    {
+        return DeviceDef{EJ_DEVICE_I2CHUB, id, {EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, address, EJ_PCA9685_NO_HUB, 0};
+    }
+
+    /**
+     * @brief PCA9685の定義を作る
+     * @param id PCA9685の識別番号
+     * @param address PCA9685のI2Cアドレス (default: 0x40)
+     * @param hub 接続先のI2CHubの識別番号 (default: EJ_PCA9685_NO_HUB: 直結)
+     * @param channel 接続先のI2CHubのチャンネル (default: 0)
+     */
+    static constexpr DeviceDef pca9685(uint8_t id, uint8_t address = 0x40, uint8_t hub = EJ_PCA9685_NO_HUB, uint8_t channel = 0)
+    {
+        return DeviceDef{EJ_DEVICE_PCA9685, id, {EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN, EJ_NO_PIN}, address, hub, channel};
+    }
+
+public:
+    /**
+     * @brief ESP32で使用できるGPIOかどうか判定する (存在しない番号とフラッシュ接続の6~11は使用できない)
+     */
+    static constexpr bool isUsablePin(uint8_t pin)
+    {
+        return pin <= 39 && pin != 20 && pin != 24 && !(28 <= pin && pin <= 31) && !(6 <= pin && pin <= 11);
+    }
+
+    /**
+     * @brief 入力専用のGPIOかどうか判定する
+     */
+    static constexpr bool isInputOnlyPin(uint8_t pin)
+    {
+        return 34 <= pin && pin <= 39;
+    }
+
+    /**
+     * @brief デバイスの種類とピンの位置から、そのピンが入力として使われるかどうか判定する
+     */
+    static constexpr bool isInputSlot(uint8_t type, uint8_t slot)
+    {
+        return (type == EJ_DEVICE_ENCODERMOTOR && slot >= 3) || (type == EJ_DEVICE_PHOTOINTERRUPTER && slot == 0);
+    }
+
+    /**
+     * @brief デバイスの種類ごとの最大インスタンス数を取得する
+     */
+    static constexpr size_t capacityOf(uint8_t type)
+    {
+        return type == EJ_DEVICE_DCMOTOR ? EJ_DCMOTOR_MAX_INSTANCES
+            : type == EJ_DEVICE_ENCODERMOTOR ? EJ_ENCODERMOTOR_MAX_INSTANCES
+            : type == EJ_DEVICE_SERVO || type == EJ_DEVICE_SERVO_RMT || type == EJ_DEVICE_SERVO_PCA9685 ? EJ_SERVOMOTOR_MAX_INSTANCES
+            : type == EJ_DEVICE_PHOTOINTERRUPTER ? EJ_PHOTOINTERRUPTER_MAX_INSTANCES
+            : type == EJ_DEVICE_TOFUNIT ? EJ_TOFUNIT_MAX_INSTANCES
+            : type == EJ_DEVICE_I2CHUB ? EJ_I2CHUB_MAX_INSTANCES
+            : type == EJ_DEVICE_PCA9685 ? EJ_PCA9685_MAX_INSTANCES
+            : 0;
+    }
+
+    /**
+     * @brief 識別番号を共有するデバイスの種類 (サーボは出力方法によらず同じマネージャで管理される) を取得する
+     */
+    static constexpr uint8_t managerOf(uint8_t type)
+    {
+        return type == EJ_DEVICE_SERVO_RMT || type == EJ_DEVICE_SERVO_PCA9685 ? (uint8_t)EJ_DEVICE_SERVO : type;
+    }
+
+    /**
+     * @brief 1つのデバイスが使うLEDC, RMTのチャンネル数を求める (エンコーダはGPIO割り込みで計数するためPCNTは使わない)
+     */
+    static constexpr size_t ledcOf(const DeviceDef &device)
+    {
+        return device.type == EJ_DEVICE_SERVO ? 1
+            : (device.type == EJ_DEVICE_DCMOTOR || device.type == EJ_DEVICE_ENCODERMOTOR) && device.pins[2] != EJ_NO_PIN ? 1
+            : 0;
+    }
+    static constexpr size_t rmtOf(const DeviceDef &device)
+    {
+        return device.type == EJ_DEVICE_SERVO_RMT ? 1 : 0;
+    }
+
+    /* テーブル全体の検証 (範囲 [low, high) を2分割して再帰する) */
+
+    static constexpr bool pinsUsable(const DeviceDef *table, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? pinUsable(table[low / EJ_DEVICE_PINS].pins[low % EJ_DEVICE_PINS])
+            : pinsUsable(table, low, (low + high) / 2) && pinsUsable(table, (low + high) / 2, high);
+    }
+
+    static constexpr bool outputsCapable(const DeviceDef *table, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? outputCapable(table[low / EJ_DEVICE_PINS], low % EJ_DEVICE_PINS)
+            : outputsCapable(table, low, (low + high) / 2) && outputsCapable(table, (low + high) / 2, high);
+    }
+
+    static constexpr bool pinsUnique(const DeviceDef *table, size_t count, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? (table[low / EJ_DEVICE_PINS].pins[low % EJ_DEVICE_PINS] == EJ_NO_PIN
+                || countPin(table, table[low / EJ_DEVICE_PINS].pins[low % EJ_DEVICE_PINS], 0, count * EJ_DEVICE_PINS) == 1)
+            : pinsUnique(table, count, low, (low + high) / 2) && pinsUnique(table, count, (low + high) / 2, high);
+    }
+
+    static constexpr size_t countPin(const DeviceDef *table, uint8_t pin, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? (table[low / EJ_DEVICE_PINS].pins[low % EJ_DEVICE_PINS] == pin ? 1 : 0)
+            : countPin(table, pin, low, (low + high) / 2) + countPin(table, pin, (low + high) / 2, high);
+    }
+
+    static constexpr size_t ledcCount(const DeviceDef *table, size_t low, size_t high)
+    {
+        return high - low == 1 ? ledcOf(table[low]) : ledcCount(table, low, (low + high) / 2) + ledcCount(table, (low + high) / 2, high);
+    }
+
+    static constexpr size_t rmtCount(const DeviceDef *table, size_t low, size_t high)
+    {
+        return high - low == 1 ? rmtOf(table[low]) : rmtCount(table, low, (low + high) / 2) + rmtCount(table, (low + high) / 2, high);
+    }
+
+    static constexpr bool idsValid(const DeviceDef *table, size_t count, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? table[low].id < capacityOf(table[low].type) && countId(table, table[low], 0, count) == 1
+            : idsValid(table, count, low, (low + high) / 2) && idsValid(table, count, (low + high) / 2, high);
+    }
+
+    static constexpr size_t countId(const DeviceDef *table, const DeviceDef &device, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? (managerOf(table[low].type) == managerOf(device.type) && table[low].id == device.id ? 1 : 0)
+            : countId(table, device, low, (low + high) / 2) + countId(table, device, (low + high) / 2, high);
+    }
+
+    static constexpr bool busValid(const DeviceDef *table, size_t count, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? deviceBusValid(table, count, table[low])
+            : busValid(table, count, low, (low + high) / 2) && busValid(table, count, (low + high) / 2, high);
+    }
+
+    static constexpr size_t countDevice(const DeviceDef *table, uint8_t type, uint8_t id, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? (table[low].type == type && table[low].id == id ? 1 : 0)
+            : countDevice(table, type, id, low, (low + high) / 2) + countDevice(table, type, id, (low + high) / 2, high);
+    }
+
+    static constexpr size_t countAddress(const DeviceDef *table, const DeviceDef &device, size_t low, size_t high)
+    {
+        return high - low == 1
+            ? (table[low].type == device.type && table[low].address == device.address
+                && table[low].hub == device.hub && table[low].channel == device.channel ? 1 : 0)
+            : countAddress(table, device, low, (low + high) / 2) + countAddress(table, device, (low + high) / 2, high);
+    }
+
+private:
+    static constexpr bool pinUsable(uint8_t pin)
+    {
+        return pin == EJ_NO_PIN || isUsablePin(pin);
+    }
+
+    static constexpr bool outputCapable(const DeviceDef &device, uint8_t slot)
+    {
+        return device.pins[slot] == EJ_NO_PIN || isInputSlot(device.type, slot) || !isInputOnlyPin(device.pins[slot]);
+    }
+
+    static constexpr bool deviceBusValid(const DeviceDef *table, size_t count, const DeviceDef &device)
+    {
+        return device.type == EJ_DEVICE_SERVO_PCA9685
+            ? device.channel < EJ_PCA9685_CHANNELS && countDevice(table, EJ_DEVICE_PCA9685, device.address, 0, count) == 1
+                && countAddress(table, device, 0, count) == 1
+            : device.type == EJ_DEVICE_PCA9685
+            ? (device.hub == EJ_PCA9685_NO_HUB || countDevice(table, EJ_DEVICE_I2CHUB, device.hub, 0, count) == 1)
+                && countAddress(table, device, 0, count) == 1
+            : device.type == EJ_DEVICE_I2CHUB || device.type == EJ_DEVICE_TOFUNIT
+            ? countAddress(table, device, 0, count) == 1
+            : true;
+    }
+
+public:
+    /**
+     * @brief デバイステーブルの全てのデバイスを生成する
+     * @details 依存関係の順 (I2CHub → PCA9685 → その他) に生成する
+     * @param table デバイステーブル
+     * @param count デバイステーブルの要素数
+     * @return true: 全て生成成功 / false: 生成に失敗したデバイスがあった
+     */
+    static bool createAll(const DeviceDef *table, size_t count);
+
+    /**
+     * @brief デバイステーブルの全てのデバイスを生成する
+     * @param table デバイステーブル (配列)
+     * @return true: 全て生成成功 / false: 生成に失敗したデバイスがあった
+     */
+    template <size_t N>
+    static bool createAll(const DeviceDef (&table)[N])
+    {
+        return createAll(table, N);
+    }
+
+    /**
+     * @brief 1つのデバイスを生成する
+     * @param device デバイスの定義
+     * @return true: 生成成功 / false: 生成失敗
+     */
+    static bool create(const DeviceDef &device);
+
+private:
+    static const char* _classname;
+};
+
+/**
+ * @brief デバイステーブルをコンパイル時に検証する
+ * @param table constexprで定義したDeviceDefの配列
+ */
+#define EJ_CHECK_DEVICE_TABLE(table) \
+    static_assert(EJ_DeviceTable::pinsUsable(table, 0, sizeof(table) / sizeof(DeviceDef) * EJ_DEVICE_PINS), \
+        #table ": 存在しないGPIO、またはフラッシュに接続されたGPIO (6~11) が指定されている"); \
+    static_assert(EJ_DeviceTable::outputsCapable(table, 0, sizeof(table) / sizeof(DeviceDef) * EJ_DEVICE_PINS), \
+        #table ": 入力専用のGPIO (34~39) が出力に指定されている"); \
+    static_assert(EJ_DeviceTable::pinsUnique(table, sizeof(table) / sizeof(DeviceDef), 0, sizeof(table) / sizeof(DeviceDef) * EJ_DEVICE_PINS), \
+        #table ": 同じGPIOが複数のデバイスに指定されている"); \
+    static_assert(EJ_DeviceTable::ledcCount(table, 0, sizeof(table) / sizeof(DeviceDef)) <= EJ_LEDC_CHANNELS, \
+        #table ": LEDCのチャンネル数を超えている"); \
+    static_assert(EJ_DeviceTable::rmtCount(table, 0, sizeof(table) / sizeof(DeviceDef)) <= EJ_RMT_CHANNELS, \
+        #table ": RMTのチャンネル数を超えている"); \
+    static_assert(EJ_DeviceTable::idsValid(table, sizeof(table) / sizeof(DeviceDef), 0, sizeof(table) / sizeof(DeviceDef)), \
+        #table ": 識別番号が最大インスタンス数以上、または同じマネージャで重複している"); \
+    static_assert(EJ_DeviceTable::busValid(table, sizeof(table) / sizeof(DeviceDef), 0, sizeof(table) / sizeof(DeviceDef)), \
+        #table ": I2Cアドレスか同じPCA9685のチャンネルが重複している、または接続先のI2CHub/PCA9685がテーブルに無い")
+
+#endif // EJDEVICETABLE
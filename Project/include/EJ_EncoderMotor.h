@@ -32,6 +32,14 @@
 #include <Arduino.h>
 #include <Encoder.h>
 #include "EJ_DCMotor.h"
+#include "EJ_Manager.h"
+
+/**
+ * @brief EJ_EncoderMotorの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_ENCODERMOTOR_MAX_INSTANCES
+#define EJ_ENCODERMOTOR_MAX_INSTANCES 4
+#endif
 
 /**
  * @struct EncoderMotorDef
@@ -50,6 +58,7 @@ typedef struct
 /**
  * @brief エンコーダ付きモーターを制御するクラス
  * @details *注意:本クラスのインスタンスはEJ_EncoderMotor_Managerクラス以外からは生成できない
+ * @details エンコーダはEncoderライブラリがGPIO割り込みで計数するため、PCNTは使わない
  */
 class EJ_EncoderMotor : public EJ_DCMotor, public Encoder
 {
@@ -65,6 +74,7 @@ private:
     EJ_EncoderMotor(uint8_t pin1 = 0, uint8_t pin2 = 0, uint8_t enc1 = 0, uint8_t enc2 = 0, int8_t en = -1);
 
     friend class EJ_EncoderMotor_Manager;
+    template <typename, size_t> friend class EJ_Manager;
 
 public:
     /**
@@ -73,8 +83,28 @@ public:
     ~EJ_EncoderMotor();
 
 public:
+    /**
+     * @brief 正転する
+     * @details 移動中の場合は移動を中止してから正転する
+     */
+    void forward();
+
+    /**
+     * @brief 逆転する
+     * @details 移動中の場合は移動を中止してから逆転する
+     */
+    void reverse();
+
+    /**
+     * @brief PWM制御で回転させる
+     * @details 移動中の場合は移動を中止してから回転させる。_enablePWMがfalseの時はコールされても何もしない
+     * @param duty Duty比 (0: 停止, -100: 最大出力で逆転, 100: 最大出力で正転)
+     */
+    void setPWM(int16_t duty);
+
     /**
      * @brief 現在位置から相対移動
+     * @details 移動を開始してすぐに戻る。目標位置を越えたらupdate()が停止する
      * @param relativePosition 現在位置からの相対位置
      */
     void move(long relativePosition);
@@ -82,6 +112,7 @@ public:
     /**
      * @brief 現在位置から相対移動 (PWM制御)
      * @param relativePosition 現在位置からの相対位置
+     * @details 移動を開始してすぐに戻る。目標位置を越えたらupdate()が停止する
      * @details _enablePWMがfalseの時はコールされても何もしない。
      * @param duty Duty比 (0: 停止, -100: 最大出力で逆転, 100: 最大出力で正転)
      */
@@ -109,56 +140,78 @@ public:
 
     /**
      * @brief 目標位置に到達したかどうか判定する
+     * @details 移動中は移動方向に目標位置を越えたかどうかで判定する
      * @return true: 目標位置に到達 / false: 目標位置に未達
      */
     bool isTargetReached();
 
+    /**
+     * @brief move()/moveTo()で開始した移動の途中かどうか判定する
+     * @return true: 移動中 / false: 停止している
+     */
+    bool isMoving();
+
+    /**
+     * @brief 停止する
+     * @details 移動中の場合は移動を中止する
+     */
+    void stop();
+
+    /**
+     * @brief 移動中であれば目標位置に到達したかどうか判定し、到達していれば停止する
+     * @details EJ_Executiveの周期処理やloop()から、エンコーダの分解能に見合う周期 (1kHzなど) で呼び出す
+     */
+    void update();
+
+    /**
+     * @brief 現在位置を取得する
+     * @details Encoder::read()と同じ値を返す。EJ_SensorLogの記録中は値を記録し、再生中は現在時刻までに記録された最新の値を返す
+     * @return 現在位置 (単位: カウント)
+     */
+    long read();
+
+    /**
+     * @brief 現在位置を記録せずに取得する
+     * @details 状態の問い合わせ (EJ_Commandの応答など) に使う。EJ_SensorLogの記録中も値を記録しないため、記録されるレコードの並びを変えない
+     * @return 現在位置 (単位: カウント)
+     */
+    long peek();
+
 private:
     static const char* _classname;
     uint8_t _enc1;
     uint8_t _enc2;
-    long _target;
+    volatile long _target;
+    volatile int8_t _direction; /**< 移動の向き (1: 正転, -1: 逆転, 0: 停止) */
+#ifdef ARDUINO_ARCH_ESP32
+    portMUX_TYPE _mux; /**< update()を呼ぶ周期処理と目標位置、向き、出力の更新を排他する */
+#endif
 };
 
 /**
  * @brief EJ_EncoderMotorクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_EncoderMotorクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_ENCODERMOTOR_MAX_INSTANCES個まで生成される
  */
-class EJ_EncoderMotor_Manager
+class EJ_EncoderMotor_Manager : public EJ_Manager<EJ_EncoderMotor, EJ_ENCODERMOTOR_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_EncoderMotor_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_EncoderMotorの最大インスタンス数の定義
-     */
-    EJ_EncoderMotor_Manager(size_t maxInstanceSize);
-
-private:
-    /**
-     * @brief EJ_EncoderMotor_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_EncoderMotor_Managerのsingletonを指すポインタ
-     */
-    static EJ_EncoderMotor_Manager* getInstance();
-
-public:
-    /**
-     * @brief EJ_EncoderMotor_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_EncoderMotorクラスのインスタンスをすべて解放する
+     * @brief EJ_EncoderMotor_Managerクラスはインスタンス化しない
      */
-    ~EJ_EncoderMotor_Manager();
+    EJ_EncoderMotor_Manager();
 
 public:
     /**
-     * @brief EJ_EncoderMotor_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_EncoderMotorの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_ENCODERMOTOR_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_EncoderMotorの最大インスタンス数
+     * @return true: EJ_ENCODERMOTOR_MAX_INSTANCES以下 / false: EJ_ENCODERMOTOR_MAX_INSTANCESを超える
      */
     static bool configure(size_t maxInstanceSize);
 
     /**
      * @brief EJ_EncoderMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetMotor関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetMotor関数で取得できるように静的な領域に生成する
      * @param MotorDef 参照
      * @return EJ_EncoderMotorクラスのインスタンスを指すポインタ
      */
@@ -166,7 +219,7 @@ public:
 
     /**
      * @brief EJ_EncoderMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetMotor関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetMotor関数で取得できるように静的な領域に生成する
      * @param pin1 モータの接続ピン1
      * @param pin2 モータの接続ピン2
      * @param en PWM設定ピン (負値: PWM無効)
@@ -191,11 +244,18 @@ public:
      */
     static EJ_EncoderMotor *getEncoderMotor(uint8_t id);
 
+    /**
+     * @brief 全てのEJ_EncoderMotorのupdate()を呼び出す
+     * @details EJ_Executive::addUpdate<EJ_EncoderMotor_Manager>("motor", 1000) で周期処理として登録できる
+     */
+    static void update();
+
 private:
     static const char* _classname;
-    static EJ_EncoderMotor_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_EncoderMotor **_instanceList;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_EncoderMotor.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_EncoderMotor, EJ_ENCODERMOTOR_MAX_INSTANCES>::_classname;
+
 #endif // EJENCODERMOTOR
\ No newline at end of file
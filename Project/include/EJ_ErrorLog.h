@@ -0,0 +1,214 @@
+/**
+ * @file           EJ_ErrorLog.h
+ * @brief          エラーイベントをロックフリーのリングバッファに記録し、後から出力するEJ_ErrorLogクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJERRORLOG
+#define EJERRORLOG
+#include <Arduino.h>
+
+/**
+ * @brief エラーイベントを保持するリングバッファの大きさ (2のべき乗, ビルドフラグで変更できる)
+ */
+#ifndef EJ_ERRORLOG_QUEUE_SIZE
+#define EJ_ERRORLOG_QUEUE_SIZE 32
+#endif
+
+/**
+ * @brief ISRから呼ばれる関数をIRAMに置く属性 (ESP32のみ)
+ */
+#ifdef ARDUINO_ARCH_ESP32
+#define EJ_ERRORLOG_IRAM IRAM_ATTR
+#else
+#define EJ_ERRORLOG_IRAM
+#endif
+
+/**
+ * @brief エラーの種類
+ */
+enum EJ_ErrorCode
+{
+    EJ_ERROR_NONE = 0,          /**< エラーなし */
+    EJ_ERROR_INVALID_ID,        /**< 範囲外、または生成されていないid、チャンネルが指定された */
+    EJ_ERROR_INSTANCE_MISMATCH, /**< 指定された定義と生成済みのインスタンスが一致しない */
+    EJ_ERROR_CAPACITY,          /**< 最大インスタンス数を超えている */
+    EJ_ERROR_INVALID_ARGUMENT,  /**< 無効な引数が指定された */
+    EJ_ERROR_NO_RESOURCE,       /**< チャンネルやメモリなどの資源が足りない */
+    EJ_ERROR_HARDWARE,          /**< ペリフェラルやセンサの設定、通信に失敗した */
+    EJ_ERROR_TIMEOUT,           /**< 待ち時間が上限を超えた */
+    EJ_ERROR_UNSUPPORTED,       /**< 対応していないプラットフォーム */
+    EJ_ERROR_NOT_READY,         /**< 必要な初期化や登録がされていない */
+    EJ_ERROR_STORAGE,           /**< NVS、パーティション、ファイルの読み書きに失敗した */
+    EJ_ERROR_INVALID_DATA,      /**< 読み込んだデータが不正 */
+    EJ_ERROR_NOT_OWNER,         /**< 所有するタスク以外から呼び出された */
+    EJ_ERROR_CODES              /**< 種類の数 */
+};
+
+/**
+ * @struct ErrorEvent
+ * @brief 1つのエラーイベント
+ */
+typedef struct
+{
+    const char *classname; /**< エラーが発生したクラスの名前 */
+    uint32_t timestamp;    /**< 発生時刻 (単位: us, micros()) */
+    uint32_t sequence;     /**< 起動してからの通し番号 */
+    uint16_t line;         /**< エラーが発生した行番号 */
+    uint8_t code;          /**< エラーの種類 (EJ_ErrorCode) */
+} ErrorEvent;
+
+/**
+ * @brief エラーイベントを受け取る関数
+ */
+typedef void (*EJ_ErrorSink)(const ErrorEvent &event, void *context);
+
+/**
+ * @brief エラーイベントを記録し、後から出力するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details record()はアトミックな加算1回で書き込み先を決めるロックフリーの処理で、ISRや両コアのタスクから同時に呼び出せる。画面やシリアルへの出力は行わないため、制御ループの中でエラーが起きてもループの周期を乱さない
+ * @details リングバッファが一杯のときは最も古いイベントを上書きする。読み出しが間に合わずに失われたイベントの数はgetLostCount()で取得できる
+ * @details 出力はloop()からdrain()を呼ぶか、startTask()で起動した低優先度のタスクで行う
+ */
+class EJ_ErrorLog
+{
+private:
+    /**
+     * @brief EJ_ErrorLogクラスはインスタンス化しない
+     */
+    EJ_ErrorLog();
+
+public:
+    /**
+     * @brief エラーイベントを記録する
+     * @details ISRから呼び出してもよい
+     * @param classname エラーが発生したクラスの名前 (静的な文字列)
+     * @param code エラーの種類
+     * @param line エラーが発生した行番号
+     */
+    static void EJ_ERRORLOG_IRAM record(const char *classname, EJ_ErrorCode code, int line);
+
+    /**
+     * @brief 最後に記録されたエラーイベントを取得する
+     * @details 読み出し (read(), drain()) の有無に関わらず取得できる
+     * @param event 取得したイベントの格納先
+     * @return true: 取得した / false: エラーが記録されていない
+     */
+    static bool getLastError(ErrorEvent &event);
+
+    /**
+     * @brief 種類ごとのエラーの発生回数を取得する
+     */
+    static uint32_t getCount(EJ_ErrorCode code);
+
+    /**
+     * @brief 全てのエラーの発生回数を取得する
+     */
+    static uint32_t getTotalCount();
+
+    /**
+     * @brief 読み出す前に上書きされて失われたイベントの数を取得する
+     */
+    static uint32_t getLostCount();
+
+    /**
+     * @brief 種類ごとの発生回数を0にする
+     */
+    static void clearCounts();
+
+    /**
+     * @brief 最も古い未読のエラーイベントを1つ読み出す
+     * @details 読み出し側は1つのタスクに限る
+     * @param event 読み出したイベントの格納先
+     * @return true: 読み出した / false: 未読のイベントがない
+     */
+    static bool read(ErrorEvent &event);
+
+    /**
+     * @brief 未読のエラーイベントを読み出して出力する
+     * @param out 出力先 (Serial, M5.Lcdなど)
+     * @param maxEvents 1回に出力する最大のイベント数
+     * @return 出力したイベントの数
+     */
+    static size_t drain(Print &out, size_t maxEvents = EJ_ERRORLOG_QUEUE_SIZE);
+
+    /**
+     * @brief 未読のエラーイベントを読み出して関数に渡す
+     * @param sink イベントを受け取る関数
+     * @param context sinkに渡すポインタ
+     * @param maxEvents 1回に渡す最大のイベント数
+     * @return 渡したイベントの数
+     */
+    static size_t drain(EJ_ErrorSink sink, void *context, size_t maxEvents = EJ_ERRORLOG_QUEUE_SIZE);
+
+    /**
+     * @brief エラーイベントを1行で出力する
+     */
+    static void print(Print &out, const ErrorEvent &event);
+
+    /**
+     * @brief エラーの種類の名前を取得する
+     */
+    static const char *getCodeName(uint8_t code);
+
+    /**
+     * @brief 一定周期でdrain()を呼ぶ低優先度のタスクを起動する (ESP32のみ)
+     * @details 出力先を他のタスクからも使う場合 (loop()でM5.Lcdに描画するなど) は、タスクを使わずにloop()からdrain()を呼ぶ
+     * @param out 出力先
+     * @param interval 出力の周期 (単位: ms)
+     * @param priority タスクの優先度
+     * @return true: 起動した / false: 起動済み、または起動に失敗した
+     */
+    static bool startTask(Print &out, uint32_t interval = 100, uint8_t priority = 1);
+
+    /**
+     * @brief startTask()で起動したタスクを停止する
+     */
+    static void stopTask();
+
+private:
+    typedef struct
+    {
+        uint32_t state; /**< 2 * 通し番号 + 1: 書き込み中 / 2 * 通し番号 + 2: 書き込み済み */
+        ErrorEvent event;
+    } Slot;
+
+    static bool readSlot(uint32_t sequence, ErrorEvent &event, int32_t &age);
+    static void taskMain(void *parameter);
+
+private:
+    static const char* _classname;
+    static Slot _slots[EJ_ERRORLOG_QUEUE_SIZE];
+    static uint32_t _head;
+    static uint32_t _tail;
+    static uint32_t _lost;
+    static uint32_t _counts[EJ_ERROR_CODES];
+    static Print *_taskOut;
+    static uint32_t _taskInterval;
+    static void *_task;
+};
+
+#endif // EJERRORLOG
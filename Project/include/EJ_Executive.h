@@ -0,0 +1,256 @@
+/**
+ * @file           EJ_Executive.h
+ * @brief          ハードウェアタイマで周期処理を固定レートで実行するEJ_Executiveクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJEXECUTIVE
+#define EJEXECUTIVE
+#include <Arduino.h>
+#include "EJ_Peripheral.h"
+
+/**
+ * @brief 登録できる周期処理の最大数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_EXECUTIVE_MAX_HOOKS
+#define EJ_EXECUTIVE_MAX_HOOKS 16
+#endif
+
+/**
+ * @brief 周期の種類の最大数 (種類ごとに1つのタスクを使う, ビルドフラグで変更できる)
+ */
+#ifndef EJ_EXECUTIVE_MAX_RATES
+#define EJ_EXECUTIVE_MAX_RATES 4
+#endif
+
+/**
+ * @brief 最も短い周期のタスクの優先度 (周期が長くなるごとに1つずつ下げる, ビルドフラグで変更できる)
+ */
+#ifndef EJ_EXECUTIVE_PRIORITY
+#define EJ_EXECUTIVE_PRIORITY 20
+#endif
+
+/**
+ * @brief 周期処理のタスクのスタックサイズ (単位: byte, ビルドフラグで変更できる)
+ */
+#ifndef EJ_EXECUTIVE_STACK_SIZE
+#define EJ_EXECUTIVE_STACK_SIZE 4096
+#endif
+
+/**
+ * @brief 周期処理として呼び出す関数
+ */
+typedef void (*EJ_UpdateHook)(void *context);
+
+/**
+ * @struct HookStats
+ * @brief 周期処理ごとの実行時間、ジッタ、デッドラインミスの統計 (時間の単位: us)
+ */
+typedef struct
+{
+    const char *name;   /**< 名前 */
+    uint32_t period;    /**< 周期 */
+    uint32_t runs;      /**< 実行回数 */
+    uint32_t misses;    /**< デッドラインミスの回数 (次の起動時刻までに終わらなかった回数と、実行できなかった起動の数の合計) */
+    uint32_t execMin;   /**< 実行時間の最小値 */
+    uint32_t execMax;   /**< 実行時間の最大値 */
+    uint64_t execTotal; /**< 実行時間の合計 (1kHzでも桁あふれしないよう64bit) */
+    uint32_t jitterMax; /**< 起動時刻から実行開始までの遅れの最大値 */
+    uint64_t jitterTotal; /**< 起動時刻から実行開始までの遅れの合計 */
+} HookStats;
+
+/**
+ * @brief 登録した周期処理をハードウェアタイマで固定レートで実行するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details 周期処理は周期ごとにまとめ、周期ごとに1つのタスクを指定したコアに固定して生成する。タスクの優先度は周期が短いほど高く (レートモノトニック)、短い周期の処理は長い周期の処理に割り込んで実行される
+ * @details ハードウェアタイマの割り込みは基本周期ごとに発生し、起動時刻になった周期のタスクに通知する。起動時刻は基本周期の整数倍で、ジッタは起動時刻から実行開始までの遅れとして測る
+ * @details ESP32以外のプラットフォームや、タイマを使わずにloop()から駆動する場合はpoll()を呼ぶ。poll()では周期の短い順に実行し、割り込みは起きない
+ */
+class EJ_Executive
+{
+private:
+    /**
+     * @brief EJ_Executiveクラスはインスタンス化しない
+     */
+    EJ_Executive();
+
+public:
+    /**
+     * @brief 基本周期を設定し、登録済みの周期処理を全て削除する
+     * @param tick 基本周期 (単位: us, 全ての周期処理の周期はこの整数倍にする)
+     * @return true: 成功 / false: 実行中、または基本周期が0
+     */
+    static bool begin(uint32_t tick = 1000);
+
+    /**
+     * @brief 周期処理を登録する
+     * @details start()の前に登録する
+     * @param name 名前 (静的な文字列)
+     * @param hook 呼び出す関数
+     * @param context hookに渡すポインタ
+     * @param rate 実行レート (単位: Hz, 1000000 / rate が基本周期の整数倍になること)
+     * @return 周期処理の番号 (負値: 登録できなかった)
+     */
+    static int8_t addHook(const char *name, EJ_UpdateHook hook, void *context, uint32_t rate);
+
+    /**
+     * @brief オブジェクトのupdate()を周期処理として登録する
+     * @tparam T update()を持つクラス
+     */
+    template <typename T>
+    static int8_t addUpdate(const char *name, T *object, uint32_t rate)
+    {
+        return addHook(name, &callUpdate<T>, object, rate);
+    }
+
+    /**
+     * @brief クラスの静的なupdate()を周期処理として登録する
+     * @details EJ_ServoMotor_Manager (軌道の補間とPCA9685への送信)、EJ_EncoderMotor_Manager (目標位置への移動)、EJ_ToFUnit_Manager (測距のポーリング) など、管理する全てのインスタンスを進めるクラスに使う
+     * @tparam T 静的なupdate()を持つクラス
+     */
+    template <typename T>
+    static int8_t addUpdate(const char *name, uint32_t rate)
+    {
+        return addHook(name, &callStaticUpdate<T>, NULL, rate);
+    }
+
+    /**
+     * @brief ハードウェアタイマと周期ごとのタスクを起動する (ESP32のみ)
+     * @param core タスクを固定するコア
+     * @return true: 起動した / false: 起動済み、周期処理が未登録、またはタイマやタスクを確保できなかった
+     */
+    static bool start(uint8_t core = 1);
+
+    /**
+     * @brief タイマとタスクを停止する
+     */
+    static void stop();
+
+    /**
+     * @brief タイマを使わずに周期処理を実行する
+     * @details loop()などから基本周期より短い間隔で呼び出す。起動時刻を過ぎた周期処理を周期の短い順に実行する
+     */
+    static void poll();
+
+    /**
+     * @brief 周期処理への切り替えを止める
+     * @details 複数のデバイスへの設定をまとめて反映する間に、周期処理と同じコアのタスク (loop()など) から呼ぶ。unlock()までは周期処理が実行されないため、周期処理からは反映が途中で分かれて見えない。ブロックする関数を呼ばず、短い時間でunlock()を呼ぶこと
+     * @details 割り込み (タイマやエンコーダ) は止めない。タイマの通知はunlock()の後に周期処理へ届く。poll()で駆動する場合は呼び出し元と周期処理が交互に実行されるため何もしない
+     */
+    static void lock();
+
+    /**
+     * @brief lock()で止めた周期処理への切り替えを再開する
+     */
+    static void unlock();
+
+    /**
+     * @brief 実行中かどうか判定する
+     */
+    static bool isRunning();
+
+    /**
+     * @brief 登録した周期処理の数を取得する
+     */
+    static uint8_t getHookCount();
+
+    /**
+     * @brief 周期処理の統計を取得する
+     * @param index 周期処理の番号
+     * @param stats 統計の格納先
+     * @return true: 取得した / false: 番号が範囲外
+     */
+    static bool getStats(uint8_t index, HookStats &stats);
+
+    /**
+     * @brief 全ての周期処理のデッドラインミスの回数の合計を取得する
+     */
+    static uint32_t getMissCount();
+
+    /**
+     * @brief 最大実行時間から求めたCPU使用率を取得する
+     * @details 周期の種類の数をnとして n(2^(1/n) - 1) 以下であれば、レートモノトニックで全てのデッドラインを守れる (Liu & Laylandの十分条件)
+     * @return 使用率 (0.0 ~ )
+     */
+    static float getUtilization();
+
+    /**
+     * @brief 統計を0にする
+     */
+    static void resetStats();
+
+    /**
+     * @brief 全ての周期処理の統計を出力する
+     * @details 実行時間は 最小/平均/最大、ジッタは 平均/最大 の順に出力する
+     * @param out 出力先 (Serial, M5.Lcdなど)
+     */
+    static void printStats(Print &out);
+
+private:
+    typedef struct
+    {
+        EJ_UpdateHook hook;
+        void *context;
+        uint8_t rate;        /**< 周期の種類の番号 */
+        HookStats stats;
+    } Hook;
+
+    typedef struct
+    {
+        uint32_t period;     /**< 周期 (単位: us) */
+        uint32_t divider;    /**< 基本周期の何倍か */
+        uint32_t release;    /**< 最後の起動時刻 (単位: us) */
+        uint32_t pending;    /**< 実行を待っている起動の数 (poll()用) */
+        void *task;
+    } Rate;
+
+    template <typename T>
+    static void callUpdate(void *object) { static_cast<T *>(object)->update(); }
+
+    template <typename T>
+    static void callStaticUpdate(void *context) { (void)context; T::update(); }
+
+    static void tick();
+    static void runRate(uint8_t rate, uint32_t release, uint32_t skipped);
+    static void taskMain(void *parameter);
+    static void onTimer();
+
+private:
+    static const char* _classname;
+    static Hook _hooks[EJ_EXECUTIVE_MAX_HOOKS];
+    static uint8_t _hookCount;
+    static Rate _rates[EJ_EXECUTIVE_MAX_RATES];
+    static uint8_t _rateCount;
+    static uint32_t _tick;
+    static uint32_t _ticks;
+    static uint32_t _epoch;
+    static bool _running;
+    static int8_t _timerIndex;
+    static void *_timer;
+    static uint8_t _core;
+};
+
+#endif // EJEXECUTIVE
@@ -0,0 +1,81 @@
+/**
+ * @file           EJ_Framing.h
+ * @brief          シリアル通信のフレーム化 (COBS) と誤り検出 (CRC) を行うEJ_Framingクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJFRAMING
+#define EJFRAMING
+#include <Arduino.h>
+
+/**
+ * @brief COBSで符号化したときの最大の長さ (区切りの0x00を含む)
+ * @param length 符号化するデータの長さ
+ */
+#define EJ_COBS_MAX_ENCODED(length) ((length) + (length) / 254 + 2)
+
+/**
+ * @brief バイナリのデータをシリアル通信で送受信するためのクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details フレームはCOBS (Consistent Overhead Byte Stuffing) で0x00を含まない列に符号化し、末尾に区切りの0x00を付ける。受信側は0x00までを1フレームとして復号するため、途中から受信しても次のフレームで同期できる
+ */
+class EJ_Framing
+{
+private:
+    /**
+     * @brief EJ_Framingクラスはインスタンス化しない
+     */
+    EJ_Framing();
+
+public:
+    /**
+     * @brief COBSで符号化する
+     * @param src 符号化するデータ
+     * @param length srcの長さ
+     * @param dst 符号化したデータの格納先 (EJ_COBS_MAX_ENCODED(length)以上の大きさ、srcと重ならないこと)
+     * @return dstに書き込んだ長さ (区切りの0x00を含む)
+     */
+    static size_t encode(const uint8_t *src, size_t length, uint8_t *dst);
+
+    /**
+     * @brief COBSで符号化したフレームを復号する
+     * @param src 復号するフレーム (区切りの0x00を含まない)
+     * @param length srcの長さ
+     * @param dst 復号したデータの格納先 (srcと同じでもよい)
+     * @return dstに書き込んだ長さ (0: フレームが壊れている)
+     */
+    static size_t decode(const uint8_t *src, size_t length, uint8_t *dst);
+
+    /**
+     * @brief CRC-16/CCITT-FALSE (多項式0x1021、初期値0xFFFF) を計算する
+     * @param data 計算するデータ
+     * @param length dataの長さ
+     * @param crc 途中までの計算結果 (続けて計算する場合)
+     */
+    static uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF);
+};
+
+#endif // EJFRAMING
@@ -0,0 +1,73 @@
+/**
+ * @file           EJ_I2CBus.h
+ * @brief          I2Cバスの排他制御を行うクラスEJ_I2CBusの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJI2CBUS
+#define EJI2CBUS
+#include <Arduino.h>
+
+/**
+ * @brief バスの獲得を待つ時間の既定値 (単位: ms, ビルドフラグで変更できる)
+ */
+#ifndef EJ_I2CBUS_TIMEOUT
+#define EJ_I2CBUS_TIMEOUT 100
+#endif
+
+/**
+ * @brief I2Cバス (Wire) を複数のタスクで共有するための排他制御を行うクラス
+ * @details EJ_PCA9685の送信はI2CHubのチャンネル選択から転送の完了までを、EJ_ToFUnitのポーリングは1ステップ分の転送をこのロックの中で行う。別のタスクから同じバスの別のデバイスにアクセスしても、チャンネル選択と転送の間や転送の途中に割り込まれない
+ * @details EJ_ToFUnitはI2CHubのチャンネルを選択しないため、I2CHubの先につないだToFセンサユニットにアクセスする場合は、スケッチからEJ_I2CHub::selectChannel()でチャンネルを切り替える処理とpoll()/read()の呼び出しをlock()からunlock()までの間で行う。同じタスクからは入れ子にしてロックできる
+ * @details ESP32ではFreeRTOSの再帰ミューテックス (静的に確保) を使う。待機するため割り込みハンドラやesp_timerのコールバックからは呼び出さない。ホストでは何もしない
+ */
+class EJ_I2CBus
+{
+private:
+    /**
+     * @brief EJ_I2CBusクラスはインスタンス化しない
+     */
+    EJ_I2CBus();
+
+public:
+    /**
+     * @brief バスを獲得する
+     * @param timeout 獲得を待つ時間 (単位: ms, default: EJ_I2CBUS_TIMEOUT)
+     * @return true: 獲得した / false: タイムアウトした
+     */
+    static bool lock(uint32_t timeout = EJ_I2CBUS_TIMEOUT);
+
+    /**
+     * @brief lock()で獲得したバスを解放する
+     */
+    static void unlock();
+
+private:
+    static const char* _classname;
+    static void *_mutex;
+};
+
+#endif // EJI2CBUS
@@ -31,6 +31,14 @@
 #define EJI2CHub
 #include <Arduino.h>
 #include "ClosedCube_TCA9548A.h"
+#include "EJ_Manager.h"
+
+/**
+ * @brief EJ_I2CHubの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_I2CHUB_MAX_INSTANCES
+#define EJ_I2CHUB_MAX_INSTANCES 2
+#endif
 
 /**
  * @struct I2CHubDef
@@ -46,6 +54,7 @@ typedef struct
  * @brief I2CHubユニットを制御するクラス
  * @details *注意:本クラスのインスタンスはEJ_I2CHub_Managerクラス以外からは生成できない
  * @details uint8_t selectChannel(uint8_t channel); メソッドの引数に 0~6 のチャンネルを指定して接続先を切り替え
+ * @details 複数のタスクからI2Cを使う場合は、チャンネルの切り替えから切り替え先のデバイスとの通信までをEJ_I2CBus::lock()/unlock()で囲む
  */
 class EJ_I2CHub : public ClosedCube::Wired::TCA9548A
 {
@@ -57,6 +66,7 @@ private:
     EJ_I2CHub(uint8_t address);
 
     friend class EJ_I2CHub_Manager;
+    template <typename, size_t> friend class EJ_Manager;
 
 public:
     /**
@@ -71,43 +81,28 @@ private:
 
 /**
  * @brief EJ_I2CHubクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_I2CHubクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_I2CHUB_MAX_INSTANCES個まで生成される
  */
-class EJ_I2CHub_Manager
+class EJ_I2CHub_Manager : public EJ_Manager<EJ_I2CHub, EJ_I2CHUB_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_I2CHub_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_I2CHubの最大インスタンス数の定義
-     */
-    EJ_I2CHub_Manager(size_t maxInstanceSize);
-
-private:
-    /**
-     * @brief EJ_I2CHub_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_I2CHub_Managerのsingletonを指すポインタ
-     */
-    static EJ_I2CHub_Manager* getInstance();
-
-public:
-    /**
-     * @brief EJ_I2CHub_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_I2CHubクラスのインスタンスをすべて解放する
+     * @brief EJ_I2CHub_Managerクラスはインスタンス化しない
      */
-    ~EJ_I2CHub_Manager();
+    EJ_I2CHub_Manager();
 
 public:
     /**
-     * @brief EJ_I2CHub_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_I2CHubの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_I2CHUB_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_I2CHubの最大インスタンス数
+     * @return true: EJ_I2CHUB_MAX_INSTANCES以下 / false: EJ_I2CHUB_MAX_INSTANCESを超える
      */
     static bool configure(size_t maxInstanceSize);
 
     /**
      * @brief EJ_I2CHubクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetI2CHub関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetI2CHub関数で取得できるように静的な領域に生成する
      * @param I2CHubDef 参照
      * @return EJ_I2CHubクラスのインスタンスを指すポインタ
      */
@@ -115,7 +110,7 @@ public:
 
     /**
      * @brief EJ_I2CHubクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetI2CHub関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetI2CHub関数で取得できるように静的な領域に生成する
      * @param id PaHubユニットの識別番号
      * @param address PaHubユニット自身のI2Cアドレス (default: 0x70)
      * @return EJ_I2CHubクラスのインスタンスを指すポインタ
@@ -132,9 +127,10 @@ public:
 
 private:
     static const char* _classname;
-    static EJ_I2CHub_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_I2CHub **_instanceList;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_I2CHub.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_I2CHub, EJ_I2CHUB_MAX_INSTANCES>::_classname;
+
 #endif // EJI2CHub
\ No newline at end of file
@@ -0,0 +1,202 @@
+/**
+ * @file           EJ_Manager.h
+ * @brief          デバイスクラスのインスタンスを静的な領域に生成、管理するクラステンプレートEJ_Managerの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJMANAGER
+#define EJMANAGER
+#include <Arduino.h>
+#include <new>
+#include "EJ_ErrorLog.h"
+#include "EJ_Trace.h"
+
+/**
+ * @brief EJ_Managerの全ての実体化で共有する処理をまとめた基底クラス
+ */
+class EJ_ManagerBase
+{
+protected:
+    /**
+     * @brief エラーをEJ_ErrorLogに記録する
+     * @param classname エラーが発生したクラスの名前
+     * @param code エラーの種類
+     * @param line エラーが発生した行番号
+     */
+    static void errorLog(const char *classname, EJ_ErrorCode code, int line);
+};
+
+/**
+ * @brief デバイスクラスのインスタンスを静的な領域に生成、管理するクラステンプレート
+ * @details 各デバイスのマネージャクラスはこのクラステンプレートを継承する。インスタンスはヒープを使わず、N個分の静的な領域にplacement newで生成するため、長時間動作させてもヒープが断片化しない
+ * @details 生成済みのインスタンスはget()で範囲と生成済みかどうかを確認して取得するか、ホットパスではat()で確認せずに取得する
+ * @details エラーに出力するクラス名は、各マネージャクラスが_classnameを明示的特殊化してヘッダで宣言し、ソースで定義する
+ * @tparam T 管理するデバイスクラス (EJ_Managerをfriendにしておく)
+ * @tparam N 最大インスタンス数 (idは 0 ~ N - 1)
+ */
+template <typename T, size_t N>
+class EJ_Manager : protected EJ_ManagerBase
+{
+protected:
+    /**
+     * @brief インスタンスを生成する
+     * @details 指定したidのインスタンスが生成済みの場合は、新たに生成せずに生成済みのインスタンスを返す
+     * @param id 識別番号
+     * @param args Tのコンストラクタの引数
+     * @return 生成したインスタンスを指すポインタ (idが範囲外の場合はNULL)
+     */
+    template <typename... Args>
+    static T *create(uint8_t id, Args... args)
+    {
+        if (id >= N) {
+            /*
+            ERRORLOG
+                内容：最大インスタンス数を超えるidが指定された
+            */
+            errorLog(_classname, EJ_ERROR_INVALID_ID, __LINE__);
+            return NULL;
+        }
+        if (!_created[id]) {
+            new (_storage[id]) T(args...);
+            _created[id] = true;
+        }
+        return &at(id);
+    }
+
+public:
+    /**
+     * @brief インスタンスを取得する
+     * @details 指定したidのインスタンスが生成されていない場合やidが範囲外の場合はエラーを出力してNULLを返す
+     * @param id 識別番号
+     * @return インスタンスを指すポインタ
+     */
+    static T *get(uint8_t id)
+    {
+        EJ_TRACE_SCOPE("EJ_Manager::get");
+        if (id >= N) {
+            /*
+            ERRORLOG
+                内容：最大インスタンス数を超えるidが指定された
+            */
+            errorLog(_classname, EJ_ERROR_INVALID_ID, __LINE__);
+            return NULL;
+        }
+        if (!_created[id]) {
+            /*
+            ERRORLOG
+                内容：指定されたidのインスタンスが存在しない
+            */
+            errorLog(_classname, EJ_ERROR_INVALID_ID, __LINE__);
+            return NULL;
+        }
+        return &at(id);
+    }
+
+    /**
+     * @brief インスタンスを取得する (エラーを出力しない)
+     * @param id 識別番号
+     * @return インスタンスを指すポインタ (生成されていない場合やidが範囲外の場合はNULL)
+     */
+    static T *find(uint8_t id)
+    {
+        return contains(id) ? &at(id) : NULL;
+    }
+
+    /**
+     * @brief インスタンスを確認せずに取得する
+     * @attention *idが範囲内で、インスタンスが生成済みであることを呼び出し側で保証すること
+     * @param id 識別番号
+     * @return インスタンスの参照
+     */
+    static T &at(uint8_t id)
+    {
+        return *reinterpret_cast<T *>(_storage[id]);
+    }
+
+    /**
+     * @brief 指定したidのインスタンスが生成済みかどうか判定する
+     * @param id 識別番号
+     * @return true: 生成済み / false: 未生成またはidが範囲外
+     */
+    static bool contains(uint8_t id)
+    {
+        return id < N && _created[id];
+    }
+
+    /**
+     * @brief インスタンスを破棄する
+     * @param id 識別番号
+     */
+    static void destroy(uint8_t id)
+    {
+        if (contains(id)) {
+            at(id).~T();
+            _created[id] = false;
+        }
+    }
+
+    /**
+     * @brief 全てのインスタンスを破棄する
+     */
+    static void clear()
+    {
+        for (size_t i = 0; i < N; i++) {
+            destroy(i);
+        }
+    }
+
+    /**
+     * @brief 最大インスタンス数を取得する
+     */
+    static size_t capacity()
+    {
+        return N;
+    }
+
+    /**
+     * @brief インスタンスの管理に使う静的な領域の大きさを取得する
+     * @details 以前のヒープを使う実装では、シングルトン、ポインタ配列、インスタンスごとに1回ずつヒープを確保しており、それぞれにヒープのブロックヘッダが付いていた
+     * @return 領域の大きさ (単位: byte)
+     */
+    static size_t footprint()
+    {
+        return sizeof(_storage) + sizeof(_created);
+    }
+
+private:
+    static const char* _classname;
+    alignas(T) static uint8_t _storage[N][sizeof(T)];
+    static bool _created[N];
+};
+
+/* static member */
+template <typename T, size_t N>
+alignas(T) uint8_t EJ_Manager<T, N>::_storage[N][sizeof(T)];
+
+template <typename T, size_t N>
+bool EJ_Manager<T, N>::_created[N];
+
+#endif // EJMANAGER
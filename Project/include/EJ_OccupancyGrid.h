@@ -0,0 +1,234 @@
+/**
+ * @file           EJ_OccupancyGrid.h
+ * @brief          ToFセンサユニットの測距値とオドメトリから局所的な占有格子地図を生成するクラスEJ_OccupancyGridの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJOCCUPANCYGRID
+#define EJOCCUPANCYGRID
+#include <Arduino.h>
+#include "EJ_Odometry.h"
+
+/**
+ * @brief 未観測のセルの値 (対数オッズ 0)
+ */
+#define EJ_OCCUPANCY_UNKNOWN 8
+
+/**
+ * @brief widthBits + heightBitsの上限 (ビルドフラグで変更できる)
+ * @details 既定値16は幅256, 高さ256 (32KB) に相当する。PSRAMを使う場合などに大きくする
+ */
+#ifndef EJ_OCCUPANCY_MAX_CELL_BITS
+#define EJ_OCCUPANCY_MAX_CELL_BITS 16
+#endif
+
+/**
+ * @brief 占有格子地図のエクスポート形式のバージョン
+ */
+#define EJ_OCCUPANCY_EXPORT_VERSION 1
+
+/**
+ * @brief バイト列を出力するコールバック関数の型
+ * @param data 出力するデータ
+ * @param size 出力するデータのサイズ
+ * @param context 呼び出し元が指定した任意のポインタ
+ * @return 出力したサイズ
+ */
+typedef size_t (*EJ_WriteCallback)(const uint8_t *data, size_t size, void *context);
+
+/**
+ * @brief ロボット周辺の局所的な占有格子地図を保持するクラス
+ * @details 各セルは4bitの対数オッズ (0: 空き ~ 8: 未観測 ~ 15: 占有) で、1バイトに2セルを詰めて保持する。
+ * @details 格子は幅と高さが2のべき乗の環状バッファで、recenter()でロボットに追従させるときはデータを複製せず、窓から外れた行と列だけを未観測に戻す。
+ * @details 測距値の反映は整数のBresenhamアルゴリズムで光線上のセルを走査して行う
+ */
+class EJ_OccupancyGrid
+{
+public:
+    /**
+     * @brief EJ_OccupancyGridクラスのコンストラクタ
+     * @details 幅256, 高さ256の場合のメモリ使用量は32KB。widthBits + heightBitsがEJ_OCCUPANCY_MAX_CELL_BITSを超える場合や、メモリの確保に失敗した場合は格子を持たない
+     * @param widthBits 幅のセル数の2を底とする対数 (例: 8 → 256セル)
+     * @param heightBits 高さのセル数の2を底とする対数
+     * @param resolution 1セルの大きさ (単位: mm)
+     */
+    EJ_OccupancyGrid(uint8_t widthBits = 8, uint8_t heightBits = 8, uint16_t resolution = 50);
+
+    /**
+     * @brief EJ_OccupancyGridクラスのデストラクタ
+     */
+    ~EJ_OccupancyGrid();
+
+public:
+    /**
+     * @brief 1回の観測でセルの値を変化させる量を設定する
+     * @param hit 障害物を検出したセルに加算する値 (default: 2)
+     * @param miss 光線が通過したセルから減算する値 (default: 1)
+     */
+    void setUpdateWeights(uint8_t hit, uint8_t miss);
+
+    /**
+     * @brief 反映する最大距離を設定する
+     * @details これより遠い測距値や無効な測距値は、最大距離まで光線が通過したものとして空きのみ反映する
+     * @param maxRange 最大距離 (単位: mm, default: 2000)
+     */
+    void setMaxRange(uint16_t maxRange);
+
+    /**
+     * @brief すべてのセルを未観測に戻す
+     */
+    void clear();
+
+    /**
+     * @brief 地図の中心をロボットの位置に追従させる
+     * @details ロボットの位置が中心から幅または高さの1/4以上離れた場合に窓を移動する
+     * @param x ロボットのX座標 (単位: mm)
+     * @param y ロボットのY座標 (単位: mm)
+     * @return true: 窓を移動した / false: 移動しなかった
+     */
+    bool recenter(float x, float y);
+
+    /**
+     * @brief 1回の測距値を地図に反映する
+     * @param pose ロボットの位置姿勢
+     * @param mount ロボット座標系におけるセンサの取り付け位置姿勢
+     * @param range 距離 (単位: mm)
+     * @param valid 測距値が有効かどうか (default: true)
+     */
+    void integrateRange(const Pose2D &pose, const Pose2D &mount, uint16_t range, bool valid = true);
+
+    /**
+     * @brief 2つのセル間の光線を地図に反映する
+     * @param x0 始点のX座標 (単位: セル)
+     * @param y0 始点のY座標 (単位: セル)
+     * @param x1 終点のX座標 (単位: セル)
+     * @param y1 終点のY座標 (単位: セル)
+     * @param hit true: 終点で障害物を検出した / false: 終点まで空き
+     */
+    void integrateRay(int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool hit);
+
+    /**
+     * @brief セルの値を取得する
+     * @param cx セルのX座標 (単位: セル)
+     * @param cy セルのY座標 (単位: セル)
+     * @return セルの値 (0~15, 窓の外の場合はEJ_OCCUPANCY_UNKNOWN)
+     */
+    uint8_t getCell(int32_t cx, int32_t cy);
+
+    /**
+     * @brief 座標を含むセルの値を取得する
+     * @param x X座標 (単位: mm)
+     * @param y Y座標 (単位: mm)
+     * @return セルの値 (0~15, 窓の外の場合はEJ_OCCUPANCY_UNKNOWN)
+     */
+    uint8_t getCellAt(float x, float y);
+
+    /**
+     * @brief 座標をセル座標に変換する
+     * @param value 座標 (単位: mm)
+     * @return セル座標
+     */
+    int32_t toCell(float value);
+
+    /**
+     * @brief 地図を圧縮形式で出力する
+     * @details 形式 (リトルエンディアン): "EJOG"(4) バージョン(1) widthBits(1) heightBits(1) 予約(1) 解像度mm(2) 予約(2) 原点X(4) 原点Y(4) に続き、
+     * 原点から行優先で並べた4bitセル (下位ニブルが偶数番目) の列を {連続数(1~255), 値} のランレングス符号で出力する
+     * @param write 出力先のコールバック関数
+     * @param context コールバック関数に渡す任意のポインタ
+     * @return 出力したバイト数
+     */
+    size_t exportTo(EJ_WriteCallback write, void *context);
+
+    /**
+     * @brief 幅を取得する (単位: セル)
+     */
+    uint16_t getWidth();
+
+    /**
+     * @brief 高さを取得する (単位: セル)
+     */
+    uint16_t getHeight();
+
+    /**
+     * @brief 1セルの大きさを取得する (単位: mm)
+     */
+    uint16_t getResolution();
+
+    /**
+     * @brief 窓の原点 (左下のセル) のX座標を取得する (単位: セル)
+     */
+    int32_t getOriginX();
+
+    /**
+     * @brief 窓の原点 (左下のセル) のY座標を取得する (単位: セル)
+     */
+    int32_t getOriginY();
+
+    /**
+     * @brief セルの格納に使用しているメモリのサイズを取得する (単位: byte, 格子を持たない場合は0)
+     */
+    size_t getMemorySize();
+
+private:
+    /**
+     * @brief セル座標に対応する環状バッファ上のセル番号を求める
+     */
+    uint32_t indexOf(int32_t cx, int32_t cy);
+
+    /**
+     * @brief セル座標が窓の中にあるかどうか判定する
+     */
+    bool contains(int32_t cx, int32_t cy);
+
+    /**
+     * @brief セルの値に加算する (0~15で飽和)
+     * @param index 環状バッファ上のセル番号
+     * @param delta 加算する値
+     */
+    void addCell(uint32_t index, int8_t delta);
+
+    /**
+     * @brief セルの値を設定する
+     * @param index 環状バッファ上のセル番号
+     * @param value 設定する値
+     */
+    void setCell(uint32_t index, uint8_t value);
+
+private:
+    static const char* _classname;
+    uint8_t _widthBits;
+    uint8_t _heightBits;
+    uint16_t _resolution;
+    uint8_t *_cells;
+    int32_t _originX;
+    int32_t _originY;
+    uint8_t _hit;
+    uint8_t _miss;
+    uint16_t _maxRange;
+};
+
+#endif // EJOCCUPANCYGRID
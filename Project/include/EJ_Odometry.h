@@ -0,0 +1,95 @@
+/**
+ * @file           EJ_Odometry.h
+ * @brief          エンコーダ付きモーターのカウントから差動二輪ロボットの位置姿勢を推定するクラスEJ_Odometryの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJODOMETRY
+#define EJODOMETRY
+#include <Arduino.h>
+
+/**
+ * @struct Pose2D
+ * @brief 平面上の位置姿勢を表す構造体
+ */
+typedef struct
+{
+    float x;     /**< X座標 (単位: mm) */
+    float y;     /**< Y座標 (単位: mm) */
+    float theta; /**< 向き (単位: rad, X軸正方向が0で反時計回りが正) */
+} Pose2D;
+
+/**
+ * @brief 差動二輪ロボットのオドメトリを計算するクラス
+ * @details 左右のエンコーダの累積カウントをupdate()に与えると、前回からの差分で位置姿勢を積算する
+ */
+class EJ_Odometry
+{
+public:
+    /**
+     * @brief EJ_Odometryクラスのコンストラクタ
+     * @param countsPerMm 車輪が1mm進むあたりのエンコーダのカウント数
+     * @param trackWidth 左右の車輪間距離 (単位: mm)
+     */
+    EJ_Odometry(float countsPerMm, float trackWidth);
+
+    /**
+     * @brief EJ_Odometryクラスのデストラクタ
+     */
+    ~EJ_Odometry();
+
+public:
+    /**
+     * @brief 位置姿勢とエンコーダの基準カウントを設定する
+     * @param pose 位置姿勢
+     * @param leftCount 左エンコーダの現在のカウント
+     * @param rightCount 右エンコーダの現在のカウント
+     */
+    void reset(const Pose2D &pose, long leftCount, long rightCount);
+
+    /**
+     * @brief エンコーダのカウントから位置姿勢を更新する
+     * @param leftCount 左エンコーダの現在のカウント
+     * @param rightCount 右エンコーダの現在のカウント
+     * @return 更新後の位置姿勢
+     */
+    const Pose2D &update(long leftCount, long rightCount);
+
+    /**
+     * @brief 現在の位置姿勢を取得する
+     */
+    const Pose2D &getPose();
+
+private:
+    static const char* _classname;
+    float _countsPerMm;
+    float _trackWidth;
+    long _leftCount;
+    long _rightCount;
+    Pose2D _pose;
+};
+
+#endif // EJODOMETRY
@@ -0,0 +1,238 @@
+/**
+ * @file           EJ_PCA9685.h
+ * @brief          PCA9685 (16チャンネルI2C PWMドライバ) を制御するEJ_PCA9685クラスと、EJ_PCA9685クラスを管理するEJ_PCA9685_Managerクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJPCA9685
+#define EJPCA9685
+#include <Arduino.h>
+#include <Wire.h>
+#include "EJ_Manager.h"
+
+/**
+ * @brief EJ_PCA9685の最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_PCA9685_MAX_INSTANCES
+#define EJ_PCA9685_MAX_INSTANCES 4
+#endif
+
+/**
+ * @brief PCA9685のチャンネル数
+ */
+#define EJ_PCA9685_CHANNELS 16
+
+/**
+ * @brief I2CHubを経由しないことを表す値
+ */
+#define EJ_PCA9685_NO_HUB 0xFF
+
+/**
+ * @struct PCA9685Def
+ * @brief 1つのPCA9685を定義する構造体
+ */
+typedef struct
+{
+    uint8_t address;    /**< PCA9685のI2Cアドレス */
+    uint8_t id;         /**< PCA9685の識別番号 */
+    uint8_t hubId;      /**< 接続先のEJ_I2CHubの識別番号 (EJ_PCA9685_NO_HUB: 直結) */
+    uint8_t hubChannel; /**< 接続先のEJ_I2CHubのチャンネル */
+} PCA9685Def;
+
+/**
+ * @brief PCA9685を制御するクラス
+ * @attention *本クラスのインスタンスはEJ_PCA9685_Managerクラス以外からは生成できない
+ * @details 各チャンネルの出力はシャドウレジスタに書き込まれ、flush()を呼び出したときに変更のあったチャンネルだけがI2Cで送信される。
+ * @details 連続する変更チャンネルはオートインクリメントを用いた1回のバースト転送にまとめる。PCA9685はSTOPコンディションで出力を更新するため、1回のバーストに含まれるチャンネルは同時に切り替わる
+ */
+class EJ_PCA9685
+{
+private:
+    /**
+     * @brief EJ_PCA9685クラスのコンストラクタ
+     * @param address I2Cアドレス
+     * @param hubId 接続先のEJ_I2CHubの識別番号 (EJ_PCA9685_NO_HUB: 直結)
+     * @param hubChannel 接続先のEJ_I2CHubのチャンネル
+     */
+    EJ_PCA9685(uint8_t address, uint8_t hubId, uint8_t hubChannel);
+
+    friend class EJ_PCA9685_Manager;
+    template <typename, size_t> friend class EJ_Manager;
+
+public:
+    /**
+     * @brief EJ_PCA9685クラスのデストラクタ
+     * @details 全チャンネルの出力を停止する
+     */
+    ~EJ_PCA9685();
+
+public:
+    /**
+     * @brief 内蔵発振器の周波数を設定する
+     * @details 個体差の補正に用いる。次回のsetFrequency()から反映される
+     * @param hz 発振器の周波数 (単位: Hz, default: 25000000)
+     */
+    void setOscillatorFrequency(uint32_t hz);
+
+    /**
+     * @brief PWMの周波数を設定する
+     * @details 設定中は一時的にスリープモードに入るため、全チャンネルの出力が停止する
+     * @param hz PWMの周波数 (単位: Hz, 24~1526)
+     * @return true: 設定成功 / false: 設定失敗
+     */
+    bool setFrequency(float hz);
+
+    /**
+     * @brief 設定されているPWMの周波数を取得する
+     * @return PWMの周波数 (単位: Hz)
+     */
+    float getFrequency();
+
+    /**
+     * @brief チャンネルのON/OFFタイミングを設定する (シャドウレジスタに書き込む)
+     * @param channel チャンネル (0~15)
+     * @param on 出力をHighにするカウント (0~4095)
+     * @param off 出力をLowにするカウント (0~4095)
+     */
+    void setPWM(uint8_t channel, uint16_t on, uint16_t off);
+
+    /**
+     * @brief チャンネルのパルス幅を設定する (シャドウレジスタに書き込む)
+     * @param channel チャンネル (0~15)
+     * @param us パルス幅 (単位: us, 0: 出力停止)
+     */
+    void setPulseWidth(uint8_t channel, uint16_t us);
+
+    /**
+     * @brief 変更のあったチャンネルをPCA9685に送信する
+     * @return true: 送信成功 / false: 送信失敗 (失敗したチャンネルは次回再送される)
+     */
+    bool flush();
+
+    /**
+     * @brief 未送信の変更があるかどうか判定する
+     * @return true: 未送信の変更がある / false: ない
+     */
+    bool isDirty();
+
+private:
+    /**
+     * @brief EJ_I2CHubを経由する場合、接続先のチャンネルを選択する
+     * @return true: 選択成功 / false: 選択失敗
+     */
+    bool selectBus();
+
+    /**
+     * @brief 1バイトのレジスタに書き込む
+     * @param reg レジスタアドレス
+     * @param value 書き込む値
+     * @return true: 書き込み成功 / false: 書き込み失敗
+     */
+    bool writeRegister(uint8_t reg, uint8_t value);
+
+private:
+    static const char* _classname;
+    bool _error;
+    uint8_t _address;
+    uint8_t _hubId;
+    uint8_t _hubChannel;
+    uint32_t _oscillator;
+    float _frequency;
+    uint32_t _countsPerUs; /**< 1usあたりのカウント数 (Q16固定小数点) */
+    uint16_t _on[EJ_PCA9685_CHANNELS];
+    uint16_t _off[EJ_PCA9685_CHANNELS];
+    uint16_t _dirty;
+#ifdef ARDUINO_ARCH_ESP32
+    portMUX_TYPE _mux;
+#endif
+};
+
+/**
+ * @brief EJ_PCA9685クラスのインスタンスを生成、管理するクラス
+ * @details 本クラスはインスタンス化せず、EJ_PCA9685クラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_PCA9685_MAX_INSTANCES個まで生成される
+ */
+class EJ_PCA9685_Manager : public EJ_Manager<EJ_PCA9685, EJ_PCA9685_MAX_INSTANCES>
+{
+private:
+    /**
+     * @brief EJ_PCA9685_Managerクラスはインスタンス化しない
+     */
+    EJ_PCA9685_Manager();
+
+public:
+    /**
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_PCA9685_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_PCA9685の最大インスタンス数
+     * @return true: EJ_PCA9685_MAX_INSTANCES以下 / false: EJ_PCA9685_MAX_INSTANCESを超える
+     */
+    static bool configure(size_t maxInstanceSize);
+
+    /**
+     * @brief EJ_PCA9685クラスのインスタンスを生成する
+     * @details 生成したインスタンスはgetPCA9685関数で取得できるように静的な領域に生成する
+     * @param PCA9685Def 参照
+     * @param frequency PWMの周波数 (単位: Hz, default: 50)
+     * @return EJ_PCA9685クラスのインスタンスを指すポインタ
+     */
+    static EJ_PCA9685 *createPCA9685(PCA9685Def pca9685, float frequency = 50.0f);
+
+    /**
+     * @brief EJ_PCA9685クラスのインスタンスを生成する
+     * @details 生成したインスタンスはgetPCA9685関数で取得できるように静的な領域に生成する
+     * @param id PCA9685の識別番号
+     * @param address PCA9685のI2Cアドレス (default: 0x40)
+     * @param frequency PWMの周波数 (単位: Hz, default: 50)
+     * @param hubId 接続先のEJ_I2CHubの識別番号 (default: EJ_PCA9685_NO_HUB)
+     * @param hubChannel 接続先のEJ_I2CHubのチャンネル (default: 0)
+     * @return EJ_PCA9685クラスのインスタンスを指すポインタ (初期化または周波数の設定に失敗した場合はNULL)
+     */
+    static EJ_PCA9685 *createPCA9685(uint8_t id, uint8_t address = 0x40, float frequency = 50.0f, uint8_t hubId = EJ_PCA9685_NO_HUB, uint8_t hubChannel = 0);
+
+    /**
+     * @brief EJ_PCA9685クラスのインスタンスを取得する
+     * @details createPCA9685関数で生成したEJ_PCA9685クラスのインスタンスを取得し返す。指定したidのインスタンスが生成されていない場合や取得に失敗した場合はNULLを返す。
+     * @param id PCA9685の識別番号
+     * @return EJ_PCA9685クラスのインスタンスを指すポインタ
+     */
+    static EJ_PCA9685 *getPCA9685(uint8_t id);
+
+    /**
+     * @brief 全てのEJ_PCA9685の変更を送信する
+     * @details EJ_ServoMotor_Manager::update()から毎回呼び出される。EJ_PCA9685を1つも生成していない場合は何もしない
+     * @return true: 全て送信成功 / false: 送信に失敗したPCA9685があった
+     */
+    static bool flush();
+
+private:
+    static const char* _classname;
+};
+
+/* EJ_Managerのエラーに出力するクラス名 (EJ_PCA9685.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_PCA9685, EJ_PCA9685_MAX_INSTANCES>::_classname;
+
+#endif // EJPCA9685
@@ -0,0 +1,144 @@
+/**
+ * @file           EJ_Peripheral.h
+ * @brief          LEDC, RMT, PCNT, MCPWM, ハードウェアタイマのチャンネルを一元管理するクラスEJ_Peripheralの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJPERIPHERAL
+#define EJPERIPHERAL
+#include <Arduino.h>
+
+/**
+ * @brief 周辺機能のチャンネル数 (ESP32)
+ */
+#define EJ_LEDC_CHANNELS 16
+#define EJ_LEDC_TIMERS 8
+#define EJ_RMT_CHANNELS 8
+#define EJ_PCNT_UNITS 8
+#define EJ_MCPWM_TIMERS 6
+#define EJ_HW_TIMERS 4
+
+/**
+ * @brief 管理する周辺機能の種類
+ */
+enum EJ_PeripheralType
+{
+    EJ_PERIPHERAL_LEDC,       /**< LEDCチャンネル (0~15) */
+    EJ_PERIPHERAL_LEDC_TIMER, /**< LEDCタイマ (0~7, チャンネル2n, 2n+1が共有する) */
+    EJ_PERIPHERAL_RMT,        /**< RMTチャンネル (0~7) */
+    EJ_PERIPHERAL_PCNT,       /**< パルスカウンタのユニット (0~7) */
+    EJ_PERIPHERAL_MCPWM,      /**< MCPWMのタイマ (0~5, ユニットn/3のタイマn%3) */
+    EJ_PERIPHERAL_TIMER,      /**< ハードウェアタイマ (0~3) */
+    EJ_PERIPHERAL_TYPES
+};
+
+/**
+ * @brief 周辺機能のチャンネルとタイマを一元管理するクラス
+ * @details 本ライブラリのデバイスクラスはLEDC, RMTなどのチャンネルを直接選ばず、本クラスから割り当てを受ける。チャンネルが足りない場合は割り当てに失敗し、デバイスの生成も失敗する
+ * @details Arduino-ESP32ではLEDCのチャンネル2nと2n+1が同じタイマを共有するため、ledcSetup()を別の周波数で呼ぶと対になるチャンネルの周波数も変わってしまう。allocateLEDC()は周波数と分解能が同じチャンネルを同じタイマにまとめ、異なる周波数のチャンネルが同じタイマに乗らないようにする
+ * @details ライブラリの外で固定のチャンネルを使う場合は、reserve()で予約しておくと割り当ての対象から外れる
+ * @details 本クラスはインスタンス化しない
+ */
+class EJ_Peripheral
+{
+private:
+    EJ_Peripheral();
+
+public:
+    /**
+     * @brief 周波数と分解能を指定してLEDCチャンネルを割り当て、ledcSetup()で設定する
+     * @details 同じ周波数と分解能で使用中のタイマに空きチャンネルがあればそれを使い、無ければ未使用のタイマのチャンネルを使う
+     * @param frequency PWM周波数 (単位: Hz)
+     * @param resolution 分解能 (単位: bit)
+     * @return 割り当てたチャンネル (-1: 割り当て失敗)
+     */
+    static int8_t allocateLEDC(uint32_t frequency, uint8_t resolution);
+
+    /**
+     * @brief RMT, PCNT, MCPWM, ハードウェアタイマのうち空いているものを1つ割り当てる
+     * @param type 周辺機能の種類 (EJ_PERIPHERAL_LEDC, EJ_PERIPHERAL_LEDC_TIMERは指定できない)
+     * @return 割り当てた番号 (-1: 割り当て失敗)
+     */
+    static int8_t allocate(EJ_PeripheralType type);
+
+    /**
+     * @brief 指定した番号を予約する
+     * @details LEDCチャンネルを予約した場合、そのタイマは他の周波数と共有されない
+     * @param type 周辺機能の種類 (EJ_PERIPHERAL_LEDC_TIMERは指定できない)
+     * @param index 予約する番号
+     * @return true: 予約成功 / false: 使用中または範囲外
+     */
+    static bool reserve(EJ_PeripheralType type, uint8_t index);
+
+    /**
+     * @brief 割り当てまたは予約した番号を解放する
+     * @param type 周辺機能の種類 (EJ_PERIPHERAL_LEDC_TIMERは指定できない)
+     * @param index 解放する番号 (負の値は無視する)
+     */
+    static void release(EJ_PeripheralType type, int8_t index);
+
+    /**
+     * @brief 使用中の数を取得する
+     * @param type 周辺機能の種類
+     */
+    static uint8_t getUsage(EJ_PeripheralType type);
+
+    /**
+     * @brief 搭載されている数を取得する
+     * @param type 周辺機能の種類
+     */
+    static uint8_t getCapacity(EJ_PeripheralType type);
+
+    /**
+     * @brief LEDCチャンネルに設定した周波数を取得する
+     * @param channel LEDCチャンネル
+     * @return 周波数 (単位: Hz, 0: 未使用または予約)
+     */
+    static uint32_t getLEDCFrequency(uint8_t channel);
+
+    /**
+     * @brief 全ての周辺機能の使用状況を出力する
+     * @param out 出力先 (Serial, M5.Lcdなど)
+     */
+    static void printUsage(Print &out);
+
+private:
+    /**
+     * @brief 使用中のビットマスクを取得する (EJ_PERIPHERAL_LEDC_TIMERはチャンネルのマスクから求める)
+     */
+    static uint16_t usedMask(EJ_PeripheralType type);
+
+private:
+    static const char* _classname;
+    static uint16_t _used[EJ_PERIPHERAL_TYPES];         /**< 使用中の番号のビットマスク */
+    static uint32_t _ledcFrequency[EJ_LEDC_TIMERS];     /**< LEDCタイマの周波数 (単位: Hz, 0: 予約) */
+    static uint8_t _ledcResolution[EJ_LEDC_TIMERS];     /**< LEDCタイマの分解能 (単位: bit) */
+#ifdef ARDUINO_ARCH_ESP32
+    static portMUX_TYPE _mux;
+#endif
+};
+
+#endif // EJPERIPHERAL
@@ -30,6 +30,15 @@
 #ifndef EJPHOTOINTERRUPTER
 #define EJPHOTOINTERRUPTER
 #include <Arduino.h>
+#include "EJ_Manager.h"
+#include "EJ_Device.h"
+
+/**
+ * @brief EJ_PhotoInterrupterの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_PHOTOINTERRUPTER_MAX_INSTANCES
+#define EJ_PHOTOINTERRUPTER_MAX_INSTANCES 8
+#endif
 
 /**
  * @struct PhotoInterrupterDef
@@ -45,7 +54,7 @@ typedef struct
  * @brief フォトインタラプタを制御するクラス
  * @details *注意:本クラスのインスタンスはEJ_PhotoInterrupter_Managerクラス以外からは生成できない
  */
-class EJ_PhotoInterrupter
+class EJ_PhotoInterrupter : public EJ_BinarySensor<EJ_PhotoInterrupter>
 {
 protected:
     /**
@@ -55,6 +64,13 @@ protected:
     EJ_PhotoInterrupter(uint8_t pin = 0);
 
     friend class EJ_PhotoInterrupter_Manager;
+    template <typename, size_t> friend class EJ_Manager;
+    friend class EJ_BinarySensor<EJ_PhotoInterrupter>;
+
+    /**
+     * @brief EJ_BinarySensorの状態 (true: 遮断された) を取得する
+     */
+    bool readState() { return isInterrupted(); }
 
 private:
 
@@ -71,6 +87,13 @@ public:
      */
     bool isInterrupted();
 
+    /**
+     * @brief 遮断されたかどうかを記録せずに判定する
+     * @details 状態の問い合わせ (EJ_Commandの応答など) に使う。EJ_SensorLogの記録中も値を記録しないため、記録されるレコードの並びを変えない
+     * @return true: 遮断された / false: 遮断されていない
+     */
+    bool peek();
+
 private:
     static const char* _classname;
     uint8_t _pin;
@@ -78,43 +101,28 @@ private:
 
 /**
  * @brief EJ_PhotoInterrupterクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_PhotoInterrupterクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_PHOTOINTERRUPTER_MAX_INSTANCES個まで生成される
  */
-class EJ_PhotoInterrupter_Manager
+class EJ_PhotoInterrupter_Manager : public EJ_Manager<EJ_PhotoInterrupter, EJ_PHOTOINTERRUPTER_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_PhotoInterrupter_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_PhotoInterrupterの最大インスタンス数の定義
+     * @brief EJ_PhotoInterrupter_Managerクラスはインスタンス化しない
      */
-    EJ_PhotoInterrupter_Manager(size_t maxInstanceSize);
-
-private:
-    /**
-     * @brief EJ_PhotoInterrupter_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_PhotoInterrupter_Managerのsingletonを指すポインタ
-     */
-    static EJ_PhotoInterrupter_Manager* getInstance();
+    EJ_PhotoInterrupter_Manager();
 
 public:
     /**
-     * @brief EJ_PhotoInterrupter_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_PhotoInterrupterクラスのインスタンスをすべて解放する
-     */
-    ~EJ_PhotoInterrupter_Manager();
-
-public:
-    /**
-     * @brief EJ_PhotoInterrupter_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_PhotoInterrupterの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_PHOTOINTERRUPTER_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_PhotoInterrupterの最大インスタンス数
+     * @return true: EJ_PHOTOINTERRUPTER_MAX_INSTANCES以下 / false: EJ_PHOTOINTERRUPTER_MAX_INSTANCESを超える
      */
     static bool configure(size_t maxInstanceSize);
 
     /**
      * @brief EJ_PhotoInterrupterクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetPhotoInterrupter関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetPhotoInterrupter関数で取得できるように静的な領域に生成する
      * @param PhotoInterrupterDef 参照
      * @return EJ_PhotoInterrupterクラスのインスタンスを指すポインタ
      */
@@ -122,7 +130,7 @@ public:
 
     /**
      * @brief EJ_PhotoInterrupterクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetPhotoInterrupter関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetPhotoInterrupter関数で取得できるように静的な領域に生成する
      * @param pin フォトインタラプタの接続ピン
      * @param id フォトインタラプタの識別番号
      * @return EJ_PhotoInterrupterクラスのインスタンスを指すポインタ
@@ -147,9 +155,10 @@ public:
 
 private:
     static const char* _classname;
-    static EJ_PhotoInterrupter_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_PhotoInterrupter **_instanceList;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_PhotoInterrupter.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_PhotoInterrupter, EJ_PHOTOINTERRUPTER_MAX_INSTANCES>::_classname;
+
 #endif // EJPHOTOINTERRUPTER
\ No newline at end of file
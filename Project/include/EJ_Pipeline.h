@@ -0,0 +1,168 @@
+/**
+ * @file           EJ_Pipeline.h
+ * @brief          センサの取得と制御を別のコアで行うためのEJ_Pipelineクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJPIPELINE
+#define EJPIPELINE
+#include <Arduino.h>
+#include "EJ_Seqlock.h"
+#include "EJ_EncoderMotor.h"
+#include "EJ_PhotoInterrupter.h"
+#include "EJ_ToFUnit.h"
+
+/**
+ * @brief 1つのフレームに含めるエンコーダ、フォトインタラプタ、ToFユニットの最大数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_PIPELINE_MAX_ENCODERS
+#define EJ_PIPELINE_MAX_ENCODERS 4
+#endif
+#ifndef EJ_PIPELINE_MAX_PHOTOINTERRUPTERS
+#define EJ_PIPELINE_MAX_PHOTOINTERRUPTERS 8
+#endif
+#ifndef EJ_PIPELINE_MAX_TOFUNITS
+#define EJ_PIPELINE_MAX_TOFUNITS 4
+#endif
+
+/**
+ * @brief 取得タスクのスタックサイズ (単位: byte) と優先度 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_PIPELINE_STACK_SIZE
+#define EJ_PIPELINE_STACK_SIZE 4096
+#endif
+#ifndef EJ_PIPELINE_PRIORITY
+#define EJ_PIPELINE_PRIORITY 10
+#endif
+
+/**
+ * @struct SensorFrame
+ * @brief 取得段が1回の取得で作るセンサ値の組 (時刻の単位: us, micros())
+ */
+typedef struct
+{
+    uint32_t sequence;                                /**< フレームの通し番号 */
+    uint32_t timestamp;                               /**< フレームを公開した時刻 */
+    int32_t encoders[EJ_PIPELINE_MAX_ENCODERS];       /**< エンコーダのカウント */
+    uint32_t encoderTime;                             /**< エンコーダを読み出した時刻 */
+    uint32_t photoStates;                             /**< フォトインタラプタの状態 (bit n: n番目, 1: 遮光) */
+    uint32_t photoTime;                               /**< フォトインタラプタを読み出した時刻 */
+    uint16_t ranges[EJ_PIPELINE_MAX_TOFUNITS];        /**< 最新の距離 (単位: mm) */
+    uint8_t rangeStatus[EJ_PIPELINE_MAX_TOFUNITS];    /**< 最新の測距ステータス (11: 正常) */
+    uint32_t rangeTime[EJ_PIPELINE_MAX_TOFUNITS];     /**< 最新の測距結果を取得した時刻 (0: 未取得) */
+    uint8_t encoderCount;                             /**< 有効なエンコーダの数 */
+    uint8_t photoCount;                               /**< 有効なフォトインタラプタの数 */
+    uint8_t tofCount;                                 /**< 有効なToFユニットの数 */
+} SensorFrame;
+
+/**
+ * @brief センサの取得段と制御段をつなぐクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details 取得段 (既定ではコア0のタスク) が登録されたエンコーダ、フォトインタラプタ、ToFユニットを読み、SensorFrameをEJ_Seqlockで公開する。制御段 (コア1のloop()やEJ_Executiveの周期処理) はgetSnapshot()で一貫したフレームをコピーして使う
+ * @details ToFユニットはpoll()で進めるため、取得段がI2Cの完了を待つことはあっても制御段は待たない。ToFユニットの通信はEJ_I2CBusのロックの中で行う
+ * @details start()すると登録したToFユニットのpoll()とread()は取得タスクからしか呼べなくなる (EJ_ToFUnit::setOwner())。制御段は測距結果をフレームから読む
+ */
+class EJ_Pipeline
+{
+private:
+    /**
+     * @brief EJ_Pipelineクラスはインスタンス化しない
+     */
+    EJ_Pipeline();
+
+public:
+    /**
+     * @brief エンコーダを登録する
+     * @details EJ_EncoderMotor::read()で読むため、EJ_SensorLogの記録と再生の対象になる
+     * @return フレーム内の番号 (負値: 登録できなかった)
+     */
+    static int8_t addEncoder(EJ_EncoderMotor *encoder);
+
+    /**
+     * @brief フォトインタラプタを登録する
+     * @return フレーム内の番号 (負値: 登録できなかった)
+     */
+    static int8_t addPhotoInterrupter(EJ_PhotoInterrupter *photoInterrupter);
+
+    /**
+     * @brief ToFユニットを登録する
+     * @return フレーム内の番号 (負値: 登録できなかった)
+     */
+    static int8_t addToFUnit(EJ_ToFUnit *tof);
+
+    /**
+     * @brief 取得段のタスクを起動する (ESP32のみ)
+     * @details 登録したToFユニットの所有者を取得タスクにする
+     * @param interval 取得の周期 (単位: ms)
+     * @param core タスクを固定するコア
+     * @return true: 起動した / false: 起動済み、またはタスクを生成できなかった
+     */
+    static bool start(uint32_t interval = 1, uint8_t core = 0);
+
+    /**
+     * @brief 取得段のタスクを停止する
+     * @details 登録したToFユニットの所有者の制限を解除する
+     */
+    static void stop();
+
+    /**
+     * @brief 取得を1回行い、フレームを公開する
+     * @details start()を使わない場合 (ホストなど) にloop()やEJ_Executiveの周期処理から呼ぶ
+     */
+    static void acquire();
+
+    /**
+     * @brief 最新のフレームを取得する
+     * @param frame フレームの格納先
+     * @return true: 取得した / false: まだフレームがない
+     */
+    static bool getSnapshot(SensorFrame &frame);
+
+    /**
+     * @brief 公開したフレームの数を取得する
+     */
+    static uint32_t getFrameCount();
+
+    /**
+     * @brief 読み出しが公開と重なって読み直した回数を取得する
+     */
+    static uint32_t getRetryCount();
+
+private:
+    static void taskMain(void *parameter);
+
+private:
+    static const char* _classname;
+    static EJ_EncoderMotor *_encoders[EJ_PIPELINE_MAX_ENCODERS];
+    static EJ_PhotoInterrupter *_photoInterrupters[EJ_PIPELINE_MAX_PHOTOINTERRUPTERS];
+    static EJ_ToFUnit *_tofUnits[EJ_PIPELINE_MAX_TOFUNITS];
+    static SensorFrame _frame;              /**< 取得段が組み立て中のフレーム */
+    static EJ_Seqlock<SensorFrame> _published;
+    static uint32_t _interval;
+    static void *_task;
+};
+
+#endif // EJPIPELINE
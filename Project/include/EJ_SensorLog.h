@@ -0,0 +1,225 @@
+/**
+ * @file           EJ_SensorLog.h
+ * @brief          センサの読み出し値を記録・再生するEJ_SensorLogクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSENSORLOG
+#define EJSENSORLOG
+#include <Arduino.h>
+
+/**
+ * @brief 記録・再生できるセンサの最大数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_SENSORLOG_MAX_CHANNELS
+#define EJ_SENSORLOG_MAX_CHANNELS 32
+#endif
+
+/**
+ * @brief 記録用バッファ1面の大きさ (単位: byte、ビルドフラグで変更できる)
+ * @details 2面を交互に使い、一杯になった面をupdate()で書き出す。書き出し先 (SDカードなど) の書き込み単位に合わせる
+ */
+#ifndef EJ_SENSORLOG_BUFFER_SIZE
+#define EJ_SENSORLOG_BUFFER_SIZE 512
+#endif
+
+/**
+ * @brief ログの形式の版数
+ */
+#define EJ_SENSORLOG_VERSION 2
+
+/**
+ * @enum EJ_SensorKind
+ * @brief 記録するセンサの種類
+ */
+typedef enum
+{
+    EJ_SENSORLOG_TOF = 0,          /**< EJ_ToFUnitの測距結果 (値: 距離 | 測距ステータス << 16, キー: 識別番号) */
+    EJ_SENSORLOG_ENCODER,          /**< EJ_EncoderMotor::read() (キー: エンコーダの接続ピン1) */
+    EJ_SENSORLOG_PHOTOINTERRUPTER, /**< EJ_PhotoInterrupter::isInterrupted() (キー: 接続ピン) */
+    EJ_SENSORLOG_KINDS
+} EJ_SensorKind;
+
+/**
+ * @brief センサの読み出し値をタイムスタンプとともに記録し、ホストで同じクラスを通して再生するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details 記録中はEJ_ToFUnit::poll()が得た測距結果と、EJ_EncoderMotor::read(), EJ_PhotoInterrupter::isInterrupted()が読み出した値を記録する。再生中はこれらのメソッドがデバイスにアクセスせず、記録した値を返す。EJ_ToFUnit::poll()は記録した時刻に達した測距結果だけを記録した順に返すため、EJ_ToFScannerやEJ_Pipelineも記録と同じ順に測距結果を受け取る。エンコーダとフォトインタラプタは現在時刻までに記録された最新の値を返すため、読み出す回数が記録時と違っても値の並びがずれない
+ * @details ログの形式: ヘッダ ('E','J','R','L', 版数, 開始時刻 (u32)) に続けて次のレコードを並べる。数値は可変長 (LEB128) で、値の差分はzigzag符号化する
+ * - センサの定義: 0xFF, 種類 (u8), キー (u8)。定義した順にチャンネル番号 0, 1, ... を割り当てる
+ * - 値: チャンネル番号 (u8), 前のレコードからの経過時間 (us), 同じチャンネルの前の値との差分
+ * @details 再生中はmicros()などの時刻がdelay()の待ち時間と測距結果を記録した時刻で進み (ホストのみ)、ホストの実時間に依存しないため、同じスケッチは常に同じ結果になる
+ */
+class EJ_SensorLog
+{
+private:
+    /**
+     * @brief EJ_SensorLogクラスはインスタンス化しない
+     */
+    EJ_SensorLog();
+
+    typedef struct
+    {
+        uint8_t kind;
+        uint8_t key;
+        int32_t value;              /**< 記録: 最後に記録した値 / 再生: offsetまでの最後の値 */
+        size_t offset;              /**< 再生: 次に読むレコードの位置 */
+        uint32_t time;              /**< 再生: offsetまでの時刻 */
+    } Channel;
+
+public:
+    /**
+     * @brief 記録を開始し、ヘッダを書き出す
+     * @param out 書き出し先 (SDカードやSPIFFSのFileなど)
+     * @return true: 開始した / false: 再生中
+     */
+    static bool startRecording(Print &out);
+
+    /**
+     * @brief 記録を終了し、バッファに残ったレコードを書き出す
+     */
+    static void stopRecording();
+
+    /**
+     * @brief 一杯になったバッファを書き出す
+     * @details 制御周期の外 (loop()や低優先度のタスク) から呼ぶ。書き出しが間に合わない場合、レコードを捨ててgetDroppedCount()で数える
+     * @return 書き出した大きさ (単位: byte)
+     */
+    static size_t update();
+
+    /**
+     * @brief 再生を開始する
+     * @param log ログ (再生を終了するまで保持すること)
+     * @param size ログの大きさ
+     * @return true: 開始した / false: ログの形式が正しくない、または記録中
+     */
+    static bool startReplay(const uint8_t *log, size_t size);
+
+#ifdef EJ_NATIVE
+    /**
+     * @brief ファイルのログの再生を開始する (ホストのみ)
+     * @param path ログのパス
+     * @return true: 開始した / false: 読み込めない、またはログの形式が正しくない
+     */
+    static bool startReplay(const char *path);
+#endif
+
+    /**
+     * @brief 再生を終了する
+     */
+    static void stopReplay();
+
+    /**
+     * @brief 記録中かどうか判定する
+     */
+    static bool isRecording() { return _recording; }
+
+    /**
+     * @brief 再生中かどうか判定する
+     */
+    static bool isReplaying() { return _replaying; }
+
+    /**
+     * @brief いずれかのセンサが記録した値を使い切ったかどうか判定する
+     */
+    static bool isFinished();
+
+    /**
+     * @brief 記録したレコードの数を取得する
+     */
+    static uint32_t getRecordCount();
+
+    /**
+     * @brief バッファが一杯で捨てたレコードの数を取得する
+     */
+    static uint32_t getDroppedCount();
+
+    /**
+     * @brief 読み出した値を記録する (センサのクラスから呼ぶ)
+     * @param kind センサの種類
+     * @param key センサを区別するキー
+     * @param value 読み出した値
+     */
+    static void record(EJ_SensorKind kind, uint8_t key, int32_t value);
+
+    /**
+     * @brief 記録した次の値を取得する (センサのクラスから呼ぶ)
+     * @details 測距結果のように、1回の測定を1回だけ受け取るセンサに使う。時刻を次の値の時刻まで進める。値を使い切った場合は最後の値を返し、isFinished()がtrueになる
+     * @param kind センサの種類
+     * @param key センサを区別するキー
+     * @return 記録した値 (記録されていないセンサは0)
+     */
+    static int32_t replay(EJ_SensorKind kind, uint8_t key);
+
+    /**
+     * @brief 現在時刻までに記録された最新の値を取得する (センサのクラスから呼ぶ)
+     * @details エンコーダのように、いつ何回読んでもよいセンサに使う。時刻は進めない。最初の値の時刻より前は最初の値を返す。最後の値の時刻に達するとisFinished()がtrueになる
+     * @param kind センサの種類
+     * @param key センサを区別するキー
+     * @return 記録した値 (記録されていないセンサは0)
+     */
+    static int32_t replayLatest(EJ_SensorKind kind, uint8_t key);
+
+    /**
+     * @brief 記録した次の値の時刻に達しているかどうか判定する (センサのクラスから呼ぶ)
+     * @details 値は読み進めない。ポーリングで新しい値を得るセンサが、記録した時刻より前に値を返さないようにするために使う
+     * @param kind センサの種類
+     * @param key センサを区別するキー
+     * @return true: 次の値の時刻に達している / false: まだ達していない、または値を使い切った
+     */
+    static bool isDue(EJ_SensorKind kind, uint8_t key);
+
+private:
+    static bool append(const uint8_t *data, size_t length);
+    static size_t writeVarint(uint8_t *data, uint32_t value);
+    static bool readVarint(size_t &offset, uint32_t &value);
+    static bool skipRecord(size_t &offset, uint8_t &tag, uint32_t &elapsed, int32_t &delta);
+    static bool nextRecord(uint8_t index, size_t &offset, uint32_t &time, int32_t &delta);
+    static int8_t findChannel(uint8_t kind, uint8_t key);
+    static uint64_t clock();
+    static void sleep(uint32_t us);
+
+private:
+    static const char* _classname;
+    static bool _recording;
+    static bool _replaying;
+    static bool _finished;
+    static Channel _channels[EJ_SENSORLOG_MAX_CHANNELS];
+    static uint8_t _channelCount;
+    static Print *_out;
+    static uint8_t _buffers[2][EJ_SENSORLOG_BUFFER_SIZE];
+    static size_t _lengths[2];
+    static uint8_t _active;                 /**< 記録中の面 */
+    static bool _pending;                   /**< 書き出し待ちの面 (_active ^ 1) がある */
+    static uint32_t _lastTime;
+    static uint32_t _records;
+    static uint32_t _dropped;
+    static const uint8_t *_log;
+    static size_t _size;
+    static uint8_t *_loaded;                /**< startReplay(path)で読み込んだログ */
+    static uint64_t _now;                   /**< 再生中の時刻 (単位: us) */
+};
+
+#endif // EJSENSORLOG
@@ -0,0 +1,130 @@
+/**
+ * @file           EJ_Seqlock.h
+ * @brief          1つの書き込み側と複数の読み出し側でデータを排他なしに受け渡すEJ_Seqlockクラステンプレートの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSEQLOCK
+#define EJSEQLOCK
+#include <Arduino.h>
+
+/**
+ * @brief キャッシュラインの大きさ (単位: byte)
+ * @details 他のデータと同じキャッシュラインを共有しないよう、EJ_Seqlockをこの大きさに揃えて配置する
+ */
+#ifndef EJ_CACHE_LINE
+#ifdef ARDUINO_ARCH_ESP32
+#define EJ_CACHE_LINE 32
+#else
+#define EJ_CACHE_LINE 64
+#endif
+#endif
+
+/**
+ * @brief 読み出しを諦めるまでの再試行回数の既定値
+ */
+#ifndef EJ_SEQLOCK_RETRIES
+#define EJ_SEQLOCK_RETRIES 16
+#endif
+
+/**
+ * @brief シーケンスロックでデータを受け渡すクラステンプレート
+ * @details 書き込み側は通し番号を奇数にしてからデータを書き、書き終えたら偶数にする。読み出し側はコピーの前後で通し番号が同じ偶数であることを確かめ、違えばコピーし直す
+ * @details 書き込み側は待たされず、読み出し側もミューテックスを使わないため、別のコアのタスクやISRとの間で使える。書き込み側は1つに限る
+ * @tparam T 受け渡すデータ (memcpyでコピーできる型)
+ */
+template <typename T>
+class alignas(EJ_CACHE_LINE) EJ_Seqlock
+{
+public:
+    EJ_Seqlock()
+    :   _sequence(0),
+        _retries(0)
+    {
+        memset(&_data, 0, sizeof(_data));
+    }
+
+    /**
+     * @brief データを書き込む
+     * @param data 書き込むデータ
+     */
+    void write(const T &data)
+    {
+        uint32_t sequence = __atomic_load_n(&_sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&_sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy((void *)&_data, &data, sizeof(T));
+        __atomic_store_n(&_sequence, sequence + 2, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief 一貫したデータを読み出す
+     * @param data 読み出したデータの格納先
+     * @param retries 書き込みと重なった場合に読み直す最大回数
+     * @return true: 読み出した / false: 一度も書き込まれていないか、書き込みと重なり続けた
+     */
+    bool read(T &data, uint8_t retries = EJ_SEQLOCK_RETRIES) const
+    {
+        for (uint8_t i = 0; i <= retries; i++) {
+            uint32_t before = __atomic_load_n(&_sequence, __ATOMIC_ACQUIRE);
+            if (before == 0) {
+                return false;
+            }
+            if ((before & 1) == 0) {
+                memcpy(&data, (const void *)&_data, sizeof(T));
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&_sequence, __ATOMIC_RELAXED) == before) {
+                    return true;
+                }
+            }
+            __atomic_fetch_add(&_retries, 1, __ATOMIC_RELAXED);
+        }
+        return false;
+    }
+
+    /**
+     * @brief 書き込まれた回数を取得する
+     */
+    uint32_t getVersion() const
+    {
+        return __atomic_load_n(&_sequence, __ATOMIC_ACQUIRE) / 2;
+    }
+
+    /**
+     * @brief 書き込みと重なって読み直した回数を取得する
+     */
+    uint32_t getRetryCount() const
+    {
+        return __atomic_load_n(&_retries, __ATOMIC_RELAXED);
+    }
+
+private:
+    uint32_t _sequence;
+    alignas(EJ_CACHE_LINE) T _data;
+    mutable uint32_t _retries; /**< 読み出し側が書き換えるため、_sequenceと別のキャッシュラインに置く */
+};
+
+#endif // EJSEQLOCK
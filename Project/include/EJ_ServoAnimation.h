@@ -0,0 +1,271 @@
+/**
+ * @file           EJ_ServoAnimation.h
+ * @brief          複数のサーボモーターを同期して動かすキーフレームアニメーションのクリップEJ_ServoClipクラスと、再生するEJ_ServoAnimationPlayerクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSERVOANIMATION
+#define EJSERVOANIMATION
+#include <Arduino.h>
+#include "EJ_ServoMotor.h"
+#ifdef ARDUINO_ARCH_ESP32
+#include <esp_partition.h>
+#endif
+
+/**
+ * @brief 1つのクリップが持てる最大チャンネル数
+ */
+#define EJ_ANIMATION_MAX_CHANNELS 16
+
+/**
+ * @brief キーフレーム形式のバージョン
+ */
+#define EJ_ANIMATION_FORMAT_VERSION 1
+
+/**
+ * @brief キーフレームアニメーションのクリップを表すクラス
+ * @details クリップのデータはメモリ上 (またはメモリマップしたフラッシュ上) のバイト列をそのまま参照し、ヒープに展開しない。
+ * @details 形式 (リトルエンディアン):
+ * - ヘッダ: "EJKF"(4) バージョン(1) チャンネル数N(1) 量子化幅(1, 単位: 0.01度, 1以上) 予約(1, 0) キーフレーム間隔(2, 単位: ms) キーフレーム数M(2)
+ * - チャンネル表: サーボの識別番号 × N (各1バイト)
+ * - 先頭キーフレーム: 角度 × N (各int16, 単位: 0.01度)
+ * - 差分キーフレーム: 直前のキーフレームとの差分 × N × (M-1) (各int8, 単位: 量子化幅)
+ */
+class EJ_ServoClip
+{
+public:
+    /**
+     * @brief EJ_ServoClipクラスのコンストラクタ
+     */
+    EJ_ServoClip();
+
+    /**
+     * @brief EJ_ServoClipクラスのデストラクタ
+     * @details openPartition()でマップしたフラッシュ領域はここで解放する
+     */
+    ~EJ_ServoClip();
+
+public:
+    /**
+     * @brief メモリ上のバイト列をクリップとして開く
+     * @details 開いているクリップ (openPartition()でマップしたフラッシュ領域を含む) は先に閉じる。ヘッダと全てのキーフレームの角度を検証してから開く
+     * @details バイト列はクリップを利用している間は保持されている必要がある。tools/servoclip_encode.pyでCSVから作成できる
+     * @param data クリップのバイト列
+     * @param size バイト列のサイズ
+     * @return true: 成功 / false: 形式が不正
+     */
+    bool open(const uint8_t *data, size_t size);
+
+#ifdef ARDUINO_ARCH_ESP32
+    /**
+     * @brief フラッシュのデータパーティションをメモリマップしてクリップとして開く
+     * @param label パーティションのラベル
+     * @return true: 成功 / false: パーティションが見つからないか形式が不正
+     */
+    bool openPartition(const char *label);
+#endif
+
+    /**
+     * @brief クリップが開かれているかどうか判定する
+     */
+    bool isOpen();
+
+    /**
+     * @brief チャンネル数を取得する
+     */
+    uint8_t getChannelCount();
+
+    /**
+     * @brief チャンネルが駆動するサーボの識別番号を取得する
+     * @param channel チャンネル番号
+     */
+    uint8_t getServoId(uint8_t channel);
+
+    /**
+     * @brief キーフレーム数を取得する
+     */
+    uint16_t getFrameCount();
+
+    /**
+     * @brief キーフレーム間隔を取得する (単位: ms)
+     */
+    uint16_t getFrameInterval();
+
+    /**
+     * @brief クリップの長さを取得する (単位: ms)
+     */
+    uint32_t getDuration();
+
+    /**
+     * @brief 2つのクリップのチャンネル構成が同じかどうか判定する
+     * @param other 比較するクリップ
+     */
+    bool isCompatible(EJ_ServoClip &other);
+
+    friend class EJ_ServoAnimationPlayer;
+
+private:
+    /**
+     * @brief バイト列を検証してクリップの各領域を設定する
+     * @param data クリップのバイト列
+     * @param size バイト列のサイズ
+     * @return true: 成功 / false: 形式が不正
+     */
+    bool load(const uint8_t *data, size_t size);
+
+    /**
+     * @brief 開いているクリップを閉じる
+     */
+    void close();
+
+private:
+    static const char* _classname;
+    const uint8_t *_data;
+    uint8_t _channelCount;
+    uint8_t _quantum;
+    uint16_t _frameInterval;
+    uint16_t _frameCount;
+    const uint8_t *_servoIds;
+    const uint8_t *_firstFrame;
+    const uint8_t *_deltas;
+#ifdef ARDUINO_ARCH_ESP32
+    spi_flash_mmap_handle_t _mmapHandle;
+    bool _mapped;
+#endif
+};
+
+/**
+ * @brief EJ_ServoClipを再生し、全チャンネルのサーボを同時に更新するクラス
+ * @details update()を呼び出すたびに全チャンネルのキーフレーム間を線形補間し、EJ_ServoMotor_Manager::writeFrame()でまとめて出力する。
+ * @details キーフレームは再生位置に合わせて先頭から逐次復号するため、ランダムアクセスは行わない
+ */
+class EJ_ServoAnimationPlayer
+{
+public:
+    /**
+     * @brief EJ_ServoAnimationPlayerクラスのコンストラクタ
+     */
+    EJ_ServoAnimationPlayer();
+
+    /**
+     * @brief EJ_ServoAnimationPlayerクラスのデストラクタ
+     */
+    ~EJ_ServoAnimationPlayer();
+
+public:
+    /**
+     * @brief クリップの再生を開始する
+     * @details 再生中のクリップとチャンネル構成が同じ場合、blendTimeの間は再生中のクリップから新しいクリップへ徐々に切り替える
+     * @param clip 再生するクリップ
+     * @param loop true: 繰り返し再生する / false: 1回だけ再生する
+     * @param blendTime 切り替えにかける時間 (単位: ms, 0: 即座に切り替える)
+     * @return true: 開始成功 / false: 開始失敗
+     */
+    bool play(EJ_ServoClip *clip, bool loop = false, uint32_t blendTime = 0);
+
+    /**
+     * @brief 再生を停止する (サーボは最後に出力した角度を保持する)
+     */
+    void stop();
+
+    /**
+     * @brief 再生を一時停止する
+     */
+    void pause();
+
+    /**
+     * @brief 一時停止した再生を再開する
+     */
+    void resume();
+
+    /**
+     * @brief 再生速度を設定する
+     * @param speed 再生速度の倍率 (0~255, 1.0: 等速)
+     */
+    void setSpeed(float speed);
+
+    /**
+     * @brief 再生を進めて全チャンネルのサーボを更新する
+     * @details サーボのフレーム周期 (20ms) ごとに呼び出す
+     * @return true: 再生中 / false: 停止中
+     */
+    bool update();
+
+    /**
+     * @brief 再生中かどうか判定する
+     */
+    bool isPlaying();
+
+    /**
+     * @brief 再生位置を取得する (単位: ms)
+     */
+    uint32_t getPosition();
+
+private:
+    /**
+     * @brief 1つのクリップの再生状態
+     */
+    typedef struct
+    {
+        EJ_ServoClip *clip;                       /**< 再生中のクリップ */
+        bool loop;                                /**< 繰り返し再生するかどうか */
+        bool finished;                            /**< 最後のキーフレームに到達したかどうか */
+        uint16_t frame;                           /**< 補間区間の始点のキーフレーム番号 */
+        const uint8_t *cursor;                    /**< 次に復号する差分キーフレーム */
+        uint32_t time;                            /**< 再生位置 (単位: 1/256ms) */
+        int32_t from[EJ_ANIMATION_MAX_CHANNELS];  /**< 補間区間の始点の角度 (単位: 0.01度) */
+        int32_t to[EJ_ANIMATION_MAX_CHANNELS];    /**< 補間区間の終点の角度 (単位: 0.01度) */
+    } Track;
+
+    /**
+     * @brief 再生状態をクリップの先頭に戻す
+     */
+    static void rewind(Track &track);
+
+    /**
+     * @brief 再生状態を指定した時間だけ進め、各チャンネルの角度を求める
+     * @param track 再生状態
+     * @param delta 進める時間 (単位: 1/256ms)
+     * @param angles 角度の格納先 (単位: 0.01度)
+     */
+    static void advance(Track &track, uint32_t delta, int32_t *angles);
+
+private:
+    static const char* _classname;
+    Track _tracks[2];
+    uint8_t _current;
+    bool _playing;
+    bool _paused;
+    bool _blending;
+    uint32_t _blendTime;
+    uint32_t _blendElapsed;
+    uint16_t _speed;
+    uint32_t _lastUpdate;
+    uint8_t _servoIds[EJ_ANIMATION_MAX_CHANNELS];
+    int32_t _angles[EJ_ANIMATION_MAX_CHANNELS];
+};
+
+#endif // EJSERVOANIMATION
@@ -32,7 +32,54 @@
 #ifndef EJSERVOMOTOR
 #define EJSERVOMOTOR
 #include <Arduino.h>
-#include <ESP32Servo.h>
+#include "EJ_Peripheral.h"
+#include "EJ_Device.h"
+#include "EJ_PCA9685.h"
+#include "EJ_ServoRMT.h"
+#include "EJ_Manager.h"
+
+/**
+ * @brief EJ_ServoMotorの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_SERVOMOTOR_MAX_INSTANCES
+#define EJ_SERVOMOTOR_MAX_INSTANCES 16
+#endif
+
+/**
+ * @brief 校正テーブルの最大点数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_SERVO_MAX_CAL_POINTS
+#define EJ_SERVO_MAX_CAL_POINTS 16
+#endif
+
+/**
+ * @brief LEDCで出力するサーボのPWMの周波数[Hz]と分解能[bit]
+ * @details 全てのサーボが同じ設定のため、2つのサーボで1つのLEDCタイマを共有する
+ */
+#define EJ_SERVO_LEDC_FREQUENCY 50
+#define EJ_SERVO_LEDC_RESOLUTION 16
+
+/**
+ * @struct ServoCalPoint
+ * @brief サーボモータの校正テーブルの1点 (角度とパルス幅の対応) を定義する構造体
+ */
+typedef struct
+{
+    int16_t angle; /**< 角度 (単位: 0.01度) */
+    uint16_t us;   /**< パルス幅 (単位: us) */
+} ServoCalPoint;
+
+/**
+ * @struct ServoKinematics
+ * @brief サーボモータの応答モデルのパラメータを定義する構造体
+ * @details 指令角度に対して、最大角速度で追従し目標付近では時定数timeConstantの1次遅れで収束するモデル。EJ_ServoMotor::fitKinematics()でベンチの測定値から求められる
+ */
+typedef struct
+{
+    float speed;        /**< 無負荷時の最大角速度 (単位: 度/s, 0: モデルを使わず指令角度をそのまま現在角度とみなす) */
+    float timeConstant; /**< 目標付近の1次遅れの時定数 (単位: ms) */
+    uint16_t deadband;  /**< 到達したとみなす誤差 (単位: 0.01度) */
+} ServoKinematics;
 
 /**
  * @struct ServoDef
@@ -40,27 +87,85 @@
  */
 typedef struct
 {
-    uint8_t pin;    /**< モーターの接続ピン */
-    uint8_t id;     /**< モーターの識別番号 */
+    uint8_t pin;                      /**< モーターの接続ピン */
+    uint8_t id;                       /**< モーターの識別番号 */
+    const ServoCalPoint *calibration; /**< 角度の昇順に並べた校正テーブル (NULL: 0度~180度を544us~2400usに線形に対応させる) */
+    uint8_t calibrationSize;          /**< 校正テーブルの点数 (2以上EJ_SERVO_MAX_CAL_POINTS以下) */
 } ServoDef;
 
+/**
+ * @struct ServoExpanderDef
+ * @brief PCA9685に接続した1つのサーボモータを定義する構造体
+ */
+typedef struct
+{
+    uint8_t expander;                 /**< 接続先のEJ_PCA9685の識別番号 */
+    uint8_t channel;                  /**< 接続先のPCA9685のチャンネル (0~15) */
+    uint8_t id;                       /**< モーターの識別番号 */
+    const ServoCalPoint *calibration; /**< 角度の昇順に並べた校正テーブル (NULL: 0度~180度を544us~2400usに線形に対応させる) */
+    uint8_t calibrationSize;          /**< 校正テーブルの点数 (2以上EJ_SERVO_MAX_CAL_POINTS以下) */
+} ServoExpanderDef;
+
 /**
  * @brief サーボモーターを制御するクラス
  * @attention*本クラスのインスタンスはEJ_ServoMotor_Managerクラス以外からは生成できない
- * @details [ESP32Servo.h](https://github.com/jkb-git/ESP32Servo/blob/master/src/ESP32_Servo.h) で定義されるServoクラスを基底とした派生クラス
+ * @details LEDCで出力するサーボはEJ_Peripheralから50HzのLEDCチャンネルの割り当てを受け、パルス幅を直接ledcWrite()で出力する
+ * @details moveTo()/moveAtSpeed()で開始した軌道は、EJ_ServoMotor_Manager::update()が呼ばれるたびに補間されて出力される
+ * @details 角度は内部で0.01度単位の固定小数点で扱い、校正テーブルの区分線形補間でパルス幅に変換してwriteMicroseconds()で出力する。区間ごとの傾きは校正テーブルの設定時に計算しておくため、出力時に除算は行わない
+ * @details PCA9685に接続したサーボはLEDCチャンネルを使わず、EJ_PCA9685のシャドウレジスタに書き込む。I2Cへの送信はEJ_ServoMotor_Manager::update()の最後にまとめて行われる
+ * @details RMTで出力するサーボもLEDCチャンネルを使わず、EJ_ServoRMTのパルスのアイテムを書き換える
+ * @details setKinematics()で応答モデルを設定すると、read()は最後の指令角度ではなくモデルで推定したホーンの現在角度を返し、isSettled(), getArrivalTime()で到達を判定できる
+ * @details EJ_Actuatorとしての出力値は角度 (単位: 度)
  */
-class EJ_ServoMotor : public Servo
+class EJ_ServoMotor : public EJ_Actuator<EJ_ServoMotor>
 {
+public:
+    /**
+     * @brief 軌道の加減速パターン
+     */
+    enum Easing
+    {
+        EASING_LINEAR,    /**< 等速 */
+        EASING_CUBIC,     /**< 3次曲線 (smoothstep) で加減速する */
+        EASING_TRAPEZOID  /**< 台形速度 (全体の1/4で加速、1/4で減速) */
+    };
+
+    /**
+     * @brief パルスの出力方法
+     */
+    enum Backend
+    {
+        BACKEND_LEDC,    /**< LEDCによる出力 */
+        BACKEND_PCA9685, /**< PCA9685による出力 */
+        BACKEND_RMT      /**< RMTペリフェラルによる出力 */
+    };
+
 private:
     /**
      * @brief EJ_ServoMotorクラスのコンストラクタ
      * @param pin モーターの接続ピン
      * @param min サーボの角度が0度のときのパルス幅[us]。デフォルト = 544
      * @param max サーボの角度が180度のときのパルス幅[us]。デフォルト = 2400
+     * @param calibration 角度の昇順に並べた校正テーブル (NULL: min, maxによる線形の対応)。指定した場合、min, maxは校正テーブルのパルス幅の最小値と最大値に置き換えられる
+     * @param calibrationSize 校正テーブルの点数
+     * @param backend パルスの出力方法 (default: BACKEND_LEDC)
+     * @param expander 接続先のPCA9685 (BACKEND_PCA9685のときのみ)。pinはPCA9685のチャンネルを表す
      */
-    EJ_ServoMotor(uint8_t pin = 0, int min = 544, int max = 2400);
+    EJ_ServoMotor(uint8_t pin = 0, int min = 544, int max = 2400, const ServoCalPoint *calibration = NULL, uint8_t calibrationSize = 0, Backend backend = BACKEND_LEDC, EJ_PCA9685 *expander = NULL);
     
     friend class EJ_ServoMotor_Manager;
+    template <typename, size_t> friend class EJ_Manager;
+    friend class EJ_Actuator<EJ_ServoMotor>;
+
+    /**
+     * @brief EJ_Actuatorの出力値 (角度[度]) を設定する
+     */
+    void writeOutput(int32_t value) { write((int)value); }
+
+    /**
+     * @brief EJ_Actuatorの出力値 (角度[度]) を取得する
+     */
+    int32_t readOutput() { return read(); }
 
 public:
     /**
@@ -71,83 +176,325 @@ public:
 public:
     /**
      * @brief 指定した角度までサーボモータを回転させる
+     * @details 実行中の軌道は中止される
      * @param value 静止させたい角度 (0~180)
      */
-    virtual void write(int angle);
+    void write(int angle);
     
     /**
      * @brief 出力をマイクロ秒単位で角度指定してサーボモータを回転させる。サーボモータに与えられるパルスは20ms周期で、1周期中のHigh時間を直接指定する。
      * @param us 出力したいパルス幅[us]
      */
-    virtual void writeMicroseconds(int us); // Write pulse width in microseconds 
+    void writeMicroseconds(int us); // Write pulse width in microseconds 
     
     /**
-     * @brief 現在のサーボの角度(最後にwriteした値)を読み取る
-     * @return angle 現在のサーボの角度
+     * @brief 現在のサーボの角度を読み取る
+     * @details 応答モデルを設定していない場合は最後に出力した指令角度を返す
+     * @return angle 応答モデルで推定した現在のサーボの角度
+     */
+    int read();                        // returns current pulse width as an angle between 0 and 180 degrees
+
+    /**
+     * @brief 0.01度単位の角度を指定してサーボモータを回転させる
+     * @details 実行中の軌道は中止される
+     * @param angle 静止させたい角度 (単位: 0.01度, 校正テーブルの範囲内)
+     */
+    void writeCentiDegrees(int32_t angle);
+
+    /**
+     * @brief 現在のサーボの角度を0.01度単位で読み取る
+     * @details 応答モデルを設定していない場合は最後に出力した指令角度を返す
+     * @return 応答モデルで推定した現在のサーボの角度 (単位: 0.01度)
+     */
+    int32_t readCentiDegrees();
+
+    /**
+     * @brief 最後に出力した指令角度を取得する
+     * @return 指令角度 (単位: 0.01度)
+     */
+    int32_t getCommandedCentiDegrees();
+
+    /**
+     * @brief 応答モデルを設定する
+     * @param kinematics 応答モデルのパラメータ (speed = 0: モデルを使わない)
+     */
+    void setKinematics(const ServoKinematics &kinematics);
+
+    /**
+     * @brief 応答モデルのパラメータを取得する
+     */
+    ServoKinematics getKinematics();
+
+    /**
+     * @brief 応答モデルが設定されているかどうか判定する
+     */
+    bool hasKinematics();
+
+    /**
+     * @brief 負荷の大きさを設定する
+     * @details 最大角速度を1/load倍、時定数をload倍して推定する
+     * @param load 負荷係数 (1.0: 無負荷, default: 1.0)
+     */
+    void setLoad(float load);
+
+    /**
+     * @brief サーボが指令角度に到達して静止しているかどうか推定する
+     * @return true: 到達済み / false: 移動中
+     */
+    bool isSettled();
+
+    /**
+     * @brief サーボが指令角度 (軌道の実行中は軌道の終点) に到達する時刻を推定する
+     * @return 到達する時刻 (millis()の時刻, 到達済みの場合は到達した時刻)
+     */
+    uint32_t getArrivalTime();
+
+    /**
+     * @brief ベンチで測定した2つのステップ応答から応答モデルのパラメータを求める
+     * @details 静止状態から大きさの異なる2つのステップ (どちらも最大角速度で動く程度の大きさ) を指令し、誤差がdeadband以内に収まるまでの時間を測定して与える
+     * @param step1 1つ目のステップの大きさ (単位: 0.01度)
+     * @param time1 1つ目のステップの到達時間 (単位: ms)
+     * @param step2 2つ目のステップの大きさ (単位: 0.01度, step1より大きい)
+     * @param time2 2つ目のステップの到達時間 (単位: ms)
+     * @param deadband 到達したとみなす誤差 (単位: 0.01度)
+     * @param kinematics 求めたパラメータの格納先
+     * @return true: 成功 / false: 測定値が不正
+     */
+    static bool fitKinematics(int32_t step1, uint32_t time1, int32_t step2, uint32_t time2, uint16_t deadband, ServoKinematics &kinematics);
+
+    /**
+     * @brief 校正テーブルを設定する
+     * @details テーブルの内容はインスタンス内の領域に複製されるため、呼び出し後に解放してよい。軌道の補間中 (他のコアのEJ_Executiveの周期処理からの出力中) に呼び出してもよい。パルス幅の範囲はコンストラクタで指定した範囲に制限される
+     * @param calibration 角度の昇順に並べた校正テーブル (NULL: コンストラクタで指定したmin, maxによる線形の対応に戻す)
+     * @param calibrationSize 校正テーブルの点数 (2以上EJ_SERVO_MAX_CAL_POINTS以下)
+     * @return true: 設定成功 / false: 設定失敗
+     */
+    bool setCalibration(const ServoCalPoint *calibration, uint8_t calibrationSize);
+
+    /**
+     * @brief 角度をパルス幅に変換する
+     * @param angle 角度 (単位: 0.01度)
+     * @return パルス幅 (単位: us)
+     */
+    int angleToMicroseconds(int32_t angle);
+
+    /**
+     * @brief 指定した時間をかけて指定した角度まで回転させる (非ブロッキング)
+     * @param angle 目標角度 (0~180)
+     * @param duration 移動にかける時間 (単位: ms)
+     * @param easing 加減速パターン (default: EASING_LINEAR)
+     */
+    void moveTo(int angle, uint32_t duration, Easing easing = EASING_LINEAR);
+
+    /**
+     * @brief 指定した時間をかけて0.01度単位で指定した角度まで回転させる (非ブロッキング)
+     * @param angle 目標角度 (単位: 0.01度)
+     * @param duration 移動にかける時間 (単位: ms)
+     * @param easing 加減速パターン (default: EASING_LINEAR)
+     */
+    void moveToCentiDegrees(int32_t angle, uint32_t duration, Easing easing = EASING_LINEAR);
+
+    /**
+     * @brief 最大速度を指定して指定した角度まで回転させる (非ブロッキング)
+     * @details 加減速パターンの最大速度がspeedとなるように移動時間を決める
+     * @param angle 目標角度 (0~180)
+     * @param speed 最大速度 (単位: 度/s)
+     * @param easing 加減速パターン (default: EASING_LINEAR)
+     */
+    void moveAtSpeed(int angle, float speed, Easing easing = EASING_LINEAR);
+
+    /**
+     * @brief 実行中の軌道を現在の角度で中止する
+     */
+    void stopMotion();
+
+    /**
+     * @brief 軌道を実行中かどうか判定する
+     * @return true: 実行中 / false: 停止中
+     */
+    bool isMoving();
+
+    /**
+     * @brief 実行中の軌道の進捗を取得する
+     * @return 進捗 (単位: %, 停止中は100)
+     */
+    uint8_t getProgress();
+
+    /**
+     * @brief 軌道の目標角度を取得する
+     */
+    int getTargetAngle();
+
+    /**
+     * @brief パルスの出力方法を取得する
+     */
+    Backend getBackend();
+
+    /**
+     * @brief パルスを出力できる状態かどうか判定する
+     * @return true: 出力可能 / false: チャンネルの割り当てに失敗した
+     */
+    bool attached();
+
+private:
+    /**
+     * @brief 校正テーブルの1区間
+     */
+    typedef struct
+    {
+        int32_t angle; /**< 区間の始点の角度 (単位: 0.01度) */
+        int32_t us;    /**< 区間の始点のパルス幅 (単位: us) */
+        int32_t slope; /**< 区間の傾き (単位: us/0.01度, Q16固定小数点) */
+    } Segment;
+
+    /**
+     * @brief 角度を出力する (軌道は中止しない)
+     * @param angle 角度 (単位: 0.01度)
+     */
+    void output(int32_t angle);
+
+    /**
+     * @brief 指定した時刻における軌道上の角度を出力する
+     * @param now 現在時刻 (単位: ms)
+     */
+    void updateMotion(uint32_t now);
+
+    /**
+     * @brief 応答モデルによる推定角度を指定した時刻まで進める
+     * @param now 現在時刻 (単位: ms)
+     */
+    void updateEstimate(uint32_t now);
+
+    /**
+     * @brief 応答モデルで誤差がdeadband以内に収まるまでの時間を求める
+     * @param error 誤差 (単位: 0.01度)
+     * @return 到達までの時間 (単位: ms)
+     */
+    float predictSettleTime(float error);
+
+    /**
+     * @brief 軌道の経過時間の割合から加減速パターンを適用した移動量の割合を求める
+     * @param progress 経過時間の割合 (Q16固定小数点, 0~65536)
+     * @param easing 加減速パターン
+     * @return 移動量の割合 (Q16固定小数点, 0~65536)
      */
-    virtual int read();                        // returns current pulse width as an angle between 0 and 180 degrees
+    static uint32_t ease(uint32_t progress, Easing easing);
 
 private:
     static const char* _classname;
     uint8_t _pin;
+    Backend _backend;
+    EJ_PCA9685 *_expander;
+    EJ_ServoRMT _rmt;
+    int8_t _channel;
     int _min_;
     int _max_;
+    Segment _segments[EJ_SERVO_MAX_CAL_POINTS];
+    uint8_t _segmentCount;
+    int32_t _angle;
+    bool _moving;
+    Easing _easing;
+    int32_t _startAngle;
+    int32_t _targetAngle;
+    uint32_t _startTime;
+    uint32_t _duration;
+    uint8_t _progress;
+    ServoKinematics _kinematics;
+    float _load;
+    bool _tracking;
+    float _estimate;
+    uint32_t _estimateTime;
+    bool _settled;
+    uint32_t _arrivedTime;
+#ifdef ARDUINO_ARCH_ESP32
+    portMUX_TYPE _mux;
+#endif
 };
 
 /**
  * @brief EJ_ServoMotorクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_ServoMotorクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_SERVOMOTOR_MAX_INSTANCES個まで生成される
  */
-class EJ_ServoMotor_Manager
+class EJ_ServoMotor_Manager : public EJ_Manager<EJ_ServoMotor, EJ_SERVOMOTOR_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_ServoMotor_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_ServoMotorの最大インスタンス数の定義
+     * @brief EJ_ServoMotor_Managerクラスはインスタンス化しない
      */
-    EJ_ServoMotor_Manager(size_t maxInstanceSize);
+    EJ_ServoMotor_Manager();
 
-private:
+public:
     /**
-     * @brief EJ_ServoMotor_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_ServoMotor_Managerのsingletonを指すポインタ
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_SERVOMOTOR_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_ServoMotorの最大インスタンス数
+     * @return true: EJ_SERVOMOTOR_MAX_INSTANCES以下 / false: EJ_SERVOMOTOR_MAX_INSTANCESを超える
      */
-    static EJ_ServoMotor_Manager* getInstance();
+    static bool configure(size_t maxInstanceSize);
 
-public:
     /**
-     * @brief EJ_ServoMotor_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_ServoMotorクラスのインスタンスをすべて解放する
+     * @brief EJ_ServoMotorクラスのインスタンスを生成する
+     * @details 生成したインスタンスはgetServo関数で取得できるように静的な領域に生成する
+     * @param ServoDef 参照
+     * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
      */
-    ~EJ_ServoMotor_Manager();
+    static EJ_ServoMotor *createServo(ServoDef servo);
 
-public:
     /**
-     * @brief EJ_ServoMotor_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_ServoMotorの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief EJ_ServoMotorクラスのインスタンスを生成する
+     * @details 生成したインスタンスはgetServo関数で取得できるように静的な領域に生成する
+     * @param pin サーボモータの接続ピン
+     * @param id サーボモータの識別番号
+     * @param min サーボの角度が0度のときのパルス幅[us]。デフォルト = 544
+     * @param max サーボの角度が180度のときのパルス幅[us]。デフォルト = 2400
+     * @param calibration 角度の昇順に並べた校正テーブル (NULL: min, maxによる線形の対応)
+     * @param calibrationSize 校正テーブルの点数
+     * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
      */
-    static bool configure(size_t maxInstanceSize);
+    static EJ_ServoMotor *createServo(uint8_t pin, uint8_t id, int min = 544, int max = 2400, const ServoCalPoint *calibration = NULL, uint8_t calibrationSize = 0);
 
     /**
-     * @brief EJ_ServoMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetServo関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @brief PCA9685に接続したEJ_ServoMotorクラスのインスタンスを生成する
+     * @details 接続先のEJ_PCA9685はEJ_PCA9685_Manager::createPCA9685()で生成しておく
+     * @param ServoExpanderDef 参照
+     * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
+     */
+    static EJ_ServoMotor *createExpanderServo(ServoExpanderDef servo);
+
+    /**
+     * @brief PCA9685に接続したEJ_ServoMotorクラスのインスタンスを生成する
+     * @details 接続先のEJ_PCA9685はEJ_PCA9685_Manager::createPCA9685()で生成しておく
+     * @param expander 接続先のEJ_PCA9685の識別番号
+     * @param channel 接続先のPCA9685のチャンネル (0~15)
+     * @param id サーボモータの識別番号
+     * @param min サーボの角度が0度のときのパルス幅[us]。デフォルト = 544
+     * @param max サーボの角度が180度のときのパルス幅[us]。デフォルト = 2400
+     * @param calibration 角度の昇順に並べた校正テーブル (NULL: min, maxによる線形の対応)
+     * @param calibrationSize 校正テーブルの点数
+     * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
+     */
+    static EJ_ServoMotor *createExpanderServo(uint8_t expander, uint8_t channel, uint8_t id, int min = 544, int max = 2400, const ServoCalPoint *calibration = NULL, uint8_t calibrationSize = 0);
+
+    /**
+     * @brief RMTペリフェラルで出力するEJ_ServoMotorクラスのインスタンスを生成する
+     * @details RMTチャンネルの数 (ESP32では8) までしか生成できない
      * @param ServoDef 参照
      * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
      */
-    static EJ_ServoMotor *createServo(ServoDef servo);
+    static EJ_ServoMotor *createRMTServo(ServoDef servo);
 
     /**
-     * @brief EJ_ServoMotorクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetServo関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @brief RMTペリフェラルで出力するEJ_ServoMotorクラスのインスタンスを生成する
+     * @details RMTチャンネルの数 (ESP32では8) までしか生成できない
      * @param pin サーボモータの接続ピン
      * @param id サーボモータの識別番号
      * @param min サーボの角度が0度のときのパルス幅[us]。デフォルト = 544
      * @param max サーボの角度が180度のときのパルス幅[us]。デフォルト = 2400
+     * @param calibration 角度の昇順に並べた校正テーブル (NULL: min, maxによる線形の対応)
+     * @param calibrationSize 校正テーブルの点数
      * @return EJ_ServoMotorクラスのインスタンスを指すポインタ
      */
-    static EJ_ServoMotor *createServo(uint8_t pin, uint8_t id, int min = 544, int max = 2400);
+    static EJ_ServoMotor *createRMTServo(uint8_t pin, uint8_t id, int min = 544, int max = 2400, const ServoCalPoint *calibration = NULL, uint8_t calibrationSize = 0);
 
     /**
      * @brief EJ_ServoMotorクラスのインスタンスを取得する
@@ -165,11 +512,32 @@ public:
      */
     static EJ_ServoMotor *getServo(uint8_t id);
 
+    /**
+     * @brief 複数のサーボの角度をまとめて出力する
+     * @details 全ての角度を出力し終えるまで他の出力を挟まない。対象のサーボで実行中の軌道は中止される
+     * @details PCA9685に接続したサーボは最後にまとめて送信される
+     * @param ids サーボの識別番号の配列
+     * @param angles 角度の配列 (単位: 0.01度)
+     * @param count 配列の要素数
+     * @return true: 全て出力した / false: 取得できないサーボがあった
+     */
+    static bool writeFrame(const uint8_t *ids, const int32_t *angles, uint8_t count);
+
+    /**
+     * @brief 全てのEJ_ServoMotorの軌道を1回の走査でまとめて補間し出力する
+     * @details サーボのフレーム周期 (20ms) ごとに呼び出す。EJ_Executive::addUpdate<EJ_ServoMotor_Manager>("servo", 50) で周期処理として登録できる
+     * @details PCA9685への送信でEJ_I2CBusのロックを待つため、タイマーのコールバックや割り込みからは呼び出さない
+     * @details 最後にEJ_PCA9685_Manager::flush()を呼び出し、PCA9685に接続したサーボの変更を送信する
+     * @details 応答モデルを設定したサーボは推定角度もここで進める
+     */
+    static void update();
+
 private:
     static const char* _classname;
-    static EJ_ServoMotor_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_ServoMotor **_instanceList;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_ServoMotor.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_ServoMotor, EJ_SERVOMOTOR_MAX_INSTANCES>::_classname;
+
 #endif // EJSERVOMOTOR
\ No newline at end of file
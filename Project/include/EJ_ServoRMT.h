@@ -0,0 +1,125 @@
+/**
+ * @file           EJ_ServoRMT.h
+ * @brief          RMTペリフェラルでサーボのパルスを生成するEJ_ServoRMTクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSERVORMT
+#define EJSERVORMT
+#include <Arduino.h>
+#include "EJ_Peripheral.h"
+#ifdef ARDUINO_ARCH_ESP32
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#endif
+
+/**
+ * @brief サーボのフレーム周期 (単位: us)
+ */
+#define EJ_SERVO_RMT_PERIOD 20000
+
+/**
+ * @brief チャンネルごとのパルス開始時刻のずらし幅 (単位: us)
+ * @details 最大パルス幅以上にしておくと、8チャンネルのパルスが1フレーム内で重ならない
+ */
+#define EJ_SERVO_RMT_SLOT 2500
+
+/**
+ * @brief RMTペリフェラルのループモードでサーボのパルスを生成するクラス
+ * @details 1つのサーボに1つのRMTチャンネルをEJ_Peripheralから割り当て、1フレーム分のパルスをRMTのメモリに置いて繰り返し出力させる。出力はハードウェアのみで行われるため、CPUの負荷によるジッタが生じない
+ * @details パルス幅とフレームの残りの時間を1つの32bitのアイテムに格納しているため、write()はアイテム1つの書き込みだけで完了し、出力中に書き換えてもフレーム周期はずれない
+ * @details チャンネルnのパルスは最初に出力を開始したチャンネルから n * EJ_SERVO_RMT_SLOT [us] 遅れて出力され、電源の電流のピークを分散させる
+ * @details EJ_ServoMotorのメンバとして埋め込めるよう、生成時にはチャンネルを割り当てず、attach()で割り当てる
+ */
+class EJ_ServoRMT
+{
+public:
+    /**
+     * @brief EJ_ServoRMTクラスのコンストラクタ
+     * @details RMTチャンネルは割り当てない
+     */
+    EJ_ServoRMT();
+
+    /**
+     * @brief EJ_ServoRMTクラスのデストラクタ
+     * @details 割り当て済みであれば出力を停止し、RMTチャンネルを解放する
+     */
+    ~EJ_ServoRMT();
+
+public:
+    /**
+     * @brief RMTチャンネルを割り当てて出力を開始する
+     * @details 空いているRMTチャンネルを割り当て、チャンネルの位相に合う時刻に出力を開始するようワンショットタイマーを設定する。待機はせず、出力は最大で1フレーム後に始まる
+     * @param pin 出力ピン
+     * @param us 初期パルス幅 (単位: us)
+     * @return true: 割り当て成功 (割り当て済みの場合も含む) / false: 割り当て失敗
+     */
+    bool attach(uint8_t pin, uint16_t us);
+
+    /**
+     * @brief 出力を停止し、RMTチャンネルを解放する
+     */
+    void detach();
+
+    /**
+     * @brief RMTチャンネルが割り当てられているかどうか判定する
+     * @return true: 割り当て済み / false: 割り当て失敗
+     */
+    bool isAttached();
+
+    /**
+     * @brief パルス幅を変更する
+     * @details 次のフレームから反映される
+     * @param us パルス幅 (単位: us, 1 ~ EJ_SERVO_RMT_PERIOD - 1)
+     */
+    void write(uint16_t us);
+
+    /**
+     * @brief 割り当てられたRMTチャンネルを取得する
+     * @return RMTチャンネル (-1: 未割り当て)
+     */
+    int8_t getChannel();
+
+private:
+#ifdef ARDUINO_ARCH_ESP32
+    /**
+     * @brief 出力開始時刻のタイマーのコールバック関数
+     * @param arg 出力を開始するRMTチャンネル
+     */
+    static void onStart(void *arg);
+#endif
+
+private:
+    static const char* _classname;
+    static uint8_t _allocated;   /**< サーボの出力に使用中のチャンネルのビットマスク */
+    static uint32_t _epoch;      /**< 最初にチャンネルが出力を開始した時刻 (単位: us) */
+    int8_t _channel;
+#ifdef ARDUINO_ARCH_ESP32
+    esp_timer_handle_t _start;   /**< 出力開始時刻のワンショットタイマー */
+#endif
+};
+
+#endif // EJSERVORMT
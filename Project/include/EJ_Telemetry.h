@@ -0,0 +1,266 @@
+/**
+ * @file           EJ_Telemetry.h
+ * @brief          計測値をバイナリでシリアルに送信するEJ_Telemetryクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJTELEMETRY
+#define EJTELEMETRY
+#include <Arduino.h>
+#include "EJ_Framing.h"
+
+/**
+ * @brief 登録できるチャンネルの最大数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_TELEMETRY_MAX_CHANNELS
+#define EJ_TELEMETRY_MAX_CHANNELS 16
+#endif
+
+/**
+ * @brief 1ブロックの大きさ (単位: byte、ヘッダとCRCを含む) と、送信待ちにできるブロックの数 (ビルドフラグで変更できる)
+ * @details ブロックはまとめて1回のwrite()で送信するため、UARTドライバの送信バッファ以下にする
+ */
+#ifndef EJ_TELEMETRY_BLOCK_SIZE
+#define EJ_TELEMETRY_BLOCK_SIZE 256
+#endif
+#ifndef EJ_TELEMETRY_BLOCKS
+#define EJ_TELEMETRY_BLOCKS 4
+#endif
+
+/**
+ * @brief スキーマを再送するまでのブロック数 (途中から受信を始めた受信側が同期するため)
+ */
+#ifndef EJ_TELEMETRY_SCHEMA_INTERVAL
+#define EJ_TELEMETRY_SCHEMA_INTERVAL 64
+#endif
+
+/**
+ * @brief チャンネル名の最大長
+ */
+#define EJ_TELEMETRY_NAME_LENGTH 15
+
+/**
+ * @brief スキーマのフレームの最大の大きさ (単位: byte、CRCを含む)
+ */
+#define EJ_TELEMETRY_SCHEMA_SIZE (9 + EJ_TELEMETRY_MAX_CHANNELS * (2 + EJ_TELEMETRY_NAME_LENGTH))
+
+/**
+ * @brief フレームの種類 (フレームの先頭1バイト)
+ */
+#define EJ_TELEMETRY_FRAME_SCHEMA 0x53
+#define EJ_TELEMETRY_FRAME_DATA 0x44
+
+/**
+ * @brief フレームの形式の版数
+ */
+#define EJ_TELEMETRY_VERSION 1
+
+/**
+ * @enum EJ_TelemetryType
+ * @brief チャンネルの値の型 (リトルエンディアンで送信する)
+ */
+typedef enum
+{
+    EJ_TELEMETRY_INT8 = 0,
+    EJ_TELEMETRY_UINT8,
+    EJ_TELEMETRY_INT16,
+    EJ_TELEMETRY_UINT16,
+    EJ_TELEMETRY_INT32,
+    EJ_TELEMETRY_UINT32,
+    EJ_TELEMETRY_FLOAT,
+    EJ_TELEMETRY_TYPES
+} EJ_TelemetryType;
+
+/**
+ * @brief チャンネルの値を返す関数
+ * @param context 登録時に渡した値
+ */
+typedef int32_t (*EJ_TelemetryHook)(void *context);
+
+/**
+ * @brief 登録したチャンネルの値を、スキーマ付きのバイナリでシリアルに送信するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details sample()は全チャンネルの値をタイムスタンプ (micros()) とともに1レコードとしてブロックに追記するだけで、送信はしない。ブロックが一杯になると送信待ちになり、update()または送信タスクがCOBSで符号化して1回のwrite()で送信する
+ * @details sample()を呼ぶタスク (制御周期) と送信するタスクはそれぞれ1つに限る。送信が追いつかない場合は新しいブロックを捨て、getDroppedCount()で数える
+ * @details フレームの形式
+ * - スキーマ: 'S', 版数, スキーマID (u16), レコード長 (u16), チャンネル数 (u8), {型 (u8), 名前の長さ (u8), 名前}..., CRC (u16)
+ * - データ: 'D', スキーマID (u16), ブロック番号 (u16), レコード数 (u8), {タイムスタンプ (u32), 値...}..., CRC (u16)
+ * - スキーマIDはスキーマ本体のCRC、CRCはフレーム先頭からのCRC-16/CCITT-FALSE
+ */
+class EJ_Telemetry
+{
+private:
+    /**
+     * @brief EJ_Telemetryクラスはインスタンス化しない
+     */
+    EJ_Telemetry();
+
+    typedef struct
+    {
+        char name[EJ_TELEMETRY_NAME_LENGTH + 1];
+        uint8_t type;
+        const volatile void *source;
+        EJ_TelemetryHook hook;
+        void *context;
+    } Channel;
+
+    typedef struct
+    {
+        uint8_t data[EJ_TELEMETRY_BLOCK_SIZE];
+        uint16_t length;
+        uint8_t count;
+    } Block;
+
+public:
+    /**
+     * @brief 変数をチャンネルとして登録する
+     * @details sample()のたびに変数の値をそのまま記録する。begin()の前に呼ぶ
+     * @param name チャンネル名 (EJ_TELEMETRY_NAME_LENGTH文字まで)
+     * @param type 変数の型
+     * @param source 変数のアドレス
+     * @return チャンネルの番号 (負値: 登録できなかった)
+     */
+    static int8_t addChannel(const char *name, EJ_TelemetryType type, const volatile void *source);
+
+    /**
+     * @brief 関数の戻り値をチャンネル (EJ_TELEMETRY_INT32) として登録する
+     * @details begin()の前に呼ぶ
+     * @param name チャンネル名 (EJ_TELEMETRY_NAME_LENGTH文字まで)
+     * @param hook sample()のたびに呼び出す関数
+     * @param context hookに渡す値
+     * @return チャンネルの番号 (負値: 登録できなかった)
+     */
+    static int8_t addChannel(const char *name, EJ_TelemetryHook hook, void *context);
+
+    /**
+     * @brief read()の戻り値をチャンネルとして登録する (Encoder, EJ_EncoderMotor, EJ_ToFUnitなど)
+     * @details ブロッキングするread()を持つクラス (EJ_ToFUnitなど) を登録すると、sample()もブロッキングする
+     * @param name チャンネル名 (EJ_TELEMETRY_NAME_LENGTH文字まで)
+     * @param object read()を持つインスタンス
+     * @return チャンネルの番号 (負値: 登録できなかった)
+     */
+    template <typename T>
+    static int8_t addRead(const char *name, T *object)
+    {
+        return addChannel(name, &callRead<T>, object);
+    }
+
+    /**
+     * @brief 送信を開始し、スキーマを送信する
+     * @param out 送信先 (Serialなど)
+     * @return true: 開始した / false: チャンネルがない、またはレコードがブロックに収まらない
+     */
+    static bool begin(Print &out);
+
+    /**
+     * @brief 送信を終了する
+     * @details 送信待ちと追記中のブロックを送信してから終了する
+     */
+    static void end();
+
+    /**
+     * @brief 全チャンネルの値を1レコードとして記録する
+     * @details 制御周期の中で呼ぶ。値をブロックにコピーするだけで送信はしない
+     */
+    static void sample();
+
+    /**
+     * @brief 追記中のブロックを一杯になる前に送信待ちにする
+     */
+    static void commit();
+
+    /**
+     * @brief 送信待ちのブロックを送信する
+     * @details 送信タスクを使わない場合にloop()から呼ぶ。送信が終わるまでブロッキングする
+     * @return 送信したブロックの数
+     */
+    static size_t update();
+
+    /**
+     * @brief 送信タスクを起動する (ESP32のみ)
+     * @param interval ブロックが一杯にならない場合に送信を確認する周期 (単位: ms)
+     * @param priority タスクの優先度 (制御周期のタスクより低くする)
+     * @param core タスクを固定するコア
+     * @return true: 起動した / false: 起動済み、またはタスクを生成できなかった
+     */
+    static bool startTask(uint32_t interval = 20, uint8_t priority = 2, uint8_t core = 0);
+
+    /**
+     * @brief 送信タスクを停止する
+     */
+    static void stopTask();
+
+    /**
+     * @brief 1レコードの大きさを取得する (単位: byte)
+     */
+    static uint16_t getRecordSize();
+
+    /**
+     * @brief 記録したレコードの数を取得する
+     */
+    static uint32_t getSampleCount();
+
+    /**
+     * @brief 送信が追いつかずに捨てたレコードの数を取得する
+     */
+    static uint32_t getDroppedCount();
+
+    /**
+     * @brief 型の大きさを取得する (単位: byte)
+     */
+    static uint8_t getTypeSize(uint8_t type);
+
+private:
+    template <typename T>
+    static int32_t callRead(void *object) { return (int32_t)static_cast<T *>(object)->read(); }
+
+    static void resetBlock(Block &block);
+    static size_t buildSchema(uint8_t *buffer);
+    static void sendBlock(Block &block);
+    static void sendSchema();
+    static void taskMain(void *parameter);
+
+private:
+    static const char* _classname;
+    static Channel _channels[EJ_TELEMETRY_MAX_CHANNELS];
+    static uint8_t _channelCount;
+    static uint16_t _recordSize;
+    static uint16_t _schemaId;
+    static Print *_out;
+    static bool _running;
+    static Block _blocks[EJ_TELEMETRY_BLOCKS];
+    static uint32_t _head;                  /**< 追記中のブロック (sample()だけが進める) */
+    static uint32_t _tail;                  /**< 次に送信するブロック (送信側だけが進める) */
+    static uint16_t _blockSequence;         /**< 次に確定するブロックの番号 (捨てたブロックも数える) */
+    static uint32_t _sentBlocks;
+    static uint32_t _samples;
+    static uint32_t _dropped;
+    static uint8_t _frame[EJ_COBS_MAX_ENCODED(EJ_TELEMETRY_BLOCK_SIZE > EJ_TELEMETRY_SCHEMA_SIZE ? EJ_TELEMETRY_BLOCK_SIZE : EJ_TELEMETRY_SCHEMA_SIZE)];
+    static uint32_t _taskInterval;
+    static void *_task;
+};
+
+#endif // EJTELEMETRY
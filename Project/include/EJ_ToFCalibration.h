@@ -0,0 +1,206 @@
+/**
+ * @file           EJ_ToFCalibration.h
+ * @brief          ToFセンサユニットVL53L0Xのキャリブレーションデータの定義と、キャリブレーションデータを永続化するEJ_ToFCalibrationStoreクラス群の定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJTOFCALIBRATION
+#define EJTOFCALIBRATION
+#include <Arduino.h>
+#include <stdio.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <Preferences.h>
+#endif
+
+/**
+ * @brief キャリブレーションデータのフォーマットバージョン。構造体の内容を変更した場合は値を更新し、古いキャッシュを無効化する
+ */
+#define EJ_TOF_CALIBRATION_VERSION 2
+
+/**
+ * @struct ToFCalibration
+ * @brief 1つのToFセンサユニットのキャリブレーションデータを保持する構造体
+ * @details VL53L0X::init()の実行後にセンサのレジスタから読み出した値で、次回起動時にSPAD管理とリファレンスキャリブレーションを省略して書き戻すために用いる
+ */
+typedef struct
+{
+    uint16_t version;           /**< フォーマットバージョン (EJ_TOF_CALIBRATION_VERSION) */
+    uint16_t crc;               /**< version, crcを除く全フィールドのCRC-16/CCITT */
+    uint32_t key;               /**< センサ識別キー (NVMの固有IDからEJ_ToFCalibrationStore::makeKey()で生成) */
+    uint8_t refSpadMap[6];      /**< リファレンスSPADの有効マップ (GLOBAL_CONFIG_SPAD_ENABLES_REF_0~5) */
+    uint8_t vhvSettings;        /**< VHVキャリブレーション値 */
+    uint8_t phaseCal;           /**< 位相キャリブレーション値 */
+    uint16_t finalRangeTimeout; /**< 最終測距タイムアウト (FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI) */
+    uint8_t sequenceConfig;     /**< シーケンス設定 (SYSTEM_SEQUENCE_CONFIG) */
+    uint8_t reserved;           /**< 予約 (0固定) */
+    int16_t offset;             /**< 距離オフセット (単位: 0.25mm) */
+} ToFCalibration;
+
+/**
+ * @brief ToFセンサユニットのキャリブレーションデータを永続化する抽象クラス
+ * @details EJ_ToFUnit_Manager::setCalibrationStore()で登録すると、EJ_ToFUnitの生成時にキャッシュの読み込みと保存に利用される
+ */
+class EJ_ToFCalibrationStore
+{
+public:
+    /**
+     * @brief EJ_ToFCalibrationStoreクラスのデストラクタ
+     */
+    virtual ~EJ_ToFCalibrationStore() {}
+
+public:
+    /**
+     * @brief キャリブレーションデータを読み込む
+     * @details 読み込んだデータのバージョン、キー、CRCが一致しない場合は古いキャッシュとみなしfalseを返す
+     * @param key センサ識別キー
+     * @param calibration 読み込んだデータの格納先
+     * @return true: 有効なデータを読み込んだ / false: データが存在しないか無効
+     */
+    bool load(uint32_t key, ToFCalibration &calibration);
+
+    /**
+     * @brief キャリブレーションデータを保存する
+     * @details version, crcフィールドは本関数内で設定される
+     * @param calibration 保存するデータ
+     * @return true: 保存成功 / false: 保存失敗
+     */
+    bool save(const ToFCalibration &calibration);
+
+    /**
+     * @brief キャリブレーションデータを削除する
+     * @param key センサ識別キー
+     * @return true: 削除成功 / false: 削除失敗
+     */
+    virtual bool erase(uint32_t key) = 0;
+
+    /**
+     * @brief センサ識別キーを生成する
+     * @details VL53L0XのNVMに書き込まれた64bitの固有IDを32bitに畳み込む (FNV-1a)。センサを交換するとキーが変わり、古いキャッシュは読み込まれない
+     * @param uniqueIdUpper 固有IDの上位32bit
+     * @param uniqueIdLower 固有IDの下位32bit
+     * @return センサ識別キー (0にはならない)
+     */
+    static uint32_t makeKey(uint32_t uniqueIdUpper, uint32_t uniqueIdLower);
+
+    /**
+     * @brief キャリブレーションデータのCRCを計算する
+     * @param calibration CRCを計算するデータ
+     * @return CRC-16/CCITT
+     */
+    static uint16_t calcCrc(const ToFCalibration &calibration);
+
+protected:
+    /**
+     * @brief 記憶媒体からキャリブレーションデータを読み出す
+     * @param key センサ識別キー
+     * @param calibration 読み出したデータの格納先
+     * @return true: 読み出し成功 / false: 読み出し失敗
+     */
+    virtual bool read(uint32_t key, ToFCalibration &calibration) = 0;
+
+    /**
+     * @brief 記憶媒体にキャリブレーションデータを書き込む
+     * @param calibration 書き込むデータ
+     * @return true: 書き込み成功 / false: 書き込み失敗
+     */
+    virtual bool write(const ToFCalibration &calibration) = 0;
+
+private:
+    static const char* _classname;
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+/**
+ * @brief キャリブレーションデータをESP32のNVSに保存するクラス
+ */
+class EJ_ToFCalibrationNVSStore : public EJ_ToFCalibrationStore
+{
+public:
+    /**
+     * @brief EJ_ToFCalibrationNVSStoreクラスのコンストラクタ
+     * @param name NVSの名前空間 (最大15文字, default: "ej_tof")
+     */
+    EJ_ToFCalibrationNVSStore(const char *name = "ej_tof");
+
+    /**
+     * @brief EJ_ToFCalibrationNVSStoreクラスのデストラクタ
+     */
+    ~EJ_ToFCalibrationNVSStore();
+
+public:
+    virtual bool erase(uint32_t key);
+
+protected:
+    virtual bool read(uint32_t key, ToFCalibration &calibration);
+    virtual bool write(const ToFCalibration &calibration);
+
+private:
+    static const char* _classname;
+    const char *_name;
+};
+#endif
+
+/**
+ * @brief キャリブレーションデータをファイルに保存するクラス
+ * @details センサごとに"<ディレクトリ>/tof_<キー>.cal"のファイルを作成する。ホスト上のテストや、SPIFFS等のVFSを利用する場合に用いる
+ */
+class EJ_ToFCalibrationFileStore : public EJ_ToFCalibrationStore
+{
+public:
+    /**
+     * @brief EJ_ToFCalibrationFileStoreクラスのコンストラクタ
+     * @param directory ファイルを保存するディレクトリのパス
+     */
+    EJ_ToFCalibrationFileStore(const char *directory);
+
+    /**
+     * @brief EJ_ToFCalibrationFileStoreクラスのデストラクタ
+     */
+    ~EJ_ToFCalibrationFileStore();
+
+public:
+    virtual bool erase(uint32_t key);
+
+protected:
+    virtual bool read(uint32_t key, ToFCalibration &calibration);
+    virtual bool write(const ToFCalibration &calibration);
+
+private:
+    /**
+     * @brief キーに対応するファイルのパスを生成する
+     * @param key センサ識別キー
+     * @param path パスの格納先
+     * @param size パスの格納先のサイズ
+     */
+    void makePath(uint32_t key, char *path, size_t size);
+
+private:
+    static const char* _classname;
+    const char *_directory;
+};
+
+#endif // EJTOFCALIBRATION
@@ -0,0 +1,152 @@
+/**
+ * @file           EJ_ToFFilter.h
+ * @brief          ToFセンサユニットの測距値を逐次フィルタリングするクラスEJ_ToFFilterの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJTOFFILTER
+#define EJTOFFILTER
+#include <Arduino.h>
+
+/**
+ * @brief スライディングメディアンの最大ウィンドウ長
+ */
+#define EJ_TOF_FILTER_MAX_WINDOW 15
+
+/**
+ * @brief ToFセンサユニットの測距値を1サンプルずつ処理するフィルタクラス
+ * @details 無効値 (8190/8191: 範囲外, 65535: タイムアウト, 有効範囲外, デバイスの測距ステータス異常) を除外し、固定長ウィンドウのスライディングメディアンを計算する。
+ * @details ウィンドウはソート済み配列で保持し、1サンプルの更新は二分探索で挿入/削除位置を求めて行うため、過去のサンプルを走査し直すことはない。
+ * @details オプションでα-βトラッカーを有効にすると、メディアン値を観測値として距離と変化率を推定する
+ */
+class EJ_ToFFilter
+{
+public:
+    /**
+     * @brief EJ_ToFFilterクラスのコンストラクタ
+     * @param window スライディングメディアンのウィンドウ長 (1~EJ_TOF_FILTER_MAX_WINDOW, default: 5)
+     */
+    EJ_ToFFilter(uint8_t window = 5);
+
+    /**
+     * @brief EJ_ToFFilterクラスのデストラクタ
+     */
+    ~EJ_ToFFilter();
+
+public:
+    /**
+     * @brief ウィンドウ長を設定する
+     * @details 設定するとフィルタの内部状態はリセットされる
+     * @param window スライディングメディアンのウィンドウ長 (1~EJ_TOF_FILTER_MAX_WINDOW)
+     */
+    void setWindow(uint8_t window);
+
+    /**
+     * @brief 有効とみなす距離の範囲を設定する (単位: mm)
+     * @param min 最小値 (default: 1)
+     * @param max 最大値 (default: 8189)
+     */
+    void setValidRange(uint16_t min, uint16_t max);
+
+    /**
+     * @brief α-βトラッカーを有効にする
+     * @param alpha 位置の補正ゲイン (0~1)
+     * @param beta 変化率の補正ゲイン (0~1)
+     */
+    void enableTracker(float alpha, float beta);
+
+    /**
+     * @brief α-βトラッカーを無効にする
+     */
+    void disableTracker();
+
+    /**
+     * @brief フィルタの内部状態をリセットする
+     */
+    void reset();
+
+    /**
+     * @brief 測距値を1サンプル入力する
+     * @param range 距離 (単位: mm)
+     * @param timestamp 測距した時刻 (単位: ms)
+     * @param deviceValid デバイスの測距ステータスが正常かどうか (default: true)
+     * @return true: 有効なサンプルとして採用した / false: 無効値として除外した
+     */
+    bool push(uint16_t range, uint32_t timestamp, bool deviceValid = true);
+
+    /**
+     * @brief フィルタ後の距離を取得する (単位: mm)
+     * @details トラッカーが有効な場合は推定値、無効な場合はメディアン値を返す。有効なサンプルが1つもない場合は0を返す
+     */
+    uint16_t getRange();
+
+    /**
+     * @brief ウィンドウ内のメディアン値を取得する (単位: mm)
+     */
+    uint16_t getMedian();
+
+    /**
+     * @brief 距離の変化率を取得する (単位: mm/s, 正: 遠ざかる)
+     */
+    float getRate();
+
+    /**
+     * @brief フィルタ出力の信頼度を取得する (0~100)
+     * @details 直近ウィンドウ長分の入力に占める有効サンプルの割合と、ウィンドウ内のばらつき (四分位範囲) から算出する
+     */
+    uint8_t getConfidence();
+
+    /**
+     * @brief 有効なサンプルを1つ以上受け取っているかどうか判定する
+     */
+    bool isValid();
+
+private:
+    /**
+     * @brief ソート済みウィンドウ内で、value以上となる最初の位置を二分探索する
+     */
+    uint8_t lowerBound(uint16_t value);
+
+private:
+    static const char* _classname;
+    uint8_t _window;
+    uint8_t _count;
+    uint8_t _head;
+    uint16_t _ring[EJ_TOF_FILTER_MAX_WINDOW];
+    uint16_t _sorted[EJ_TOF_FILTER_MAX_WINDOW];
+    uint16_t _validMin;
+    uint16_t _validMax;
+    uint32_t _history;
+    uint16_t _median;
+    uint32_t _lastTimestamp;
+    bool _trackerEnabled;
+    float _alpha;
+    float _beta;
+    float _position;
+    float _rate;
+};
+
+#endif // EJTOFFILTER
@@ -0,0 +1,192 @@
+/**
+ * @file           EJ_ToFScanner.h
+ * @brief          サーボモーターに搭載したToFセンサユニットを掃引して極座標の距離スキャンを生成するクラスEJ_ToFScannerの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJTOFSCANNER
+#define EJTOFSCANNER
+#include <Arduino.h>
+#include "EJ_ServoMotor.h"
+#include "EJ_ToFUnit.h"
+
+/**
+ * @brief 1回の掃引の最大点数 (ビルドフラグで変更できる)
+ * @details 0~180度を1度刻みで掃引できる点数。EJ_ToFScannerは表裏2面分の領域をインスタンス内に持つ
+ */
+#ifndef EJ_TOFSCANNER_MAX_POINTS
+#define EJ_TOFSCANNER_MAX_POINTS 181
+#endif
+
+/**
+ * @struct ToFScanPoint
+ * @brief 極座標スキャンの1点を保持する構造体
+ */
+typedef struct
+{
+    int16_t angle;      /**< 測距したときのサーボの角度 (単位: 度) */
+    uint16_t range;     /**< 距離 (単位: mm, 65535: 未測定) */
+    uint8_t rangeStatus; /**< デバイスの測距ステータス (11: 正常) */
+    uint32_t timestamp; /**< 測距結果を取得した時刻 (単位: ms) */
+} ToFScanPoint;
+
+/**
+ * @brief サーボモーターでToFセンサユニットを掃引し、極座標の距離スキャンを生成するクラス
+ * @details update()を周期的に呼び出して進める非ブロッキングの処理で、サーボの整定時間モデルから求めた整定時刻に連続測距を始め直し (EJ_ToFUnit::restartRanging())、測距時間が終わった時点で結果の読み出しを待たずに次の角度を指令する。1点あたりの時間は 整定時間 + 測距時間 になる
+ * @details 整定前や移動中に行われた測距の結果は採用しない。
+ * @details 掃引は往復で行い、1回の掃引が完了するごとに裏バッファと表バッファを入れ替えて公開する。バッファはヒープを使わずインスタンス内に持つ
+ */
+class EJ_ToFScanner
+{
+public:
+    /**
+     * @brief EJ_ToFScannerクラスのコンストラクタ
+     * @param servo センサを搭載したサーボモーター
+     * @param tof 掃引するToFセンサユニット
+     * @param minAngle 掃引範囲の最小角度 (単位: 度)
+     * @param maxAngle 掃引範囲の最大角度 (単位: 度)
+     * @param step 1ステップあたりの角度 (単位: 度)
+     */
+    EJ_ToFScanner(EJ_ServoMotor *servo, EJ_ToFUnit *tof, int16_t minAngle = 0, int16_t maxAngle = 180, uint8_t step = 5);
+
+    /**
+     * @brief EJ_ToFScannerクラスのデストラクタ
+     */
+    ~EJ_ToFScanner();
+
+public:
+    /**
+     * @brief サーボの整定時間モデルを設定する
+     * @details 角度を指令してから整定するまでの時間を baseTime + |角度変化| * timePerDegree とみなす
+     * @details サーボにEJ_ServoMotor::setKinematics()で応答モデルが設定されている場合は、このモデルではなくEJ_ServoMotor::getArrivalTime()を用いる
+     * @param baseTime 角度変化によらない整定時間 (単位: ms, default: 10)
+     * @param timePerDegree 1度あたりの移動時間 (単位: ms/度, default: 2.0)
+     */
+    void setSettleModel(uint16_t baseTime, float timePerDegree);
+
+    /**
+     * @brief ToFセンサユニットの1回の測距にかかる時間を設定する
+     * @details 測距を始め直してからこの時間が経過すると、結果の読み出しを待たずに次の角度を指令する
+     * @param period 測距時間 (単位: ms, default: 測定タイミングバジェット)
+     */
+    void setMeasurementPeriod(uint16_t period);
+
+    /**
+     * @brief 掃引を開始する
+     */
+    void start();
+
+    /**
+     * @brief 掃引を停止する
+     */
+    void stop();
+
+    /**
+     * @brief 掃引処理を1ステップ進める
+     * @details ToFセンサユニットのpoll()を1回呼び出し、採用できる測距結果が得られた場合は記録する。整定時刻になれば測距を始め直し、測距時間が終われば次の角度を指令する
+     * @return true: この呼び出しで掃引が1回完了した / false: 掃引中
+     */
+    bool update();
+
+    /**
+     * @brief 前回getScan()を呼び出してから新しい掃引が完了したかどうか判定する
+     */
+    bool available();
+
+    /**
+     * @brief 最新の完了した掃引を取得する
+     * @details 点は角度の昇順に並ぶ。呼び出すとavailable()はfalseに戻る。返したバッファは次の掃引が完了するまで書き換えられない
+     * @param count 点数の格納先
+     * @return 点の配列の先頭を指すポインタ (掃引が1回も完了していない場合はNULL)
+     */
+    const ToFScanPoint *getScan(uint16_t &count);
+
+    /**
+     * @brief 完了した掃引の回数を取得する
+     */
+    uint32_t getSweepCount();
+
+    /**
+     * @brief 最新の完了した掃引での1秒あたりの測距点数を取得する
+     */
+    float getPointsPerSecond();
+
+private:
+    /**
+     * @brief 指定したステップの角度を指令する
+     * @param index ステップ番号
+     */
+    void command(uint16_t index);
+
+    /**
+     * @brief 指定したステップの角度を求める
+     * @param index ステップ番号
+     * @return 角度 (単位: 度)
+     */
+    int16_t angleOf(uint16_t index);
+
+    /**
+     * @brief 測距時間が終わった点の結果を待つ状態にし、次の角度を指令する
+     */
+    void finishRanging();
+
+    /**
+     * @brief 結果を待っている点に測距結果を記録する
+     * @param measurement 測距結果
+     * @return true: 掃引が1回完了した / false: 掃引中
+     */
+    bool store(const ToFMeasurement &measurement);
+
+private:
+    static const char* _classname;
+    EJ_ServoMotor *_servo;
+    EJ_ToFUnit *_tof;
+    int16_t _minAngle;
+    uint8_t _step;
+    uint16_t _pointCount;
+    ToFScanPoint _buffers[2][EJ_TOFSCANNER_MAX_POINTS];
+    uint8_t _back;
+    bool _published;
+    bool _available;
+    uint32_t _sweepCount;
+    uint16_t _settleBase;
+    float _settlePerDegree;
+    uint16_t _measurementPeriod;
+    bool _running;
+    uint16_t _index;
+    int8_t _direction;
+    uint32_t _settledAt;
+    bool _ranging;              /**< 整定後に測距を始め直し、測距時間が終わるのを待っている */
+    uint32_t _rangingStart;     /**< 測距を始め直した時刻 (単位: ms) */
+    bool _resultPending;        /**< 測距時間が終わり、結果の読み出しを待っている点がある */
+    uint16_t _resultIndex;      /**< 結果を待っている点のステップ番号 */
+    uint32_t _resultStart;      /**< 結果を待っている点の測距を始め直した時刻 (単位: ms) */
+    bool _resultEndsSweep;      /**< 結果を待っている点が掃引の最後の点 */
+    uint32_t _sweepStart;
+    float _pointsPerSecond;
+};
+
+#endif // EJTOFSCANNER
@@ -31,6 +31,18 @@
 #define EJToFUnit
 #include <Arduino.h>
 #include <VL53L0X.h>
+#include "EJ_ToFCalibration.h"
+#include "EJ_ToFFilter.h"
+#include "EJ_Manager.h"
+#include "EJ_Device.h"
+#include "EJ_I2CBus.h"
+
+/**
+ * @brief EJ_ToFUnitの最大インスタンス数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_TOFUNIT_MAX_INSTANCES
+#define EJ_TOFUNIT_MAX_INSTANCES 8
+#endif
 
 /**
  * @struct ToFUnitDef
@@ -42,20 +54,63 @@ typedef struct
     uint8_t id;      /**< ToFUnitの識別番号 */
 } ToFUnitDef;
 
+/**
+ * @struct ToFMeasurement
+ * @brief 1回の測距結果を保持する構造体
+ * @details 結果レジスタブロック (RESULT_RANGE_STATUS から12バイト) を1回のバースト読み出しで取得した値から生成する
+ */
+typedef struct
+{
+    uint16_t range;       /**< 距離 (単位: mm, 8190/8191: 範囲外, 65535: タイムアウト) */
+    uint16_t signalRate;  /**< 信号レート (単位: MCPS, 9.7固定小数点) */
+    uint16_t ambientRate; /**< 環境光レート (単位: MCPS, 9.7固定小数点) */
+    uint16_t spadCount;   /**< 有効SPAD数 (8.8固定小数点) */
+    uint8_t rangeStatus;  /**< デバイスの測距ステータス (11: 正常) */
+    uint32_t timestamp;   /**< 測距結果を取得した時刻 (単位: ms) */
+} ToFMeasurement;
+
 /**
  * @brief ToFセンサユニットを制御するクラス
  * @details *注意:本クラスのインスタンスはEJ_ToFUnit_Managerクラス以外からは生成できない
+ * @details 測距はpoll()を周期的に呼び出して進める非ブロッキングの状態遷移で行う。poll()は1回の呼び出しで高々1回のI2C通信しか行わないため、他のバス処理と交互に実行できる
+ * @details 得られた測距結果はすべてセンサごとのEJ_ToFFilterに入力され、getFilter()からフィルタ後の距離、変化率、信頼度を取得できる
+ * @details EJ_RangeSensorとしての距離はread()の値
  */
-class EJ_ToFUnit : public VL53L0X
+class EJ_ToFUnit : public VL53L0X, public EJ_RangeSensor<EJ_ToFUnit>
 {
+public:
+    /**
+     * @brief 測距状態遷移の状態
+     */
+    enum State
+    {
+        STATE_WAIT_READY,      /**< 測距完了待ち (割り込みステータスを確認する) */
+        STATE_READ_RESULT,     /**< 結果レジスタブロックをバースト読み出しする */
+        STATE_CLEAR_INTERRUPT  /**< 割り込みをクリアして次の測距を開始させる */
+    };
+
+    /**
+     * @brief デバイスの測距ステータスのうち、測距が正常に完了したことを示す値
+     */
+    static const uint8_t RANGE_STATUS_VALID = 11;
+
 private:
     /**
      * @brief EJ_ToFUnitクラスのコンストラクタ
+     * @details センサのNVMから固有IDを読み出し、storeにそのIDのキャリブレーションデータがあればSPAD管理とリファレンスキャリブレーションを省略して書き戻す。データが無いか書き戻しに失敗した場合、storeがNULLの場合はVL53L0X::init()によるフルキャリブレーションを行う
      * @param address I2C通信で利用するアドレス
+     * @param store キャリブレーションデータの保存先 (NULL: フルキャリブレーションを行う)
      */
-    EJ_ToFUnit(uint8_t address);
+    EJ_ToFUnit(uint8_t address, EJ_ToFCalibrationStore *store = NULL);
 
     friend class EJ_ToFUnit_Manager;
+    template <typename, size_t> friend class EJ_Manager;
+    friend class EJ_RangeSensor<EJ_ToFUnit>;
+
+    /**
+     * @brief EJ_RangeSensorの距離 (単位: mm) を取得する
+     */
+    uint16_t readRange() { return read(); }
 
 public:
     /**
@@ -66,62 +121,251 @@ public:
 public:
     /**
      * @brief 距離を取得する (単位: mm)
+     * @details EJ_SensorLogの再生中はセンサにアクセスせず、記録した次の測距結果を返す
+     * @details 新しい測距結果が得られるまでpoll()を繰り返すため、最大でタイムアウト時間だけブロックする。タイムアウトした場合やsetOwner()で指定したタスク以外から呼び出した場合は65535を返す
+     */
+    uint16_t read();
+
+    /**
+     * @brief 測距の状態遷移を1ステップ進める
+     * @details 1回の呼び出しで行うI2C通信は高々1回 (1バイト読み出し、12バイトのバースト読み出し、1バイト書き込みのいずれか)。通信はEJ_I2CBusのロックの中で行う
+     * @details setOwner()で指定したタスク以外から呼び出した場合は何もせずfalseを返す
+     * @details EJ_SensorLogの記録中は得られた測距結果を記録する。再生中はセンサにアクセスせず、記録した時刻に達した測距結果を返す
+     * @return true: この呼び出しで新しい測距結果が得られた / false: 測距結果はまだ得られていない
+     */
+    bool poll();
+
+    /**
+     * @brief poll()を呼び出す
+     * @details EJ_Executive::addUpdate("tof", tof, 200) で周期処理として登録できる。測距結果はavailable(), getMeasurement(), getFilter()で取得する
+     */
+    void update() { poll(); }
+
+    /**
+     * @brief 連続測距を始め直す
+     * @details 実行中の測距を捨て、呼び出した時刻から次の測距を始める。サーボの整定を待ってから測距を始める場合などに使う (EJ_ToFScanner)
+     * @details EJ_SensorLogの再生中は何もしない
+     * @return true: 始め直した / false: setOwner()で指定したタスク以外から呼び出した、またはI2Cバスを獲得できなかった
+     */
+    bool restartRanging();
+
+    /**
+     * @brief poll()とread()を呼び出せるタスクを限定する
+     * @details EJ_Pipeline::start()が取得タスクを指定する。他のタスクからの呼び出しはEJ_ERROR_NOT_OWNERを記録して失敗する (ESP32のみ)
+     * @param task 測距を進めるタスク (TaskHandle_t, NULL: 制限しない)
+     */
+    void setOwner(void *task);
+
+    /**
+     * @brief 前回getMeasurement()を呼び出してから新しい測距結果が得られたかどうか判定する
+     * @return true: 新しい測距結果がある / false: 新しい測距結果はない
+     */
+    bool available();
+
+    /**
+     * @brief 最新の測距結果を取得する
+     * @details 呼び出すとavailable()はfalseに戻る
+     * @return 最新の測距結果
+     */
+    const ToFMeasurement &getMeasurement();
+
+    /**
+     * @brief 最新の測距結果の信号レートを取得する (単位: MCPS, 9.7固定小数点)
+     */
+    uint16_t getSignalRate();
+
+    /**
+     * @brief 最新の測距結果の環境光レートを取得する (単位: MCPS, 9.7固定小数点)
+     */
+    uint16_t getAmbientRate();
+
+    /**
+     * @brief 最新の測距結果のデバイス測距ステータスを取得する (11: 正常)
+     */
+    uint8_t getRangeStatus();
+
+    /**
+     * @brief 現在の測距状態遷移の状態を取得する
+     */
+    State getState();
+
+    /**
+     * @brief このセンサの測距結果を入力しているフィルタを取得する
+     * @details ウィンドウ長やトラッカーの設定はこのフィルタに対して行う
+     * @return フィルタへの参照
+     */
+    EJ_ToFFilter &getFilter();
+
+    /**
+     * @brief フィルタ後の距離を取得する (単位: mm)
+     * @details getFilter().getRange()と同じ
+     */
+    uint16_t getFilteredRange();
+
+    /**
+     * @brief 距離オフセットを設定する
+     * @details 設定値はキャリブレーションデータにも反映されるため、EJ_ToFUnit_Manager::saveCalibration()で永続化できる
+     * @param offset 距離オフセット (単位: 0.25mm, 範囲: -2048~2047)
+     */
+    void setRangeOffset(int16_t offset);
+
+    /**
+     * @brief 距離オフセットを取得する (単位: 0.25mm)
+     */
+    int16_t getRangeOffset();
+
+    /**
+     * @brief 現在のキャリブレーションデータを取得する
      */
-    virtual uint16_t read();
+    const ToFCalibration &getCalibration();
+
+    /**
+     * @brief 生成時にフルキャリブレーションを行ったかどうか判定する
+     * @return true: フルキャリブレーションを行った / false: キャリブレーションデータを書き戻した
+     */
+    bool isFullyCalibrated();
+
+private:
+    /**
+     * @brief キャリブレーションデータを書き戻してセンサを初期化する (VL53L0X::init()からSPAD管理とリファレンスキャリブレーションを除いたもの)
+     * @param calibration 書き戻すキャリブレーションデータ
+     * @return true: 初期化成功 / false: 初期化失敗
+     */
+    bool initFromCalibration(const ToFCalibration &calibration);
+
+    /**
+     * @brief 初期化済みのセンサからキャリブレーションデータを読み出し_calibrationに記憶する
+     */
+    void captureCalibration();
+
+    /**
+     * @brief VHV/位相キャリブレーション値が格納されたレジスタページを選択または解除する
+     * @param select true: 選択 / false: 解除
+     */
+    void selectRefCalibrationPage(bool select);
+
+    /**
+     * @brief センサのNVMから固有IDを読み出し、センサ識別キーを生成する
+     * @return センサ識別キー (0: 読み出しに失敗した)
+     */
+    uint32_t readUniqueKey();
+
+    /**
+     * @brief センサのNVMから32bitの値を読み出す (NVMの読み出しモードで呼び出す)
+     * @param address NVMのアドレス
+     * @param value 読み出した値の格納先
+     * @return true: 読み出し成功 / false: タイムアウト
+     */
+    bool readNvm(uint8_t address, uint32_t &value);
+
+    /**
+     * @brief 連続測距の開始/停止に用いるストップ変数をセンサから読み出す
+     */
+    void readStopVariable();
+
+    /**
+     * @brief 連続測距を開始する
+     */
+    void startRanging();
+
+    /**
+     * @brief 連続測距を停止する
+     */
+    void stopRanging();
+
+    /**
+     * @brief 状態遷移を測距完了待ちから始め直す
+     */
+    void restartPolling();
+
+    /**
+     * @brief 測距の状態遷移を1ステップ進める (EJ_I2CBusのロックを獲得した状態で呼び出す)
+     * @return true: 新しい測距結果が得られた / false: 測距結果はまだ得られていない
+     */
+    bool step();
+
+    /**
+     * @brief 呼び出し元のタスクがsetOwner()で指定したタスクかどうか判定する
+     * @return true: 指定したタスク、または制限なし / false: 他のタスク
+     */
+    bool isOwner();
+
+    /**
+     * @brief 再生中に、記録した次の測距結果を最新の測距結果にする
+     * @details 記録していない信号レート、環境光レート、SPAD数は0になる
+     */
+    void replayMeasurement();
 
 private:
     static const char* _classname;
+    uint8_t _id;
     uint8_t _address;
     bool _error;
+    State _state;
+    uint32_t _waitStart;
+    bool _available;
+    ToFMeasurement _measurement;
+    EJ_ToFFilter _filter;
+    ToFCalibration _calibration;
+    bool _fullyCalibrated;
+    uint8_t _stopVariable;
+    void *_owner;
 };
 
 /**
  * @brief EJ_ToFUnitクラスのインスタンスを生成、管理するクラス
- * @details 本クラスはシングルトンで提供され、configure()メソッドにのみよってインスタンスが1つだけ生成される
+ * @details 本クラスはインスタンス化せず、EJ_ToFUnitクラスのインスタンスはヒープを使わずにEJ_Managerの静的な領域に最大EJ_TOFUNIT_MAX_INSTANCES個まで生成される
  */
-class EJ_ToFUnit_Manager
+class EJ_ToFUnit_Manager : public EJ_Manager<EJ_ToFUnit, EJ_TOFUNIT_MAX_INSTANCES>
 {
 private:
     /**
-     * @brief EJ_ToFUnit_Managerクラスのコンストラクタ
-     * @param maxInstanceSize EJ_ToFUnitの最大インスタンス数の定義
-     */
-    EJ_ToFUnit_Manager(size_t maxInstanceSize);
-
-private:
-    /**
-     * @brief EJ_ToFUnit_Manager のインスタンスを取得する
-     * @attention *configure()がコールされていない場合はNULLポインタを返す
-     * @return EJ_ToFUnit_Managerのsingletonを指すポインタ
-     */
-    static EJ_ToFUnit_Manager* getInstance();
-
-public:
-    /**
-     * @brief EJ_ToFUnit_Managerクラスのデストラクタ
-     * @details 本クラスによって生成されたEJ_ToFUnitクラスのインスタンスをすべて解放する
+     * @brief EJ_ToFUnit_Managerクラスはインスタンス化しない
      */
-    ~EJ_ToFUnit_Manager();
+    EJ_ToFUnit_Manager();
 
 public:
     /**
-     * @brief EJ_ToFUnit_Managerのインスタンスを生成する
-     * @param maxInstanceSize EJ_ToFUnitの最大インスタンス数の定義
-     * @return true: 生成成功 / false: 生成失敗
+     * @brief 使用する最大インスタンス数を確認する
+     * @details インスタンスの領域は静的に確保されるため、呼び出さなくてもよい。最大インスタンス数はビルドフラグでEJ_TOFUNIT_MAX_INSTANCESを定義して変更する
+     * @param maxInstanceSize 使用するEJ_ToFUnitの最大インスタンス数
+     * @return true: EJ_TOFUNIT_MAX_INSTANCES以下 / false: EJ_TOFUNIT_MAX_INSTANCESを超える
      */
     static bool configure(size_t maxInstanceSize);
 
     /**
      * @brief EJ_ToFUnitクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetToFUnit関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetToFUnit関数で取得できるように静的な領域に生成する
      * @param ToFUnitDef 参照
      * @return EJ_ToFUnitクラスのインスタンスを指すポインタ
      */
     static EJ_ToFUnit *createToFUnit(ToFUnitDef tof);
 
+    /**
+     * @brief キャリブレーションデータの保存先を登録する
+     * @details 登録後に生成するEJ_ToFUnitはセンサのNVMの固有IDをキーにキャッシュを探し、有効であればフルキャリブレーションを省略する。キャッシュが無いか古い場合 (センサを交換した場合を含む) はフルキャリブレーションの結果を保存する
+     * @param store キャリブレーションデータの保存先 (NULL: キャッシュを利用しない)
+     */
+    static void setCalibrationStore(EJ_ToFCalibrationStore *store);
+
+    /**
+     * @brief 指定したidのEJ_ToFUnitの現在のキャリブレーションデータを保存する
+     * @details setRangeOffset()でオフセットを変更した後などに呼び出す
+     * @param id ToFセンサユニットの識別番号
+     * @return true: 保存成功 / false: 保存失敗
+     */
+    static bool saveCalibration(uint8_t id);
+
+    /**
+     * @brief 指定したidのEJ_ToFUnitのセンサについて保存されたキャリブレーションデータを削除し、次回起動時にフルキャリブレーションを行わせる
+     * @param id ToFセンサユニットの識別番号
+     * @return true: 削除成功 / false: 削除失敗
+     */
+    static bool invalidateCalibration(uint8_t id);
+
     /**
      * @brief EJ_ToFUnitクラスのインスタンスを生成する
-     * @details 生成したインスタンスはgetToFUnit関数で取得できるように同時に自身の_instanceList配列に記憶しておく
+     * @details 生成したインスタンスはgetToFUnit関数で取得できるように静的な領域に生成する
      * @param id ToFセンサユニットの識別番号
      * @param address ToFセンサユニットのI2Cアドレス (default: 0x29)
      * @return EJ_ToFUnitクラスのインスタンスを指すポインタ
@@ -136,11 +380,19 @@ public:
      */
     static EJ_ToFUnit *getToFUnit(uint8_t id);
 
+    /**
+     * @brief 全てのEJ_ToFUnitのpoll()を呼び出す
+     * @details EJ_Executive::addUpdate<EJ_ToFUnit_Manager>("tof", 200) で周期処理として登録できる。EJ_Pipelineなど他のタスクが所有するユニットは飛ばす
+     */
+    static void update();
+
 private:
     static const char* _classname;
-    static EJ_ToFUnit_Manager *_singleton;
-    const size_t _maxInstanceSize;
-    EJ_ToFUnit **_instanceList;
+    static EJ_ToFCalibrationStore *_calibrationStore;
 };
 
+/* EJ_Managerのエラーに出力するクラス名 (EJ_ToFUnit.cppで定義する) */
+template <>
+const char* EJ_Manager<EJ_ToFUnit, EJ_TOFUNIT_MAX_INSTANCES>::_classname;
+
 #endif // EJToFUnit
\ No newline at end of file
@@ -0,0 +1,233 @@
+/**
+ * @file           EJ_Trace.h
+ * @brief          処理時間を記録するトレースポイントとEJ_Traceクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJTRACE
+#define EJTRACE
+#include <Arduino.h>
+#if !defined(ARDUINO_ARCH_ESP32) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief コアごとに記録できるイベント数 (2のべき乗、ビルドフラグで変更できる)
+ * @details 一杯になると古いイベントから上書きする
+ */
+#ifndef EJ_TRACE_BUFFER_SIZE
+#define EJ_TRACE_BUFFER_SIZE 512
+#endif
+
+/**
+ * @brief 記録するコアの数
+ */
+#ifdef ARDUINO_ARCH_ESP32
+#define EJ_TRACE_CORES 2
+#else
+#define EJ_TRACE_CORES 1
+#endif
+
+/**
+ * @brief ISRから呼ばれる関数をIRAMに置く属性 (ESP32のみ)
+ */
+#ifdef ARDUINO_ARCH_ESP32
+#define EJ_TRACE_IRAM IRAM_ATTR
+#else
+#define EJ_TRACE_IRAM
+#endif
+
+/**
+ * @brief トレースポイント
+ * @details ビルドフラグでEJ_TRACEを定義した場合だけ有効になり、定義しない場合は何も生成しない
+ * - EJ_TRACE_SCOPE(name): 宣言したブロックの開始から終了までを1イベントとして記録する
+ * - EJ_TRACE_INSTANT(name): 呼び出した時刻を記録する (ISRの発生など)
+ * @details nameは文字列リテラルなど、書き出すまで有効な文字列にする (ポインタだけを記録する)
+ */
+#define EJ_TRACE_CONCAT2(a, b) a##b
+#define EJ_TRACE_CONCAT(a, b) EJ_TRACE_CONCAT2(a, b)
+#ifdef EJ_TRACE
+#define EJ_TRACE_SCOPE(name) EJ_TraceScope EJ_TRACE_CONCAT(_ejTraceScope, __LINE__)(name)
+#define EJ_TRACE_INSTANT(name) EJ_Trace::instant(name)
+#else
+#define EJ_TRACE_SCOPE(name) do {} while (0)
+#define EJ_TRACE_INSTANT(name) do {} while (0)
+#endif
+
+/**
+ * @brief サイクルカウンタの値
+ * @details ESP32はCPUのサイクルカウンタ (32bit、コアごとに独立)、x86のホストはTSC、それ以外のホストはナノ秒
+ */
+#ifdef ARDUINO_ARCH_ESP32
+typedef uint32_t EJ_TraceCycles;
+#else
+typedef uint64_t EJ_TraceCycles;
+#endif
+
+/**
+ * @brief トレースポイントのイベントをコアごとのリングバッファに記録し、Chromeのトレース形式で書き出すクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details 記録はロックを使わず、同じコアのタスクとISRが同時に記録しても壊れない。書き出しはstop()の後に行う
+ * @details 書き出したファイルはchrome://tracingまたはPerfetto (ui.perfetto.dev) で開ける。コアごとに1つのスレッドとして表示する
+ * @details ESP32のサイクルカウンタはコアごとに独立しているため、コアごとにmicros()との対応を記録して時刻を揃える。対応は約2^31サイクル (240MHzで約9秒) ごとに更新し、それより古いイベントの時刻は正しくない
+ */
+class EJ_Trace
+{
+private:
+    /**
+     * @brief EJ_Traceクラスはインスタンス化しない
+     */
+    EJ_Trace();
+
+    typedef struct
+    {
+        uint32_t sequence;          /**< 書き込み済みのイベントの通し番号 + 1 (0: 書き込み中) */
+        EJ_TraceCycles start;
+        uint32_t duration;          /**< 単位: サイクル (0xFFFFFFFF: 瞬間のイベント) */
+        const char *name;
+    } Event;
+
+    typedef struct
+    {
+        Event events[EJ_TRACE_BUFFER_SIZE];
+        uint32_t head;
+        EJ_TraceCycles baseCycles;  /**< baseMicrosに対応するサイクルカウンタの値 */
+        uint32_t baseMicros;
+        bool baseValid;
+    } Ring;
+
+public:
+    /**
+     * @brief 記録を開始する
+     * @details 記録済みのイベントは消去する
+     */
+    static void start();
+
+    /**
+     * @brief 記録を停止する
+     */
+    static void stop();
+
+    /**
+     * @brief 記録中かどうか判定する
+     */
+    static bool isRunning() { return _running; }
+
+    /**
+     * @brief 処理時間のイベントを記録する
+     * @param name イベント名
+     * @param start 開始時のcycles()
+     * @param end 終了時のcycles()
+     */
+    static void EJ_TRACE_IRAM complete(const char *name, EJ_TraceCycles start, EJ_TraceCycles end);
+
+    /**
+     * @brief 瞬間のイベントを記録する
+     * @param name イベント名
+     */
+    static void EJ_TRACE_IRAM instant(const char *name);
+
+    /**
+     * @brief サイクルカウンタの値を取得する
+     */
+    static inline EJ_TraceCycles EJ_TRACE_IRAM cycles()
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+        return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return nanoseconds();
+#endif
+    }
+
+    /**
+     * @brief サイクルカウンタの周波数を取得する (単位: Hz)
+     * @details x86のホストではstart()からの経過時間で較正する
+     */
+    static double getFrequency();
+
+    /**
+     * @brief 記録されているイベントの数を取得する
+     */
+    static uint32_t getEventCount();
+
+    /**
+     * @brief 上書きされて失われたイベントの数を取得する
+     */
+    static uint32_t getLostCount();
+
+    /**
+     * @brief Chromeのトレース形式 (JSON) で書き出す
+     * @param out 書き出し先 (Serialなど)
+     * @return 書き出したイベントの数
+     */
+    static uint32_t exportChrome(Print &out);
+
+#ifndef ARDUINO_ARCH_ESP32
+    /**
+     * @brief Chromeのトレース形式 (JSON) でファイルに書き出す (ホストのみ)
+     * @param path ファイルのパス
+     * @return 書き出したイベントの数 (負値: ファイルを開けなかった)
+     */
+    static int32_t exportChrome(const char *path);
+#endif
+
+private:
+    static void EJ_TRACE_IRAM record(const char *name, EJ_TraceCycles start, uint32_t duration);
+    static uint8_t EJ_TRACE_IRAM coreId();
+    static uint64_t nanoseconds();
+
+private:
+    static const char* _classname;
+    static Ring _rings[EJ_TRACE_CORES];
+    static bool _running;
+    static EJ_TraceCycles _startCycles;
+    static uint64_t _startNanoseconds;
+};
+
+/**
+ * @brief 宣言したブロックの処理時間を記録するクラス (EJ_TRACE_SCOPEで使う)
+ */
+class EJ_TraceScope
+{
+public:
+    explicit EJ_TraceScope(const char *name)
+    :   _name(name),
+        _start(EJ_Trace::cycles())
+    {}
+
+    ~EJ_TraceScope()
+    {
+        EJ_Trace::complete(_name, _start, EJ_Trace::cycles());
+    }
+
+private:
+    const char *_name;
+    EJ_TraceCycles _start;
+};
+
+#endif // EJTRACE
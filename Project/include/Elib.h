@@ -28,10 +28,31 @@
  */
 #ifndef ELIB
 #define ELIB
+#include "EJ_ErrorLog.h"
+#include "EJ_Device.h"
 #include "EJ_DCMotor.h"
 #include "EJ_ServoMotor.h"
 #include "EJ_ToFUnit.h"
+#include "EJ_ToFCalibration.h"
+#include "EJ_ToFFilter.h"
+#include "EJ_ToFScanner.h"
+#include "EJ_Odometry.h"
+#include "EJ_OccupancyGrid.h"
+#include "EJ_ServoAnimation.h"
 #include "EJ_I2CHub.h"
+#include "EJ_I2CBus.h"
+#include "EJ_PCA9685.h"
+#include "EJ_ServoRMT.h"
 #include "EJ_EncoderMotor.h"
 #include "EJ_PhotoInterrupter.h"
+#include "EJ_Peripheral.h"
+#include "EJ_DeviceTable.h"
+#include "EJ_Executive.h"
+#include "EJ_Seqlock.h"
+#include "EJ_Pipeline.h"
+#include "EJ_Framing.h"
+#include "EJ_Telemetry.h"
+#include "EJ_Command.h"
+#include "EJ_Trace.h"
+#include "EJ_SensorLog.h"
 #endif // ELIB
\ No newline at end of file
@@ -1,9 +1,12 @@
 #ifndef PINASSIGN
 #define PINASSIGN
-#include "EJ_DCMotor.h"
-#include "EJ_ServoMotor.h"
+#include "EJ_DeviceTable.h"
 
-MotorDef MOTOR1 = {13, 14, 26, 0};
-ServoDef SERVO1 = {19, 0};
+/* ロボットのデバイス構成 (ピンの重複や入力専用GPIOへの出力などはコンパイル時に検出される) */
+constexpr DeviceDef DEVICES[] = {
+    EJ_DeviceTable::encoderMotor(0, 25, 26, 35, 36),
+    EJ_DeviceTable::servo(0, 19),
+};
+EJ_CHECK_DEVICE_TABLE(DEVICES);
 
 #endif // PINASSIGN
@@ -0,0 +1,163 @@
+#include "EJ_Bench.h"
+#include <stdlib.h>
+#if !defined(ARDUINO_ARCH_ESP32)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+/* カウンタの読み出し時間を求めるサンプル数 */
+static const uint16_t CALIBRATION_SAMPLES = 64;
+
+/*------------
+class EJ_Bench
+------------*/
+
+/* static member */
+Print *EJ_Bench::_out = NULL;
+uint32_t EJ_Bench::_overhead = 0;
+uint16_t EJ_Bench::_count = 0;
+uint32_t EJ_Bench::_samples[EJ_BENCH_MAX_SAMPLES];
+BenchResult EJ_Bench::_result;
+
+/* private method */
+int EJ_Bench::compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+const BenchResult &EJ_Bench::finish(const char *name, uint16_t samples, uint16_t batch)
+{
+    for (uint16_t i = 0; i < samples; i++) {
+        _samples[i] = _samples[i] > _overhead ? _samples[i] - _overhead : 0;
+    }
+    summarize(name, samples);
+    /* 1呼び出しあたりの値に直す */
+    _result.batch = batch;
+    _result.min /= batch;
+    _result.p50 /= batch;
+    _result.p90 /= batch;
+    _result.p99 /= batch;
+    _result.max /= batch;
+    _result.mean /= batch;
+    print(_result, unit());
+    return _result;
+}
+
+void EJ_Bench::summarize(const char *name, uint16_t count)
+{
+    qsort(_samples, count, sizeof(uint32_t), compare);
+
+    uint64_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        sum += _samples[i];
+    }
+    _result.name = name;
+    _result.samples = count;
+    _result.batch = 1;
+    if (count == 0) {
+        _result.min = _result.p50 = _result.p90 = _result.p99 = _result.max = _result.mean = 0.0f;
+    } else {
+        /* 最近傍順位法によるパーセンタイル */
+        _result.min = (float)_samples[0];
+        _result.p50 = (float)_samples[(count - 1) * 50 / 100];
+        _result.p90 = (float)_samples[(count - 1) * 90 / 100];
+        _result.p99 = (float)_samples[(count - 1) * 99 / 100];
+        _result.max = (float)_samples[count - 1];
+        _result.mean = (float)sum / count;
+    }
+}
+
+void EJ_Bench::print(const BenchResult &result, const char *unit)
+{
+    if (_out == NULL) {
+        return;
+    }
+    _out->printf("{\"bench\":\"%s\",\"unit\":\"%s\",\"samples\":%u,\"batch\":%u,"
+                 "\"min\":%.1f,\"p50\":%.1f,\"p90\":%.1f,\"p99\":%.1f,\"max\":%.1f,\"mean\":%.1f}\n",
+                 result.name, unit, (unsigned)result.samples, (unsigned)result.batch,
+                 result.min, result.p50, result.p90, result.p99, result.max, result.mean);
+    _count++;
+}
+
+/* static public method */
+void EJ_Bench::begin(Print &out, const char *suite)
+{
+    _out = &out;
+    _count = 0;
+    _overhead = 0xFFFFFFFF;
+    for (uint16_t i = 0; i < CALIBRATION_SAMPLES; i++) {
+        uint32_t start = cycles();
+        uint32_t elapsed = cycles() - start;
+        if (elapsed < _overhead) {
+            _overhead = elapsed;
+        }
+    }
+#ifdef ARDUINO_ARCH_ESP32
+    const char *platform = "esp32";
+    unsigned mhz = getCpuFrequencyMhz();
+#else
+    const char *platform = "host";
+    unsigned mhz = 0;
+#endif
+    _out->printf("{\"suite\":\"%s\",\"platform\":\"%s\",\"unit\":\"%s\",\"cpu_mhz\":%u,\"overhead\":%u}\n",
+                 suite, platform, unit(), mhz, (unsigned)_overhead);
+}
+
+void EJ_Bench::end()
+{
+    if (_out != NULL) {
+        _out->printf("{\"done\":%u}\n", (unsigned)_count);
+    }
+}
+
+uint32_t EJ_Bench::cycles()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+#endif
+}
+
+const char *EJ_Bench::unit()
+{
+#if defined(ARDUINO_ARCH_ESP32) || defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+const BenchResult &EJ_Bench::record(const char *name, const uint32_t *values, uint16_t count, const char *unit)
+{
+    if (count > EJ_BENCH_MAX_SAMPLES) {
+        count = EJ_BENCH_MAX_SAMPLES;
+    }
+    memmove(_samples, values, count * sizeof(uint32_t));
+    summarize(name, count);
+    print(_result, unit != NULL ? unit : EJ_Bench::unit());
+    return _result;
+}
+
+void EJ_Bench::skip(const char *name, const char *reason)
+{
+    if (_out != NULL) {
+        _out->printf("{\"bench\":\"%s\",\"skipped\":\"%s\"}\n", name, reason);
+    }
+}
+
+void EJ_Bench::size(const char *name, size_t bytes)
+{
+    if (_out != NULL) {
+        _out->printf("{\"size\":\"%s\",\"bytes\":%u}\n", name, (unsigned)bytes);
+    }
+}
@@ -0,0 +1,172 @@
+/**
+ * @file           EJ_Bench.h
+ * @brief          ELibのホットパスを計測するマイクロベンチマークEJ_Benchクラスの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJBENCH
+#define EJBENCH
+#include <Arduino.h>
+
+/**
+ * @brief 1つのベンチマークで記録する最大サンプル数 (ビルドフラグで変更できる)
+ */
+#ifndef EJ_BENCH_MAX_SAMPLES
+#define EJ_BENCH_MAX_SAMPLES 256
+#endif
+
+/**
+ * @struct BenchResult
+ * @brief 1つのベンチマークの結果 (値は1呼び出しあたりのカウント)
+ */
+typedef struct
+{
+    const char *name;  /**< ベンチマーク名 */
+    uint16_t samples;  /**< サンプル数 */
+    uint16_t batch;    /**< 1サンプルあたりの呼び出し回数 */
+    float min;         /**< 最小値 */
+    float p50;         /**< 中央値 */
+    float p90;         /**< 90パーセンタイル */
+    float p99;         /**< 99パーセンタイル */
+    float max;         /**< 最大値 */
+    float mean;        /**< 平均値 */
+} BenchResult;
+
+/**
+ * @brief 関数の1呼び出しあたりのサイクル数とそのばらつきを計測するクラス
+ * @details 本クラスはインスタンス化せず、静的メソッドのみを使用する
+ * @details ESP32ではCPUのサイクルカウンタ (ESP.getCycleCount())、x86のホストではTSC、それ以外のホストではナノ秒を単位とする。計測値からはカウンタの読み出しにかかる時間を差し引く
+ * @details 結果は1行1ベンチマークのJSON (JSON Lines) で出力し、bench/compare.pyで2回分の結果を比較できる
+ */
+class EJ_Bench
+{
+private:
+    /**
+     * @brief EJ_Benchクラスはインスタンス化しない
+     */
+    EJ_Bench();
+
+public:
+    /**
+     * @brief 計測を開始する
+     * @details カウンタの読み出し時間を測り、スイート名、プラットフォーム、単位、CPU周波数を1行目に出力する
+     * @param out 結果の出力先
+     * @param suite スイート名
+     */
+    static void begin(Print &out, const char *suite);
+
+    /**
+     * @brief 計測を終了し、ベンチマーク数を出力する
+     */
+    static void end();
+
+    /**
+     * @brief カウンタの現在値を取得する
+     */
+    static uint32_t cycles();
+
+    /**
+     * @brief カウンタの単位を取得する ("cycles" または "ns")
+     */
+    static const char *unit();
+
+    /**
+     * @brief 関数を計測する
+     * @details batch回の呼び出しを1サンプルとしてsamples回計測する。batchが1のときは1呼び出しごとのばらつき (ジッタ) がパーセンタイルに現れる
+     * @param name ベンチマーク名
+     * @param function 計測する関数 (ラムダ式など)
+     * @param samples サンプル数 (最大EJ_BENCH_MAX_SAMPLES)
+     * @param batch 1サンプルあたりの呼び出し回数
+     * @return 計測結果
+     */
+    template <typename F>
+    static const BenchResult &run(const char *name, F function, uint16_t samples = EJ_BENCH_MAX_SAMPLES, uint16_t batch = 1)
+    {
+        if (samples > EJ_BENCH_MAX_SAMPLES) {
+            samples = EJ_BENCH_MAX_SAMPLES;
+        }
+        if (batch == 0) {
+            batch = 1;
+        }
+        for (uint16_t i = 0; i < samples; i++) {
+            uint32_t start = cycles();
+            for (uint16_t j = 0; j < batch; j++) {
+                function();
+            }
+            _samples[i] = cycles() - start;
+        }
+        return finish(name, samples, batch);
+    }
+
+    /**
+     * @brief 外部で計測した値を集計する
+     * @details 割り込みで取得したエッジの間隔など、run()で計測できない値をrun()と同じ形式で出力する
+     * @param name ベンチマーク名
+     * @param values 計測値
+     * @param count 計測値の数 (最大EJ_BENCH_MAX_SAMPLES)
+     * @param unit 計測値の単位 (NULL: unit()と同じ)
+     * @return 計測結果
+     */
+    static const BenchResult &record(const char *name, const uint32_t *values, uint16_t count, const char *unit = NULL);
+
+    /**
+     * @brief 計測しなかったベンチマークを出力する
+     * @param name ベンチマーク名
+     * @param reason 理由
+     */
+    static void skip(const char *name, const char *reason);
+
+    /**
+     * @brief インスタンスなどの大きさを出力する
+     * @param name 対象の名前
+     * @param bytes 大きさ (単位: byte)
+     */
+    static void size(const char *name, size_t bytes);
+
+    /**
+     * @brief 値を使用したことにして、計測対象の処理が最適化で消されないようにする
+     */
+    template <typename T>
+    static inline void keep(const T &value)
+    {
+        __asm__ __volatile__("" : : "r"(&value) : "memory");
+    }
+
+private:
+    static void summarize(const char *name, uint16_t count);
+    static const BenchResult &finish(const char *name, uint16_t samples, uint16_t batch);
+    static void print(const BenchResult &result, const char *unit);
+    static int compare(const void *a, const void *b);
+
+private:
+    static Print *_out;
+    static uint32_t _overhead;
+    static uint16_t _count;
+    static uint32_t _samples[EJ_BENCH_MAX_SAMPLES];
+    static BenchResult _result;
+};
+
+#endif // EJBENCH
@@ -0,0 +1,151 @@
+/**
+ * @file           Arduino.h
+ * @brief          ホスト (Linux) 向けのArduino APIの代替。ELibが使う範囲のAPIをEJ_HALの模擬周辺機能の上に実装する
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJNATIVE_ARDUINO
+#define EJNATIVE_ARDUINO
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include "EJ_HAL.h"
+
+#define ARDUINO 10819
+#define EJ_NATIVE 1
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+#define PI 3.1415926535897932384626433832795
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define IRAM_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+/* GPIO */
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+
+/* PWM (LEDC) */
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits);
+void ledcAttachPin(uint8_t pin, uint8_t channel);
+void ledcDetachPin(uint8_t pin);
+void ledcWrite(uint8_t channel, uint32_t duty);
+uint32_t ledcRead(uint8_t channel);
+
+/* 時刻 */
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+/* 割り込み (ホストでは何もしない) */
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+
+/**
+ * @brief 文字列出力の基底クラス (Arduino互換)
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str);
+
+    int printf(const char *format, ...);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits = 2);
+    size_t println();
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(int value);
+    size_t println(unsigned int value);
+    size_t println(long value);
+    size_t println(unsigned long value);
+    size_t println(double value, int digits = 2);
+};
+
+/**
+ * @brief 入力もできる文字列出力の基底クラス (Arduino互換)
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+};
+
+/**
+ * @brief 標準入出力につながるシリアルポート
+ */
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+    void end();
+    virtual int available();
+    virtual int read();
+    int availableForWrite();
+    void flush();
+    virtual size_t write(uint8_t c);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+/* スケッチが定義する関数 */
+void setup();
+void loop();
+
+#endif // EJNATIVE_ARDUINO
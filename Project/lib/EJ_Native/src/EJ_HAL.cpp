@@ -0,0 +1,507 @@
+#include "EJ_HAL.h"
+#include <Arduino.h>
+#include <Encoder.h>
+#include "EJ_Trace.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/*----------
+class EJ_HAL
+----------*/
+
+/* 模擬周辺機能の状態 */
+static EJ_HAL::ClockSource clockSource = NULL;
+static EJ_HAL::SleepHandler sleepHandler = NULL;
+static uint64_t hostEpoch = 0;
+
+static uint8_t pinModes[EJ_HAL_PINS];
+static uint8_t pinOutputs[EJ_HAL_PINS];
+static uint8_t pinInputs[EJ_HAL_PINS];
+static bool pinInputSet[EJ_HAL_PINS];
+static uint16_t analogInputs[EJ_HAL_PINS];
+static int8_t pinChannels[EJ_HAL_PINS];
+
+static uint32_t ledcFrequency[EJ_HAL_LEDC_CHANNELS];
+static uint8_t ledcResolution[EJ_HAL_LEDC_CHANNELS];
+static uint32_t ledcDuty[EJ_HAL_LEDC_CHANNELS];
+
+static EJ_HAL_I2CDevice *i2cDevices[EJ_HAL_I2C_ADDRESSES];
+
+static int serialFd = -1;
+
+static bool isRunning = true;
+static int stopCode = 0;
+
+static uint64_t hostMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void hostSleep(uint32_t us)
+{
+    struct timespec ts;
+    ts.tv_sec = us / 1000000UL;
+    ts.tv_nsec = (long)(us % 1000000UL) * 1000L;
+    nanosleep(&ts, NULL);
+}
+
+static bool validPin(uint8_t pin)
+{
+    return pin < EJ_HAL_PINS;
+}
+
+/* static public method */
+void EJ_HAL::reset()
+{
+    clockSource = NULL;
+    sleepHandler = NULL;
+    hostEpoch = hostMicros();
+    for (uint8_t pin = 0; pin < EJ_HAL_PINS; pin++) {
+        pinModes[pin] = INPUT;
+        pinOutputs[pin] = LOW;
+        pinInputs[pin] = LOW;
+        pinInputSet[pin] = false;
+        analogInputs[pin] = 0;
+        pinChannels[pin] = -1;
+    }
+    for (uint8_t channel = 0; channel < EJ_HAL_LEDC_CHANNELS; channel++) {
+        ledcFrequency[channel] = 0;
+        ledcResolution[channel] = 0;
+        ledcDuty[channel] = 0;
+    }
+    for (uint8_t address = 0; address < EJ_HAL_I2C_ADDRESSES; address++) {
+        i2cDevices[address] = NULL;
+    }
+    for (Encoder *encoder = Encoder::_head; encoder != NULL; encoder = encoder->_next) {
+        encoder->_position = 0;
+    }
+    isRunning = true;
+    stopCode = 0;
+}
+
+uint64_t EJ_HAL::now()
+{
+    if (clockSource != NULL) {
+        return clockSource();
+    }
+    if (hostEpoch == 0) {
+        hostEpoch = hostMicros();
+    }
+    return hostMicros() - hostEpoch;
+}
+
+void EJ_HAL::sleep(uint32_t us)
+{
+    if (sleepHandler != NULL) {
+        sleepHandler(us);
+    } else {
+        hostSleep(us);
+    }
+}
+
+void EJ_HAL::setClock(ClockSource source, SleepHandler sleep)
+{
+    clockSource = source;
+    sleepHandler = sleep;
+}
+
+void EJ_HAL::elapse(uint32_t us)
+{
+    if (clockSource != NULL && sleepHandler != NULL) {
+        sleepHandler(us);
+    }
+}
+
+uint8_t EJ_HAL::getPinMode(uint8_t pin)
+{
+    return validPin(pin) ? pinModes[pin] : INPUT;
+}
+
+uint8_t EJ_HAL::getPinOutput(uint8_t pin)
+{
+    return validPin(pin) ? pinOutputs[pin] : LOW;
+}
+
+void EJ_HAL::setPinInput(uint8_t pin, uint8_t level)
+{
+    if (validPin(pin)) {
+        pinInputs[pin] = level ? HIGH : LOW;
+        pinInputSet[pin] = true;
+    }
+}
+
+void EJ_HAL::setAnalogInput(uint8_t pin, uint16_t value)
+{
+    if (validPin(pin)) {
+        analogInputs[pin] = value;
+    }
+}
+
+uint32_t EJ_HAL::getLEDCDuty(uint8_t channel)
+{
+    return channel < EJ_HAL_LEDC_CHANNELS ? ledcDuty[channel] : 0;
+}
+
+uint32_t EJ_HAL::getLEDCFrequency(uint8_t channel)
+{
+    return channel < EJ_HAL_LEDC_CHANNELS ? ledcFrequency[channel] : 0;
+}
+
+uint8_t EJ_HAL::getLEDCResolution(uint8_t channel)
+{
+    return channel < EJ_HAL_LEDC_CHANNELS ? ledcResolution[channel] : 0;
+}
+
+float EJ_HAL::getPinDuty(uint8_t pin)
+{
+    if (!validPin(pin) || pinChannels[pin] < 0) {
+        return -1.0f;
+    }
+    uint8_t channel = (uint8_t)pinChannels[pin];
+    return (float)ledcDuty[channel] / (float)(1UL << ledcResolution[channel]);
+}
+
+float EJ_HAL::getPinPulseWidth(uint8_t pin)
+{
+    float duty = getPinDuty(pin);
+    uint8_t channel = validPin(pin) && pinChannels[pin] >= 0 ? (uint8_t)pinChannels[pin] : 0;
+    if (duty < 0.0f || ledcFrequency[channel] == 0) {
+        return -1.0f;
+    }
+    return duty * 1000000.0f / (float)ledcFrequency[channel];
+}
+
+void EJ_HAL::addEncoderCount(uint8_t pin, int32_t delta)
+{
+    /* 実機のエンコーダの割り込みに相当する */
+    EJ_TRACE_INSTANT("Encoder::isr");
+    for (Encoder *encoder = Encoder::_head; encoder != NULL; encoder = encoder->_next) {
+        if (encoder->_pin1 == pin) {
+            encoder->_position += delta;
+        }
+    }
+}
+
+void EJ_HAL::attachI2CDevice(uint8_t address, EJ_HAL_I2CDevice *device)
+{
+    if (address < EJ_HAL_I2C_ADDRESSES) {
+        i2cDevices[address] = device;
+    }
+}
+
+EJ_HAL_I2CDevice *EJ_HAL::getI2CDevice(uint8_t address)
+{
+    return address < EJ_HAL_I2C_ADDRESSES ? i2cDevices[address] : NULL;
+}
+
+bool EJ_HAL::openSerial(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return false;
+    }
+    /* 端末の場合は改行の変換やエコーをしないrawモードにする */
+    struct termios attributes;
+    if (tcgetattr(fd, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(fd, TCSANOW, &attributes);
+    }
+    closeSerial();
+    fflush(stdout);
+    serialFd = fd;
+    return true;
+}
+
+void EJ_HAL::closeSerial()
+{
+    if (serialFd >= 0) {
+        close(serialFd);
+        serialFd = -1;
+    }
+}
+
+int EJ_HAL::getSerialFd()
+{
+    return serialFd;
+}
+
+void EJ_HAL::stop(int code)
+{
+    isRunning = false;
+    stopCode = code;
+}
+
+bool EJ_HAL::running()
+{
+    return isRunning;
+}
+
+int EJ_HAL::exitCode()
+{
+    return stopCode;
+}
+
+/*-----------
+Arduino API
+-----------*/
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (validPin(pin)) {
+        pinModes[pin] = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (validPin(pin)) {
+        pinOutputs[pin] = val ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (!validPin(pin)) {
+        return LOW;
+    }
+    if (pinModes[pin] == OUTPUT) {
+        return pinOutputs[pin];
+    }
+    if (!pinInputSet[pin] && pinModes[pin] == INPUT_PULLUP) {
+        return HIGH;
+    }
+    return pinInputs[pin];
+}
+
+uint16_t analogRead(uint8_t pin)
+{
+    return validPin(pin) ? analogInputs[pin] : 0;
+}
+
+double ledcSetup(uint8_t channel, double freq, uint8_t resolution_bits)
+{
+    if (channel >= EJ_HAL_LEDC_CHANNELS || resolution_bits == 0 || resolution_bits > 20) {
+        return 0;
+    }
+    ledcFrequency[channel] = (uint32_t)freq;
+    ledcResolution[channel] = resolution_bits;
+    return freq;
+}
+
+void ledcAttachPin(uint8_t pin, uint8_t channel)
+{
+    if (validPin(pin) && channel < EJ_HAL_LEDC_CHANNELS) {
+        pinChannels[pin] = (int8_t)channel;
+        pinModes[pin] = OUTPUT;
+    }
+}
+
+void ledcDetachPin(uint8_t pin)
+{
+    if (validPin(pin)) {
+        pinChannels[pin] = -1;
+    }
+}
+
+void ledcWrite(uint8_t channel, uint32_t duty)
+{
+    if (channel < EJ_HAL_LEDC_CHANNELS) {
+        ledcDuty[channel] = duty;
+    }
+}
+
+uint32_t ledcRead(uint8_t channel)
+{
+    return channel < EJ_HAL_LEDC_CHANNELS ? ledcDuty[channel] : 0;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(EJ_HAL::now() / 1000ULL);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)EJ_HAL::now();
+}
+
+void delay(uint32_t ms)
+{
+    EJ_HAL::sleep(ms * 1000UL);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    EJ_HAL::sleep(us);
+}
+
+void yield()
+{}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)
+{
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+/*---------
+class Print
+---------*/
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char *str)
+{
+    return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+}
+
+int Print::printf(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+        return length;
+    }
+    write((const uint8_t *)buffer, (size_t)length < sizeof(buffer) ? (size_t)length : sizeof(buffer) - 1);
+    return length;
+}
+
+size_t Print::print(const char *str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(int value) { return (size_t)printf("%d", value); }
+size_t Print::print(unsigned int value) { return (size_t)printf("%u", value); }
+size_t Print::print(long value) { return (size_t)printf("%ld", value); }
+size_t Print::print(unsigned long value) { return (size_t)printf("%lu", value); }
+size_t Print::print(double value, int digits) { return (size_t)printf("%.*f", digits, value); }
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const char *str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(int value) { return print(value) + println(); }
+size_t Print::println(unsigned int value) { return print(value) + println(); }
+size_t Print::println(long value) { return print(value) + println(); }
+size_t Print::println(unsigned long value) { return print(value) + println(); }
+size_t Print::println(double value, int digits) { return print(value, digits) + println(); }
+
+/*------------------
+class HardwareSerial
+------------------*/
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    (void)baud;
+}
+
+void HardwareSerial::end()
+{}
+
+int HardwareSerial::available()
+{
+    int count = 0;
+    if (serialFd < 0 || ioctl(serialFd, FIONREAD, &count) != 0) {
+        return 0;
+    }
+    return count;
+}
+
+int HardwareSerial::read()
+{
+    uint8_t c;
+    if (available() <= 0 || ::read(serialFd, &c, 1) != 1) {
+        return -1;
+    }
+    return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return 4096;
+}
+
+void HardwareSerial::flush()
+{
+    if (serialFd >= 0) {
+        tcdrain(serialFd);
+    } else {
+        fflush(stdout);
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    if (serialFd < 0) {
+        return fwrite(buffer, 1, size, stdout);
+    }
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::write(serialFd, buffer + written, size - written);
+        if (result <= 0) {
+            break;
+        }
+        written += (size_t)result;
+    }
+    return written;
+}
+
+/*-----------
+class Encoder
+-----------*/
+
+Encoder *Encoder::_head = NULL;
+
+Encoder::Encoder(uint8_t pin1, uint8_t pin2)
+:   _next(_head),
+    _pin1(pin1),
+    _position(0)
+{
+    (void)pin2;
+    _head = this;
+}
+
+Encoder::~Encoder()
+{
+    for (Encoder **link = &_head; *link != NULL; link = &(*link)->_next) {
+        if (*link == this) {
+            *link = _next;
+            break;
+        }
+    }
+}
+
+int32_t Encoder::read()
+{
+    return _position;
+}
+
+int32_t Encoder::readAndReset()
+{
+    int32_t position = _position;
+    _position = 0;
+    return position;
+}
+
+void Encoder::write(int32_t position)
+{
+    _position = position;
+}
@@ -0,0 +1,243 @@
+/**
+ * @file           EJ_HAL.h
+ * @brief          ホスト (Linux) でELibを動かすための模擬周辺機能 (GPIO, PWM, I2C, エンコーダ, 時刻) を操作するクラスEJ_HALの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJHAL
+#define EJHAL
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief 模擬するGPIOの数
+ */
+#define EJ_HAL_PINS 40
+
+/**
+ * @brief 模擬するLEDCチャンネルの数
+ */
+#define EJ_HAL_LEDC_CHANNELS 16
+
+/**
+ * @brief 模擬するI2Cアドレスの数 (7bit)
+ */
+#define EJ_HAL_I2C_ADDRESSES 128
+
+/**
+ * @brief 模擬するI2Cデバイスの基底クラス
+ * @details I2Cの1回のトランザクション (開始条件から停止条件または再開始条件まで) ごとにwrite()またはread()が呼ばれる。レジスタポインタなどの状態はデバイス側で保持する
+ */
+class EJ_HAL_I2CDevice
+{
+public:
+    virtual ~EJ_HAL_I2CDevice() {}
+
+    /**
+     * @brief マスタからの書き込みを受け取る
+     * @param data 書き込まれたバイト列
+     * @param length バイト数
+     * @return true: ACK / false: NACK
+     */
+    virtual bool write(const uint8_t *data, size_t length) = 0;
+
+    /**
+     * @brief マスタへの読み出しに応答する
+     * @param data 読み出すバイト列の格納先
+     * @param length 要求されたバイト数
+     * @return 応答したバイト数
+     */
+    virtual size_t read(uint8_t *data, size_t length) = 0;
+};
+
+/**
+ * @brief ホスト上の模擬周辺機能を操作するクラス
+ * @details EJ_NativeライブラリのArduino.h, Wire.h, Encoder.hは本クラスの状態を読み書きする。テストやベンチマークは本クラスで入力を与え、出力を観測する
+ * @details 時刻はデフォルトでホストの単調増加時計に従う。setClock()で時刻の取得と待機を差し替えると、仮想時刻で動かせる
+ * @details 本クラスはインスタンス化しない
+ */
+class EJ_HAL
+{
+private:
+    EJ_HAL();
+
+public:
+    /**
+     * @brief 時刻の取得関数と待機関数
+     */
+    typedef uint64_t (*ClockSource)();
+    typedef void (*SleepHandler)(uint32_t us);
+
+    /**
+     * @brief 全ての模擬周辺機能を初期状態に戻す
+     * @details 接続したI2Cデバイスは切り離され、時刻はホストの時計に戻る
+     */
+    static void reset();
+
+    /* 時刻 */
+
+    /**
+     * @brief 起動からの経過時間を取得する (単位: us)
+     */
+    static uint64_t now();
+
+    /**
+     * @brief 指定した時間だけ待機する
+     * @param us 待機時間 (単位: us)
+     */
+    static void sleep(uint32_t us);
+
+    /**
+     * @brief 時刻の取得関数と待機関数を差し替える
+     * @param source 時刻の取得関数 (NULL: ホストの時計)
+     * @param sleep 待機関数 (NULL: ホストのスリープ)
+     */
+    static void setClock(ClockSource source, SleepHandler sleep);
+
+    /**
+     * @brief 処理にかかった時間を時刻に反映する
+     * @details 仮想時刻で動かしている場合は待機関数で時刻を進める。ホストの時計で動かしている場合は何もしない (実際に時間が経過しているため)
+     * @details 模擬I2Cバスはトランザクションごとに転送時間を反映するため、I2Cの読み出しを繰り返す待ちループも仮想時刻で終了する
+     * @param us 経過時間 (単位: us)
+     */
+    static void elapse(uint32_t us);
+
+    /* GPIO */
+
+    /**
+     * @brief ピンのモード (INPUT, OUTPUT, INPUT_PULLUP) を取得する
+     */
+    static uint8_t getPinMode(uint8_t pin);
+
+    /**
+     * @brief 出力ピンにdigitalWrite()で書き込まれた値を取得する
+     */
+    static uint8_t getPinOutput(uint8_t pin);
+
+    /**
+     * @brief 入力ピンの値を設定する (digitalRead()が返す値)
+     */
+    static void setPinInput(uint8_t pin, uint8_t level);
+
+    /**
+     * @brief 入力ピンのアナログ値を設定する (analogRead()が返す値)
+     */
+    static void setAnalogInput(uint8_t pin, uint16_t value);
+
+    /* PWM (LEDC) */
+
+    /**
+     * @brief LEDCチャンネルに書き込まれたDutyを取得する
+     */
+    static uint32_t getLEDCDuty(uint8_t channel);
+
+    /**
+     * @brief LEDCチャンネルに設定された周波数を取得する (単位: Hz)
+     */
+    static uint32_t getLEDCFrequency(uint8_t channel);
+
+    /**
+     * @brief LEDCチャンネルに設定された分解能を取得する (単位: bit)
+     */
+    static uint8_t getLEDCResolution(uint8_t channel);
+
+    /**
+     * @brief ピンに接続されたLEDCチャンネルの出力をDuty比で取得する
+     * @return Duty比 (0.0~1.0, 負値: LEDCに接続されていない)
+     */
+    static float getPinDuty(uint8_t pin);
+
+    /**
+     * @brief ピンに接続されたLEDCチャンネルの出力をパルス幅で取得する
+     * @return パルス幅 (単位: us, 負値: LEDCに接続されていない)
+     */
+    static float getPinPulseWidth(uint8_t pin);
+
+    /* エンコーダ */
+
+    /**
+     * @brief エンコーダのカウントを進める
+     * @details Encoderクラスのインスタンスのうち、1つ目の接続ピンがpinのものに加算される
+     * @param pin エンコーダの接続ピン1
+     * @param delta 加算するカウント
+     */
+    static void addEncoderCount(uint8_t pin, int32_t delta);
+
+    /* I2C */
+
+    /**
+     * @brief 模擬するI2Cデバイスを接続する
+     * @param address 7bitアドレス
+     * @param device デバイス (NULL: 切り離す)。所有権は移らない
+     */
+    static void attachI2CDevice(uint8_t address, EJ_HAL_I2CDevice *device);
+
+    /**
+     * @brief 指定したアドレスに接続されたI2Cデバイスを取得する
+     * @return デバイス (NULL: 未接続)
+     */
+    static EJ_HAL_I2CDevice *getI2CDevice(uint8_t address);
+
+    /* シリアルポート */
+
+    /**
+     * @brief Serialの入出力を端末デバイス (擬似端末など) につなぐ
+     * @details つないでいない場合、Serialは標準出力に書き込み、読み出すデータはない。環境変数EJ_SERIALにパスを指定すると起動時につなぐ
+     * @param path デバイスのパス (例: /dev/pts/3)
+     * @return true: つないだ / false: 開けなかった
+     */
+    static bool openSerial(const char *path);
+
+    /**
+     * @brief Serialを標準出力に戻す
+     */
+    static void closeSerial();
+
+    /**
+     * @brief Serialの入出力のファイルディスクリプタを取得する (-1: 入力なし)
+     */
+    static int getSerialFd();
+
+    /* 実行制御 */
+
+    /**
+     * @brief loop()の繰り返しを終了させる
+     * @param code プロセスの終了コード
+     */
+    static void stop(int code = 0);
+
+    /**
+     * @brief loop()を繰り返すかどうか判定する
+     */
+    static bool running();
+
+    /**
+     * @brief stop()で指定された終了コードを取得する
+     */
+    static int exitCode();
+};
+
+#endif // EJHAL
@@ -0,0 +1,191 @@
+#include "EJ_Sim.h"
+
+/*----------
+class EJ_Sim
+----------*/
+
+/* static member */
+bool EJ_Sim::_running = false;
+uint64_t EJ_Sim::_now = 0;
+uint64_t EJ_Sim::_integrated = 0;
+uint32_t EJ_Sim::_step = 100;
+EJ_SimPlant *EJ_Sim::_plants[EJ_SIM_MAX_PLANTS];
+uint8_t EJ_Sim::_plantCount = 0;
+EJ_Sim::Event EJ_Sim::_events[EJ_SIM_MAX_EVENTS];
+uint8_t EJ_Sim::_eventCount = 0;
+
+/* private method */
+uint64_t EJ_Sim::clock()
+{
+    return _now;
+}
+
+void EJ_Sim::sleep(uint32_t us)
+{
+    advance(us);
+}
+
+/* static public method */
+void EJ_Sim::begin(uint32_t step)
+{
+    _now = 0;
+    _integrated = 0;
+    _step = step > 0 ? step : 1;
+    _plantCount = 0;
+    _eventCount = 0;
+    _running = true;
+    EJ_HAL::setClock(clock, sleep);
+}
+
+void EJ_Sim::end()
+{
+    _running = false;
+    EJ_HAL::setClock(NULL, NULL);
+}
+
+bool EJ_Sim::addPlant(EJ_SimPlant *plant)
+{
+    if (plant == NULL || _plantCount >= EJ_SIM_MAX_PLANTS) {
+        return false;
+    }
+    _plants[_plantCount++] = plant;
+    return true;
+}
+
+bool EJ_Sim::at(uint64_t time, Action action, void *context)
+{
+    if (action == NULL || _eventCount >= EJ_SIM_MAX_EVENTS) {
+        return false;
+    }
+    /* 実行時刻の昇順に挿入する (同時刻は予約順) */
+    uint8_t index = _eventCount;
+    while (index > 0 && _events[index - 1].time > time) {
+        _events[index] = _events[index - 1];
+        index--;
+    }
+    _events[index].time = time;
+    _events[index].action = action;
+    _events[index].context = context;
+    _eventCount++;
+    return true;
+}
+
+void EJ_Sim::advance(uint64_t us)
+{
+    uint64_t target = _now + us;
+    /* 刻み幅に満たない端数は次回に持ち越し、積分は常に同じ刻み幅で行う */
+    while (_integrated + _step <= target) {
+        _integrated += _step;
+        _now = _integrated;
+        float dt = (float)_step * 1e-6f;
+        for (uint8_t i = 0; i < _plantCount; i++) {
+            _plants[i]->step(_now, dt);
+        }
+        while (_eventCount > 0 && _events[0].time <= _now) {
+            Event event = _events[0];
+            for (uint8_t i = 1; i < _eventCount; i++) {
+                _events[i - 1] = _events[i];
+            }
+            _eventCount--;
+            event.action(event.context);
+        }
+    }
+    _now = target;
+}
+
+uint64_t EJ_Sim::now()
+{
+    return _now;
+}
+
+bool EJ_Sim::isRunning()
+{
+    return _running;
+}
+
+/*----------------------
+class EJ_SimStepResponse
+----------------------*/
+
+EJ_SimStepResponse::EJ_SimStepResponse()
+{
+    begin(0.0f, 1.0f, 0.02f, 0);
+}
+
+void EJ_SimStepResponse::begin(float initial, float target, float band, int64_t start)
+{
+    _initial = initial;
+    _target = target;
+    _band = band;
+    _start = start < 0 ? EJ_Sim::now() : (uint64_t)start;
+    _time10 = 0;
+    _time90 = 0;
+    _reached10 = false;
+    _reached90 = false;
+    _peak = initial;
+    _lastOutside = _start;
+    _settled = false;
+    _last = initial;
+    _count = 0;
+}
+
+void EJ_SimStepResponse::sample(uint64_t time, float value)
+{
+    float span = _target - _initial;
+    /* ステップの向きによらず、0 (初期値) → 1 (目標値) に正規化して評価する */
+    float progress = span != 0.0f ? (value - _initial) / span : 1.0f;
+    if (!_reached10 && progress >= 0.1f) {
+        _reached10 = true;
+        _time10 = time;
+    }
+    if (!_reached90 && progress >= 0.9f) {
+        _reached90 = true;
+        _time90 = time;
+    }
+    float peak = span != 0.0f ? (_peak - _initial) / span : 1.0f;
+    if (_count == 0 || progress > peak) {
+        _peak = value;
+    }
+    _settled = fabsf(1.0f - progress) <= _band;
+    if (!_settled) {
+        _lastOutside = time;
+    }
+    _last = value;
+    _count++;
+}
+
+float EJ_SimStepResponse::getRiseTime()
+{
+    return _reached90 ? (float)(_time90 - _time10) * 1e-6f : -1.0f;
+}
+
+float EJ_SimStepResponse::getOvershoot()
+{
+    float span = _target - _initial;
+    if (span == 0.0f) {
+        return 0.0f;
+    }
+    float overshoot = (_peak - _initial) / span - 1.0f;
+    return overshoot > 0.0f ? overshoot : 0.0f;
+}
+
+float EJ_SimStepResponse::getSettlingTime()
+{
+    return _settled ? (float)(_lastOutside - _start) * 1e-6f : -1.0f;
+}
+
+float EJ_SimStepResponse::getSteadyStateError()
+{
+    return _target - _last;
+}
+
+uint32_t EJ_SimStepResponse::getSampleCount()
+{
+    return _count;
+}
+
+void EJ_SimStepResponse::print(Print &out, const char *name)
+{
+    out.printf("%s: rise=%.4fs overshoot=%.2f%% settling=%.4fs error=%.3f samples=%u\n",
+        name, getRiseTime(), getOvershoot() * 100.0f, getSettlingTime(), getSteadyStateError(), (unsigned)_count);
+}
@@ -0,0 +1,239 @@
+/**
+ * @file           EJ_Sim.h
+ * @brief          仮想時刻で模擬周辺機能と物理モデルを進めるシミュレータEJ_Simと、ステップ応答の評価指標を求めるEJ_SimStepResponseの定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSIM
+#define EJSIM
+#include <Arduino.h>
+
+/**
+ * @brief 登録できる物理モデルの最大数
+ */
+#define EJ_SIM_MAX_PLANTS 16
+
+/**
+ * @brief 登録できる予定イベントの最大数
+ */
+#define EJ_SIM_MAX_EVENTS 64
+
+/**
+ * @brief 仮想時刻で進める物理モデルの基底クラス
+ */
+class EJ_SimPlant
+{
+public:
+    virtual ~EJ_SimPlant() {}
+
+    /**
+     * @brief モデルを1刻み進める
+     * @param now 刻みの終了時刻 (単位: us)
+     * @param dt 刻み幅 (単位: s)
+     */
+    virtual void step(uint64_t now, float dt) = 0;
+};
+
+/**
+ * @brief 仮想時刻のシミュレータ
+ * @details begin()を呼ぶとmillis(), micros(), delay()が仮想時刻に従うようになる。delay()や模擬I2Cバスの転送時間で時刻が進むたびに、登録した物理モデルが固定の刻み幅で積分される
+ * @details 実時間の待機を一切行わないため、ホストの速度に応じて実時間の数百倍以上で進み、同じ入力に対して常に同じ結果になる
+ * @details at()で時刻を指定したイベント (負荷の印加、目標値の変更、終了など) を予約して、シナリオを記述する
+ * @details 本クラスはインスタンス化しない
+ * @code
+ * EJ_SimDCMotor plant(25, 26, 27, 35, params);
+ * EJ_SimStepResponse response;
+ *
+ * void setup() {
+ *     EJ_Sim::begin();
+ *     EJ_Sim::addPlant(&plant);
+ *     EJ_Sim::at(2000000, stopScenario, NULL);
+ *     motor = EJ_EncoderMotor_Manager::createEncoderMotor(25, 26, 35, 36, 27, 0);
+ *     response.begin(0, 1000, 0.02f);
+ * }
+ *
+ * void loop() {
+ *     int32_t position = motor->Encoder::read();
+ *     motor->setPWM(constrain((1000 - position) / 4, -100, 100));
+ *     response.sample(EJ_Sim::now(), position);
+ *     delay(1);
+ * }
+ * @endcode
+ */
+class EJ_Sim
+{
+private:
+    EJ_Sim();
+
+public:
+    /**
+     * @brief 予定イベントの処理関数
+     */
+    typedef void (*Action)(void *context);
+
+    /**
+     * @brief 仮想時刻を0から開始し、EJ_HALの時計を仮想時刻に切り替える
+     * @details 登録済みの物理モデルと予定イベントは破棄される
+     * @param step 物理モデルの積分の刻み幅 (単位: us, default: 100)
+     */
+    static void begin(uint32_t step = 100);
+
+    /**
+     * @brief EJ_HALの時計をホストの時計に戻す
+     */
+    static void end();
+
+    /**
+     * @brief 物理モデルを登録する
+     * @param plant 物理モデル。所有権は移らない
+     * @return true: 登録成功 / false: 登録数の上限を超えた
+     */
+    static bool addPlant(EJ_SimPlant *plant);
+
+    /**
+     * @brief 指定した時刻に実行するイベントを予約する
+     * @param time 実行時刻 (単位: us)
+     * @param action 処理関数
+     * @param context 処理関数に渡す値
+     * @return true: 予約成功 / false: 予約数の上限を超えた
+     */
+    static bool at(uint64_t time, Action action, void *context);
+
+    /**
+     * @brief 仮想時刻を進める
+     * @param us 進める時間 (単位: us)
+     */
+    static void advance(uint64_t us);
+
+    /**
+     * @brief 現在の仮想時刻を取得する (単位: us)
+     */
+    static uint64_t now();
+
+    /**
+     * @brief 仮想時刻で動作しているかどうか判定する
+     */
+    static bool isRunning();
+
+private:
+    static uint64_t clock();
+    static void sleep(uint32_t us);
+
+private:
+    typedef struct
+    {
+        uint64_t time;
+        Action action;
+        void *context;
+    } Event;
+
+    static bool _running;
+    static uint64_t _now;
+    static uint64_t _integrated;
+    static uint32_t _step;
+    static EJ_SimPlant *_plants[EJ_SIM_MAX_PLANTS];
+    static uint8_t _plantCount;
+    static Event _events[EJ_SIM_MAX_EVENTS];
+    static uint8_t _eventCount;
+};
+
+/**
+ * @brief ステップ応答の評価指標 (立ち上がり時間、オーバーシュート、整定時間、定常偏差) を求めるクラス
+ * @details begin()で初期値と目標値を設定し、sample()で応答を時系列順に入力する
+ */
+class EJ_SimStepResponse
+{
+public:
+    EJ_SimStepResponse();
+
+    /**
+     * @brief 評価を開始する
+     * @param initial 初期値
+     * @param target 目標値
+     * @param band 整定とみなす範囲 (ステップ幅に対する割合, default: 0.02)
+     * @param start ステップを与えた時刻 (単位: us, default: 現在の仮想時刻)
+     */
+    void begin(float initial, float target, float band = 0.02f, int64_t start = -1);
+
+    /**
+     * @brief 応答を1点入力する
+     * @param time 時刻 (単位: us)
+     * @param value 値
+     */
+    void sample(uint64_t time, float value);
+
+    /**
+     * @brief 立ち上がり時間 (ステップ幅の10%から90%に達するまで) を取得する
+     * @return 立ち上がり時間 (単位: s, 負値: まだ90%に達していない)
+     */
+    float getRiseTime();
+
+    /**
+     * @brief オーバーシュートを取得する
+     * @return 目標値を超えた最大量のステップ幅に対する割合 (0: オーバーシュートなし)
+     */
+    float getOvershoot();
+
+    /**
+     * @brief 整定時間 (最後に整定範囲の外にあった時刻までの時間) を取得する
+     * @return 整定時間 (単位: s, 負値: 最後のサンプルで整定範囲の外にある)
+     */
+    float getSettlingTime();
+
+    /**
+     * @brief 最後のサンプルでの偏差 (目標値 - 値) を取得する
+     */
+    float getSteadyStateError();
+
+    /**
+     * @brief 入力したサンプル数を取得する
+     */
+    uint32_t getSampleCount();
+
+    /**
+     * @brief 評価指標を出力する
+     * @param out 出力先 (Serialなど)
+     * @param name シナリオ名
+     */
+    void print(Print &out, const char *name);
+
+private:
+    float _initial;
+    float _target;
+    float _band;
+    uint64_t _start;
+    uint64_t _time10;
+    uint64_t _time90;
+    bool _reached10;
+    bool _reached90;
+    float _peak;
+    uint64_t _lastOutside;
+    bool _settled;
+    float _last;
+    uint32_t _count;
+};
+
+#endif // EJSIM
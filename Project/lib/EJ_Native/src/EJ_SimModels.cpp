@@ -0,0 +1,528 @@
+#include "EJ_SimModels.h"
+
+/* VL53L0Xのレジスタ */
+static const uint8_t REG_SYSRANGE_START = 0x00;
+static const uint8_t REG_SYSTEM_INTERRUPT_CLEAR = 0x0B;
+static const uint8_t REG_RESULT_INTERRUPT_STATUS = 0x13;
+static const uint8_t REG_RESULT_RANGE_STATUS = 0x14;
+static const uint8_t REG_SPAD_INFO_READY = 0x83;
+static const uint8_t REG_SPAD_INFO = 0x92;
+static const uint8_t REG_NVM_ADDRESS = 0x94;
+static const uint8_t REG_NVM_DATA = 0x90;
+static const uint8_t NVM_UNIQUE_ID_UPPER = 0x7B;
+static const uint8_t NVM_UNIQUE_ID_LOWER = 0x7C;
+static const uint8_t REG_I2C_SLAVE_DEVICE_ADDRESS = 0x8A;
+static const uint8_t REG_IDENTIFICATION_MODEL_ID = 0xC0;
+static const uint8_t REG_PAGE_SELECT = 0xFF;
+
+/* 測距ステータス (結果レジスタの bit6-3) */
+static const uint8_t RANGE_STATUS_VALID = 11;
+static const uint8_t RANGE_STATUS_PHASE_FAIL = 4;
+static const uint16_t RANGE_OUT_OF_RANGE = 8190;
+
+/* PCA9685のレジスタ */
+static const uint8_t PCA_REG_MODE1 = 0x00;
+static const uint8_t PCA_REG_MODE2 = 0x01;
+static const uint8_t PCA_REG_LED0_ON_L = 0x06;
+static const uint8_t PCA_REG_LED15_OFF_H = 0x45;
+static const uint8_t PCA_REG_ALL_LED_ON_L = 0xFA;
+static const uint8_t PCA_REG_ALL_LED_OFF_H = 0xFD;
+static const uint8_t PCA_REG_PRE_SCALE = 0xFE;
+
+/* PCA9685のMODE1のビット */
+static const uint8_t PCA_MODE1_RESTART = 0x80;
+static const uint8_t PCA_MODE1_AI = 0x20;
+static const uint8_t PCA_MODE1_SLEEP = 0x10;
+static const uint8_t PCA_MODE1_ALLCALL = 0x01;
+
+/* PCA9685の内蔵発振器の周波数 (単位: Hz) */
+static const float PCA_OSCILLATOR = 25000000.0f;
+
+static float signum(float value)
+{
+    return value > 0.0f ? 1.0f : (value < 0.0f ? -1.0f : 0.0f);
+}
+
+/*----------------
+class EJ_SimRandom
+----------------*/
+
+EJ_SimRandom::EJ_SimRandom(uint32_t seed)
+:   _state(seed != 0 ? seed : 1)
+{}
+
+uint32_t EJ_SimRandom::next()
+{
+    _state ^= _state << 13;
+    _state ^= _state >> 17;
+    _state ^= _state << 5;
+    return _state;
+}
+
+float EJ_SimRandom::uniform()
+{
+    return (float)(next() >> 8) / 16777216.0f;
+}
+
+float EJ_SimRandom::gaussian()
+{
+    /* Box-Muller法 */
+    float u1 = uniform();
+    float u2 = uniform();
+    if (u1 < 1e-7f) {
+        u1 = 1e-7f;
+    }
+    return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)PI * u2);
+}
+
+/*-----------------
+class EJ_SimDCMotor
+-----------------*/
+
+EJ_SimDCMotor::EJ_SimDCMotor(uint8_t pin1, uint8_t pin2, int8_t en, int8_t encoder, const SimDCMotorDef &def)
+:   _pin1(pin1),
+    _pin2(pin2),
+    _en(en),
+    _encoder(encoder),
+    _def(def),
+    _load(0.0f),
+    _angle(0.0f),
+    _velocity(0.0f),
+    _current(0.0f),
+    _counts(0)
+{}
+
+void EJ_SimDCMotor::step(uint64_t now, float dt)
+{
+    (void)now;
+    uint8_t a = EJ_HAL::getPinOutput(_pin1);
+    uint8_t b = EJ_HAL::getPinOutput(_pin2);
+    float direction = (a == HIGH && b == LOW) ? 1.0f : ((a == LOW && b == HIGH) ? -1.0f : 0.0f);
+    float duty = _en >= 0 ? EJ_HAL::getPinDuty((uint8_t)_en) : 1.0f;
+    if (duty < _def.deadband) {
+        duty = 0.0f;
+    }
+
+    /* 電気系: インダクタンスを無視し、電流は印加電圧と逆起電力の差で決まる (方向0は端子短絡) */
+    float voltage = direction * duty * _def.voltage;
+    _current = (voltage - _def.torqueConstant * _velocity) / _def.resistance;
+
+    /* 機械系: 静止中は駆動トルクがクーロン摩擦を超えるまで動かない */
+    float drive = _def.torqueConstant * _current - _def.viscousFriction * _velocity;
+    float motion = _velocity != 0.0f ? signum(_velocity) : signum(drive);
+    drive -= _load * motion;
+    if (_velocity == 0.0f && fabsf(drive) <= _def.coulombFriction) {
+        return;
+    }
+    float torque = drive - _def.coulombFriction * motion;
+    float velocity = _velocity + torque / _def.inertia * dt;
+    /* 摩擦で符号が反転する場合はその刻みで停止させる */
+    if (_velocity != 0.0f && signum(velocity) != signum(_velocity) && fabsf(drive) <= _def.coulombFriction) {
+        velocity = 0.0f;
+    }
+    _velocity = velocity;
+    _angle += _velocity * dt;
+
+    if (_encoder >= 0) {
+        int32_t counts = (int32_t)floorf(_angle / (2.0f * (float)PI) * _def.countsPerRev);
+        if (counts != _counts) {
+            EJ_HAL::addEncoderCount((uint8_t)_encoder, counts - _counts);
+            _counts = counts;
+        }
+    }
+}
+
+void EJ_SimDCMotor::setLoad(float torque)
+{
+    _load = torque;
+}
+
+float EJ_SimDCMotor::getAngle()
+{
+    return _angle;
+}
+
+float EJ_SimDCMotor::getVelocity()
+{
+    return _velocity;
+}
+
+float EJ_SimDCMotor::getCurrent()
+{
+    return _current;
+}
+
+/*---------------
+class EJ_SimServo
+---------------*/
+
+EJ_SimServo::EJ_SimServo(uint8_t pin, float speed, uint16_t min, uint16_t max)
+:   _pin(pin),
+    _speed(speed),
+    _min(min),
+    _max(max),
+    _angle(90.0f),
+    _target(90.0f),
+    _load(1.0f),
+    _initialized(false)
+{}
+
+void EJ_SimServo::step(uint64_t now, float dt)
+{
+    (void)now;
+    float us = EJ_HAL::getPinPulseWidth(_pin);
+    if (us > 0.0f) {
+        _target = constrain((us - _min) * 180.0f / (float)(_max - _min), 0.0f, 180.0f);
+        if (!_initialized) {
+            /* 最初のパルスを受け取った時点ではホーンが目標角度にあるとみなす */
+            _angle = _target;
+            _initialized = true;
+        }
+    }
+    float limit = _speed * _load * dt;
+    float error = _target - _angle;
+    _angle += constrain(error, -limit, limit);
+}
+
+float EJ_SimServo::getAngle()
+{
+    return _angle;
+}
+
+float EJ_SimServo::getTarget()
+{
+    return _target;
+}
+
+void EJ_SimServo::setLoad(float factor)
+{
+    _load = factor;
+}
+
+/*-----------------
+class EJ_SimVL53L0X
+-----------------*/
+
+EJ_SimVL53L0X::EJ_SimVL53L0X(uint8_t address, uint32_t seed)
+:   _address(address),
+    _pointer(0),
+    _random(seed),
+    _range(500),
+    _noise(0.0f),
+    _maxRange(2000),
+    _period(33000),
+    _timeoutRate(0.0f),
+    _continuous(false),
+    _measuring(false),
+    _lost(false),
+    _stalled(false),
+    _readyAt(0),
+    _count(0)
+{
+    _uniqueId[0] = 0x4C3F2A00;
+    _uniqueId[1] = seed;
+    memset(_registers, 0, sizeof(_registers));
+    _registers[0][REG_IDENTIFICATION_MODEL_ID] = 0xEE;
+    _registers[0][REG_I2C_SLAVE_DEVICE_ADDRESS] = address;
+    _registers[0][REG_SPAD_INFO] = 0x05;
+    EJ_HAL::attachI2CDevice(_address, this);
+}
+
+EJ_SimVL53L0X::~EJ_SimVL53L0X()
+{
+    if (EJ_HAL::getI2CDevice(_address) == this) {
+        EJ_HAL::attachI2CDevice(_address, NULL);
+    }
+}
+
+uint8_t &EJ_SimVL53L0X::reg(uint8_t index)
+{
+    /* 0xFFはページ選択レジスタで、どちらのページからも同じものが見える */
+    uint8_t page = (index != REG_PAGE_SELECT && _registers[0][REG_PAGE_SELECT] == 0x01) ? 1 : 0;
+    return _registers[page][index];
+}
+
+void EJ_SimVL53L0X::startMeasurement()
+{
+    _measuring = true;
+    _readyAt = EJ_HAL::now() + _period;
+    _lost = _random.uniform() < _timeoutRate;
+}
+
+void EJ_SimVL53L0X::update()
+{
+    uint64_t now = EJ_HAL::now();
+    while (_measuring && now >= _readyAt) {
+        if (!_lost) {
+            float range = (float)_range + _noise * _random.gaussian();
+            bool valid = _range <= _maxRange;
+            uint16_t value = valid ? (uint16_t)constrain(range, 0.0f, 8189.0f) : RANGE_OUT_OF_RANGE;
+            uint8_t *result = &_registers[0][REG_RESULT_RANGE_STATUS];
+            result[0] = (uint8_t)((valid ? RANGE_STATUS_VALID : RANGE_STATUS_PHASE_FAIL) << 3);
+            result[2] = 0x0A;  /* SPAD数 (8.8固定小数点) */
+            result[3] = 0x00;
+            result[6] = 0x01;  /* 信号レート (9.7固定小数点) */
+            result[7] = 0x80;
+            result[8] = 0x00;  /* 環境光レート */
+            result[9] = 0x10;
+            result[10] = (uint8_t)(value >> 8);
+            result[11] = (uint8_t)(value & 0xFF);
+            _registers[0][REG_RESULT_INTERRUPT_STATUS] = 0x04;
+            _count++;
+        }
+        if (_continuous) {
+            /* 連続測距では結果の読み出しを待たずに次の測距が始まる */
+            _readyAt += _period;
+            _lost = _random.uniform() < _timeoutRate;
+        } else {
+            _measuring = false;
+        }
+    }
+}
+
+bool EJ_SimVL53L0X::write(const uint8_t *data, size_t length)
+{
+    if (_stalled) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    update();
+    _pointer = data[0];
+    for (size_t i = 1; i < length; i++, _pointer++) {
+        uint8_t value = data[i];
+        bool page0 = _registers[0][REG_PAGE_SELECT] != 0x01;
+        if (page0 && _pointer == REG_SYSRANGE_START) {
+            if (value & 0x02) {
+                _continuous = true;
+                startMeasurement();
+            } else if (value & 0x01) {
+                if (_continuous) {
+                    _continuous = false;
+                    _measuring = false;
+                } else {
+                    startMeasurement();
+                }
+            }
+            /* bit0 (開始) は測距の開始とともにクリアされる */
+            reg(_pointer) = value & (uint8_t)~0x01;
+        } else if (page0 && _pointer == REG_SYSTEM_INTERRUPT_CLEAR) {
+            if (value & 0x01) {
+                _registers[0][REG_RESULT_INTERRUPT_STATUS] = 0;
+            }
+        } else if (page0 && _pointer == REG_SPAD_INFO_READY && value == 0x00) {
+            /* SPAD情報や固有IDのNVMの読み出し要求には即座に完了を返す */
+            reg(_pointer) = 0x10;
+            uint8_t address = reg(REG_NVM_ADDRESS);
+            if (address == NVM_UNIQUE_ID_UPPER || address == NVM_UNIQUE_ID_LOWER) {
+                uint32_t id = _uniqueId[address - NVM_UNIQUE_ID_UPPER];
+                for (uint8_t b = 0; b < 4; b++) {
+                    reg(REG_NVM_DATA + b) = (uint8_t)(id >> (24 - 8 * b));
+                }
+            }
+        } else if (page0 && _pointer == REG_I2C_SLAVE_DEVICE_ADDRESS) {
+            uint8_t address = value & 0x7F;
+            if (EJ_HAL::getI2CDevice(_address) == this) {
+                EJ_HAL::attachI2CDevice(_address, NULL);
+            }
+            _address = address;
+            EJ_HAL::attachI2CDevice(_address, this);
+            reg(_pointer) = address;
+        } else {
+            reg(_pointer) = value;
+        }
+    }
+    return true;
+}
+
+size_t EJ_SimVL53L0X::read(uint8_t *data, size_t length)
+{
+    if (_stalled) {
+        return 0;
+    }
+    update();
+    for (size_t i = 0; i < length; i++, _pointer++) {
+        data[i] = reg(_pointer);
+    }
+    return length;
+}
+
+void EJ_SimVL53L0X::setRange(uint16_t range)
+{
+    _range = range;
+}
+
+void EJ_SimVL53L0X::setNoise(float sigma)
+{
+    _noise = sigma;
+}
+
+void EJ_SimVL53L0X::setMaxRange(uint16_t range)
+{
+    _maxRange = range;
+}
+
+void EJ_SimVL53L0X::setMeasurementPeriod(uint32_t period)
+{
+    _period = period;
+}
+
+void EJ_SimVL53L0X::setTimeoutRate(float rate)
+{
+    _timeoutRate = rate;
+}
+
+void EJ_SimVL53L0X::setUniqueId(uint32_t upper, uint32_t lower)
+{
+    _uniqueId[0] = upper;
+    _uniqueId[1] = lower;
+}
+
+void EJ_SimVL53L0X::setStalled(bool stalled)
+{
+    _stalled = stalled;
+}
+
+uint32_t EJ_SimVL53L0X::getMeasurementCount()
+{
+    return _count;
+}
+
+/*-----------------
+class EJ_SimPCA9685
+-----------------*/
+
+EJ_SimPCA9685::EJ_SimPCA9685(uint8_t address)
+:   _address(address),
+    _pointer(0),
+    _stalled(false),
+    _transactions(0)
+{
+    /* 電源投入時の値 (スリープ中、全チャンネルFULL_OFF) */
+    memset(_registers, 0, sizeof(_registers));
+    _registers[PCA_REG_MODE1] = PCA_MODE1_SLEEP | PCA_MODE1_ALLCALL;
+    _registers[PCA_REG_MODE2] = 0x04;
+    _registers[PCA_REG_PRE_SCALE] = 0x1E;
+    for (uint8_t channel = 0; channel < 16; channel++) {
+        _registers[PCA_REG_LED0_ON_L + 4 * channel + 3] = 0x10;
+    }
+    EJ_HAL::attachI2CDevice(_address, this);
+}
+
+EJ_SimPCA9685::~EJ_SimPCA9685()
+{
+    if (EJ_HAL::getI2CDevice(_address) == this) {
+        EJ_HAL::attachI2CDevice(_address, NULL);
+    }
+}
+
+void EJ_SimPCA9685::writeRegister(uint8_t index, uint8_t value)
+{
+    if (index == PCA_REG_MODE1) {
+        /* RESTARTは1を書き込むとクリアされる */
+        _registers[index] = value & (uint8_t)~PCA_MODE1_RESTART;
+    } else if (index == PCA_REG_PRE_SCALE) {
+        /* PRE_SCALEはスリープ中にしか書き込めない */
+        if (_registers[PCA_REG_MODE1] & PCA_MODE1_SLEEP) {
+            _registers[index] = value;
+        }
+    } else if (index >= PCA_REG_ALL_LED_ON_L && index <= PCA_REG_ALL_LED_OFF_H) {
+        /* ALL_LEDは書き込み専用で、全チャンネルの同じレジスタに反映される */
+        for (uint8_t channel = 0; channel < 16; channel++) {
+            _registers[PCA_REG_LED0_ON_L + 4 * channel + (index - PCA_REG_ALL_LED_ON_L)] = value;
+        }
+    } else {
+        _registers[index] = value;
+    }
+}
+
+void EJ_SimPCA9685::advancePointer()
+{
+    if ((_registers[PCA_REG_MODE1] & PCA_MODE1_AI) == 0) {
+        return;
+    }
+    _pointer = (_pointer == PCA_REG_LED15_OFF_H) ? 0 : (uint8_t)(_pointer + 1);
+}
+
+bool EJ_SimPCA9685::write(const uint8_t *data, size_t length)
+{
+    if (_stalled) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    _transactions++;
+    _pointer = data[0];
+    for (size_t i = 1; i < length; i++) {
+        writeRegister(_pointer, data[i]);
+        advancePointer();
+    }
+    return true;
+}
+
+size_t EJ_SimPCA9685::read(uint8_t *data, size_t length)
+{
+    if (_stalled) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        bool allLed = _pointer >= PCA_REG_ALL_LED_ON_L && _pointer <= PCA_REG_ALL_LED_OFF_H;
+        data[i] = allLed ? 0 : _registers[_pointer];
+        advancePointer();
+    }
+    return length;
+}
+
+uint16_t EJ_SimPCA9685::getOn(uint8_t channel)
+{
+    const uint8_t *led = &_registers[PCA_REG_LED0_ON_L + 4 * (channel & 0x0F)];
+    return (uint16_t)(led[0] | ((led[1] & 0x1F) << 8));
+}
+
+uint16_t EJ_SimPCA9685::getOff(uint8_t channel)
+{
+    const uint8_t *led = &_registers[PCA_REG_LED0_ON_L + 4 * (channel & 0x0F)];
+    return (uint16_t)(led[2] | ((led[3] & 0x1F) << 8));
+}
+
+float EJ_SimPCA9685::getPulseWidth(uint8_t channel)
+{
+    uint16_t on = getOn(channel);
+    uint16_t off = getOff(channel);
+    float period = 1000000.0f / getFrequency();
+    /* FULL_OFFはFULL_ONより優先される */
+    if (isSleeping() || (off & 0x1000)) {
+        return 0.0f;
+    }
+    if (on & 0x1000) {
+        return period;
+    }
+    return (float)((off - on) & 0x0FFF) * period / 4096.0f;
+}
+
+uint8_t EJ_SimPCA9685::getPreScale()
+{
+    return _registers[PCA_REG_PRE_SCALE];
+}
+
+float EJ_SimPCA9685::getFrequency()
+{
+    return PCA_OSCILLATOR / (4096.0f * (_registers[PCA_REG_PRE_SCALE] + 1));
+}
+
+bool EJ_SimPCA9685::isSleeping()
+{
+    return (_registers[PCA_REG_MODE1] & PCA_MODE1_SLEEP) != 0;
+}
+
+uint32_t EJ_SimPCA9685::getTransactionCount()
+{
+    return _transactions;
+}
+
+void EJ_SimPCA9685::setStalled(bool stalled)
+{
+    _stalled = stalled;
+}
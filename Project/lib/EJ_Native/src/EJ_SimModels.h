@@ -0,0 +1,352 @@
+/**
+ * @file           EJ_SimModels.h
+ * @brief          シミュレータで用いる物理モデル (DCモータとエンコーダ、サーボ、VL53L0X) の定義
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJSIMMODELS
+#define EJSIMMODELS
+#include <Arduino.h>
+#include "EJ_Sim.h"
+
+/**
+ * @brief 再現性のある擬似乱数 (xorshift32)
+ */
+class EJ_SimRandom
+{
+public:
+    /**
+     * @param seed 乱数の種 (0以外)
+     */
+    explicit EJ_SimRandom(uint32_t seed = 1);
+
+    /**
+     * @brief 32bitの一様乱数を取得する
+     */
+    uint32_t next();
+
+    /**
+     * @brief [0, 1)の一様乱数を取得する
+     */
+    float uniform();
+
+    /**
+     * @brief 標準正規分布の乱数を取得する
+     */
+    float gaussian();
+
+private:
+    uint32_t _state;
+};
+
+/**
+ * @struct SimDCMotorDef
+ * @brief DCモータの物理パラメータ (出力軸換算)
+ */
+typedef struct
+{
+    float voltage;         /**< 電源電圧 (単位: V) */
+    float resistance;      /**< 巻線抵抗 (単位: Ω) */
+    float torqueConstant;  /**< トルク定数 = 逆起電力定数 (単位: N·m/A = V·s/rad) */
+    float inertia;         /**< 慣性モーメント (単位: kg·m^2) */
+    float viscousFriction; /**< 粘性摩擦係数 (単位: N·m·s/rad) */
+    float coulombFriction; /**< クーロン摩擦 (単位: N·m) */
+    float deadband;        /**< ドライバの不感帯 (このDuty比未満では出力されない, 0.0~1.0) */
+    float countsPerRev;    /**< 出力軸1回転あたりのエンコーダのカウント数 */
+} SimDCMotorDef;
+
+/**
+ * @brief DCモータとエンコーダの物理モデル
+ * @details ピン1, ピン2の出力で回転方向を、PWM設定ピンのLEDC出力で電圧を決め、電機子のインダクタンスを無視した1次の電気系と慣性、粘性摩擦、クーロン摩擦 (静止摩擦) の機械系を積分する
+ * @details ピン1, ピン2が同じレベルのときは端子を短絡した状態 (ブレーキ) とし、逆起電力による制動がかかる
+ * @details 回転角をエンコーダのカウントに量子化し、差分をEJ_HAL::addEncoderCount()でEncoderに与える
+ */
+class EJ_SimDCMotor : public EJ_SimPlant
+{
+public:
+    /**
+     * @param pin1 モーターの接続ピン1
+     * @param pin2 モーターの接続ピン2
+     * @param en PWM設定ピン (負値: 常に最大出力)
+     * @param encoder エンコーダの接続ピン1 (負値: エンコーダなし)
+     * @param def 物理パラメータ
+     */
+    EJ_SimDCMotor(uint8_t pin1, uint8_t pin2, int8_t en, int8_t encoder, const SimDCMotorDef &def);
+
+    virtual void step(uint64_t now, float dt);
+
+    /**
+     * @brief 外部からの負荷トルクを設定する (単位: N·m, 回転を妨げる向きが正)
+     */
+    void setLoad(float torque);
+
+    /**
+     * @brief 回転角を取得する (単位: rad)
+     */
+    float getAngle();
+
+    /**
+     * @brief 角速度を取得する (単位: rad/s)
+     */
+    float getVelocity();
+
+    /**
+     * @brief 電流を取得する (単位: A)
+     */
+    float getCurrent();
+
+private:
+    uint8_t _pin1;
+    uint8_t _pin2;
+    int8_t _en;
+    int8_t _encoder;
+    SimDCMotorDef _def;
+    float _load;
+    float _angle;
+    float _velocity;
+    float _current;
+    int32_t _counts;
+};
+
+/**
+ * @brief サーボの物理モデル
+ * @details 接続ピンのLEDC出力からパルス幅を求めて目標角度に変換し、一定の角速度で追従させる。パルスが途切れた場合はその場で止まる
+ */
+class EJ_SimServo : public EJ_SimPlant
+{
+public:
+    /**
+     * @param pin サーボの接続ピン
+     * @param speed 最大角速度 (単位: 度/s)
+     * @param min 0度に対応するパルス幅 (単位: us, default: 544)
+     * @param max 180度に対応するパルス幅 (単位: us, default: 2400)
+     */
+    EJ_SimServo(uint8_t pin, float speed, uint16_t min = 544, uint16_t max = 2400);
+
+    virtual void step(uint64_t now, float dt);
+
+    /**
+     * @brief ホーンの角度を取得する (単位: 度)
+     */
+    float getAngle();
+
+    /**
+     * @brief 最後に受け取ったパルスから求めた目標角度を取得する (単位: 度)
+     */
+    float getTarget();
+
+    /**
+     * @brief 負荷を設定する (最大角速度に掛ける係数, 1.0: 無負荷)
+     */
+    void setLoad(float factor);
+
+private:
+    uint8_t _pin;
+    float _speed;
+    uint16_t _min;
+    uint16_t _max;
+    float _angle;
+    float _target;
+    float _load;
+    bool _initialized;
+};
+
+/**
+ * @brief VL53L0XのI2Cレジスタの模擬
+ * @details EJ_HALに接続して使う。VL53L0X::init()とEJ_ToFUnitの測距の手順に応答し、測距開始から測距時間が経過すると、setRange()で与えた距離に正規分布の雑音を加えた結果を結果レジスタに置く
+ * @details 距離がsetMaxRange()を超える場合は範囲外 (距離8190、ステータス不正) を返す。setTimeoutRate()で指定した確率で測距が完了せず、EJ_ToFUnit側のタイムアウトを起こす
+ * @details I2Cアドレスの変更 (レジスタ0x8A) に従ってEJ_HALへの接続先を移す
+ */
+class EJ_SimVL53L0X : public EJ_HAL_I2CDevice
+{
+public:
+    /**
+     * @param address I2Cアドレス (default: 0x29)
+     * @param seed 雑音の乱数の種
+     */
+    explicit EJ_SimVL53L0X(uint8_t address = 0x29, uint32_t seed = 1);
+    virtual ~EJ_SimVL53L0X();
+
+    virtual bool write(const uint8_t *data, size_t length);
+    virtual size_t read(uint8_t *data, size_t length);
+
+    /**
+     * @brief 真の距離を設定する (単位: mm)
+     */
+    void setRange(uint16_t range);
+
+    /**
+     * @brief 距離の雑音の標準偏差を設定する (単位: mm)
+     */
+    void setNoise(float sigma);
+
+    /**
+     * @brief 測定できる最大距離を設定する (単位: mm, default: 2000)
+     */
+    void setMaxRange(uint16_t range);
+
+    /**
+     * @brief 1回の測距にかかる時間を設定する (単位: us, default: 33000)
+     */
+    void setMeasurementPeriod(uint32_t period);
+
+    /**
+     * @brief 測距結果が得られない確率を設定する (0.0~1.0)
+     * @details 失われた回が続き、EJ_ToFUnitのタイムアウト時間を超えるとタイムアウトになる
+     */
+    void setTimeoutRate(float rate);
+
+    /**
+     * @brief NVMの固有ID (部品ID) を設定する (default: 上位0x4C3F2A00, 下位は乱数の種)
+     * @details センサの交換を模擬する場合に、別の値を設定する
+     */
+    void setUniqueId(uint32_t upper, uint32_t lower);
+
+    /**
+     * @brief I2Cに応答しない状態にする
+     * @param stalled true: 全てのトランザクションにNACKを返す / false: 通常の応答
+     */
+    void setStalled(bool stalled);
+
+    /**
+     * @brief 完了した測距の回数を取得する
+     */
+    uint32_t getMeasurementCount();
+
+private:
+    /**
+     * @brief 測距を開始する
+     */
+    void startMeasurement();
+
+    /**
+     * @brief 測距の完了時刻を過ぎていれば結果レジスタを更新する
+     */
+    void update();
+
+    /**
+     * @brief 現在のページのレジスタを取得する
+     */
+    uint8_t &reg(uint8_t index);
+
+private:
+    uint8_t _address;
+    uint8_t _registers[2][256];
+    uint8_t _pointer;
+    EJ_SimRandom _random;
+    uint16_t _range;
+    float _noise;
+    uint16_t _maxRange;
+    uint32_t _period;
+    float _timeoutRate;
+    bool _continuous;
+    bool _measuring;
+    bool _lost;
+    bool _stalled;
+    uint64_t _readyAt;
+    uint32_t _count;
+    uint32_t _uniqueId[2];
+};
+
+/**
+ * @brief PCA9685のI2Cレジスタの模擬
+ * @details EJ_HALに接続して使う。MODE1のオートインクリメント (AI)、スリープ (SLEEP)、再起動 (RESTART) に従い、PRE_SCALEはスリープ中の書き込みだけを受け付ける
+ * @details オートインクリメントはLEDnのレジスタ (0x06~0x45) を含む0x00~0x45の範囲で行い、0x45の次は0x00に戻る。ALL_LED (0xFA~0xFD) への書き込みは全チャンネルの同じレジスタに反映する
+ * @details パルス幅はPRE_SCALEと内蔵発振器 (25MHz) から求め、スリープ中やFULL_OFFのチャンネルは0を返す
+ */
+class EJ_SimPCA9685 : public EJ_HAL_I2CDevice
+{
+public:
+    /**
+     * @param address I2Cアドレス (default: 0x40)
+     */
+    explicit EJ_SimPCA9685(uint8_t address = 0x40);
+    virtual ~EJ_SimPCA9685();
+
+    virtual bool write(const uint8_t *data, size_t length);
+    virtual size_t read(uint8_t *data, size_t length);
+
+    /**
+     * @brief チャンネルのONのカウントを取得する (bit12: FULL_ON)
+     */
+    uint16_t getOn(uint8_t channel);
+
+    /**
+     * @brief チャンネルのOFFのカウントを取得する (bit12: FULL_OFF)
+     */
+    uint16_t getOff(uint8_t channel);
+
+    /**
+     * @brief チャンネルの出力のパルス幅を取得する (単位: us)
+     */
+    float getPulseWidth(uint8_t channel);
+
+    /**
+     * @brief PRE_SCALEの値を取得する
+     */
+    uint8_t getPreScale();
+
+    /**
+     * @brief PWMの周波数を取得する (単位: Hz)
+     */
+    float getFrequency();
+
+    /**
+     * @brief スリープ中かどうか判定する
+     */
+    bool isSleeping();
+
+    /**
+     * @brief 受け付けた書き込みトランザクションの回数を取得する
+     */
+    uint32_t getTransactionCount();
+
+    /**
+     * @brief I2Cに応答しない状態にする
+     * @param stalled true: 全てのトランザクションにNACKを返す / false: 通常の応答
+     */
+    void setStalled(bool stalled);
+
+private:
+    /**
+     * @brief 1バイトのレジスタに書き込む
+     */
+    void writeRegister(uint8_t index, uint8_t value);
+
+    /**
+     * @brief オートインクリメントが有効ならレジスタのポインタを進める
+     */
+    void advancePointer();
+
+private:
+    uint8_t _address;
+    uint8_t _registers[256];
+    uint8_t _pointer;
+    bool _stalled;
+    uint32_t _transactions;
+};
+
+#endif // EJSIMMODELS
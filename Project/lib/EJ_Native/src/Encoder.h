@@ -0,0 +1,56 @@
+/**
+ * @file           Encoder.h
+ * @brief          ホスト (Linux) 向けのEncoderライブラリの代替。カウントはEJ_HAL::addEncoderCount()で与える
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJNATIVE_ENCODER
+#define EJNATIVE_ENCODER
+#include <Arduino.h>
+
+/**
+ * @brief 模擬エンコーダ (Encoderライブラリ互換)
+ * @details 生成したインスタンスはEJ_HALに登録され、EJ_HAL::addEncoderCount()で接続ピン1を指定してカウントを進める
+ */
+class Encoder
+{
+public:
+    Encoder(uint8_t pin1, uint8_t pin2);
+    ~Encoder();
+
+    int32_t read();
+    int32_t readAndReset();
+    void write(int32_t position);
+
+private:
+    friend class EJ_HAL;
+    static Encoder *_head;
+    Encoder *_next;
+    uint8_t _pin1;
+    volatile int32_t _position;
+};
+
+#endif // EJNATIVE_ENCODER
@@ -0,0 +1,155 @@
+#include "Wire.h"
+
+/* 1トランザクションの転送時間 (開始条件, アドレス, データ, 停止条件をそれぞれ9クロックとみなす) */
+static uint32_t transferTime(uint32_t frequency, size_t length)
+{
+    return (uint32_t)(((uint64_t)(length + 2) * 9 * 1000000ULL + frequency - 1) / frequency);
+}
+
+/*-----------
+class TwoWire
+-----------*/
+
+TwoWire Wire;
+
+TwoWire::TwoWire()
+:   _frequency(100000),
+    _address(0),
+    _transmitting(false),
+    _txLength(0),
+    _rxLength(0),
+    _rxIndex(0)
+{}
+
+bool TwoWire::begin()
+{
+    return true;
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    if (frequency != 0) {
+        _frequency = frequency;
+    }
+    return true;
+}
+
+bool TwoWire::end()
+{
+    return true;
+}
+
+void TwoWire::setClock(uint32_t frequency)
+{
+    _frequency = frequency;
+}
+
+uint32_t TwoWire::getClock()
+{
+    return _frequency;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address = address;
+    _transmitting = true;
+    _txLength = 0;
+}
+
+void TwoWire::beginTransmission(int address)
+{
+    beginTransmission((uint8_t)address);
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    if (!_transmitting) {
+        return 4;
+    }
+    _transmitting = false;
+    EJ_HAL_I2CDevice *device = EJ_HAL::getI2CDevice(_address);
+    /* 戻り値はArduinoと同じ (0: 成功, 2: アドレスにNACK, 3: データにNACK) */
+    EJ_HAL::elapse(transferTime(_frequency, _txLength));
+    if (device == NULL) {
+        return 2;
+    }
+    return device->write(_txBuffer, _txLength) ? 0 : 3;
+}
+
+uint8_t TwoWire::endTransmission()
+{
+    return endTransmission(true);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    (void)sendStop;
+    _rxIndex = 0;
+    _rxLength = 0;
+    EJ_HAL_I2CDevice *device = EJ_HAL::getI2CDevice(address);
+    EJ_HAL::elapse(transferTime(_frequency, quantity));
+    if (device == NULL) {
+        return 0;
+    }
+    size_t length = quantity < EJ_NATIVE_WIRE_BUFFER ? quantity : EJ_NATIVE_WIRE_BUFFER;
+    _rxLength = device->read(_rxBuffer, length);
+    return (uint8_t)_rxLength;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+    return requestFrom(address, quantity, (uint8_t)1);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity)
+{
+    return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)1);
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop)
+{
+    return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop);
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (!_transmitting || _txLength >= EJ_NATIVE_WIRE_BUFFER) {
+        return 0;
+    }
+    _txBuffer[_txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    size_t n = 0;
+    while (n < quantity && write(data[n])) {
+        n++;
+    }
+    return n;
+}
+
+int TwoWire::available()
+{
+    return (int)(_rxLength - _rxIndex);
+}
+
+int TwoWire::read()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1;
+}
+
+void TwoWire::flush()
+{
+    _rxIndex = 0;
+    _rxLength = 0;
+    _txLength = 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file           Wire.h
+ * @brief          ホスト (Linux) 向けのWireライブラリの代替。トランザクションをEJ_HALに接続した模擬I2Cデバイスに送る
+ * @author         IKDnot
+ * @date           2026/10/19
+ * 
+ * License
+ * 
+ * Copyright (c) 2023 IKDnot
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef EJNATIVE_WIRE
+#define EJNATIVE_WIRE
+#include <Arduino.h>
+
+/**
+ * @brief 送受信バッファの大きさ (単位: byte)
+ */
+#define EJ_NATIVE_WIRE_BUFFER 128
+
+/**
+ * @brief 模擬I2Cバス (TwoWire互換)
+ * @details endTransmission()で書き込みのトランザクションを、requestFrom()で読み出しのトランザクションをEJ_HAL::getI2CDevice()のデバイスに渡す
+ */
+class TwoWire : public Print
+{
+public:
+    TwoWire();
+
+    bool begin();
+    bool begin(int sda, int scl, uint32_t frequency = 0);
+    bool end();
+    void setClock(uint32_t frequency);
+    uint32_t getClock();
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address);
+    uint8_t endTransmission(bool sendStop);
+    uint8_t endTransmission();
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+    uint8_t requestFrom(int address, int quantity);
+    uint8_t requestFrom(int address, int quantity, int sendStop);
+
+    virtual size_t write(uint8_t data);
+    virtual size_t write(const uint8_t *data, size_t quantity);
+    using Print::write;
+    int available();
+    int read();
+    int peek();
+    void flush();
+
+private:
+    uint32_t _frequency;
+    uint8_t _address;
+    bool _transmitting;
+    uint8_t _txBuffer[EJ_NATIVE_WIRE_BUFFER];
+    size_t _txLength;
+    uint8_t _rxBuffer[EJ_NATIVE_WIRE_BUFFER];
+    size_t _rxLength;
+    size_t _rxIndex;
+};
+
+extern TwoWire Wire;
+
+#endif // EJNATIVE_WIRE
@@ -0,0 +1,28 @@
+#include <Arduino.h>
+#include <stdio.h>
+
+/* スケッチがsetup(), loop()を定義しない場合 (ライブラリ単体のビルド) は何もせずに終了する */
+__attribute__((weak)) void setup()
+{}
+
+__attribute__((weak)) void loop()
+{
+    EJ_HAL::stop();
+}
+
+/* Arduinoコアと同じく、setup()を1回呼んだ後にEJ_HAL::stop()が呼ばれるまでloop()を繰り返す */
+int main()
+{
+    EJ_HAL::reset();
+    const char *port = getenv("EJ_SERIAL");
+    if (port != NULL && !EJ_HAL::openSerial(port)) {
+        fprintf(stderr, "EJ_SERIAL: cannot open %s\n", port);
+        return 1;
+    }
+    setup();
+    while (EJ_HAL::running()) {
+        loop();
+    }
+    Serial.flush();
+    return EJ_HAL::exitCode();
+}
@@ -0,0 +1,270 @@
+#include "EJ_Command.h"
+#include "EJ_ErrorLog.h"
+#include "EJ_Executive.h"
+#include "EJ_DCMotor.h"
+#include "EJ_ServoMotor.h"
+#include "EJ_EncoderMotor.h"
+#include "EJ_PhotoInterrupter.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*--------------
+class EJ_Command
+--------------*/
+
+/* static member */
+const char* EJ_Command::_classname = "EJ_Command";
+Stream *EJ_Command::_io = NULL;
+uint8_t EJ_Command::_buffer[EJ_COBS_MAX_ENCODED(EJ_COMMAND_REQUEST_SIZE)];
+size_t EJ_Command::_length = 0;
+bool EJ_Command::_overflow = false;
+uint8_t EJ_Command::_reply[EJ_COBS_MAX_ENCODED(EJ_COMMAND_ACK_SIZE)];
+uint32_t EJ_Command::_applied = 0;
+uint32_t EJ_Command::_rejected = 0;
+uint32_t EJ_Command::_corrupted = 0;
+
+static int32_t readInt32(const uint8_t *data)
+{
+    return (int32_t)((uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+}
+
+static void writeInt32(uint8_t *data, int32_t value)
+{
+    data[0] = (uint8_t)((uint32_t)value & 0xFF);
+    data[1] = (uint8_t)(((uint32_t)value >> 8) & 0xFF);
+    data[2] = (uint8_t)(((uint32_t)value >> 16) & 0xFF);
+    data[3] = (uint8_t)(((uint32_t)value >> 24) & 0xFF);
+}
+
+/* private method */
+void EJ_Command::process(size_t length)
+{
+    /* COBSの復号はフレームより短くなるため、受信バッファ上でそのまま行う */
+    size_t size = EJ_Framing::decode(_buffer, length, _buffer);
+    if (size < 3 + 2 || EJ_Framing::crc16(_buffer, size - 2) != (uint16_t)(_buffer[size - 2] | (_buffer[size - 1] << 8))) {
+        _corrupted++;
+        return;
+    }
+    size -= 2;
+    uint8_t sequence = _buffer[1];
+    uint8_t count = _buffer[2];
+    const uint8_t *commands = _buffer + 3;
+    if (_buffer[0] != EJ_COMMAND_FRAME_REQUEST || count > EJ_COMMAND_MAX_BATCH || size != 3 + (size_t)count * EJ_COMMAND_SIZE) {
+        _rejected++;
+        reply(sequence, EJ_COMMAND_MALFORMED, 0xFF, commands, 0);
+        return;
+    }
+    /* 全コマンドを検証してから適用し、途中まで適用された状態を作らない */
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *command = commands + i * EJ_COMMAND_SIZE;
+        EJ_CommandStatus status = validate(command[0], command[1], command[2], readInt32(command + 3));
+        if (status != EJ_COMMAND_OK) {
+            _rejected++;
+            reply(sequence, status, i, commands, 0);
+            return;
+        }
+    }
+    /* 周期処理を止めたまま適用し、周期処理からは1フレーム分のコマンドが同時に適用されたように見せる */
+    EJ_Executive::lock();
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *command = commands + i * EJ_COMMAND_SIZE;
+        apply(command[0], command[1], command[2], readInt32(command + 3));
+    }
+    EJ_Executive::unlock();
+    _applied++;
+    reply(sequence, EJ_COMMAND_OK, 0xFF, commands, count);
+}
+
+EJ_CommandStatus EJ_Command::validate(uint8_t target, uint8_t id, uint8_t operation, int32_t value)
+{
+    EJ_DCMotor *motor = NULL;
+    switch (target) {
+        case EJ_COMMAND_DCMOTOR:
+            motor = EJ_DCMotor_Manager::find(id);
+            if (motor == NULL) {
+                return EJ_COMMAND_INVALID_DEVICE;
+            }
+            break;
+        case EJ_COMMAND_ENCODERMOTOR:
+            motor = EJ_EncoderMotor_Manager::find(id);
+            if (motor == NULL) {
+                return EJ_COMMAND_INVALID_DEVICE;
+            }
+            if (operation == EJ_COMMAND_SET_TARGET || operation == EJ_COMMAND_SET_POSITION) {
+                return EJ_COMMAND_OK;
+            }
+            break;
+        case EJ_COMMAND_SERVO:
+            if (EJ_ServoMotor_Manager::find(id) == NULL) {
+                return EJ_COMMAND_INVALID_DEVICE;
+            }
+            if (operation == EJ_COMMAND_SET_ANGLE) {
+                return value >= 0 && value <= 18000 ? EJ_COMMAND_OK : EJ_COMMAND_INVALID_VALUE;
+            }
+            return operation == EJ_COMMAND_QUERY || operation == EJ_COMMAND_STOP ? EJ_COMMAND_OK : EJ_COMMAND_INVALID_OPERATION;
+        case EJ_COMMAND_PHOTOINTERRUPTER:
+            if (EJ_PhotoInterrupter_Manager::find(id) == NULL) {
+                return EJ_COMMAND_INVALID_DEVICE;
+            }
+            return operation == EJ_COMMAND_QUERY ? EJ_COMMAND_OK : EJ_COMMAND_INVALID_OPERATION;
+        default:
+            return EJ_COMMAND_INVALID_DEVICE;
+    }
+    /* DCMotorとEncoderMotorに共通の操作 */
+    if (operation == EJ_COMMAND_SET_PWM) {
+        /* enピン無しのモーターではsetPWMが何もしないため、受理せずに拒否を返す */
+        if (!motor->isPWMEnabled()) {
+            return EJ_COMMAND_INVALID_OPERATION;
+        }
+        return value >= -100 && value <= 100 ? EJ_COMMAND_OK : EJ_COMMAND_INVALID_VALUE;
+    }
+    return operation == EJ_COMMAND_QUERY || operation == EJ_COMMAND_STOP ? EJ_COMMAND_OK : EJ_COMMAND_INVALID_OPERATION;
+}
+
+void EJ_Command::apply(uint8_t target, uint8_t id, uint8_t operation, int32_t value)
+{
+    if (target == EJ_COMMAND_DCMOTOR) {
+        EJ_DCMotor *motor = EJ_DCMotor_Manager::find(id);
+        if (operation == EJ_COMMAND_STOP) {
+            motor->stop();
+        } else if (operation == EJ_COMMAND_SET_PWM) {
+            motor->setPWM((int16_t)value);
+        }
+    } else if (target == EJ_COMMAND_ENCODERMOTOR) {
+        EJ_EncoderMotor *motor = EJ_EncoderMotor_Manager::find(id);
+        if (operation == EJ_COMMAND_STOP) {
+            motor->stop();
+        } else if (operation == EJ_COMMAND_SET_PWM) {
+            motor->setPWM((int16_t)value);
+        } else if (operation == EJ_COMMAND_SET_TARGET) {
+            motor->setTarget(value);
+        } else if (operation == EJ_COMMAND_SET_POSITION) {
+            motor->Encoder::write(value);
+        }
+    } else if (target == EJ_COMMAND_SERVO) {
+        EJ_ServoMotor *servo = EJ_ServoMotor_Manager::find(id);
+        if (operation == EJ_COMMAND_STOP) {
+            servo->stopMotion();
+        } else if (operation == EJ_COMMAND_SET_ANGLE) {
+            servo->writeCentiDegrees(value);
+        }
+    }
+}
+
+void EJ_Command::getState(uint8_t target, uint8_t id, int32_t &value1, int32_t &value2)
+{
+    value1 = 0;
+    value2 = 0;
+    if (target == EJ_COMMAND_DCMOTOR) {
+        value1 = EJ_DCMotor_Manager::find(id)->getPWM();
+    } else if (target == EJ_COMMAND_ENCODERMOTOR) {
+        EJ_EncoderMotor *motor = EJ_EncoderMotor_Manager::find(id);
+        value1 = motor->peek();
+        value2 = motor->getPWM();
+    } else if (target == EJ_COMMAND_SERVO) {
+        EJ_ServoMotor *servo = EJ_ServoMotor_Manager::find(id);
+        value1 = servo->readCentiDegrees();
+        value2 = servo->getCommandedCentiDegrees();
+    } else if (target == EJ_COMMAND_PHOTOINTERRUPTER) {
+        value1 = EJ_PhotoInterrupter_Manager::find(id)->peek() ? 1 : 0;
+    }
+}
+
+void EJ_Command::reply(uint8_t sequence, EJ_CommandStatus status, uint8_t index, const uint8_t *commands, uint8_t count)
+{
+    uint8_t ack[EJ_COMMAND_ACK_SIZE];
+    size_t length = 0;
+    ack[length++] = EJ_COMMAND_FRAME_ACK;
+    ack[length++] = sequence;
+    ack[length++] = (uint8_t)status;
+    ack[length++] = index;
+    ack[length++] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *command = commands + i * EJ_COMMAND_SIZE;
+        int32_t value1;
+        int32_t value2;
+        getState(command[0], command[1], value1, value2);
+        ack[length++] = command[0];
+        ack[length++] = command[1];
+        writeInt32(ack + length, value1);
+        writeInt32(ack + length + 4, value2);
+        length += 8;
+    }
+    uint16_t crc = EJ_Framing::crc16(ack, length);
+    ack[length++] = (uint8_t)(crc & 0xFF);
+    ack[length++] = (uint8_t)(crc >> 8);
+    _io->write(_reply, EJ_Framing::encode(ack, length, _reply));
+}
+
+/* static public method */
+void EJ_Command::begin(Stream &io)
+{
+    _io = &io;
+    _length = 0;
+    _overflow = false;
+}
+
+uint8_t EJ_Command::poll()
+{
+    if (_io == NULL) {
+        /*
+        ERRORLOG
+            内容：begin()を呼ぶ前にpoll()が呼ばれた
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return 0;
+    }
+    uint8_t applied = 0;
+    while (_io->available() > 0) {
+        int c = _io->read();
+        if (c < 0) {
+            break;
+        }
+        if (feed((uint8_t)c)) {
+            applied++;
+        }
+    }
+    return applied;
+}
+
+bool EJ_Command::feed(uint8_t c)
+{
+    if (c != 0) {
+        if (_length < sizeof(_buffer)) {
+            _buffer[_length++] = c;
+        } else {
+            _overflow = true;
+        }
+        return false;
+    }
+    /* 区切りの0x00でフレームが完了する。長すぎたフレームは次の区切りまで読み捨てる */
+    size_t length = _length;
+    bool overflow = _overflow;
+    _length = 0;
+    _overflow = false;
+    if (overflow) {
+        _corrupted++;
+        return false;
+    }
+    if (length == 0 || _io == NULL) {
+        return false;
+    }
+    uint32_t applied = _applied;
+    process(length);
+    return _applied != applied;
+}
+
+uint32_t EJ_Command::getAppliedCount()
+{
+    return _applied;
+}
+
+uint32_t EJ_Command::getRejectedCount()
+{
+    return _rejected;
+}
+
+uint32_t EJ_Command::getCorruptedCount()
+{
+    return _corrupted;
+}
@@ -1,19 +1,10 @@
 #include "EJ_DCMotor.h"
 #include <math.h>
 
-#ifdef M5CORE2
-#include <M5Core2.h>
-#elif M5STICKCPLUS
-#include <M5StickCPlus.h>
-#else
-#undef M5_DEBUG
-#endif
-
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
-#else
-#define ERRORLOG() ((void)0)
-#endif
+#include "EJ_ErrorLog.h"
+#include "EJ_Trace.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
 
 /*--------------
 class EJ_DCMotor
@@ -24,18 +15,22 @@ const char* EJ_DCMotor::_classname = "EJ_DCMotor";
 
 /* private method */
 EJ_DCMotor::EJ_DCMotor(uint8_t pin1, uint8_t pin2, int8_t en)
-:   _pin1(pin1),
+:   _enablePWM(false),
+    _pin1(pin1),
     _pin2(pin2),
     _en(en),
-    _enablePWM(false),
-    _duty(0)
+    _duty(0),
+    _channel(-1)
 {
-    if (_en >= 0) {
-        _enablePWM = true;
-    }
     pinMode(_pin1, OUTPUT);
     pinMode(_pin2, OUTPUT);
-    pinMode(_en, OUTPUT);
+    if (_en >= 0) {
+        _channel = EJ_Peripheral::allocateLEDC(EJ_DCMOTOR_PWM_FREQUENCY, EJ_DCMOTOR_PWM_RESOLUTION);
+        if (_channel >= 0) {
+            ledcAttachPin(_en, _channel);
+            _enablePWM = true;
+        }
+    }
     setPWM(_duty);
     stop();
 }
@@ -48,7 +43,13 @@ void EJ_DCMotor::write(uint8_t bit1, uint8_t bit2)
 
 /* public method */
 EJ_DCMotor::~EJ_DCMotor()
-{}
+{
+    if (_channel >= 0) {
+        ledcWrite(_channel, 0);
+        ledcDetachPin(_en);
+        EJ_Peripheral::release(EJ_PERIPHERAL_LEDC, _channel);
+    }
+}
 
 void EJ_DCMotor::forward()
 {
@@ -67,12 +68,13 @@ void EJ_DCMotor::stop()
 
 void EJ_DCMotor::setPWM(int16_t duty)
 {
+    EJ_TRACE_SCOPE("EJ_DCMotor::setPWM");
     if (!_enablePWM) return;
 
     _duty = constrain(duty, -100, 100);
-    uint8_t setVal = map(abs(_duty), 0, 100, 0, 255);
+    uint32_t setVal = map(abs(_duty), 0, 100, 0, (1L << EJ_DCMOTOR_PWM_RESOLUTION) - 1);
 
-    analogWrite(_en, setVal);
+    ledcWrite(_channel, setVal);
 
     if (_duty > 0) {
         forward();
@@ -88,74 +90,35 @@ int16_t EJ_DCMotor::getPWM()
     return _duty;
 }
 
-/*----------------------
-class EJ_DCMotor_Manager 
-----------------------*/
-
-/* static member */
-EJ_DCMotor_Manager* EJ_DCMotor_Manager::_singleton = NULL;
-const char* EJ_DCMotor_Manager::_classname = "EJ_DCMotor_Manager";
-
-/* private method */
-EJ_DCMotor_Manager::EJ_DCMotor_Manager(size_t maxInstanceSize)
-:   _maxInstanceSize(maxInstanceSize),
-    _instanceList(NULL)
+int8_t EJ_DCMotor::getPWMChannel()
 {
-    _instanceList = new EJ_DCMotor*[_maxInstanceSize];
-    if (_instanceList == NULL) {
-        /* 
-        ERRORLOG 
-            内容: メモリ確保に失敗した
-        */
-        ERRORLOG();
-        return;
-    }
-    for (size_t i = 0; i < _maxInstanceSize; i++) {
-        _instanceList[i] = NULL;
-    }
+    return _channel;
 }
 
-/* static private method */
-EJ_DCMotor_Manager* EJ_DCMotor_Manager::getInstance()
+bool EJ_DCMotor::isPWMEnabled()
 {
-    if (_singleton == NULL) {
-        /*
-        ERROLOG
-            内容：シングルトンがまだ生成されていない
-        */
-        ERRORLOG();
-        return NULL;
-    }
-
-    return _singleton;
+    return _enablePWM;
 }
 
-/* public method */
-EJ_DCMotor_Manager::~EJ_DCMotor_Manager()
-{
-    if (_instanceList != NULL) {
-        for (size_t i = 0; i < _maxInstanceSize; i++) {
-            if (_instanceList[i] != NULL) {
-                delete _instanceList[i];
-                _instanceList[i] = NULL;
-            }
-        }
-    }
-}
+/*----------------------
+class EJ_DCMotor_Manager 
+----------------------*/
+
+/* static member */
+const char* EJ_DCMotor_Manager::_classname = "EJ_DCMotor_Manager";
+template <>
+const char* EJ_Manager<EJ_DCMotor, EJ_DCMOTOR_MAX_INSTANCES>::_classname = "EJ_DCMotor_Manager";
 
 /* static public method */
 bool EJ_DCMotor_Manager::configure(size_t maxInstanceSize)
 {
-    if (_singleton == NULL) {
-        _singleton = new EJ_DCMotor_Manager(maxInstanceSize);
-        if (_singleton == NULL) {
-            /*
-            ERROLOG
-                内容：メモリ確保に失敗した 
-            */
-            ERRORLOG();
-            return false;
-        }
+    if (maxInstanceSize > EJ_DCMOTOR_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_DCMOTOR_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
     }
     return true;
 }
@@ -167,37 +130,20 @@ EJ_DCMotor* EJ_DCMotor_Manager::createMotor(MotorDef motor)
 
 EJ_DCMotor* EJ_DCMotor_Manager::createMotor(uint8_t pin1, uint8_t pin2, int8_t en, uint8_t id)
 {
-    EJ_DCMotor_Manager *manager = EJ_DCMotor_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
+    if (contains(id)) {
+        return &at(id);
     }
-    if (id > manager->_maxInstanceSize) {
+    EJ_DCMotor* instance = create(id, pin1, pin2, en);
+    if (instance != NULL && en >= 0 && instance->_channel < 0) {
         /*
         ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
+            内容：LEDCチャンネルの割り当てに失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        destroy(id);
         return NULL;
     }
-    if (manager->_instanceList[id] == NULL) {
-        EJ_DCMotor *instance = new EJ_DCMotor(pin1, pin2, en);
-        if (instance == NULL) {
-            /*
-            ERRORLOG
-                内容：メモリ確保に失敗した
-            */
-            ERRORLOG();
-            return NULL;
-        }
-        manager->_instanceList[id] = instance;
-    }
-
-    return manager->_instanceList[id];
+    return instance;
 }
 
 EJ_DCMotor* EJ_DCMotor_Manager::getMotor(MotorDef motor)
@@ -208,7 +154,7 @@ EJ_DCMotor* EJ_DCMotor_Manager::getMotor(MotorDef motor)
         ERROLOG
             内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ID);
         return NULL;
     }
     if (instance->_pin1 != motor.pin1 || instance->_pin2 != motor.pin2 || instance->_en != motor.en) {
@@ -216,7 +162,7 @@ EJ_DCMotor* EJ_DCMotor_Manager::getMotor(MotorDef motor)
         ERROLOG
             内容：指定されたidが指すインスタンスと、確保済みの同じidのインスタンスが一致しない
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INSTANCE_MISMATCH);
         return NULL;
     }
     return instance;
@@ -224,31 +170,5 @@ EJ_DCMotor* EJ_DCMotor_Manager::getMotor(MotorDef motor)
 
 EJ_DCMotor* EJ_DCMotor_Manager::getMotor(uint8_t id)
 {
-    EJ_DCMotor_Manager *manager = EJ_DCMotor_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
-    }
-
-    if (id >= manager->_maxInstanceSize) {
-        /*
-        ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
-        */
-        ERRORLOG();
-        return NULL;
-    } 
-    if (manager->_instanceList[id] == NULL) {
-        /*
-        ERRORLOG
-            内容：指定されたidのインスタンスが存在しない
-        */
-        ERRORLOG();
-        return NULL;
-    }
-    return manager->_instanceList[id];
+    return get(id);
 }
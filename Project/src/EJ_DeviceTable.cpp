@@ -0,0 +1,88 @@
+#include "EJ_DeviceTable.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*-------------------
+class EJ_DeviceTable
+-------------------*/
+
+/* static member */
+const char* EJ_DeviceTable::_classname = "EJ_DeviceTable";
+
+/* static public method */
+bool EJ_DeviceTable::createAll(const DeviceDef *table, size_t count)
+{
+    if (table == NULL) {
+        /*
+        ERRORLOG
+            内容：デバイステーブルがNULL
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+
+    bool result = true;
+    /* 接続先が先に生成されているよう、I2CHub → PCA9685 → その他の順に生成する */
+    for (uint8_t pass = 0; pass < 3; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            uint8_t order = table[i].type == EJ_DEVICE_I2CHUB ? 0 : table[i].type == EJ_DEVICE_PCA9685 ? 1 : 2;
+            if (order != pass) {
+                continue;
+            }
+            if (!create(table[i])) {
+                result = false;
+            }
+        }
+    }
+    return result;
+}
+
+bool EJ_DeviceTable::create(const DeviceDef &device)
+{
+    /* テーブルのEJ_NO_PINは、マネージャの引数では-1 (PWM無効) にあたる */
+    int8_t en = device.pins[2] == EJ_NO_PIN ? -1 : (int8_t)device.pins[2];
+    bool created = false;
+
+    switch (device.type) {
+    case EJ_DEVICE_DCMOTOR:
+        created = EJ_DCMotor_Manager::createMotor(device.pins[0], device.pins[1], en, device.id) != NULL;
+        break;
+    case EJ_DEVICE_ENCODERMOTOR:
+        created = EJ_EncoderMotor_Manager::createEncoderMotor(device.pins[0], device.pins[1], device.pins[3], device.pins[4], en, device.id) != NULL;
+        break;
+    case EJ_DEVICE_SERVO:
+        created = EJ_ServoMotor_Manager::createServo(device.pins[0], device.id) != NULL;
+        break;
+    case EJ_DEVICE_SERVO_RMT:
+        created = EJ_ServoMotor_Manager::createRMTServo(device.pins[0], device.id) != NULL;
+        break;
+    case EJ_DEVICE_SERVO_PCA9685:
+        created = EJ_ServoMotor_Manager::createExpanderServo(device.address, device.channel, device.id) != NULL;
+        break;
+    case EJ_DEVICE_PHOTOINTERRUPTER:
+        created = EJ_PhotoInterrupter_Manager::createPhotoInterrupter(device.pins[0], device.id) != NULL;
+        break;
+    case EJ_DEVICE_TOFUNIT:
+        created = EJ_ToFUnit_Manager::createToFUnit(device.id, device.address) != NULL;
+        break;
+    case EJ_DEVICE_I2CHUB:
+        created = EJ_I2CHub_Manager::createI2CHub(device.id, device.address) != NULL;
+        break;
+    case EJ_DEVICE_PCA9685:
+        created = EJ_PCA9685_Manager::createPCA9685(device.id, device.address, 50.0f, device.hub, device.channel) != NULL;
+        break;
+    default:
+        break;
+    }
+
+    if (!created) {
+        /*
+        ERRORLOG
+            内容：デバイスの生成に失敗した、または未対応のデバイスの種類
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+    }
+    return created;
+}
@@ -1,17 +1,16 @@
 #include "EJ_EncoderMotor.h"
 
-#ifdef M5CORE2
-#include <M5Core2.h>
-#elif M5STICKCPLUS
-#include <M5StickCPlus.h>
-#else
-#undef M5_DEBUG
-#endif
+#include "EJ_ErrorLog.h"
+#include "EJ_SensorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
 
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
+#ifdef ARDUINO_ARCH_ESP32
+#define MOTION_LOCK() portENTER_CRITICAL(&_mux)
+#define MOTION_UNLOCK() portEXIT_CRITICAL(&_mux)
 #else
-#define ERRORLOG() ((void)0)
+#define MOTION_LOCK() ((void)0)
+#define MOTION_UNLOCK() ((void)0)
 #endif
 
 /*-------------------
@@ -23,28 +22,61 @@ const char* EJ_EncoderMotor::_classname = "EJ_EncoderMotor";
 
 /* private method */
 EJ_EncoderMotor::EJ_EncoderMotor(uint8_t pin1, uint8_t pin2, uint8_t enc1, uint8_t enc2, int8_t en)
-:   _enc1(enc1),
+:   EJ_DCMotor(pin1, pin2, en),
+    Encoder(enc1, enc2),
+    _enc1(enc1),
     _enc2(enc2),
     _target(0),
-    EJ_DCMotor(pin1, pin2, en),
-    Encoder(_enc1, _enc2)
-{}
+    _direction(0)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+}
 
 /* public method */
 EJ_EncoderMotor::~EJ_EncoderMotor()
 {}
 
+void EJ_EncoderMotor::forward() {
+    MOTION_LOCK();
+    _direction = 0;
+    EJ_DCMotor::forward();
+    MOTION_UNLOCK();
+}
+
+void EJ_EncoderMotor::reverse() {
+    MOTION_LOCK();
+    _direction = 0;
+    EJ_DCMotor::reverse();
+    MOTION_UNLOCK();
+}
+
+void EJ_EncoderMotor::setPWM(int16_t duty) {
+    MOTION_LOCK();
+    _direction = 0;
+    EJ_DCMotor::setPWM(duty);
+    MOTION_UNLOCK();
+}
+
 void EJ_EncoderMotor::move(long relativePosition) {
-    _target = Encoder::read() + relativePosition;
+    if (relativePosition == 0) {
+        stop();
+        return;
+    }
+    long position = read();
+    /* 周期処理のupdate()が古い向きと新しい目標位置の組で停止しないよう、向きを0にしてから書き換え、出力後に向きを公開する */
+    MOTION_LOCK();
+    _direction = 0;
+    _target = position + relativePosition;
     if (relativePosition > 0) {
         EJ_DCMotor::forward();
+        _direction = 1;
     } else {
         EJ_DCMotor::reverse();
+        _direction = -1;
     }
-    while (!isTargetReached()) {
-        delay(1);
-    }
-    EJ_DCMotor::stop();
+    MOTION_UNLOCK();
 }
 
 void EJ_EncoderMotor::move(long relativePosition, int16_t duty) {
@@ -54,28 +86,91 @@ void EJ_EncoderMotor::move(long relativePosition, int16_t duty) {
         ERRORLOG
             内容：目標方向とduty比で表現する進行方向が不一致
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
         return;
     }
-    _target = Encoder::read() + relativePosition;
-    EJ_DCMotor::setPWM(duty);
-    while (!isTargetReached()) {
-        delay(1);
+    if (relativePosition == 0 || duty == 0) {
+        stop();
+        return;
     }
-    EJ_DCMotor::stop();
+    long position = read();
+    MOTION_LOCK();
+    _direction = 0;
+    _target = position + relativePosition;
+    EJ_DCMotor::setPWM(duty);
+    _direction = relativePosition > 0 ? 1 : -1;
+    MOTION_UNLOCK();
+}
+
+void EJ_EncoderMotor::moveTo(long absolutePosition) {
+    move(absolutePosition - read());
 }
 
 void EJ_EncoderMotor::moveTo(long absolutePosition, int16_t duty) {
-    move(absolutePosition - Encoder::read(), duty);
+    move(absolutePosition - read(), duty);
 }
 
 
 void EJ_EncoderMotor::setTarget(long targetPosition) {
+    MOTION_LOCK();
     _target = targetPosition;
+    MOTION_UNLOCK();
 }
 
 bool EJ_EncoderMotor::isTargetReached() {
-    return Encoder::read() == _target;
+    long position = read();
+    MOTION_LOCK();
+    int8_t direction = _direction;
+    long target = _target;
+    MOTION_UNLOCK();
+    if (direction > 0) {
+        return position >= target;
+    }
+    if (direction < 0) {
+        return position <= target;
+    }
+    return position == target;
+}
+
+bool EJ_EncoderMotor::isMoving() {
+    return _direction != 0;
+}
+
+void EJ_EncoderMotor::stop() {
+    MOTION_LOCK();
+    _direction = 0;
+    EJ_DCMotor::stop();
+    MOTION_UNLOCK();
+}
+
+void EJ_EncoderMotor::update() {
+    if (_direction == 0) {
+        return;
+    }
+    long position = read();
+    /* 判定と停止の間にmove()で向きと目標位置が書き換えられないよう、ロックしたまま判定する */
+    MOTION_LOCK();
+    if ((_direction > 0 && position >= _target) || (_direction < 0 && position <= _target)) {
+        _direction = 0;
+        EJ_DCMotor::stop();
+    }
+    MOTION_UNLOCK();
+}
+
+long EJ_EncoderMotor::read() {
+    if (EJ_SensorLog::isReplaying()) {
+        return EJ_SensorLog::replayLatest(EJ_SENSORLOG_ENCODER, _enc1);
+    }
+    long position = Encoder::read();
+    EJ_SensorLog::record(EJ_SENSORLOG_ENCODER, _enc1, (int32_t)position);
+    return position;
+}
+
+long EJ_EncoderMotor::peek() {
+    if (EJ_SensorLog::isReplaying()) {
+        return EJ_SensorLog::replayLatest(EJ_SENSORLOG_ENCODER, _enc1);
+    }
+    return Encoder::read();
 }
 
 /* ↑のコードでしきい値がオーバーシュートする場合のアイデア (Draft)
@@ -101,69 +196,20 @@ class EJ_EncoderMotor_Manager
 ---------------------------*/
 
 /* static member */
-EJ_EncoderMotor_Manager* EJ_EncoderMotor_Manager::_singleton = NULL;
 const char* EJ_EncoderMotor_Manager::_classname = "EJ_EncoderMotor_Manager";
-
-/* private method */
-EJ_EncoderMotor_Manager::EJ_EncoderMotor_Manager(size_t maxInstanceSize)
-:   _maxInstanceSize(maxInstanceSize),
-    _instanceList(NULL)
-{
-    _instanceList = new EJ_EncoderMotor*[_maxInstanceSize];
-    if (_instanceList == NULL) {
-        /* 
-        ERRORLOG 
-            内容: メモリ確保に失敗した
-        */
-        ERRORLOG();
-        return;
-    }
-    for (size_t i = 0; i < _maxInstanceSize; i++) {
-        _instanceList[i] = NULL;
-    }
-}
-
-/* static private method */
-EJ_EncoderMotor_Manager* EJ_EncoderMotor_Manager::getInstance()
-{
-    if (_singleton == NULL) {
-        /*
-        ERROLOG
-            内容：シングルトンがまだ生成されていない
-        */
-        ERRORLOG();
-        return NULL;
-    }
-
-    return _singleton;
-}
-
-/* public method */
-EJ_EncoderMotor_Manager::~EJ_EncoderMotor_Manager()
-{
-    if (_instanceList != NULL) {
-        for (size_t i = 0; i < _maxInstanceSize; i++) {
-            if (_instanceList[i] != NULL) {
-                delete _instanceList[i];
-                _instanceList[i] = NULL;
-            }
-        }
-    }
-}
+template <>
+const char* EJ_Manager<EJ_EncoderMotor, EJ_ENCODERMOTOR_MAX_INSTANCES>::_classname = "EJ_EncoderMotor_Manager";
 
 /* static public method */
 bool EJ_EncoderMotor_Manager::configure(size_t maxInstanceSize)
 {
-    if (_singleton == NULL) {
-        _singleton = new EJ_EncoderMotor_Manager(maxInstanceSize);
-        if (_singleton == NULL) {
-            /*
-            ERROLOG
-                内容：メモリ確保に失敗した 
-            */
-            ERRORLOG();
-            return false;
-        }
+    if (maxInstanceSize > EJ_ENCODERMOTOR_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_ENCODERMOTOR_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
     }
     return true;
 }
@@ -175,37 +221,20 @@ EJ_EncoderMotor* EJ_EncoderMotor_Manager::createEncoderMotor(EncoderMotorDef mot
 
 EJ_EncoderMotor* EJ_EncoderMotor_Manager::createEncoderMotor(uint8_t pin1, uint8_t pin2, uint8_t enc1, uint8_t enc2, int8_t en, uint8_t id)
 {
-    EJ_EncoderMotor_Manager *manager = EJ_EncoderMotor_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
+    if (contains(id)) {
+        return &at(id);
     }
-    if (id > manager->_maxInstanceSize) {
+    EJ_EncoderMotor* instance = create(id, pin1, pin2, enc1, enc2, en);
+    if (instance != NULL && en >= 0 && instance->getPWMChannel() < 0) {
         /*
         ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
+            内容：LEDCチャンネルの割り当てに失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        destroy(id);
         return NULL;
     }
-    if (manager->_instanceList[id] == NULL) {
-        EJ_EncoderMotor *instance = new EJ_EncoderMotor(pin1, pin2, enc1, enc2, en);
-        if (instance == NULL) {
-            /*
-            ERRORLOG
-                内容：メモリ確保に失敗した
-            */
-            ERRORLOG();
-            return NULL;
-        }
-        manager->_instanceList[id] = instance;
-    }
-
-    return manager->_instanceList[id];
+    return instance;
 }
 
 EJ_EncoderMotor* EJ_EncoderMotor_Manager::getEncoderMotor(EncoderMotorDef motor)
@@ -216,7 +245,7 @@ EJ_EncoderMotor* EJ_EncoderMotor_Manager::getEncoderMotor(EncoderMotorDef motor)
         ERROLOG
             内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ID);
         return NULL;
     }
     if (instance->_enc1 != motor.enc1 || instance->_enc2 != motor.enc2) {
@@ -224,7 +253,7 @@ EJ_EncoderMotor* EJ_EncoderMotor_Manager::getEncoderMotor(EncoderMotorDef motor)
         ERROLOG
             内容：指定されたidが指すインスタンスと、確保済みの同じidのインスタンスが一致しない
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INSTANCE_MISMATCH);
         return NULL;
     }
     return instance;
@@ -232,31 +261,14 @@ EJ_EncoderMotor* EJ_EncoderMotor_Manager::getEncoderMotor(EncoderMotorDef motor)
 
 EJ_EncoderMotor* EJ_EncoderMotor_Manager::getEncoderMotor(uint8_t id)
 {
-    EJ_EncoderMotor_Manager *manager = EJ_EncoderMotor_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
-    }
+    return get(id);
+}
 
-    if (id >= manager->_maxInstanceSize) {
-        /*
-        ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
-        */
-        ERRORLOG();
-        return NULL;
-    } 
-    if (manager->_instanceList[id] == NULL) {
-        /*
-        ERRORLOG
-            内容：指定されたidのインスタンスが存在しない
-        */
-        ERRORLOG();
-        return NULL;
+void EJ_EncoderMotor_Manager::update()
+{
+    for (size_t i = 0; i < EJ_ENCODERMOTOR_MAX_INSTANCES; i++) {
+        if (contains(i)) {
+            at(i).update();
+        }
     }
-    return manager->_instanceList[id];
 }
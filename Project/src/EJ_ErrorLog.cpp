@@ -0,0 +1,239 @@
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+static_assert((EJ_ERRORLOG_QUEUE_SIZE & (EJ_ERRORLOG_QUEUE_SIZE - 1)) == 0, "EJ_ERRORLOG_QUEUE_SIZE must be a power of two");
+static const uint32_t QUEUE_MASK = EJ_ERRORLOG_QUEUE_SIZE - 1;
+
+/* getLastError()で書き込み中のイベントを避けて遡る回数 */
+static const uint8_t LAST_ERROR_RETRIES = 4;
+
+static const char *const CODE_NAMES[EJ_ERROR_CODES] = {
+    "NONE",
+    "INVALID_ID",
+    "INSTANCE_MISMATCH",
+    "CAPACITY",
+    "INVALID_ARGUMENT",
+    "NO_RESOURCE",
+    "HARDWARE",
+    "TIMEOUT",
+    "UNSUPPORTED",
+    "NOT_READY",
+    "STORAGE",
+    "INVALID_DATA",
+    "NOT_OWNER",
+};
+
+/*---------------
+class EJ_ErrorLog
+---------------*/
+
+/* static member */
+const char* EJ_ErrorLog::_classname = "EJ_ErrorLog";
+EJ_ErrorLog::Slot EJ_ErrorLog::_slots[EJ_ERRORLOG_QUEUE_SIZE];
+uint32_t EJ_ErrorLog::_head = 0;
+uint32_t EJ_ErrorLog::_tail = 0;
+uint32_t EJ_ErrorLog::_lost = 0;
+uint32_t EJ_ErrorLog::_counts[EJ_ERROR_CODES];
+Print *EJ_ErrorLog::_taskOut = NULL;
+uint32_t EJ_ErrorLog::_taskInterval = 100;
+void *EJ_ErrorLog::_task = NULL;
+
+/* private method */
+bool EJ_ErrorLog::readSlot(uint32_t sequence, ErrorEvent &event, int32_t &age)
+{
+    Slot &slot = _slots[sequence & QUEUE_MASK];
+    uint32_t written = 2 * sequence + 2;
+    uint32_t state = __atomic_load_n(&slot.state, __ATOMIC_ACQUIRE);
+    age = (int32_t)(state - written);
+    if (age != 0) {
+        /* 負: まだ書き込まれていないか書き込み中 / 正: 新しいイベントで上書きされた */
+        return false;
+    }
+    event = slot.event;
+    /* コピーの途中で上書きが始まっていないことを確かめる (seqlock) */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot.state, __ATOMIC_RELAXED) != state) {
+        age = 1;
+        return false;
+    }
+    return true;
+}
+
+void EJ_ErrorLog::taskMain(void *parameter)
+{
+    (void)parameter;
+#ifdef ARDUINO_ARCH_ESP32
+    for (;;) {
+        drain(*_taskOut);
+        vTaskDelay(pdMS_TO_TICKS(_taskInterval));
+    }
+#endif
+}
+
+/* static public method */
+void EJ_ERRORLOG_IRAM EJ_ErrorLog::record(const char *classname, EJ_ErrorCode code, int line)
+{
+    uint8_t index = (uint8_t)code < EJ_ERROR_CODES ? (uint8_t)code : 0;
+    __atomic_fetch_add(&_counts[index], 1, __ATOMIC_RELAXED);
+
+    uint32_t sequence = __atomic_fetch_add(&_head, 1, __ATOMIC_ACQ_REL);
+    Slot &slot = _slots[sequence & QUEUE_MASK];
+    uint32_t writing = 2 * sequence + 1;
+    uint32_t state = __atomic_load_n(&slot.state, __ATOMIC_RELAXED);
+    do {
+        if ((int32_t)(state - writing) >= 0) {
+            /* 1周後のイベントが先に書き込んでいる (書き込み中に割り込まれた) ため、古いこのイベントは捨てる */
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&slot.state, &state, writing, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot.event.classname = classname;
+    slot.event.timestamp = micros();
+    slot.event.sequence = sequence;
+    slot.event.line = (uint16_t)line;
+    slot.event.code = index;
+
+    /* 書き込み中に1周後のイベントに追い越された場合は状態を戻さない */
+    __atomic_compare_exchange_n(&slot.state, &writing, writing + 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+bool EJ_ErrorLog::getLastError(ErrorEvent &event)
+{
+    uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < LAST_ERROR_RETRIES && i < head && i < EJ_ERRORLOG_QUEUE_SIZE; i++) {
+        int32_t age;
+        if (readSlot(head - 1 - i, event, age)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t EJ_ErrorLog::getCount(EJ_ErrorCode code)
+{
+    if ((uint8_t)code >= EJ_ERROR_CODES) {
+        return 0;
+    }
+    return __atomic_load_n(&_counts[code], __ATOMIC_RELAXED);
+}
+
+uint32_t EJ_ErrorLog::getTotalCount()
+{
+    return __atomic_load_n(&_head, __ATOMIC_RELAXED);
+}
+
+uint32_t EJ_ErrorLog::getLostCount()
+{
+    return _lost;
+}
+
+void EJ_ErrorLog::clearCounts()
+{
+    for (uint8_t i = 0; i < EJ_ERROR_CODES; i++) {
+        __atomic_store_n(&_counts[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+bool EJ_ErrorLog::read(ErrorEvent &event)
+{
+    for (;;) {
+        uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        if (_tail == head) {
+            return false;
+        }
+        if (head - _tail > EJ_ERRORLOG_QUEUE_SIZE) {
+            /* 1周以上遅れている分は上書きされている */
+            _lost += head - _tail - EJ_ERRORLOG_QUEUE_SIZE;
+            _tail = head - EJ_ERRORLOG_QUEUE_SIZE;
+        }
+        int32_t age;
+        if (readSlot(_tail, event, age)) {
+            _tail++;
+            return true;
+        }
+        if (age < 0) {
+            /* 書き込み中のイベントは次回読み出す */
+            return false;
+        }
+        _lost++;
+        _tail++;
+    }
+}
+
+size_t EJ_ErrorLog::drain(Print &out, size_t maxEvents)
+{
+    size_t count = 0;
+    ErrorEvent event;
+    while (count < maxEvents && read(event)) {
+        print(out, event);
+        count++;
+    }
+    return count;
+}
+
+size_t EJ_ErrorLog::drain(EJ_ErrorSink sink, void *context, size_t maxEvents)
+{
+    size_t count = 0;
+    ErrorEvent event;
+    while (sink != NULL && count < maxEvents && read(event)) {
+        sink(event, context);
+        count++;
+    }
+    return count;
+}
+
+void EJ_ErrorLog::print(Print &out, const ErrorEvent &event)
+{
+    out.printf("[ERROR] Class:%s, Line:%u, Code:%s, Time:%lu.%03lu\n",
+               event.classname != NULL ? event.classname : "?", (unsigned)event.line, getCodeName(event.code),
+               (unsigned long)(event.timestamp / 1000000), (unsigned long)(event.timestamp / 1000 % 1000));
+}
+
+const char *EJ_ErrorLog::getCodeName(uint8_t code)
+{
+    return code < EJ_ERROR_CODES ? CODE_NAMES[code] : "?";
+}
+
+bool EJ_ErrorLog::startTask(Print &out, uint32_t interval, uint8_t priority)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        return false;
+    }
+    _taskOut = &out;
+    _taskInterval = interval > 0 ? interval : 1;
+    TaskHandle_t task = NULL;
+    if (xTaskCreate(taskMain, "EJ_ErrorLog", 3072, NULL, priority, &task) != pdPASS) {
+        /*
+        ERRORLOG
+            内容：タスクの生成に失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return false;
+    }
+    _task = task;
+    return true;
+#else
+    (void)out;
+    (void)interval;
+    (void)priority;
+    /*
+    ERRORLOG
+        内容：タスクに対応していないプラットフォーム
+    */
+    ERRORLOG(EJ_ERROR_UNSUPPORTED);
+    return false;
+#endif
+}
+
+void EJ_ErrorLog::stopTask()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        vTaskDelete((TaskHandle_t)_task);
+        _task = NULL;
+    }
+#endif
+}
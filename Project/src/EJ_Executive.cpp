@@ -0,0 +1,371 @@
+#include "EJ_Executive.h"
+#include "EJ_ErrorLog.h"
+#include "EJ_Trace.h"
+#include <math.h>
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* ハードウェアタイマのカウンタを1usで進める分周比 (APBクロック80MHz) */
+static const uint16_t TIMER_DIVIDER = 80;
+
+/*----------------
+class EJ_Executive
+----------------*/
+
+/* static member */
+const char* EJ_Executive::_classname = "EJ_Executive";
+EJ_Executive::Hook EJ_Executive::_hooks[EJ_EXECUTIVE_MAX_HOOKS];
+uint8_t EJ_Executive::_hookCount = 0;
+EJ_Executive::Rate EJ_Executive::_rates[EJ_EXECUTIVE_MAX_RATES];
+uint8_t EJ_Executive::_rateCount = 0;
+uint32_t EJ_Executive::_tick = 1000;
+uint32_t EJ_Executive::_ticks = 0;
+uint32_t EJ_Executive::_epoch = 0;
+bool EJ_Executive::_running = false;
+int8_t EJ_Executive::_timerIndex = -1;
+void *EJ_Executive::_timer = NULL;
+uint8_t EJ_Executive::_core = 1;
+
+/* private method */
+void EJ_Executive::runRate(uint8_t rate, uint32_t release, uint32_t skipped)
+{
+    uint32_t period = _rates[rate].period;
+    for (uint8_t i = 0; i < _hookCount; i++) {
+        Hook &hook = _hooks[i];
+        if (hook.rate != rate) {
+            continue;
+        }
+        uint32_t start = micros();
+        hook.hook(hook.context);
+        uint32_t end = micros();
+
+        HookStats &stats = hook.stats;
+        uint32_t exec = end - start;
+        uint32_t jitter = (int32_t)(start - release) > 0 ? start - release : 0;
+        stats.runs++;
+        stats.misses += skipped + ((end - release) > period ? 1 : 0);
+        stats.execMin = exec < stats.execMin ? exec : stats.execMin;
+        stats.execMax = exec > stats.execMax ? exec : stats.execMax;
+        stats.execTotal += exec;
+        stats.jitterMax = jitter > stats.jitterMax ? jitter : stats.jitterMax;
+        stats.jitterTotal += jitter;
+    }
+}
+
+void EJ_Executive::tick()
+{
+    _ticks++;
+    uint32_t release = _epoch + _ticks * _tick;
+    for (uint8_t r = 0; r < _rateCount; r++) {
+        if (_ticks % _rates[r].divider == 0) {
+            _rates[r].release = release;
+            _rates[r].pending++;
+        }
+    }
+}
+
+void EJ_Executive::taskMain(void *parameter)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    uint8_t rate = (uint8_t)(uintptr_t)parameter;
+    for (;;) {
+        /* 前回の実行中に重なった起動はまとめて受け取り、実行できなかった起動としてデッドラインミスに数える */
+        uint32_t released = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (released == 0) {
+            continue;
+        }
+        runRate(rate, _rates[rate].release, released - 1);
+    }
+#else
+    (void)parameter;
+#endif
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+void IRAM_ATTR EJ_Executive::onTimer()
+{
+    EJ_TRACE_INSTANT("EJ_Executive::onTimer");
+    BaseType_t woken = pdFALSE;
+    _ticks++;
+    uint32_t release = _epoch + _ticks * _tick;
+    for (uint8_t r = 0; r < _rateCount; r++) {
+        if (_ticks % _rates[r].divider == 0) {
+            _rates[r].release = release;
+            vTaskNotifyGiveFromISR((TaskHandle_t)_rates[r].task, &woken);
+        }
+    }
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+#else
+void EJ_Executive::onTimer()
+{}
+#endif
+
+/* static public method */
+bool EJ_Executive::begin(uint32_t tick)
+{
+    if (_running || tick == 0) {
+        /*
+        ERRORLOG
+            内容：実行中、または無効な基本周期が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+    _tick = tick;
+    _ticks = 0;
+    _epoch = micros();
+    _hookCount = 0;
+    _rateCount = 0;
+    return true;
+}
+
+int8_t EJ_Executive::addHook(const char *name, EJ_UpdateHook hook, void *context, uint32_t rate)
+{
+    if (_running || hook == NULL || rate == 0 || _hookCount >= EJ_EXECUTIVE_MAX_HOOKS) {
+        /*
+        ERRORLOG
+            内容：実行中、無効な引数、または周期処理の数がEJ_EXECUTIVE_MAX_HOOKSを超えている
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    uint32_t period = 1000000UL / rate;
+    if (period < _tick || period % _tick != 0) {
+        /*
+        ERRORLOG
+            内容：周期が基本周期の整数倍になっていない
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+
+    /* 周期の種類を周期の短い順 (優先度の高い順) に並べる */
+    uint8_t index = 0;
+    while (index < _rateCount && _rates[index].period < period) {
+        index++;
+    }
+    if (index == _rateCount || _rates[index].period != period) {
+        if (_rateCount >= EJ_EXECUTIVE_MAX_RATES) {
+            /*
+            ERRORLOG
+                内容：周期の種類の数がEJ_EXECUTIVE_MAX_RATESを超えている
+            */
+            ERRORLOG(EJ_ERROR_CAPACITY);
+            return -1;
+        }
+        for (uint8_t r = _rateCount; r > index; r--) {
+            _rates[r] = _rates[r - 1];
+        }
+        for (uint8_t i = 0; i < _hookCount; i++) {
+            if (_hooks[i].rate >= index) {
+                _hooks[i].rate++;
+            }
+        }
+        _rates[index].period = period;
+        _rates[index].divider = period / _tick;
+        _rates[index].release = _epoch;
+        _rates[index].pending = 0;
+        _rates[index].task = NULL;
+        _rateCount++;
+    }
+
+    Hook &entry = _hooks[_hookCount];
+    entry.hook = hook;
+    entry.context = context;
+    entry.rate = index;
+    memset(&entry.stats, 0, sizeof(entry.stats));
+    entry.stats.name = name;
+    entry.stats.period = period;
+    entry.stats.execMin = 0xFFFFFFFF;
+    return (int8_t)_hookCount++;
+}
+
+bool EJ_Executive::start(uint8_t core)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_running || _hookCount == 0) {
+        return false;
+    }
+    _timerIndex = EJ_Peripheral::allocate(EJ_PERIPHERAL_TIMER);
+    if (_timerIndex < 0) {
+        /*
+        ERRORLOG
+            内容：空いているハードウェアタイマがない
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return false;
+    }
+    for (uint8_t r = 0; r < _rateCount; r++) {
+        TaskHandle_t task = NULL;
+        if (xTaskCreatePinnedToCore(taskMain, "EJ_Executive", EJ_EXECUTIVE_STACK_SIZE, (void *)(uintptr_t)r,
+                                    EJ_EXECUTIVE_PRIORITY - r, &task, core) != pdPASS) {
+            /*
+            ERRORLOG
+                内容：タスクの生成に失敗した
+            */
+            ERRORLOG(EJ_ERROR_NO_RESOURCE);
+            stop();
+            return false;
+        }
+        _rates[r].task = task;
+    }
+    _ticks = 0;
+    _epoch = micros();
+    hw_timer_t *timer = timerBegin(_timerIndex, TIMER_DIVIDER, true);
+    if (timer == NULL) {
+        /*
+        ERRORLOG
+            内容：タイマーの生成に失敗した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        stop();
+        return false;
+    }
+    _timer = timer;
+    _core = core;
+    timerAttachInterrupt(timer, &onTimer, true);
+    timerAlarmWrite(timer, _tick, true);
+    timerAlarmEnable(timer);
+    _running = true;
+    return true;
+#else
+    (void)core;
+    /*
+    ERRORLOG
+        内容：タイマーに対応していないプラットフォーム (poll()を使う)
+    */
+    ERRORLOG(EJ_ERROR_UNSUPPORTED);
+    return false;
+#endif
+}
+
+void EJ_Executive::stop()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_timer != NULL) {
+        timerAlarmDisable((hw_timer_t *)_timer);
+        timerDetachInterrupt((hw_timer_t *)_timer);
+        timerEnd((hw_timer_t *)_timer);
+        _timer = NULL;
+    }
+    for (uint8_t r = 0; r < _rateCount; r++) {
+        if (_rates[r].task != NULL) {
+            vTaskDelete((TaskHandle_t)_rates[r].task);
+            _rates[r].task = NULL;
+        }
+    }
+#endif
+    if (_timerIndex >= 0) {
+        EJ_Peripheral::release(EJ_PERIPHERAL_TIMER, _timerIndex);
+        _timerIndex = -1;
+    }
+    _running = false;
+}
+
+void EJ_Executive::poll()
+{
+    if (_running) {
+        return;
+    }
+    uint32_t now = micros();
+    while ((int32_t)(now - (_epoch + (_ticks + 1) * _tick)) >= 0) {
+        tick();
+    }
+    for (uint8_t r = 0; r < _rateCount; r++) {
+        if (_rates[r].pending > 0) {
+            uint32_t skipped = _rates[r].pending - 1;
+            _rates[r].pending = 0;
+            runRate(r, _rates[r].release, skipped);
+        }
+    }
+}
+
+void EJ_Executive::lock()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_running && xPortGetCoreID() != _core) {
+        /*
+        ERRORLOG
+            内容：周期処理と別のコアから呼ばれたため、周期処理を止められない
+        */
+        ERRORLOG(EJ_ERROR_NOT_OWNER);
+    }
+    /* スケジューラを止めるのは呼び出したコアだけなので、周期処理のタスクと同じコアから呼ぶ */
+    vTaskSuspendAll();
+#endif
+}
+
+void EJ_Executive::unlock()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    xTaskResumeAll();
+#endif
+}
+
+bool EJ_Executive::isRunning()
+{
+    return _running;
+}
+
+uint8_t EJ_Executive::getHookCount()
+{
+    return _hookCount;
+}
+
+bool EJ_Executive::getStats(uint8_t index, HookStats &stats)
+{
+    if (index >= _hookCount) {
+        return false;
+    }
+    stats = _hooks[index].stats;
+    return true;
+}
+
+uint32_t EJ_Executive::getMissCount()
+{
+    uint32_t misses = 0;
+    for (uint8_t i = 0; i < _hookCount; i++) {
+        misses += _hooks[i].stats.misses;
+    }
+    return misses;
+}
+
+float EJ_Executive::getUtilization()
+{
+    float utilization = 0.0f;
+    for (uint8_t i = 0; i < _hookCount; i++) {
+        utilization += (float)_hooks[i].stats.execMax / (float)_hooks[i].stats.period;
+    }
+    return utilization;
+}
+
+void EJ_Executive::resetStats()
+{
+    for (uint8_t i = 0; i < _hookCount; i++) {
+        HookStats &stats = _hooks[i].stats;
+        stats.runs = 0;
+        stats.misses = 0;
+        stats.execMin = 0xFFFFFFFF;
+        stats.execMax = 0;
+        stats.execTotal = 0;
+        stats.jitterMax = 0;
+        stats.jitterTotal = 0;
+    }
+}
+
+void EJ_Executive::printStats(Print &out)
+{
+    for (uint8_t i = 0; i < _hookCount; i++) {
+        const HookStats &stats = _hooks[i].stats;
+        uint32_t runs = stats.runs > 0 ? stats.runs : 1;
+        out.printf("%s: %luus runs=%lu exec=%lu/%lu/%luus jitter=%lu/%luus miss=%lu\n",
+            stats.name != NULL ? stats.name : "?", (unsigned long)stats.period, (unsigned long)stats.runs,
+            (unsigned long)(stats.runs > 0 ? stats.execMin : 0), (unsigned long)(stats.execTotal / runs), (unsigned long)stats.execMax,
+            (unsigned long)(stats.jitterTotal / runs), (unsigned long)stats.jitterMax, (unsigned long)stats.misses);
+    }
+    float n = (float)(_rateCount > 0 ? _rateCount : 1);
+    out.printf("utilization: %.3f (bound %.3f)\n", getUtilization(), n * (powf(2.0f, 1.0f / n) - 1.0f));
+}
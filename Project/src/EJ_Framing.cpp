@@ -0,0 +1,65 @@
+#include "EJ_Framing.h"
+
+/*--------------
+class EJ_Framing
+--------------*/
+
+/* static public method */
+size_t EJ_Framing::encode(const uint8_t *src, size_t length, uint8_t *dst)
+{
+    /* 0x00の代わりに「次の0x00までの距離」を置く。0x00が254バイト続かない場合は0xFFで区切る */
+    size_t code = 0;
+    size_t out = 1;
+    uint8_t distance = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (src[i] == 0) {
+            dst[code] = distance;
+            code = out++;
+            distance = 1;
+        } else {
+            dst[out++] = src[i];
+            if (++distance == 0xFF) {
+                dst[code] = distance;
+                code = out++;
+                distance = 1;
+            }
+        }
+    }
+    dst[code] = distance;
+    dst[out++] = 0;
+    return out;
+}
+
+size_t EJ_Framing::decode(const uint8_t *src, size_t length, uint8_t *dst)
+{
+    size_t in = 0;
+    size_t out = 0;
+    while (in < length) {
+        uint8_t distance = src[in];
+        if (distance == 0 || in + distance > length) {
+            return 0;
+        }
+        in++;
+        for (uint8_t i = 1; i < distance; i++) {
+            if (src[in] == 0) {
+                return 0;
+            }
+            dst[out++] = src[in++];
+        }
+        if (distance != 0xFF && in < length) {
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
+
+uint16_t EJ_Framing::crc16(const uint8_t *data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,60 @@
+#include "EJ_I2CBus.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+#ifdef ARDUINO_ARCH_ESP32
+/* ミューテックスの領域 (ヒープを使わない) */
+static StaticSemaphore_t mutexBuffer;
+static portMUX_TYPE createMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool creating = false;
+#endif
+
+/*--------------
+class EJ_I2CBus
+--------------*/
+
+/* static member */
+const char* EJ_I2CBus::_classname = "EJ_I2CBus";
+void* EJ_I2CBus::_mutex = NULL;
+
+/* static public method */
+bool EJ_I2CBus::lock(uint32_t timeout)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_mutex == NULL) {
+        /* 最初にロックしたタスクがミューテックスを生成し、同時に呼び出した他のタスクは生成を待つ */
+        portENTER_CRITICAL(&createMux);
+        bool creator = !creating;
+        creating = true;
+        portEXIT_CRITICAL(&createMux);
+        if (creator) {
+            _mutex = xSemaphoreCreateRecursiveMutexStatic(&mutexBuffer);
+        }
+        while (_mutex == NULL) {
+            vTaskDelay(1);
+        }
+    }
+    if (xSemaphoreTakeRecursive((SemaphoreHandle_t)_mutex, pdMS_TO_TICKS(timeout)) != pdTRUE) {
+        /*
+        ERRORLOG
+            内容：I2Cバスの獲得がタイムアウトした
+        */
+        ERRORLOG(EJ_ERROR_TIMEOUT);
+        return false;
+    }
+#else
+    (void)timeout;
+#endif
+    return true;
+}
+
+void EJ_I2CBus::unlock()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_mutex != NULL) {
+        xSemaphoreGiveRecursive((SemaphoreHandle_t)_mutex);
+    }
+#endif
+}
@@ -0,0 +1,11 @@
+#include "EJ_Manager.h"
+
+/*-------------------
+class EJ_ManagerBase
+-------------------*/
+
+/* static protected method */
+void EJ_ManagerBase::errorLog(const char *classname, EJ_ErrorCode code, int line)
+{
+    EJ_ErrorLog::record(classname, code, line);
+}
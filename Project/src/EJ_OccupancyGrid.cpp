@@ -0,0 +1,281 @@
+#include "EJ_OccupancyGrid.h"
+
+#include <new>
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* 2セル分の未観測値 */
+static const uint8_t UNKNOWN_PAIR = (EJ_OCCUPANCY_UNKNOWN << 4) | EJ_OCCUPANCY_UNKNOWN;
+
+/*--------------------
+class EJ_OccupancyGrid
+--------------------*/
+
+/* static member */
+const char* EJ_OccupancyGrid::_classname = "EJ_OccupancyGrid";
+
+/* public method */
+EJ_OccupancyGrid::EJ_OccupancyGrid(uint8_t widthBits, uint8_t heightBits, uint16_t resolution)
+:   _widthBits(widthBits),
+    _heightBits(heightBits),
+    _resolution(resolution),
+    _cells(NULL),
+    _originX(0),
+    _originY(0),
+    _hit(2),
+    _miss(1),
+    _maxRange(2000)
+{
+    if (_widthBits < 1 || 15 < _widthBits || 15 < _heightBits || _resolution == 0 || EJ_OCCUPANCY_MAX_CELL_BITS < _widthBits + _heightBits) {
+        /*
+        ERRORLOG
+            内容：無効な格子サイズ、またはEJ_OCCUPANCY_MAX_CELL_BITSを超える格子サイズが指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
+    }
+    _cells = new (std::nothrow) uint8_t[((size_t)1 << (_widthBits + _heightBits)) / 2];
+    if (_cells == NULL) {
+        /*
+        ERRORLOG
+            内容：メモリ確保に失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return;
+    }
+    _originX = -(int32_t)(getWidth() / 2);
+    _originY = -(int32_t)(getHeight() / 2);
+    clear();
+}
+
+EJ_OccupancyGrid::~EJ_OccupancyGrid()
+{
+    delete[] _cells;
+}
+
+void EJ_OccupancyGrid::setUpdateWeights(uint8_t hit, uint8_t miss)
+{
+    _hit = constrain(hit, 0, 15);
+    _miss = constrain(miss, 0, 15);
+}
+
+void EJ_OccupancyGrid::setMaxRange(uint16_t maxRange)
+{
+    _maxRange = maxRange;
+}
+
+void EJ_OccupancyGrid::clear()
+{
+    if (_cells == NULL) return;
+    memset(_cells, UNKNOWN_PAIR, getMemorySize());
+}
+
+bool EJ_OccupancyGrid::recenter(float x, float y)
+{
+    if (_cells == NULL) return false;
+    int32_t width = getWidth();
+    int32_t height = getHeight();
+    int32_t dx = toCell(x) - width / 2 - _originX;
+    int32_t dy = toCell(y) - height / 2 - _originY;
+    if (abs(dx) < width / 4 && abs(dy) < height / 4) {
+        return false;
+    }
+    if (abs(dx) >= width || abs(dy) >= height) {
+        _originX += dx;
+        _originY += dy;
+        clear();
+        return true;
+    }
+
+    /* 窓から外れる列を未観測に戻す (環状バッファ上では新たに窓に入る列と同じ位置) */
+    int32_t first = (dx > 0) ? _originX : _originX + width + dx;
+    for (int32_t i = 0; i < abs(dx); i++) {
+        uint32_t column = (first + i) & (width - 1);
+        for (int32_t row = 0; row < height; row++) {
+            setCell(((uint32_t)row << _widthBits) | column, EJ_OCCUPANCY_UNKNOWN);
+        }
+    }
+    _originX += dx;
+
+    /* 窓から外れる行を未観測に戻す (1行は連続した領域) */
+    first = (dy > 0) ? _originY : _originY + height + dy;
+    for (int32_t i = 0; i < abs(dy); i++) {
+        uint32_t row = (first + i) & (height - 1);
+        memset(&_cells[(row << _widthBits) / 2], UNKNOWN_PAIR, width / 2);
+    }
+    _originY += dy;
+    return true;
+}
+
+void EJ_OccupancyGrid::integrateRange(const Pose2D &pose, const Pose2D &mount, uint16_t range, bool valid)
+{
+    float c = cosf(pose.theta);
+    float s = sinf(pose.theta);
+    float sensorX = pose.x + mount.x * c - mount.y * s;
+    float sensorY = pose.y + mount.x * s + mount.y * c;
+    float heading = pose.theta + mount.theta;
+
+    bool hit = valid && range <= _maxRange;
+    float distance = hit ? range : _maxRange;
+    float endX = sensorX + distance * cosf(heading);
+    float endY = sensorY + distance * sinf(heading);
+    integrateRay(toCell(sensorX), toCell(sensorY), toCell(endX), toCell(endY), hit);
+}
+
+void EJ_OccupancyGrid::integrateRay(int32_t x0, int32_t y0, int32_t x1, int32_t y1, bool hit)
+{
+    if (_cells == NULL) return;
+    int32_t dx = abs(x1 - x0);
+    int32_t dy = -abs(y1 - y0);
+    int32_t sx = (x0 < x1) ? 1 : -1;
+    int32_t sy = (y0 < y1) ? 1 : -1;
+    int32_t error = dx + dy;
+    int32_t x = x0;
+    int32_t y = y0;
+    while (x != x1 || y != y1) {
+        if (contains(x, y)) {
+            addCell(indexOf(x, y), -(int8_t)_miss);
+        }
+        int32_t error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x += sx;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y += sy;
+        }
+    }
+    if (contains(x1, y1)) {
+        addCell(indexOf(x1, y1), hit ? (int8_t)_hit : -(int8_t)_miss);
+    }
+}
+
+uint8_t EJ_OccupancyGrid::getCell(int32_t cx, int32_t cy)
+{
+    if (_cells == NULL || !contains(cx, cy)) {
+        return EJ_OCCUPANCY_UNKNOWN;
+    }
+    uint32_t index = indexOf(cx, cy);
+    uint8_t pair = _cells[index >> 1];
+    return (index & 1) ? (pair >> 4) : (pair & 0x0F);
+}
+
+uint8_t EJ_OccupancyGrid::getCellAt(float x, float y)
+{
+    return getCell(toCell(x), toCell(y));
+}
+
+int32_t EJ_OccupancyGrid::toCell(float value)
+{
+    return (int32_t)floorf(value / _resolution);
+}
+
+size_t EJ_OccupancyGrid::exportTo(EJ_WriteCallback write, void *context)
+{
+    if (_cells == NULL || write == NULL) {
+        /*
+        ERRORLOG
+            内容：地図が確保されていないか、出力先が指定されていない
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return 0;
+    }
+    uint8_t header[20] = {'E', 'J', 'O', 'G', EJ_OCCUPANCY_EXPORT_VERSION, _widthBits, _heightBits, 0,
+                          (uint8_t)_resolution, (uint8_t)(_resolution >> 8), 0, 0};
+    for (uint8_t i = 0; i < 4; i++) {
+        header[12 + i] = (uint8_t)((uint32_t)_originX >> (8 * i));
+        header[16 + i] = (uint8_t)((uint32_t)_originY >> (8 * i));
+    }
+    size_t written = write(header, sizeof(header), context);
+
+    uint8_t buf[64];
+    size_t used = 0;
+    uint8_t run = 0;
+    uint8_t value = 0;
+    int32_t width = getWidth();
+    int32_t height = getHeight();
+    for (int32_t row = 0; row < height; row++) {
+        for (int32_t column = 0; column < width; column += 2) {
+            uint8_t pair = getCell(_originX + column, _originY + row) | (getCell(_originX + column + 1, _originY + row) << 4);
+            if (run > 0 && (pair != value || run == 255)) {
+                buf[used++] = run;
+                buf[used++] = value;
+                run = 0;
+                if (used == sizeof(buf)) {
+                    written += write(buf, used, context);
+                    used = 0;
+                }
+            }
+            value = pair;
+            run++;
+        }
+    }
+    if (run > 0) {
+        buf[used++] = run;
+        buf[used++] = value;
+    }
+    if (used > 0) {
+        written += write(buf, used, context);
+    }
+    return written;
+}
+
+uint16_t EJ_OccupancyGrid::getWidth()
+{
+    return 1U << _widthBits;
+}
+
+uint16_t EJ_OccupancyGrid::getHeight()
+{
+    return 1U << _heightBits;
+}
+
+uint16_t EJ_OccupancyGrid::getResolution()
+{
+    return _resolution;
+}
+
+int32_t EJ_OccupancyGrid::getOriginX()
+{
+    return _originX;
+}
+
+int32_t EJ_OccupancyGrid::getOriginY()
+{
+    return _originY;
+}
+
+size_t EJ_OccupancyGrid::getMemorySize()
+{
+    if (_cells == NULL) return 0;
+    return ((size_t)1 << (_widthBits + _heightBits)) / 2;
+}
+
+/* private method */
+uint32_t EJ_OccupancyGrid::indexOf(int32_t cx, int32_t cy)
+{
+    return (((uint32_t)cy & (getHeight() - 1)) << _widthBits) | ((uint32_t)cx & (getWidth() - 1));
+}
+
+bool EJ_OccupancyGrid::contains(int32_t cx, int32_t cy)
+{
+    return (uint32_t)(cx - _originX) < getWidth() && (uint32_t)(cy - _originY) < getHeight();
+}
+
+void EJ_OccupancyGrid::addCell(uint32_t index, int8_t delta)
+{
+    uint8_t &pair = _cells[index >> 1];
+    uint8_t shift = (index & 1) ? 4 : 0;
+    int8_t value = ((pair >> shift) & 0x0F) + delta;
+    value = constrain(value, 0, 15);
+    pair = (pair & ~(0x0F << shift)) | (value << shift);
+}
+
+void EJ_OccupancyGrid::setCell(uint32_t index, uint8_t value)
+{
+    uint8_t &pair = _cells[index >> 1];
+    uint8_t shift = (index & 1) ? 4 : 0;
+    pair = (pair & ~(0x0F << shift)) | (value << shift);
+}
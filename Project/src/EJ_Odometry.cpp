@@ -0,0 +1,70 @@
+#include "EJ_Odometry.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*---------------
+class EJ_Odometry
+---------------*/
+
+/* static member */
+const char* EJ_Odometry::_classname = "EJ_Odometry";
+
+/* public method */
+EJ_Odometry::EJ_Odometry(float countsPerMm, float trackWidth)
+:   _countsPerMm(countsPerMm),
+    _trackWidth(trackWidth),
+    _leftCount(0),
+    _rightCount(0)
+{
+    if (_countsPerMm <= 0.0f || _trackWidth <= 0.0f) {
+        /*
+        ERRORLOG
+            内容：無効な機構パラメータが指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        _countsPerMm = 1.0f;
+        _trackWidth = 1.0f;
+    }
+    _pose.x = 0.0f;
+    _pose.y = 0.0f;
+    _pose.theta = 0.0f;
+}
+
+EJ_Odometry::~EJ_Odometry()
+{}
+
+void EJ_Odometry::reset(const Pose2D &pose, long leftCount, long rightCount)
+{
+    _pose = pose;
+    _leftCount = leftCount;
+    _rightCount = rightCount;
+}
+
+const Pose2D &EJ_Odometry::update(long leftCount, long rightCount)
+{
+    float left = (leftCount - _leftCount) / _countsPerMm;
+    float right = (rightCount - _rightCount) / _countsPerMm;
+    _leftCount = leftCount;
+    _rightCount = rightCount;
+
+    float distance = (left + right) * 0.5f;
+    float rotation = (right - left) / _trackWidth;
+    /* 移動区間の中間の向きで進んだとみなす */
+    float heading = _pose.theta + rotation * 0.5f;
+    _pose.x += distance * cosf(heading);
+    _pose.y += distance * sinf(heading);
+    _pose.theta += rotation;
+    if (_pose.theta > (float)M_PI) {
+        _pose.theta -= 2.0f * (float)M_PI;
+    } else if (_pose.theta < -(float)M_PI) {
+        _pose.theta += 2.0f * (float)M_PI;
+    }
+    return _pose;
+}
+
+const Pose2D &EJ_Odometry::getPose()
+{
+    return _pose;
+}
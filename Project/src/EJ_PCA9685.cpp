@@ -0,0 +1,326 @@
+#include "EJ_PCA9685.h"
+#include "EJ_I2CHub.h"
+#include "EJ_I2CBus.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*---------------
+class EJ_PCA9685
+---------------*/
+
+/* static member */
+const char* EJ_PCA9685::_classname = "EJ_PCA9685";
+
+#ifdef ARDUINO_ARCH_ESP32
+#define SHADOW_LOCK() portENTER_CRITICAL(&_mux)
+#define SHADOW_UNLOCK() portEXIT_CRITICAL(&_mux)
+#else
+#define SHADOW_LOCK() ((void)0)
+#define SHADOW_UNLOCK() ((void)0)
+#endif
+
+/* レジスタアドレス */
+static const uint8_t REG_MODE1 = 0x00;
+static const uint8_t REG_MODE2 = 0x01;
+static const uint8_t REG_LED0_ON_L = 0x06;
+static const uint8_t REG_ALL_LED_OFF_H = 0xFD;
+static const uint8_t REG_PRE_SCALE = 0xFE;
+
+/* MODE1, MODE2 のビット */
+static const uint8_t MODE1_RESTART = 0x80;
+static const uint8_t MODE1_AI = 0x20;
+static const uint8_t MODE1_SLEEP = 0x10;
+static const uint8_t MODE2_OUTDRV = 0x04;
+
+/* LEDn_OFF_H の FULL_OFF ビット */
+static const uint16_t FULL_OFF = 0x1000;
+
+/* private method */
+EJ_PCA9685::EJ_PCA9685(uint8_t address, uint8_t hubId, uint8_t hubChannel)
+:   _error(true),
+    _address(address),
+    _hubId(hubId),
+    _hubChannel(hubChannel),
+    _oscillator(25000000UL),
+    _frequency(0.0f),
+    _countsPerUs(0),
+    _dirty(0)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+    for (uint8_t i = 0; i < EJ_PCA9685_CHANNELS; i++) {
+        _on[i] = 0;
+        _off[i] = FULL_OFF;
+    }
+    if (!EJ_I2CBus::lock()) {
+        return;
+    }
+    bool result = selectBus()
+        && writeRegister(REG_MODE2, MODE2_OUTDRV)
+        && writeRegister(REG_MODE1, MODE1_AI)
+        && writeRegister(REG_ALL_LED_OFF_H, FULL_OFF >> 8);
+    EJ_I2CBus::unlock();
+    if (!result) {
+        /*
+        ERRORLOG
+            内容：PCA9685の初期化に失敗した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        return;
+    }
+    _error = false;
+}
+
+bool EJ_PCA9685::selectBus()
+{
+    if (_hubId == EJ_PCA9685_NO_HUB) {
+        return true;
+    }
+    EJ_I2CHub *hub = EJ_I2CHub_Manager::getI2CHub(_hubId);
+    if (hub == NULL) {
+        /*
+        ERRORLOG
+            内容：接続先のEJ_I2CHubが取得できない
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return false;
+    }
+    return hub->selectChannel(_hubChannel) == 0;
+}
+
+bool EJ_PCA9685::writeRegister(uint8_t reg, uint8_t value)
+{
+    Wire.beginTransmission(_address);
+    Wire.write(reg);
+    Wire.write(value);
+    return Wire.endTransmission() == 0;
+}
+
+/* public method */
+EJ_PCA9685::~EJ_PCA9685()
+{
+    if (_error || !EJ_I2CBus::lock()) {
+        return;
+    }
+    if (selectBus()) {
+        writeRegister(REG_ALL_LED_OFF_H, FULL_OFF >> 8);
+    }
+    EJ_I2CBus::unlock();
+}
+
+void EJ_PCA9685::setOscillatorFrequency(uint32_t hz)
+{
+    _oscillator = hz;
+}
+
+bool EJ_PCA9685::setFrequency(float hz)
+{
+    if (hz <= 0.0f) {
+        /*
+        ERRORLOG
+            内容：無効な周波数が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+    long prescale = lroundf((float)_oscillator / (4096.0f * hz)) - 1;
+    prescale = constrain(prescale, 3L, 255L);
+    if (!EJ_I2CBus::lock()) {
+        return false;
+    }
+    /* PRE_SCALEはスリープ中にしか書き込めない */
+    if (!selectBus()
+        || !writeRegister(REG_MODE1, MODE1_AI | MODE1_SLEEP)
+        || !writeRegister(REG_PRE_SCALE, (uint8_t)prescale)
+        || !writeRegister(REG_MODE1, MODE1_AI)) {
+        EJ_I2CBus::unlock();
+        /*
+        ERRORLOG
+            内容：周波数の設定に失敗した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        return false;
+    }
+    /* 発振器の安定を待ってからPWMを再開する */
+    delayMicroseconds(500);
+    writeRegister(REG_MODE1, MODE1_AI | MODE1_RESTART);
+    EJ_I2CBus::unlock();
+
+    _frequency = (float)_oscillator / (4096.0f * (prescale + 1));
+    _countsPerUs = (uint32_t)(4096.0f * _frequency / 1000000.0f * 65536.0f + 0.5f);
+    return true;
+}
+
+float EJ_PCA9685::getFrequency()
+{
+    return _frequency;
+}
+
+void EJ_PCA9685::setPWM(uint8_t channel, uint16_t on, uint16_t off)
+{
+    if (channel >= EJ_PCA9685_CHANNELS) {
+        /*
+        ERRORLOG
+            内容：存在しないチャンネルが指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ID);
+        return;
+    }
+    SHADOW_LOCK();
+    if (_on[channel] != on || _off[channel] != off) {
+        _on[channel] = on;
+        _off[channel] = off;
+        _dirty |= (uint16_t)(1U << channel);
+    }
+    SHADOW_UNLOCK();
+}
+
+void EJ_PCA9685::setPulseWidth(uint8_t channel, uint16_t us)
+{
+    if (us == 0) {
+        setPWM(channel, 0, FULL_OFF);
+        return;
+    }
+    uint32_t counts = ((uint32_t)us * _countsPerUs + 0x8000) >> 16;
+    if (counts > 4095) {
+        counts = 4095;
+    }
+    setPWM(channel, 0, (uint16_t)counts);
+}
+
+bool EJ_PCA9685::flush()
+{
+    uint16_t on[EJ_PCA9685_CHANNELS];
+    uint16_t off[EJ_PCA9685_CHANNELS];
+    SHADOW_LOCK();
+    uint16_t dirty = _dirty;
+    _dirty = 0;
+    memcpy(on, _on, sizeof(on));
+    memcpy(off, _off, sizeof(off));
+    SHADOW_UNLOCK();
+    if (dirty == 0) {
+        return true;
+    }
+    /* I2CHubのチャンネル選択から送信の完了までを他のタスクのI2C通信に割り込ませない */
+    if (!EJ_I2CBus::lock()) {
+        SHADOW_LOCK();
+        _dirty |= dirty;
+        SHADOW_UNLOCK();
+        return false;
+    }
+    if (!selectBus()) {
+        EJ_I2CBus::unlock();
+        SHADOW_LOCK();
+        _dirty |= dirty;
+        SHADOW_UNLOCK();
+        return false;
+    }
+
+    bool result = true;
+    uint8_t channel = 0;
+    while (channel < EJ_PCA9685_CHANNELS) {
+        if ((dirty & (1U << channel)) == 0) {
+            channel++;
+            continue;
+        }
+        /* 連続して変更されたチャンネルを1回のバーストで送信する (最大 1 + 16 * 4 バイト) */
+        uint8_t first = channel;
+        Wire.beginTransmission(_address);
+        Wire.write((uint8_t)(REG_LED0_ON_L + 4 * first));
+        while (channel < EJ_PCA9685_CHANNELS && (dirty & (1U << channel)) != 0) {
+            uint8_t buf[4] = {
+                (uint8_t)(on[channel] & 0xFF), (uint8_t)(on[channel] >> 8),
+                (uint8_t)(off[channel] & 0xFF), (uint8_t)(off[channel] >> 8)
+            };
+            Wire.write(buf, sizeof(buf));
+            channel++;
+        }
+        if (Wire.endTransmission() != 0) {
+            /*
+            ERRORLOG
+                内容：チャンネルの送信に失敗した
+            */
+            ERRORLOG(EJ_ERROR_HARDWARE);
+            uint16_t run = (uint16_t)(((1U << channel) - 1) & ~((1U << first) - 1));
+            SHADOW_LOCK();
+            _dirty |= run;
+            SHADOW_UNLOCK();
+            result = false;
+        }
+    }
+    EJ_I2CBus::unlock();
+    return result;
+}
+
+bool EJ_PCA9685::isDirty()
+{
+    return _dirty != 0;
+}
+
+/*-----------------------
+class EJ_PCA9685_Manager
+-----------------------*/
+
+/* static member */
+const char* EJ_PCA9685_Manager::_classname = "EJ_PCA9685_Manager";
+template <>
+const char* EJ_Manager<EJ_PCA9685, EJ_PCA9685_MAX_INSTANCES>::_classname = "EJ_PCA9685_Manager";
+
+/* static public method */
+bool EJ_PCA9685_Manager::configure(size_t maxInstanceSize)
+{
+    if (maxInstanceSize > EJ_PCA9685_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_PCA9685_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
+    }
+    return true;
+}
+
+EJ_PCA9685* EJ_PCA9685_Manager::createPCA9685(PCA9685Def pca9685, float frequency)
+{
+    return EJ_PCA9685_Manager::createPCA9685(pca9685.id, pca9685.address, frequency, pca9685.hubId, pca9685.hubChannel);
+}
+
+EJ_PCA9685* EJ_PCA9685_Manager::createPCA9685(uint8_t id, uint8_t address, float frequency, uint8_t hubId, uint8_t hubChannel)
+{
+    if (contains(id)) {
+        return &at(id);
+    }
+    EJ_PCA9685 *instance = create(id, address, hubId, hubChannel);
+    if (instance == NULL) {
+        return NULL;
+    }
+    if (instance->_error || !instance->setFrequency(frequency)) {
+        /*
+        ERRORLOG
+            内容：インスタンス生成に失敗した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        destroy(id);
+        return NULL;
+    }
+    return instance;
+}
+
+EJ_PCA9685* EJ_PCA9685_Manager::getPCA9685(uint8_t id)
+{
+    return get(id);
+}
+
+bool EJ_PCA9685_Manager::flush()
+{
+    bool result = true;
+    for (size_t i = 0; i < EJ_PCA9685_MAX_INSTANCES; i++) {
+        if (contains(i) && !at(i).flush()) {
+            result = false;
+        }
+    }
+    return result;
+}
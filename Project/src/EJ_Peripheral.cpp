@@ -0,0 +1,241 @@
+#include "EJ_Peripheral.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+#ifdef ARDUINO_ARCH_ESP32
+#define PERIPHERAL_LOCK() portENTER_CRITICAL(&_mux)
+#define PERIPHERAL_UNLOCK() portEXIT_CRITICAL(&_mux)
+#else
+#define PERIPHERAL_LOCK() ((void)0)
+#define PERIPHERAL_UNLOCK() ((void)0)
+#endif
+
+/*-----------------
+class EJ_Peripheral
+-----------------*/
+
+/* static member */
+const char* EJ_Peripheral::_classname = "EJ_Peripheral";
+uint16_t EJ_Peripheral::_used[EJ_PERIPHERAL_TYPES] = {0};
+uint32_t EJ_Peripheral::_ledcFrequency[EJ_LEDC_TIMERS] = {0};
+uint8_t EJ_Peripheral::_ledcResolution[EJ_LEDC_TIMERS] = {0};
+#ifdef ARDUINO_ARCH_ESP32
+portMUX_TYPE EJ_Peripheral::_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+static const char *PERIPHERAL_NAMES[EJ_PERIPHERAL_TYPES] = {"LEDC", "LEDC timer", "RMT", "PCNT", "MCPWM", "Timer"};
+
+/* private method */
+uint16_t EJ_Peripheral::usedMask(EJ_PeripheralType type)
+{
+    if (type != EJ_PERIPHERAL_LEDC_TIMER) {
+        return _used[type];
+    }
+    /* チャンネル2n, 2n+1のどちらかが使用中ならタイマnは使用中 */
+    uint16_t timers = 0;
+    for (uint8_t timer = 0; timer < EJ_LEDC_TIMERS; timer++) {
+        if (_used[EJ_PERIPHERAL_LEDC] & (3U << (timer * 2))) {
+            timers |= (uint16_t)(1U << timer);
+        }
+    }
+    return timers;
+}
+
+/* static public method */
+int8_t EJ_Peripheral::allocateLEDC(uint32_t frequency, uint8_t resolution)
+{
+    if (frequency == 0 || resolution == 0) {
+        /*
+        ERRORLOG
+            内容：無効な周波数または分解能が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+
+    int8_t channel = -1;
+    PERIPHERAL_LOCK();
+    /* 同じ設定で使用中のタイマの空きチャンネルを優先し、タイマの数を節約する */
+    for (uint8_t timer = 0; timer < EJ_LEDC_TIMERS && channel < 0; timer++) {
+        uint16_t pair = (_used[EJ_PERIPHERAL_LEDC] >> (timer * 2)) & 3U;
+        if (pair == 1U || pair == 2U) {
+            if (_ledcFrequency[timer] == frequency && _ledcResolution[timer] == resolution) {
+                channel = (int8_t)(timer * 2 + (pair == 1U ? 1 : 0));
+            }
+        }
+    }
+    for (uint8_t timer = 0; timer < EJ_LEDC_TIMERS && channel < 0; timer++) {
+        if (((_used[EJ_PERIPHERAL_LEDC] >> (timer * 2)) & 3U) == 0) {
+            channel = (int8_t)(timer * 2);
+            _ledcFrequency[timer] = frequency;
+            _ledcResolution[timer] = resolution;
+        }
+    }
+    if (channel >= 0) {
+        _used[EJ_PERIPHERAL_LEDC] |= (uint16_t)(1U << channel);
+    }
+    PERIPHERAL_UNLOCK();
+
+    if (channel < 0) {
+        /*
+        ERRORLOG
+            内容：この周波数で使えるLEDCチャンネルが残っていない
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return -1;
+    }
+    /* ledcSetup()はロック内で呼べないため、チャンネルを確保してから設定する */
+    if (ledcSetup(channel, frequency, resolution) == 0) {
+        /*
+        ERRORLOG
+            内容：LEDCの設定に失敗した (周波数と分解能の組み合わせが不正)
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        release(EJ_PERIPHERAL_LEDC, channel);
+        return -1;
+    }
+    return channel;
+}
+
+int8_t EJ_Peripheral::allocate(EJ_PeripheralType type)
+{
+    if (type == EJ_PERIPHERAL_LEDC || type == EJ_PERIPHERAL_LEDC_TIMER || type >= EJ_PERIPHERAL_TYPES) {
+        /*
+        ERRORLOG
+            内容：allocate()で割り当てられない種類が指定された (LEDCはallocateLEDC()を使う)
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+
+    int8_t index = -1;
+    uint8_t capacity = getCapacity(type);
+    PERIPHERAL_LOCK();
+    for (uint8_t i = 0; i < capacity; i++) {
+        if ((_used[type] & (1U << i)) == 0) {
+            _used[type] |= (uint16_t)(1U << i);
+            index = (int8_t)i;
+            break;
+        }
+    }
+    PERIPHERAL_UNLOCK();
+
+    if (index < 0) {
+        /*
+        ERRORLOG
+            内容：空いているチャンネルが残っていない
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+    }
+    return index;
+}
+
+bool EJ_Peripheral::reserve(EJ_PeripheralType type, uint8_t index)
+{
+    if (type == EJ_PERIPHERAL_LEDC_TIMER || type >= EJ_PERIPHERAL_TYPES || index >= getCapacity(type)) {
+        /*
+        ERRORLOG
+            内容：予約できない種類、または範囲外の番号が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+
+    bool reserved = false;
+    PERIPHERAL_LOCK();
+    if ((_used[type] & (1U << index)) == 0) {
+        _used[type] |= (uint16_t)(1U << index);
+        if (type == EJ_PERIPHERAL_LEDC) {
+            /* 周波数が分からないため、このタイマは他のチャンネルと共有しない */
+            _ledcFrequency[index / 2] = 0;
+            _ledcResolution[index / 2] = 0;
+        }
+        reserved = true;
+    }
+    PERIPHERAL_UNLOCK();
+
+    if (!reserved) {
+        /*
+        ERRORLOG
+            内容：予約しようとした番号は使用中
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+    }
+    return reserved;
+}
+
+void EJ_Peripheral::release(EJ_PeripheralType type, int8_t index)
+{
+    if (index < 0 || type == EJ_PERIPHERAL_LEDC_TIMER || type >= EJ_PERIPHERAL_TYPES || index >= getCapacity(type)) {
+        return;
+    }
+    PERIPHERAL_LOCK();
+    _used[type] &= (uint16_t)~(1U << index);
+    PERIPHERAL_UNLOCK();
+}
+
+uint8_t EJ_Peripheral::getUsage(EJ_PeripheralType type)
+{
+    if (type >= EJ_PERIPHERAL_TYPES) {
+        return 0;
+    }
+    PERIPHERAL_LOCK();
+    uint16_t mask = usedMask(type);
+    PERIPHERAL_UNLOCK();
+
+    uint8_t count = 0;
+    for (; mask != 0; mask &= (uint16_t)(mask - 1)) {
+        count++;
+    }
+    return count;
+}
+
+uint8_t EJ_Peripheral::getCapacity(EJ_PeripheralType type)
+{
+    switch (type) {
+    case EJ_PERIPHERAL_LEDC:
+        return EJ_LEDC_CHANNELS;
+    case EJ_PERIPHERAL_LEDC_TIMER:
+        return EJ_LEDC_TIMERS;
+    case EJ_PERIPHERAL_RMT:
+        return EJ_RMT_CHANNELS;
+    case EJ_PERIPHERAL_PCNT:
+        return EJ_PCNT_UNITS;
+    case EJ_PERIPHERAL_MCPWM:
+        return EJ_MCPWM_TIMERS;
+    case EJ_PERIPHERAL_TIMER:
+        return EJ_HW_TIMERS;
+    default:
+        return 0;
+    }
+}
+
+uint32_t EJ_Peripheral::getLEDCFrequency(uint8_t channel)
+{
+    if (channel >= EJ_LEDC_CHANNELS) {
+        return 0;
+    }
+    PERIPHERAL_LOCK();
+    uint32_t frequency = (_used[EJ_PERIPHERAL_LEDC] & (1U << channel)) ? _ledcFrequency[channel / 2] : 0;
+    PERIPHERAL_UNLOCK();
+    return frequency;
+}
+
+void EJ_Peripheral::printUsage(Print &out)
+{
+    for (uint8_t type = 0; type < EJ_PERIPHERAL_TYPES; type++) {
+        out.printf("%s: %u/%u\n", PERIPHERAL_NAMES[type],
+            getUsage((EJ_PeripheralType)type), getCapacity((EJ_PeripheralType)type));
+    }
+    for (uint8_t timer = 0; timer < EJ_LEDC_TIMERS; timer++) {
+        uint32_t frequency = getLEDCFrequency(timer * 2);
+        if (frequency == 0) {
+            frequency = getLEDCFrequency(timer * 2 + 1);
+        }
+        if (frequency != 0) {
+            out.printf("  LEDC timer %u: %luHz\n", timer, (unsigned long)frequency);
+        }
+    }
+}
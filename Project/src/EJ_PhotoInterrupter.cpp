@@ -1,18 +1,9 @@
 #include "EJ_PhotoInterrupter.h"
 
-#ifdef M5CORE2
-#include <M5Core2.h>
-#elif M5STICKCPLUS
-#include <M5StickCPlus.h>
-#else
-#undef M5_DEBUG
-#endif
+#include "EJ_ErrorLog.h"
+#include "EJ_SensorLog.h"
 
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
-#else
-#define ERRORLOG() ((void)0)
-#endif
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
 
 /*-----------------------
 class EJ_PhotoInterrupter
@@ -31,8 +22,21 @@ EJ_PhotoInterrupter::EJ_PhotoInterrupter(uint8_t pin)
 /* public method */
 bool EJ_PhotoInterrupter::isInterrupted()
 {
+    if (EJ_SensorLog::isReplaying()) {
+        return EJ_SensorLog::replayLatest(EJ_SENSORLOG_PHOTOINTERRUPTER, _pin) != 0;
+    }
     int value = digitalRead(_pin);
-    return (value == HIGH) ? true : false;
+    bool interrupted = (value == HIGH) ? true : false;
+    EJ_SensorLog::record(EJ_SENSORLOG_PHOTOINTERRUPTER, _pin, interrupted ? 1 : 0);
+    return interrupted;
+}
+
+bool EJ_PhotoInterrupter::peek()
+{
+    if (EJ_SensorLog::isReplaying()) {
+        return EJ_SensorLog::replayLatest(EJ_SENSORLOG_PHOTOINTERRUPTER, _pin) != 0;
+    }
+    return digitalRead(_pin) == HIGH;
 }
 
 EJ_PhotoInterrupter::~EJ_PhotoInterrupter()
@@ -43,69 +47,20 @@ class EJ_PhotoInterrupter_Manager
 -------------------------------*/
 
 /* static member */
-EJ_PhotoInterrupter_Manager* EJ_PhotoInterrupter_Manager::_singleton = NULL;
 const char* EJ_PhotoInterrupter_Manager::_classname = "EJ_PhotoInterrupter_Manager";
-
-/* private method */
-EJ_PhotoInterrupter_Manager::EJ_PhotoInterrupter_Manager(size_t maxInstanceSize)
-:   _maxInstanceSize(maxInstanceSize),
-    _instanceList(NULL)
-{
-    _instanceList = new EJ_PhotoInterrupter*[_maxInstanceSize];
-    if (_instanceList == NULL) {
-        /* 
-        ERRORLOG 
-            内容: メモリ確保に失敗した
-        */
-        ERRORLOG();
-        return;
-    }
-    for (size_t i = 0; i < _maxInstanceSize; i++) {
-        _instanceList[i] = NULL;
-    }
-}
-
-/* static private method */
-EJ_PhotoInterrupter_Manager* EJ_PhotoInterrupter_Manager::getInstance()
-{
-    if (_singleton == NULL) {
-        /*
-        ERROLOG
-            内容：シングルトンがまだ生成されていない
-        */
-        ERRORLOG();
-        return NULL;
-    }
-
-    return _singleton;
-}
-
-/* public method */
-EJ_PhotoInterrupter_Manager::~EJ_PhotoInterrupter_Manager()
-{
-    if (_instanceList != NULL) {
-        for (size_t i = 0; i < _maxInstanceSize; i++) {
-            if (_instanceList[i] != NULL) {
-                delete _instanceList[i];
-                _instanceList[i] = NULL;
-            }
-        }
-    }
-}
+template <>
+const char* EJ_Manager<EJ_PhotoInterrupter, EJ_PHOTOINTERRUPTER_MAX_INSTANCES>::_classname = "EJ_PhotoInterrupter_Manager";
 
 /* static public method */
 bool EJ_PhotoInterrupter_Manager::configure(size_t maxInstanceSize)
 {
-    if (_singleton == NULL) {
-        _singleton = new EJ_PhotoInterrupter_Manager(maxInstanceSize);
-        if (_singleton == NULL) {
-            /*
-            ERROLOG
-                内容：メモリ確保に失敗した 
-            */
-            ERRORLOG();
-            return false;
-        }
+    if (maxInstanceSize > EJ_PHOTOINTERRUPTER_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_PHOTOINTERRUPTER_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
     }
     return true;
 }
@@ -117,37 +72,7 @@ EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::createPhotoInterrupter(PhotoIn
 
 EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::createPhotoInterrupter(uint8_t pin, uint8_t id)
 {
-    EJ_PhotoInterrupter_Manager *manager = EJ_PhotoInterrupter_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
-    }
-    if (id > manager->_maxInstanceSize) {
-        /*
-        ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
-        */
-        ERRORLOG();
-        return NULL;
-    }
-    if (manager->_instanceList[id] == NULL) {
-        EJ_PhotoInterrupter *instance = new EJ_PhotoInterrupter(pin);
-        if (instance == NULL) {
-            /*
-            ERRORLOG
-                内容：メモリ確保に失敗した
-            */
-            ERRORLOG();
-            return NULL;
-        }
-        manager->_instanceList[id] = instance;
-    }
-
-    return manager->_instanceList[id];
+    return create(id, pin);
 }
 
 EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::getPhotoInterrupter(PhotoInterrupterDef PhotoInterrupter)
@@ -158,7 +83,7 @@ EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::getPhotoInterrupter(PhotoInter
         ERROLOG
             内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ID);
         return NULL;
     }
     if (instance->_pin != PhotoInterrupter.pin) {
@@ -166,7 +91,7 @@ EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::getPhotoInterrupter(PhotoInter
         ERROLOG
             内容：指定されたidが指すインスタンスと、確保済みの同じidのインスタンスが一致しない
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INSTANCE_MISMATCH);
         return NULL;
     }
     return instance;
@@ -174,31 +99,5 @@ EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::getPhotoInterrupter(PhotoInter
 
 EJ_PhotoInterrupter* EJ_PhotoInterrupter_Manager::getPhotoInterrupter(uint8_t id)
 {
-    EJ_PhotoInterrupter_Manager *manager = EJ_PhotoInterrupter_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
-    }
-
-    if (id >= manager->_maxInstanceSize) {
-        /*
-        ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
-        */
-        ERRORLOG();
-        return NULL;
-    } 
-    if (manager->_instanceList[id] == NULL) {
-        /*
-        ERRORLOG
-            内容：指定されたidのインスタンスが存在しない
-        */
-        ERRORLOG();
-        return NULL;
-    }
-    return manager->_instanceList[id];
+    return get(id);
 }
@@ -0,0 +1,167 @@
+#include "EJ_Pipeline.h"
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*---------------
+class EJ_Pipeline
+---------------*/
+
+/* static member */
+const char* EJ_Pipeline::_classname = "EJ_Pipeline";
+EJ_EncoderMotor *EJ_Pipeline::_encoders[EJ_PIPELINE_MAX_ENCODERS];
+EJ_PhotoInterrupter *EJ_Pipeline::_photoInterrupters[EJ_PIPELINE_MAX_PHOTOINTERRUPTERS];
+EJ_ToFUnit *EJ_Pipeline::_tofUnits[EJ_PIPELINE_MAX_TOFUNITS];
+SensorFrame EJ_Pipeline::_frame;
+EJ_Seqlock<SensorFrame> EJ_Pipeline::_published;
+uint32_t EJ_Pipeline::_interval = 1;
+void *EJ_Pipeline::_task = NULL;
+
+/* private method */
+void EJ_Pipeline::taskMain(void *parameter)
+{
+    (void)parameter;
+#ifdef ARDUINO_ARCH_ESP32
+    TickType_t wake = xTaskGetTickCount();
+    TickType_t interval = pdMS_TO_TICKS(_interval) > 0 ? pdMS_TO_TICKS(_interval) : 1;
+    for (;;) {
+        acquire();
+        vTaskDelayUntil(&wake, interval);
+    }
+#endif
+}
+
+/* static public method */
+int8_t EJ_Pipeline::addEncoder(EJ_EncoderMotor *encoder)
+{
+    if (_task != NULL || encoder == NULL || _frame.encoderCount >= EJ_PIPELINE_MAX_ENCODERS) {
+        /*
+        ERRORLOG
+            内容：取得中、NULL、またはエンコーダの数がEJ_PIPELINE_MAX_ENCODERSを超えている
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    _encoders[_frame.encoderCount] = encoder;
+    return (int8_t)_frame.encoderCount++;
+}
+
+int8_t EJ_Pipeline::addPhotoInterrupter(EJ_PhotoInterrupter *photoInterrupter)
+{
+    if (_task != NULL || photoInterrupter == NULL || _frame.photoCount >= EJ_PIPELINE_MAX_PHOTOINTERRUPTERS) {
+        /*
+        ERRORLOG
+            内容：取得中、NULL、またはフォトインタラプタの数がEJ_PIPELINE_MAX_PHOTOINTERRUPTERSを超えている
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    _photoInterrupters[_frame.photoCount] = photoInterrupter;
+    return (int8_t)_frame.photoCount++;
+}
+
+int8_t EJ_Pipeline::addToFUnit(EJ_ToFUnit *tof)
+{
+    if (_task != NULL || tof == NULL || _frame.tofCount >= EJ_PIPELINE_MAX_TOFUNITS) {
+        /*
+        ERRORLOG
+            内容：取得中、NULL、またはToFユニットの数がEJ_PIPELINE_MAX_TOFUNITSを超えている
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    _tofUnits[_frame.tofCount] = tof;
+    return (int8_t)_frame.tofCount++;
+}
+
+bool EJ_Pipeline::start(uint32_t interval, uint8_t core)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        return false;
+    }
+    _interval = interval;
+    TaskHandle_t task = NULL;
+    if (xTaskCreatePinnedToCore(taskMain, "EJ_Pipeline", EJ_PIPELINE_STACK_SIZE, NULL,
+                                EJ_PIPELINE_PRIORITY, &task, core) != pdPASS) {
+        /*
+        ERRORLOG
+            内容：タスクの生成に失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return false;
+    }
+    _task = task;
+    /* 登録したToFユニットは以降、取得タスクからしか測距を進められない */
+    for (uint8_t i = 0; i < _frame.tofCount; i++) {
+        _tofUnits[i]->setOwner(task);
+    }
+    return true;
+#else
+    (void)interval;
+    (void)core;
+    /*
+    ERRORLOG
+        内容：タスクに対応していないプラットフォーム (acquire()を使う)
+    */
+    ERRORLOG(EJ_ERROR_UNSUPPORTED);
+    return false;
+#endif
+}
+
+void EJ_Pipeline::stop()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        vTaskDelete((TaskHandle_t)_task);
+        _task = NULL;
+        for (uint8_t i = 0; i < _frame.tofCount; i++) {
+            _tofUnits[i]->setOwner(NULL);
+        }
+    }
+#endif
+}
+
+void EJ_Pipeline::acquire()
+{
+    /* エンコーダとフォトインタラプタは時刻を揃えるため続けて読む */
+    _frame.encoderTime = micros();
+    for (uint8_t i = 0; i < _frame.encoderCount; i++) {
+        _frame.encoders[i] = _encoders[i]->read();
+    }
+    _frame.photoTime = micros();
+    uint32_t states = 0;
+    for (uint8_t i = 0; i < _frame.photoCount; i++) {
+        states |= (_photoInterrupters[i]->isInterrupted() ? 1UL : 0UL) << i;
+    }
+    _frame.photoStates = states;
+
+    /* ToFユニットは新しい測距結果がある場合だけ更新し、なければ前回の値を残す */
+    for (uint8_t i = 0; i < _frame.tofCount; i++) {
+        if (_tofUnits[i]->poll()) {
+            const ToFMeasurement &measurement = _tofUnits[i]->getMeasurement();
+            _frame.ranges[i] = measurement.range;
+            _frame.rangeStatus[i] = measurement.rangeStatus;
+            _frame.rangeTime[i] = micros();
+        }
+    }
+
+    _frame.sequence++;
+    _frame.timestamp = micros();
+    _published.write(_frame);
+}
+
+bool EJ_Pipeline::getSnapshot(SensorFrame &frame)
+{
+    return _published.read(frame);
+}
+
+uint32_t EJ_Pipeline::getFrameCount()
+{
+    return _published.getVersion();
+}
+
+uint32_t EJ_Pipeline::getRetryCount()
+{
+    return _published.getRetryCount();
+}
@@ -0,0 +1,418 @@
+#include "EJ_SensorLog.h"
+#include "EJ_ErrorLog.h"
+#ifdef EJ_NATIVE
+#include <stdio.h>
+#endif
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* ヘッダの大きさとセンサの定義のタグ */
+#define EJ_SENSORLOG_HEADER_SIZE 9
+#define EJ_SENSORLOG_DEFINE 0xFF
+
+/* 記録は複数のタスクから呼ばれるため、バッファへの追記を排他する */
+#ifdef ARDUINO_ARCH_ESP32
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+#define LOG_LOCK() portENTER_CRITICAL(&logMux)
+#define LOG_UNLOCK() portEXIT_CRITICAL(&logMux)
+#else
+#define LOG_LOCK() ((void)0)
+#define LOG_UNLOCK() ((void)0)
+#endif
+
+/*----------------
+class EJ_SensorLog
+----------------*/
+
+/* static member */
+const char* EJ_SensorLog::_classname = "EJ_SensorLog";
+bool EJ_SensorLog::_recording = false;
+bool EJ_SensorLog::_replaying = false;
+bool EJ_SensorLog::_finished = false;
+EJ_SensorLog::Channel EJ_SensorLog::_channels[EJ_SENSORLOG_MAX_CHANNELS];
+uint8_t EJ_SensorLog::_channelCount = 0;
+Print *EJ_SensorLog::_out = NULL;
+uint8_t EJ_SensorLog::_buffers[2][EJ_SENSORLOG_BUFFER_SIZE];
+size_t EJ_SensorLog::_lengths[2];
+uint8_t EJ_SensorLog::_active = 0;
+bool EJ_SensorLog::_pending = false;
+uint32_t EJ_SensorLog::_lastTime = 0;
+uint32_t EJ_SensorLog::_records = 0;
+uint32_t EJ_SensorLog::_dropped = 0;
+const uint8_t *EJ_SensorLog::_log = NULL;
+size_t EJ_SensorLog::_size = 0;
+uint8_t *EJ_SensorLog::_loaded = NULL;
+uint64_t EJ_SensorLog::_now = 0;
+
+/* private method */
+bool EJ_SensorLog::append(const uint8_t *data, size_t length)
+{
+    if (_lengths[_active] + length > EJ_SENSORLOG_BUFFER_SIZE) {
+        if (_pending) {
+            return false;
+        }
+        /* 一杯になった面を書き出し待ちにし、もう一方の面に追記する */
+        _pending = true;
+        _active ^= 1;
+        _lengths[_active] = 0;
+    }
+    memcpy(_buffers[_active] + _lengths[_active], data, length);
+    _lengths[_active] += length;
+    return true;
+}
+
+size_t EJ_SensorLog::writeVarint(uint8_t *data, uint32_t value)
+{
+    size_t length = 0;
+    while (value >= 0x80) {
+        data[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    data[length++] = (uint8_t)value;
+    return length;
+}
+
+bool EJ_SensorLog::readVarint(size_t &offset, uint32_t &value)
+{
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (offset >= _size) {
+            return false;
+        }
+        uint8_t byte = _log[offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EJ_SensorLog::skipRecord(size_t &offset, uint8_t &tag, uint32_t &elapsed, int32_t &delta)
+{
+    if (offset >= _size) {
+        return false;
+    }
+    tag = _log[offset++];
+    elapsed = 0;
+    delta = 0;
+    if (tag == EJ_SENSORLOG_DEFINE) {
+        offset += 2;
+        return offset <= _size;
+    }
+    uint32_t zigzag;
+    if (!readVarint(offset, elapsed) || !readVarint(offset, zigzag)) {
+        return false;
+    }
+    delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+    return true;
+}
+
+bool EJ_SensorLog::nextRecord(uint8_t index, size_t &offset, uint32_t &time, int32_t &delta)
+{
+    /* このチャンネルの次のレコードまで読み進める (他のチャンネルのレコードは経過時間だけを加える) */
+    uint8_t tag;
+    uint32_t elapsed;
+    while (skipRecord(offset, tag, elapsed, delta)) {
+        time += elapsed;
+        if (tag == index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int8_t EJ_SensorLog::findChannel(uint8_t kind, uint8_t key)
+{
+    for (uint8_t i = 0; i < _channelCount; i++) {
+        if (_channels[i].kind == kind && _channels[i].key == key) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+uint64_t EJ_SensorLog::clock()
+{
+    return _now;
+}
+
+void EJ_SensorLog::sleep(uint32_t us)
+{
+    _now += us;
+}
+
+/* static public method */
+bool EJ_SensorLog::startRecording(Print &out)
+{
+    if (_recording || _replaying) {
+        /*
+        ERRORLOG
+            内容：記録中または再生中に記録を開始しようとした
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return false;
+    }
+    uint32_t now = micros();
+    uint8_t header[EJ_SENSORLOG_HEADER_SIZE] = {'E', 'J', 'R', 'L', EJ_SENSORLOG_VERSION,
+        (uint8_t)(now & 0xFF), (uint8_t)((now >> 8) & 0xFF), (uint8_t)((now >> 16) & 0xFF), (uint8_t)(now >> 24)};
+    out.write(header, sizeof(header));
+    _out = &out;
+    _channelCount = 0;
+    _active = 0;
+    _pending = false;
+    _lengths[0] = 0;
+    _lengths[1] = 0;
+    _lastTime = now;
+    _records = 0;
+    _dropped = 0;
+    _recording = true;
+    return true;
+}
+
+void EJ_SensorLog::stopRecording()
+{
+    if (!_recording) {
+        return;
+    }
+    LOG_LOCK();
+    _recording = false;
+    LOG_UNLOCK();
+    update();
+    _out->write(_buffers[_active], _lengths[_active]);
+    _lengths[_active] = 0;
+}
+
+size_t EJ_SensorLog::update()
+{
+    LOG_LOCK();
+    bool pending = _pending;
+    uint8_t index = _active ^ 1;
+    LOG_UNLOCK();
+    if (!pending || _out == NULL) {
+        return 0;
+    }
+    /* 書き出し待ちの面は、_pendingを戻すまで記録側が触らない */
+    size_t written = _out->write(_buffers[index], _lengths[index]);
+    LOG_LOCK();
+    _pending = false;
+    LOG_UNLOCK();
+    return written;
+}
+
+void EJ_SensorLog::record(EJ_SensorKind kind, uint8_t key, int32_t value)
+{
+    if (!_recording) {
+        return;
+    }
+    uint8_t data[3 + 1 + 5 + 5];
+    size_t length = 0;
+    LOG_LOCK();
+    int8_t channel = findChannel((uint8_t)kind, key);
+    bool define = channel < 0;
+    if (define) {
+        if (_channelCount >= EJ_SENSORLOG_MAX_CHANNELS) {
+            LOG_UNLOCK();
+            /*
+            ERRORLOG
+                内容：センサの数がEJ_SENSORLOG_MAX_CHANNELSを超えている
+            */
+            ERRORLOG(EJ_ERROR_CAPACITY);
+            return;
+        }
+        channel = (int8_t)_channelCount;
+        data[length++] = EJ_SENSORLOG_DEFINE;
+        data[length++] = (uint8_t)kind;
+        data[length++] = key;
+    }
+    int32_t previous = define ? 0 : _channels[channel].value;
+    uint32_t now = micros();
+    int32_t delta = (int32_t)((uint32_t)value - (uint32_t)previous);
+    data[length++] = (uint8_t)channel;
+    length += writeVarint(data + length, now - _lastTime);
+    length += writeVarint(data + length, ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+    /* 捨てたレコードは前の値と時刻を更新しないため、以降の差分は記録したレコードから復元できる */
+    if (append(data, length)) {
+        if (define) {
+            _channels[channel].kind = (uint8_t)kind;
+            _channels[channel].key = key;
+            _channelCount++;
+        }
+        _channels[channel].value = value;
+        _lastTime = now;
+        _records++;
+    } else {
+        _dropped++;
+    }
+    LOG_UNLOCK();
+}
+
+bool EJ_SensorLog::startReplay(const uint8_t *log, size_t size)
+{
+    if (_recording || log == NULL || size < EJ_SENSORLOG_HEADER_SIZE || memcmp(log, "EJRL", 4) != 0
+        || log[4] != EJ_SENSORLOG_VERSION) {
+        /*
+        ERRORLOG
+            内容：記録中、またはログの形式が正しくない
+        */
+        ERRORLOG(EJ_ERROR_INVALID_DATA);
+        return false;
+    }
+    _log = log;
+    _size = size;
+    uint32_t start = (uint32_t)log[5] | ((uint32_t)log[6] << 8) | ((uint32_t)log[7] << 16) | ((uint32_t)log[8] << 24);
+    /* センサの定義を集め、各チャンネルの読み出し位置を先頭にする */
+    _channelCount = 0;
+    size_t offset = EJ_SENSORLOG_HEADER_SIZE;
+    uint8_t tag;
+    uint32_t elapsed;
+    int32_t delta;
+    while (offset < _size) {
+        size_t at = offset;
+        if (!skipRecord(offset, tag, elapsed, delta)) {
+            /* 記録中に電源が切れた場合など、末尾の不完全なレコードは無視する */
+            _size = at;
+            break;
+        }
+        if (tag == EJ_SENSORLOG_DEFINE && _channelCount < EJ_SENSORLOG_MAX_CHANNELS) {
+            Channel &channel = _channels[_channelCount++];
+            channel.kind = _log[at + 1];
+            channel.key = _log[at + 2];
+        }
+    }
+    for (uint8_t i = 0; i < _channelCount; i++) {
+        _channels[i].value = 0;
+        _channels[i].offset = EJ_SENSORLOG_HEADER_SIZE;
+        _channels[i].time = start;
+    }
+    _now = start;
+    _finished = false;
+    _replaying = true;
+#ifdef EJ_NATIVE
+    EJ_HAL::setClock(clock, sleep);
+#endif
+    return true;
+}
+
+#ifdef EJ_NATIVE
+bool EJ_SensorLog::startReplay(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        /*
+        ERRORLOG
+            内容：ログのファイルを開けなかった
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    stopReplay();
+    _loaded = (uint8_t *)malloc(size > 0 ? (size_t)size : 1);
+    size_t loaded = _loaded != NULL ? fread(_loaded, 1, (size_t)(size > 0 ? size : 0), file) : 0;
+    fclose(file);
+    if (!startReplay(_loaded, loaded)) {
+        stopReplay();
+        return false;
+    }
+    return true;
+}
+#endif
+
+void EJ_SensorLog::stopReplay()
+{
+    if (_replaying) {
+        _replaying = false;
+#ifdef EJ_NATIVE
+        EJ_HAL::setClock(NULL, NULL);
+#endif
+    }
+    free(_loaded);
+    _loaded = NULL;
+    _log = NULL;
+    _size = 0;
+}
+
+bool EJ_SensorLog::isFinished()
+{
+    return _finished;
+}
+
+int32_t EJ_SensorLog::replay(EJ_SensorKind kind, uint8_t key)
+{
+    int8_t index = findChannel((uint8_t)kind, key);
+    if (!_replaying || index < 0) {
+        _finished = true;
+        return 0;
+    }
+    Channel &channel = _channels[index];
+    int32_t delta;
+    if (!nextRecord((uint8_t)index, channel.offset, channel.time, delta)) {
+        channel.offset = _size;
+        _finished = true;
+        return channel.value;
+    }
+    channel.value = (int32_t)((uint32_t)channel.value + (uint32_t)delta);
+    /* 時刻は記録した時刻より前に戻さない (delay()で先に進んでいる場合はそのまま) */
+    if ((int32_t)(channel.time - (uint32_t)_now) > 0) {
+        _now += (uint32_t)(channel.time - (uint32_t)_now);
+    }
+    return channel.value;
+}
+
+int32_t EJ_SensorLog::replayLatest(EJ_SensorKind kind, uint8_t key)
+{
+    int8_t index = findChannel((uint8_t)kind, key);
+    if (!_replaying || index < 0) {
+        _finished = true;
+        return 0;
+    }
+    /* 現在時刻までのレコードを読み進め、次のレコードは時刻に達するまで残す */
+    Channel &channel = _channels[index];
+    bool first = channel.offset == EJ_SENSORLOG_HEADER_SIZE;
+    while (true) {
+        size_t offset = channel.offset;
+        uint32_t time = channel.time;
+        int32_t delta;
+        if (!nextRecord((uint8_t)index, offset, time, delta)) {
+            _finished = true;
+            return channel.value;
+        }
+        int32_t value = (int32_t)((uint32_t)channel.value + (uint32_t)delta);
+        if ((int32_t)(time - (uint32_t)_now) > 0) {
+            return first ? value : channel.value;
+        }
+        channel.offset = offset;
+        channel.time = time;
+        channel.value = value;
+        first = false;
+    }
+}
+
+bool EJ_SensorLog::isDue(EJ_SensorKind kind, uint8_t key)
+{
+    int8_t index = findChannel((uint8_t)kind, key);
+    if (!_replaying || index < 0) {
+        return false;
+    }
+    /* replay()と同じように読み進めるが、チャンネルの位置は更新しない */
+    size_t offset = _channels[index].offset;
+    uint32_t time = _channels[index].time;
+    int32_t delta;
+    if (!nextRecord((uint8_t)index, offset, time, delta)) {
+        return false;
+    }
+    return (int32_t)(time - (uint32_t)_now) <= 0;
+}
+
+uint32_t EJ_SensorLog::getRecordCount()
+{
+    return _records;
+}
+
+uint32_t EJ_SensorLog::getDroppedCount()
+{
+    return _dropped;
+}
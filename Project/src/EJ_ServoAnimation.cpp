@@ -0,0 +1,390 @@
+#include "EJ_ServoAnimation.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* ヘッダのサイズ */
+static const size_t HEADER_SIZE = 12;
+
+/* リトルエンディアンの16bit値を読み出す (アライメントを仮定しない) */
+static inline uint16_t readU16(const uint8_t *p)
+{
+    return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+/*----------------
+class EJ_ServoClip
+----------------*/
+
+/* static member */
+const char* EJ_ServoClip::_classname = "EJ_ServoClip";
+
+/* public method */
+EJ_ServoClip::EJ_ServoClip()
+:   _data(NULL),
+    _channelCount(0),
+    _quantum(0),
+    _frameInterval(0),
+    _frameCount(0),
+    _servoIds(NULL),
+    _firstFrame(NULL),
+    _deltas(NULL)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    _mmapHandle = 0;
+    _mapped = false;
+#endif
+}
+
+EJ_ServoClip::~EJ_ServoClip()
+{
+    close();
+}
+
+bool EJ_ServoClip::open(const uint8_t *data, size_t size)
+{
+    close();
+    return load(data, size);
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+bool EJ_ServoClip::openPartition(const char *label)
+{
+    close();
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == NULL) {
+        /*
+        ERRORLOG
+            内容：指定したラベルのパーティションが存在しない
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    const void *mapped = NULL;
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &_mmapHandle) != 0) {
+        /*
+        ERRORLOG
+            内容：パーティションのメモリマップに失敗した
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    _mapped = true;
+    if (!load((const uint8_t *)mapped, partition->size)) {
+        close();
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool EJ_ServoClip::isOpen()
+{
+    return _data != NULL;
+}
+
+uint8_t EJ_ServoClip::getChannelCount()
+{
+    return _channelCount;
+}
+
+uint8_t EJ_ServoClip::getServoId(uint8_t channel)
+{
+    if (channel >= _channelCount) {
+        /*
+        ERRORLOG
+            内容：存在しないチャンネルが指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ID);
+        return 0;
+    }
+    return _servoIds[channel];
+}
+
+uint16_t EJ_ServoClip::getFrameCount()
+{
+    return _frameCount;
+}
+
+uint16_t EJ_ServoClip::getFrameInterval()
+{
+    return _frameInterval;
+}
+
+uint32_t EJ_ServoClip::getDuration()
+{
+    return (uint32_t)_frameInterval * (_frameCount - 1);
+}
+
+bool EJ_ServoClip::isCompatible(EJ_ServoClip &other)
+{
+    return isOpen() && other.isOpen() && _channelCount == other._channelCount
+        && memcmp(_servoIds, other._servoIds, _channelCount) == 0;
+}
+
+/* private method */
+bool EJ_ServoClip::load(const uint8_t *data, size_t size)
+{
+    if (data == NULL || size < HEADER_SIZE || memcmp(data, "EJKF", 4) != 0 || data[4] != EJ_ANIMATION_FORMAT_VERSION || data[7] != 0) {
+        /*
+        ERRORLOG
+            内容：クリップのヘッダが不正
+        */
+        ERRORLOG(EJ_ERROR_INVALID_DATA);
+        return false;
+    }
+    uint8_t channelCount = data[5];
+    uint8_t quantum = data[6];
+    uint16_t frameInterval = readU16(&data[8]);
+    uint16_t frameCount = readU16(&data[10]);
+    if (channelCount == 0 || EJ_ANIMATION_MAX_CHANNELS < channelCount || quantum == 0 || frameInterval == 0 || frameCount == 0) {
+        /*
+        ERRORLOG
+            内容：クリップのチャンネル数、量子化幅、キーフレーム間隔、キーフレーム数のいずれかが不正
+        */
+        ERRORLOG(EJ_ERROR_INVALID_DATA);
+        return false;
+    }
+    size_t required = HEADER_SIZE + channelCount + channelCount * 2 + (size_t)channelCount * (frameCount - 1);
+    if (size < required) {
+        /*
+        ERRORLOG
+            内容：クリップのデータが不足している
+        */
+        ERRORLOG(EJ_ERROR_INVALID_DATA);
+        return false;
+    }
+    /* 再生中に範囲外の角度を出力しないよう、全てのキーフレームを先に復元して確かめる */
+    const uint8_t *firstFrame = &data[HEADER_SIZE + channelCount];
+    const uint8_t *deltas = firstFrame + channelCount * 2;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        int32_t angle = (int16_t)readU16(&firstFrame[i * 2]);
+        for (uint16_t frame = 0; ; frame++) {
+            if (angle < 0 || 18000 < angle) {
+                /*
+                ERRORLOG
+                    内容：クリップのキーフレームの角度が0度~180度の範囲外
+                */
+                ERRORLOG(EJ_ERROR_INVALID_DATA);
+                return false;
+            }
+            if (frame + 1 >= frameCount) {
+                break;
+            }
+            angle += (int8_t)deltas[(size_t)frame * channelCount + i] * quantum;
+        }
+    }
+    _data = data;
+    _channelCount = channelCount;
+    _quantum = quantum;
+    _frameInterval = frameInterval;
+    _frameCount = frameCount;
+    _servoIds = &data[HEADER_SIZE];
+    _firstFrame = firstFrame;
+    _deltas = deltas;
+    return true;
+}
+
+void EJ_ServoClip::close()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_mapped) {
+        spi_flash_munmap(_mmapHandle);
+        _mapped = false;
+    }
+#endif
+    _data = NULL;
+    _channelCount = 0;
+    _frameCount = 0;
+}
+
+/*---------------------------
+class EJ_ServoAnimationPlayer
+---------------------------*/
+
+/* static member */
+const char* EJ_ServoAnimationPlayer::_classname = "EJ_ServoAnimationPlayer";
+
+/* public method */
+EJ_ServoAnimationPlayer::EJ_ServoAnimationPlayer()
+:   _current(0),
+    _playing(false),
+    _paused(false),
+    _blending(false),
+    _blendTime(0),
+    _blendElapsed(0),
+    _speed(256),
+    _lastUpdate(0)
+{
+    memset(_tracks, 0, sizeof(_tracks));
+    memset(_servoIds, 0, sizeof(_servoIds));
+    memset(_angles, 0, sizeof(_angles));
+}
+
+EJ_ServoAnimationPlayer::~EJ_ServoAnimationPlayer()
+{}
+
+bool EJ_ServoAnimationPlayer::play(EJ_ServoClip *clip, bool loop, uint32_t blendTime)
+{
+    if (clip == NULL || !clip->isOpen()) {
+        /*
+        ERRORLOG
+            内容：開かれていないクリップが指定された
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return false;
+    }
+    Track &current = _tracks[_current];
+    _blending = _playing && blendTime > 0 && current.clip != NULL && current.clip->isCompatible(*clip);
+    if (_blending) {
+        _current ^= 1;
+        _blendTime = blendTime;
+        _blendElapsed = 0;
+    }
+    Track &track = _tracks[_current];
+    track.clip = clip;
+    track.loop = loop;
+    track.time = 0;
+    rewind(track);
+    memcpy(_servoIds, clip->_servoIds, clip->_channelCount);
+    _playing = true;
+    _paused = false;
+    _lastUpdate = millis();
+    return true;
+}
+
+void EJ_ServoAnimationPlayer::stop()
+{
+    _playing = false;
+    _blending = false;
+}
+
+void EJ_ServoAnimationPlayer::pause()
+{
+    _paused = true;
+}
+
+void EJ_ServoAnimationPlayer::resume()
+{
+    _paused = false;
+    _lastUpdate = millis();
+}
+
+void EJ_ServoAnimationPlayer::setSpeed(float speed)
+{
+    _speed = (uint16_t)(constrain(speed, 0.0f, 255.0f) * 256.0f);
+}
+
+bool EJ_ServoAnimationPlayer::update()
+{
+    if (!_playing) {
+        return false;
+    }
+    uint32_t now = millis();
+    uint32_t elapsed = now - _lastUpdate;
+    _lastUpdate = now;
+    if (_paused) {
+        return true;
+    }
+
+    Track &track = _tracks[_current];
+    uint8_t channelCount = track.clip->_channelCount;
+    uint32_t delta = elapsed * _speed;
+    advance(track, delta, _angles);
+    if (_blending) {
+        int32_t previous[EJ_ANIMATION_MAX_CHANNELS];
+        advance(_tracks[_current ^ 1], delta, previous);
+        _blendElapsed += elapsed;
+        if (_blendElapsed >= _blendTime) {
+            _blending = false;
+        } else {
+            int64_t weight = ((uint64_t)_blendElapsed << 16) / _blendTime;
+            for (uint8_t i = 0; i < channelCount; i++) {
+                _angles[i] = previous[i] + (int32_t)(((_angles[i] - previous[i]) * weight) >> 16);
+            }
+        }
+    }
+    EJ_ServoMotor_Manager::writeFrame(_servoIds, _angles, channelCount);
+
+    if (track.finished && !_blending) {
+        _playing = false;
+    }
+    return _playing;
+}
+
+bool EJ_ServoAnimationPlayer::isPlaying()
+{
+    return _playing;
+}
+
+uint32_t EJ_ServoAnimationPlayer::getPosition()
+{
+    const Track &track = _tracks[_current];
+    if (track.clip == NULL) {
+        return 0;
+    }
+    return (uint32_t)track.frame * track.clip->_frameInterval + (track.time >> 8);
+}
+
+/* static private method */
+void EJ_ServoAnimationPlayer::rewind(Track &track)
+{
+    EJ_ServoClip *clip = track.clip;
+    uint8_t channelCount = clip->_channelCount;
+    track.frame = 0;
+    track.finished = false;
+    track.cursor = clip->_deltas;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        track.from[i] = (int16_t)readU16(&clip->_firstFrame[i * 2]);
+        track.to[i] = track.from[i];
+    }
+    if (clip->_frameCount > 1) {
+        for (uint8_t i = 0; i < channelCount; i++) {
+            track.to[i] += (int8_t)track.cursor[i] * clip->_quantum;
+        }
+        track.cursor += channelCount;
+    } else {
+        track.finished = !track.loop;
+    }
+}
+
+void EJ_ServoAnimationPlayer::advance(Track &track, uint32_t delta, int32_t *angles)
+{
+    EJ_ServoClip *clip = track.clip;
+    uint8_t channelCount = clip->_channelCount;
+    if (track.finished || clip->_frameCount == 1) {
+        memcpy(angles, track.to, channelCount * sizeof(int32_t));
+        return;
+    }
+
+    uint32_t interval = (uint32_t)clip->_frameInterval << 8;
+    track.time += delta;
+    while (track.time >= interval) {
+        track.time -= interval;
+        track.frame++;
+        if (track.frame >= clip->_frameCount - 1) {
+            if (!track.loop) {
+                track.finished = true;
+                track.frame = clip->_frameCount - 1;
+                track.time = 0;
+                memcpy(track.from, track.to, channelCount * sizeof(int32_t));
+                memcpy(angles, track.to, channelCount * sizeof(int32_t));
+                return;
+            }
+            rewind(track);
+            continue;
+        }
+        for (uint8_t i = 0; i < channelCount; i++) {
+            track.from[i] = track.to[i];
+            track.to[i] += (int8_t)track.cursor[i] * clip->_quantum;
+        }
+        track.cursor += channelCount;
+    }
+
+    /* 補間区間内の位置 (Q16固定小数点) */
+    int64_t fraction = (track.time << 8) / clip->_frameInterval;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        angles[i] = track.from[i] + (int32_t)(((int64_t)(track.to[i] - track.from[i]) * fraction) >> 16);
+    }
+}
@@ -1,18 +1,8 @@
 #include "EJ_ServoMotor.h"
 
-#ifdef M5CORE2
-#include <M5Core2.h>
-#elif M5STICKCPLUS
-#include <M5StickCPlus.h>
-#else
-#undef M5_DEBUG
-#endif
+#include "EJ_ErrorLog.h"
 
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
-#else
-#define ERRORLOG() ((void)0)
-#endif
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
 
 /*-------------------
 class EJ_ServoMotor
@@ -21,21 +11,116 @@ class EJ_ServoMotor
 /* static member */
 const char* EJ_ServoMotor::_classname = "EJ_ServoMotor";
 
+#ifdef ARDUINO_ARCH_ESP32
+#define MOTION_LOCK() portENTER_CRITICAL(&_mux)
+#define MOTION_UNLOCK() portEXIT_CRITICAL(&_mux)
+#else
+#define MOTION_LOCK() ((void)0)
+#define MOTION_UNLOCK() ((void)0)
+#endif
+
+/* Q16固定小数点の1.0 */
+static const uint32_t Q16_ONE = 1UL << 16;
+
 /* private method */
-EJ_ServoMotor::EJ_ServoMotor(uint8_t pin, int min, int max)
+EJ_ServoMotor::EJ_ServoMotor(uint8_t pin, int min, int max, const ServoCalPoint *calibration, uint8_t calibrationSize, Backend backend, EJ_PCA9685 *expander)
 :   _pin(pin),
+    _backend(backend),
+    _expander(expander),
+    _channel(-1),
     _min_(min),
     _max_(max),
-    Servo()
+    _segmentCount(0),
+    _angle(0),
+    _moving(false),
+    _easing(EASING_LINEAR),
+    _startAngle(0),
+    _targetAngle(0),
+    _startTime(0),
+    _duration(0),
+    _progress(100),
+    _load(1.0f),
+    _tracking(false),
+    _estimate(0.0f),
+    _estimateTime(0),
+    _settled(true),
+    _arrivedTime(0)
+{
+    _kinematics.speed = 0.0f;
+    _kinematics.timeConstant = 0.0f;
+    _kinematics.deadband = 0;
+#ifdef ARDUINO_ARCH_ESP32
+    _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+    if (calibration != NULL && calibrationSize >= 2) {
+        _min_ = calibration[0].us;
+        _max_ = calibration[0].us;
+        for (uint8_t i = 1; i < calibrationSize; i++) {
+            if (calibration[i].us < _min_) _min_ = calibration[i].us;
+            if (calibration[i].us > _max_) _max_ = calibration[i].us;
+        }
+    }
+    if (_backend == BACKEND_LEDC) {
+        _channel = EJ_Peripheral::allocateLEDC(EJ_SERVO_LEDC_FREQUENCY, EJ_SERVO_LEDC_RESOLUTION);
+        if (_channel >= 0) {
+            ledcAttachPin(_pin, _channel);
+        } else {
+            /* 
+            ERRORLOG 
+                内容: LEDCチャンネルの割り当てに失敗した
+            */
+            ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        }
+    } else if (_backend == BACKEND_RMT) {
+        /* 校正テーブルの設定前のため、中間のパルス幅で出力を開始する */
+        if (!_rmt.attach(_pin, (uint16_t)((_min_ + _max_) / 2))) {
+            /* 
+            ERRORLOG 
+                内容: RMTチャンネルの割り当てに失敗した
+            */
+            ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        }
+    }
+    if (!setCalibration(calibration, calibrationSize)) {
+        /* 不正な校正テーブルはmin, maxによる線形の対応で置き換える */
+        setCalibration(NULL, 0);
+    }
+}
+
+void EJ_ServoMotor::output(int32_t angle)
 {
-    pinMode(_pin, OUTPUT);
-    Servo::attach(_pin, _min_, _max_);
+    if (!_tracking) {
+        /* 最初の出力ではホーンが指令角度にあるとみなす */
+        _estimate = (float)angle;
+        _estimateTime = millis();
+        _tracking = true;
+    }
+    _angle = angle;
+    if (fabsf((float)angle - _estimate) > _kinematics.deadband) {
+        _settled = false;
+    }
+    writeMicroseconds(angleToMicroseconds(angle));
 }
 
 /* public method */
 EJ_ServoMotor::~EJ_ServoMotor()
 {
-    Servo::detach();
+    switch (_backend) {
+    case BACKEND_PCA9685:
+        _expander->setPulseWidth(_pin, 0);
+        break;
+    case BACKEND_RMT:
+        _rmt.detach();
+        break;
+    case BACKEND_LEDC:
+    default:
+        if (_channel >= 0) {
+            ledcWrite(_channel, 0);
+            ledcDetachPin(_pin);
+            EJ_Peripheral::release(EJ_PERIPHERAL_LEDC, _channel);
+        }
+        break;
+    }
 }
 
 void EJ_ServoMotor::write(int angle)
@@ -45,132 +130,550 @@ void EJ_ServoMotor::write(int angle)
         ERRORLOG 
             内容: 無効な角度が指定された
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
         return;
     }
-    Servo::write(angle);
+    writeCentiDegrees((int32_t)angle * 100);
 }
 
 void EJ_ServoMotor::writeMicroseconds(int us)
 {
-    Servo::writeMicroseconds(us);
+    switch (_backend) {
+    case BACKEND_PCA9685:
+        _expander->setPulseWidth(_pin, (uint16_t)constrain(us, _min_, _max_));
+        break;
+    case BACKEND_RMT:
+        _rmt.write((uint16_t)constrain(us, _min_, _max_));
+        break;
+    case BACKEND_LEDC:
+    default:
+        if (_channel >= 0) {
+            /* 1周期 (1000000 / EJ_SERVO_LEDC_FREQUENCY [us]) を2^EJ_SERVO_LEDC_RESOLUTIONカウントに対応させる */
+            uint32_t duty = ((uint32_t)constrain(us, _min_, _max_) << EJ_SERVO_LEDC_RESOLUTION) / (1000000UL / EJ_SERVO_LEDC_FREQUENCY);
+            ledcWrite(_channel, duty);
+        }
+        break;
+    }
 }
 
 int EJ_ServoMotor::read()
 {
-    return Servo::read();
+    return (readCentiDegrees() + 50) / 100;
 }
 
-/*-----------------
-class EJ_ServoMotor
------------------*/
+void EJ_ServoMotor::writeCentiDegrees(int32_t angle)
+{
+    stopMotion();
+    output(angle);
+}
 
-/* static member */
-EJ_ServoMotor_Manager* EJ_ServoMotor_Manager::_singleton = NULL;
-const char* EJ_ServoMotor_Manager::_classname = "EJ_ServoMotor_Manager";
+int32_t EJ_ServoMotor::readCentiDegrees()
+{
+    if (!hasKinematics()) {
+        return _angle;
+    }
+    updateEstimate(millis());
+    return (int32_t)lroundf(_estimate);
+}
 
-/* private method */
-EJ_ServoMotor_Manager::EJ_ServoMotor_Manager(size_t maxInstanceSize)
-:   _maxInstanceSize(maxInstanceSize),
-    _instanceList(NULL)
+int32_t EJ_ServoMotor::getCommandedCentiDegrees()
 {
-    _instanceList = new EJ_ServoMotor*[_maxInstanceSize];
-    if (_instanceList == NULL) {
+    return _angle;
+}
+
+void EJ_ServoMotor::setKinematics(const ServoKinematics &kinematics)
+{
+    if (kinematics.speed < 0.0f || kinematics.timeConstant < 0.0f) {
         /* 
         ERRORLOG 
-            内容: メモリ確保に失敗した
+            内容: 無効な応答モデルが指定された
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
         return;
     }
-    for (size_t i = 0; i < _maxInstanceSize; i++) {
-        _instanceList[i] = NULL;
-    }
+    MOTION_LOCK();
+    _kinematics = kinematics;
+    _estimate = (float)_angle;
+    _estimateTime = millis();
+    MOTION_UNLOCK();
 }
 
-/* static private method */
-EJ_ServoMotor_Manager* EJ_ServoMotor_Manager::getInstance()
+ServoKinematics EJ_ServoMotor::getKinematics()
 {
-    if (_singleton == NULL) {
-        /*
-        ERROLOG
-            内容：シングルトンがまだ生成されていない
+    return _kinematics;
+}
+
+bool EJ_ServoMotor::hasKinematics()
+{
+    return _kinematics.speed > 0.0f;
+}
+
+void EJ_ServoMotor::setLoad(float load)
+{
+    if (load < 1.0f) {
+        /* 
+        ERRORLOG 
+            内容: 無効な負荷係数が指定された
         */
-        ERRORLOG();
-        return NULL;
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
     }
+    _load = load;
+}
 
-    return _singleton;
+bool EJ_ServoMotor::isSettled()
+{
+    if (!hasKinematics()) {
+        return !_moving;
+    }
+    updateEstimate(millis());
+    return _settled && !_moving;
 }
 
-/* public method */
-EJ_ServoMotor_Manager::~EJ_ServoMotor_Manager()
+uint32_t EJ_ServoMotor::getArrivalTime()
 {
-    if (_instanceList != NULL) {
-        for (size_t i = 0; i < _maxInstanceSize; i++) {
-            if (_instanceList[i] != NULL) {
-                delete _instanceList[i];
-                _instanceList[i] = NULL;
+    uint32_t now = millis();
+    if (!hasKinematics()) {
+        return _moving ? _startTime + _duration : now;
+    }
+    updateEstimate(now);
+    if (_settled && !_moving) {
+        return _arrivedTime;
+    }
+    MOTION_LOCK();
+    bool moving = _moving;
+    int32_t target = moving ? _targetAngle : _angle;
+    uint32_t end = _startTime + _duration;
+    float velocity = moving && _duration > 0 ? fabsf((float)(_targetAngle - _startAngle)) / _duration : 0.0f;
+    float estimate = _estimate;
+    MOTION_UNLOCK();
+    uint32_t arrival = now + (uint32_t)predictSettleTime(fabsf((float)target - estimate));
+    if (moving) {
+        /* 軌道の終点では平均速度 × 時定数 程度の追従遅れが残っているとみなす */
+        uint32_t tail = end + (uint32_t)predictSettleTime(velocity * _kinematics.timeConstant * _load);
+        if ((int32_t)(tail - arrival) > 0) {
+            arrival = tail;
+        }
+    }
+    return arrival;
+}
+
+bool EJ_ServoMotor::fitKinematics(int32_t step1, uint32_t time1, int32_t step2, uint32_t time2, uint16_t deadband, ServoKinematics &kinematics)
+{
+    if (step1 <= 0 || step2 <= step1 || time2 <= time1 || deadband == 0) {
+        /* 
+        ERRORLOG 
+            内容: 無効な測定値が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+    /* 到達時間 T(step) = step / v + tau * (ln(tau * v / deadband) - 1) の傾きから速度を求める */
+    float v = (float)(step2 - step1) / (float)(time2 - time1);
+    float c = (float)time1 - (float)step1 / v;
+    float tau = 0.0f;
+    if (c > 0.0f) {
+        /* f(tau) = tau * (ln(tau * v / deadband) - 1) は tau > deadband / v で単調増加なので二分法で解く */
+        float low = deadband / v;
+        float high = low * 2.0f;
+        while (high * (logf(high * v / deadband) - 1.0f) < c) {
+            high *= 2.0f;
+        }
+        for (uint8_t i = 0; i < 32; i++) {
+            float mid = (low + high) * 0.5f;
+            if (mid * (logf(mid * v / deadband) - 1.0f) < c) {
+                low = mid;
+            } else {
+                high = mid;
             }
         }
+        tau = (low + high) * 0.5f;
     }
+    kinematics.speed = v * 10.0f;
+    kinematics.timeConstant = tau;
+    kinematics.deadband = deadband;
+    return true;
 }
 
-/* static public method */
-bool EJ_ServoMotor_Manager::configure(size_t maxInstanceSize)
+bool EJ_ServoMotor::setCalibration(const ServoCalPoint *calibration, uint8_t calibrationSize)
 {
-    if (_singleton == NULL) {
-        _singleton = new EJ_ServoMotor_Manager(maxInstanceSize);
-        if (_singleton == NULL) {
-            /*
-            ERROLOG
-                内容：メモリ確保に失敗した 
+    ServoCalPoint linear[2] = {{0, (uint16_t)_min_}, {18000, (uint16_t)_max_}};
+    if (calibration == NULL) {
+        calibration = linear;
+        calibrationSize = 2;
+    }
+    if (calibrationSize < 2) {
+        /* 
+        ERRORLOG 
+            内容: 校正テーブルの点数が不足している
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+    if (calibrationSize > EJ_SERVO_MAX_CAL_POINTS) {
+        /* 
+        ERRORLOG 
+            内容: 校正テーブルの点数がEJ_SERVO_MAX_CAL_POINTSを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
+    }
+    for (uint8_t i = 1; i < calibrationSize; i++) {
+        if (calibration[i].angle <= calibration[i - 1].angle) {
+            /* 
+            ERRORLOG 
+                内容: 校正テーブルが角度の昇順に並んでいない
             */
-            ERRORLOG();
+            ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
             return false;
         }
     }
+    Segment segments[EJ_SERVO_MAX_CAL_POINTS];
+    /* 各区間の傾きはここで1度だけ除算して求める。最後の要素は終点として傾き0で保持する */
+    for (uint8_t i = 0; i < calibrationSize; i++) {
+        segments[i].angle = calibration[i].angle;
+        segments[i].us = calibration[i].us;
+        segments[i].slope = 0;
+        if (i + 1 < calibrationSize) {
+            int32_t dUs = (int32_t)calibration[i + 1].us - calibration[i].us;
+            int32_t dAngle = (int32_t)calibration[i + 1].angle - calibration[i].angle;
+            segments[i].slope = (int32_t)(((int64_t)dUs << 16) / dAngle);
+        }
+    }
+    /* 他のタスクからのangleToMicroseconds()が途中まで書き換えたテーブルを読まないよう、ロックしたまま差し替える */
+    MOTION_LOCK();
+    memcpy(_segments, segments, sizeof(Segment) * calibrationSize);
+    _segmentCount = calibrationSize;
+    MOTION_UNLOCK();
+    return true;
+}
+
+int EJ_ServoMotor::angleToMicroseconds(int32_t angle)
+{
+    MOTION_LOCK();
+    uint8_t last = _segmentCount - 1;
+    Segment segment;
+    if (angle <= _segments[0].angle) {
+        segment = _segments[0];
+        angle = segment.angle;
+    } else if (angle >= _segments[last].angle) {
+        segment = _segments[last];
+        angle = segment.angle;
+    } else {
+        /* angleを含む区間 [_segments[low].angle, _segments[low + 1].angle) を二分探索する */
+        uint8_t low = 0;
+        uint8_t high = last;
+        while (high - low > 1) {
+            uint8_t mid = (low + high) / 2;
+            if (_segments[mid].angle <= angle) {
+                low = mid;
+            } else {
+                high = mid;
+            }
+        }
+        segment = _segments[low];
+    }
+    MOTION_UNLOCK();
+    return segment.us + (int32_t)(((int64_t)(angle - segment.angle) * segment.slope + (1 << 15)) >> 16);
+}
+
+void EJ_ServoMotor::moveTo(int angle, uint32_t duration, Easing easing)
+{
+    if (angle < 0 || 180 < angle) {
+        /* 
+        ERRORLOG 
+            内容: 無効な角度が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
+    }
+    moveToCentiDegrees((int32_t)angle * 100, duration, easing);
+}
+
+void EJ_ServoMotor::moveToCentiDegrees(int32_t angle, uint32_t duration, Easing easing)
+{
+    MOTION_LOCK();
+    _startAngle = _angle;
+    _targetAngle = angle;
+    _easing = easing;
+    _startTime = millis();
+    _duration = duration;
+    _progress = 0;
+    _moving = true;
+    MOTION_UNLOCK();
+}
+
+void EJ_ServoMotor::moveAtSpeed(int angle, float speed, Easing easing)
+{
+    if (speed <= 0.0f) {
+        /* 
+        ERRORLOG 
+            内容: 無効な速度が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
+    }
+    /* 加減速パターンの最大速度と平均速度の比 */
+    float peak = 1.0f;
+    if (easing == EASING_CUBIC) {
+        peak = 1.5f;
+    } else if (easing == EASING_TRAPEZOID) {
+        peak = 4.0f / 3.0f;
+    }
+    uint32_t duration = (uint32_t)(abs((int32_t)angle * 100 - _angle) * peak * 10.0f / speed);
+    moveTo(angle, duration, easing);
+}
+
+void EJ_ServoMotor::stopMotion()
+{
+    MOTION_LOCK();
+    _moving = false;
+    _progress = 100;
+    MOTION_UNLOCK();
+}
+
+bool EJ_ServoMotor::isMoving()
+{
+    return _moving;
+}
+
+uint8_t EJ_ServoMotor::getProgress()
+{
+    return _progress;
+}
+
+int EJ_ServoMotor::getTargetAngle()
+{
+    return ((_moving ? _targetAngle : _angle) + 50) / 100;
+}
+
+EJ_ServoMotor::Backend EJ_ServoMotor::getBackend()
+{
+    return _backend;
+}
+
+bool EJ_ServoMotor::attached()
+{
+    switch (_backend) {
+    case BACKEND_PCA9685:
+        return _expander != NULL;
+    case BACKEND_RMT:
+        return _rmt.isAttached();
+    case BACKEND_LEDC:
+    default:
+        return _channel >= 0;
+    }
+}
+
+/* private method */
+void EJ_ServoMotor::updateMotion(uint32_t now)
+{
+    MOTION_LOCK();
+    if (!_moving) {
+        MOTION_UNLOCK();
+        return;
+    }
+    uint32_t elapsed = now - _startTime;
+    int32_t angle = _targetAngle;
+    if (elapsed >= _duration) {
+        _moving = false;
+        _progress = 100;
+    } else {
+        uint32_t progress = (uint32_t)(((uint64_t)elapsed << 16) / _duration);
+        int32_t delta = (int32_t)(((int64_t)(_targetAngle - _startAngle) * ease(progress, _easing) + (Q16_ONE / 2)) >> 16);
+        angle = _startAngle + delta;
+        _progress = (uint8_t)((progress * 100) >> 16);
+    }
+    MOTION_UNLOCK();
+    if (angle != _angle) {
+        output(angle);
+    }
+}
+
+void EJ_ServoMotor::updateEstimate(uint32_t now)
+{
+    if (!hasKinematics()) {
+        return;
+    }
+    MOTION_LOCK();
+    uint32_t elapsed = now - _estimateTime;
+    if ((int32_t)elapsed <= 0) {
+        MOTION_UNLOCK();
+        return;
+    }
+    _estimateTime = now;
+    float error = (float)_angle - _estimate;
+    float tau = _kinematics.timeConstant * _load;
+    float step = error;
+    if (tau > 0.0f) {
+        step = error * (1.0f - expf(-(float)elapsed / tau));
+    }
+    /* 最大角速度 (0.01度/ms) による制限 */
+    float limit = _kinematics.speed * 0.1f / _load * elapsed;
+    step = constrain(step, -limit, limit);
+    _estimate += step;
+    bool settled = fabsf((float)_angle - _estimate) <= _kinematics.deadband;
+    if (settled && !_settled) {
+        _arrivedTime = now;
+    }
+    _settled = settled;
+    MOTION_UNLOCK();
+}
+
+float EJ_ServoMotor::predictSettleTime(float error)
+{
+    float deadband = _kinematics.deadband > 0 ? (float)_kinematics.deadband : 1.0f;
+    float speed = _kinematics.speed * 0.1f / _load;
+    float tau = _kinematics.timeConstant * _load;
+    if (error <= deadband) {
+        return 0.0f;
+    }
+    if (tau <= 0.0f) {
+        return error / speed;
+    }
+    /* 誤差が speed * tau を超える間は最大角速度、それ以下では1次遅れで収束する */
+    float time = 0.0f;
+    float knee = speed * tau;
+    if (error > knee) {
+        time += (error - knee) / speed;
+        error = knee;
+    }
+    if (error > deadband) {
+        time += tau * logf(error / deadband);
+    }
+    return time;
+}
+
+/* static private method */
+uint32_t EJ_ServoMotor::ease(uint32_t progress, Easing easing)
+{
+    uint64_t p = progress;
+    switch (easing) {
+    case EASING_CUBIC:
+        /* p^2 * (3 - 2p) */
+        return (uint32_t)((((p * p) >> 16) * (3 * Q16_ONE - 2 * p)) >> 16);
+    case EASING_TRAPEZOID:
+        /* 加速区間 ta = 1/4 のとき 2ta(1-ta) = 3/8 */
+        if (p < Q16_ONE / 4) {
+            return (uint32_t)(((p * p) >> 16) * 8 / 3);
+        } else if (p > Q16_ONE * 3 / 4) {
+            uint64_t r = Q16_ONE - p;
+            return (uint32_t)(Q16_ONE - ((r * r) >> 16) * 8 / 3);
+        }
+        return (uint32_t)((p - Q16_ONE / 8) * 4 / 3);
+    case EASING_LINEAR:
+    default:
+        return progress;
+    }
+}
+
+/*---------------------------
+class EJ_ServoMotor_Manager
+---------------------------*/
+
+/* static member */
+const char* EJ_ServoMotor_Manager::_classname = "EJ_ServoMotor_Manager";
+template <>
+const char* EJ_Manager<EJ_ServoMotor, EJ_SERVOMOTOR_MAX_INSTANCES>::_classname = "EJ_ServoMotor_Manager";
+
+/* static public method */
+bool EJ_ServoMotor_Manager::configure(size_t maxInstanceSize)
+{
+    if (maxInstanceSize > EJ_SERVOMOTOR_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_SERVOMOTOR_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
+    }
     return true;
 }
 
 EJ_ServoMotor* EJ_ServoMotor_Manager::createServo(ServoDef servo)
 {
-    return EJ_ServoMotor_Manager::createServo(servo.pin, servo.id);
+    return EJ_ServoMotor_Manager::createServo(servo.pin, servo.id, 544, 2400, servo.calibration, servo.calibrationSize);
+}
+
+EJ_ServoMotor* EJ_ServoMotor_Manager::createServo(uint8_t pin, uint8_t id, int min, int max, const ServoCalPoint *calibration, uint8_t calibrationSize)
+{
+    if (contains(id)) {
+        return &at(id);
+    }
+    EJ_ServoMotor *instance = create(id, pin, min, max, calibration, calibrationSize);
+    if (instance != NULL && !instance->attached()) {
+        /*
+        ERRORLOG
+            内容：LEDCチャンネルの割り当てに失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        destroy(id);
+        return NULL;
+    }
+    return instance;
+}
+
+EJ_ServoMotor* EJ_ServoMotor_Manager::createExpanderServo(ServoExpanderDef servo)
+{
+    return EJ_ServoMotor_Manager::createExpanderServo(servo.expander, servo.channel, servo.id, 544, 2400, servo.calibration, servo.calibrationSize);
 }
 
-EJ_ServoMotor* EJ_ServoMotor_Manager::createServo(uint8_t pin, uint8_t id, int min, int max)
+EJ_ServoMotor* EJ_ServoMotor_Manager::createExpanderServo(uint8_t expander, uint8_t channel, uint8_t id, int min, int max, const ServoCalPoint *calibration, uint8_t calibrationSize)
 {
-    EJ_ServoMotor_Manager *manager = EJ_ServoMotor_Manager::getInstance();
-    if (manager == NULL) {
+    if (channel >= EJ_PCA9685_CHANNELS) {
         /*
         ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
+            内容：存在しないチャンネルが指定された
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ID);
         return NULL;
     }
-    if (id > manager->_maxInstanceSize) {
+    if (contains(id)) {
+        return &at(id);
+    }
+    EJ_PCA9685 *pca9685 = EJ_PCA9685_Manager::getPCA9685(expander);
+    if (pca9685 == NULL) {
         /*
         ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
+            内容：接続先のEJ_PCA9685が取得できない
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_NOT_READY);
         return NULL;
     }
-    if (manager->_instanceList[id] == NULL) {
-        EJ_ServoMotor *instance = new EJ_ServoMotor(pin, min, max);
-        if (instance == NULL) {
+    for (uint8_t i = 0; i < EJ_SERVOMOTOR_MAX_INSTANCES; i++) {
+        if (contains(i) && at(i)._backend == EJ_ServoMotor::BACKEND_PCA9685 && at(i)._expander == pca9685 && at(i)._pin == channel) {
             /*
             ERRORLOG
-                内容：メモリ確保に失敗した
+                内容：同じPCA9685のチャンネルに別のサーボが生成済み
             */
-            ERRORLOG();
+            ERRORLOG(EJ_ERROR_NO_RESOURCE);
             return NULL;
         }
-        manager->_instanceList[id] = instance;
     }
+    return create(id, channel, min, max, calibration, calibrationSize, EJ_ServoMotor::BACKEND_PCA9685, pca9685);
+}
 
-    return manager->_instanceList[id];
+EJ_ServoMotor* EJ_ServoMotor_Manager::createRMTServo(ServoDef servo)
+{
+    return EJ_ServoMotor_Manager::createRMTServo(servo.pin, servo.id, 544, 2400, servo.calibration, servo.calibrationSize);
+}
+
+EJ_ServoMotor* EJ_ServoMotor_Manager::createRMTServo(uint8_t pin, uint8_t id, int min, int max, const ServoCalPoint *calibration, uint8_t calibrationSize)
+{
+    if (contains(id)) {
+        return &at(id);
+    }
+    EJ_ServoMotor *instance = create(id, pin, min, max, calibration, calibrationSize, EJ_ServoMotor::BACKEND_RMT);
+    if (instance != NULL && !instance->_rmt.isAttached()) {
+        /*
+        ERRORLOG
+            内容：RMTチャンネルの割り当てに失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        destroy(id);
+        return NULL;
+    }
+    return instance;
 }
 
 EJ_ServoMotor* EJ_ServoMotor_Manager::getServo(ServoDef servo)
@@ -181,15 +684,15 @@ EJ_ServoMotor* EJ_ServoMotor_Manager::getServo(ServoDef servo)
         ERROLOG
             内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INVALID_ID);
         return NULL;
     }
-    if (instance->_pin != servo.pin) {
+    if (instance->_pin != servo.pin || instance->_backend == EJ_ServoMotor::BACKEND_PCA9685) {
         /*
         ERROLOG
             内容：指定されたidが指すインスタンスと、確保済みの同じidのインスタンスが一致しない
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_INSTANCE_MISMATCH);
         return NULL;
     }
     return instance;
@@ -197,30 +700,39 @@ EJ_ServoMotor* EJ_ServoMotor_Manager::getServo(ServoDef servo)
 
 EJ_ServoMotor* EJ_ServoMotor_Manager::getServo(uint8_t id)
 {
-    EJ_ServoMotor_Manager *manager = EJ_ServoMotor_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
-        return NULL;
+    return get(id);
+}
+
+bool EJ_ServoMotor_Manager::writeFrame(const uint8_t *ids, const int32_t *angles, uint8_t count)
+{
+    bool result = true;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!contains(ids[i])) {
+            /*
+            ERRORLOG
+                内容：指定されたidのインスタンスが存在しない
+            */
+            ERRORLOG(EJ_ERROR_INVALID_ID);
+            result = false;
+            continue;
+        }
+        at(ids[i]).writeCentiDegrees(angles[i]);
     }
-    if (id >= manager->_maxInstanceSize) {
-        /*
-        ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
-        */
-        ERRORLOG();
-        return NULL;
-    } 
-    if (manager->_instanceList[id] == NULL) {
-        /*
-        ERRORLOG
-            内容：指定されたidのインスタンスが存在しない
-        */
-        ERRORLOG();
-        return NULL;
+    if (!EJ_PCA9685_Manager::flush()) {
+        result = false;
+    }
+    return result;
+}
+
+void EJ_ServoMotor_Manager::update()
+{
+    uint32_t now = millis();
+    for (size_t i = 0; i < EJ_SERVOMOTOR_MAX_INSTANCES; i++) {
+        if (contains(i)) {
+            EJ_ServoMotor &servo = at(i);
+            servo.updateMotion(now);
+            servo.updateEstimate(now);
+        }
     }
-    return manager->_instanceList[id];
+    EJ_PCA9685_Manager::flush();
 }
@@ -0,0 +1,176 @@
+#include "EJ_ServoRMT.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* static member */
+const char* EJ_ServoRMT::_classname = "EJ_ServoRMT";
+uint8_t EJ_ServoRMT::_allocated = 0;
+uint32_t EJ_ServoRMT::_epoch = 0;
+
+#ifdef ARDUINO_ARCH_ESP32
+/* APBクロック (80MHz) を80分周して1tick = 1usにする */
+static const uint8_t CLOCK_DIVIDER = 80;
+
+/* 1フレーム分のアイテム (High: us, Low: 残り) を作る */
+static inline rmt_item32_t makeFrame(uint16_t us)
+{
+    rmt_item32_t item;
+    item.level0 = 1;
+    item.duration0 = us;
+    item.level1 = 0;
+    item.duration1 = EJ_SERVO_RMT_PERIOD - us;
+    return item;
+}
+#endif
+
+/* static private method */
+#ifdef ARDUINO_ARCH_ESP32
+void EJ_ServoRMT::onStart(void *arg)
+{
+    rmt_tx_start((rmt_channel_t)(intptr_t)arg, true);
+}
+#endif
+
+/* public method */
+EJ_ServoRMT::EJ_ServoRMT()
+:   _channel(-1)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    _start = NULL;
+#endif
+}
+
+EJ_ServoRMT::~EJ_ServoRMT()
+{
+    detach();
+}
+
+bool EJ_ServoRMT::attach(uint8_t pin, uint16_t us)
+{
+    if (_channel >= 0) {
+        return true;
+    }
+#ifdef ARDUINO_ARCH_ESP32
+    int8_t channel = EJ_Peripheral::allocate(EJ_PERIPHERAL_RMT);
+    if (channel < 0) {
+        /*
+        ERRORLOG
+            内容：空いているRMTチャンネルがない
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return false;
+    }
+
+    rmt_config_t config = {};
+    config.rmt_mode = RMT_MODE_TX;
+    config.channel = (rmt_channel_t)channel;
+    config.gpio_num = (gpio_num_t)pin;
+    config.clk_div = CLOCK_DIVIDER;
+    config.mem_block_num = 1;
+    config.tx_config.loop_en = true;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+    config.tx_config.carrier_en = false;
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(config.channel, 0, 0) != ESP_OK) {
+        /*
+        ERRORLOG
+            内容：RMTチャンネルの設定に失敗した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        EJ_Peripheral::release(EJ_PERIPHERAL_RMT, channel);
+        return false;
+    }
+    /* 2つ目のアイテムは終端 (duration0 = 0) */
+    rmt_item32_t items[2];
+    items[0] = makeFrame(constrain(us, 1, EJ_SERVO_RMT_PERIOD - 1));
+    items[1].val = 0;
+    rmt_fill_tx_items(config.channel, items, 2, 0);
+
+    /* 最初のチャンネルの開始時刻から channel * EJ_SERVO_RMT_SLOT だけずれた位相で開始する */
+    uint32_t now = micros();
+    if (_allocated == 0) {
+        _epoch = now - (uint32_t)channel * EJ_SERVO_RMT_SLOT;
+    }
+    uint32_t phase = (now - _epoch) % EJ_SERVO_RMT_PERIOD;
+    uint32_t slot = ((uint32_t)channel * EJ_SERVO_RMT_SLOT) % EJ_SERVO_RMT_PERIOD;
+    uint32_t wait = (slot + EJ_SERVO_RMT_PERIOD - phase) % EJ_SERVO_RMT_PERIOD;
+
+    /* 位相が合うまで待たず、ワンショットタイマーで開始させる */
+    esp_timer_create_args_t args = {};
+    args.callback = &EJ_ServoRMT::onStart;
+    args.arg = (void *)(intptr_t)channel;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "ej_servo_rmt";
+    if (wait == 0 || esp_timer_create(&args, &_start) != ESP_OK) {
+        _start = NULL;
+        rmt_tx_start(config.channel, true);
+    } else if (esp_timer_start_once(_start, wait) != ESP_OK) {
+        /*
+        ERRORLOG
+            内容：出力開始のタイマーの開始に失敗したため、位相をずらさずに開始した
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        esp_timer_delete(_start);
+        _start = NULL;
+        rmt_tx_start(config.channel, true);
+    }
+
+    _allocated |= (uint8_t)(1U << channel);
+    _channel = channel;
+    return true;
+#else
+    (void)pin;
+    (void)us;
+    /*
+    ERRORLOG
+        内容：RMTに対応していないプラットフォーム
+    */
+    ERRORLOG(EJ_ERROR_UNSUPPORTED);
+    return false;
+#endif
+}
+
+void EJ_ServoRMT::detach()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_channel < 0) {
+        return;
+    }
+    if (_start != NULL) {
+        /* 出力開始前に解放された場合はタイマーを止める */
+        esp_timer_stop(_start);
+        esp_timer_delete(_start);
+        _start = NULL;
+    }
+    rmt_tx_stop((rmt_channel_t)_channel);
+    rmt_driver_uninstall((rmt_channel_t)_channel);
+    _allocated &= (uint8_t)~(1U << _channel);
+    EJ_Peripheral::release(EJ_PERIPHERAL_RMT, _channel);
+    _channel = -1;
+#endif
+}
+
+bool EJ_ServoRMT::isAttached()
+{
+    return _channel >= 0;
+}
+
+void EJ_ServoRMT::write(uint16_t us)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_channel < 0) {
+        return;
+    }
+    rmt_item32_t item = makeFrame(constrain(us, 1, EJ_SERVO_RMT_PERIOD - 1));
+    rmt_fill_tx_items((rmt_channel_t)_channel, &item, 1, 0);
+#else
+    (void)us;
+#endif
+}
+
+int8_t EJ_ServoRMT::getChannel()
+{
+    return _channel;
+}
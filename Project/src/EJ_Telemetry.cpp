@@ -0,0 +1,322 @@
+#include "EJ_Telemetry.h"
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* データのフレームのヘッダ ('D', スキーマID, ブロック番号, レコード数) とCRCの大きさ */
+#define EJ_TELEMETRY_HEADER_SIZE 6
+#define EJ_TELEMETRY_CRC_SIZE 2
+
+/*----------------
+class EJ_Telemetry
+----------------*/
+
+/* static member */
+const char* EJ_Telemetry::_classname = "EJ_Telemetry";
+EJ_Telemetry::Channel EJ_Telemetry::_channels[EJ_TELEMETRY_MAX_CHANNELS];
+uint8_t EJ_Telemetry::_channelCount = 0;
+uint16_t EJ_Telemetry::_recordSize = 0;
+uint16_t EJ_Telemetry::_schemaId = 0;
+Print *EJ_Telemetry::_out = NULL;
+bool EJ_Telemetry::_running = false;
+EJ_Telemetry::Block EJ_Telemetry::_blocks[EJ_TELEMETRY_BLOCKS];
+uint32_t EJ_Telemetry::_head = 0;
+uint32_t EJ_Telemetry::_tail = 0;
+uint16_t EJ_Telemetry::_blockSequence = 0;
+uint32_t EJ_Telemetry::_sentBlocks = 0;
+uint32_t EJ_Telemetry::_samples = 0;
+uint32_t EJ_Telemetry::_dropped = 0;
+uint8_t EJ_Telemetry::_frame[EJ_COBS_MAX_ENCODED(EJ_TELEMETRY_BLOCK_SIZE > EJ_TELEMETRY_SCHEMA_SIZE ? EJ_TELEMETRY_BLOCK_SIZE : EJ_TELEMETRY_SCHEMA_SIZE)];
+uint32_t EJ_Telemetry::_taskInterval = 20;
+void *EJ_Telemetry::_task = NULL;
+
+static const uint8_t TYPE_SIZES[EJ_TELEMETRY_TYPES] = {1, 1, 2, 2, 4, 4, 4};
+
+/* private method */
+void EJ_Telemetry::resetBlock(Block &block)
+{
+    block.data[0] = EJ_TELEMETRY_FRAME_DATA;
+    block.length = EJ_TELEMETRY_HEADER_SIZE;
+    block.count = 0;
+}
+
+size_t EJ_Telemetry::buildSchema(uint8_t *buffer)
+{
+    size_t length = 0;
+    buffer[length++] = EJ_TELEMETRY_FRAME_SCHEMA;
+    buffer[length++] = EJ_TELEMETRY_VERSION;
+    length += 2; /* スキーマID */
+    buffer[length++] = (uint8_t)(_recordSize & 0xFF);
+    buffer[length++] = (uint8_t)(_recordSize >> 8);
+    buffer[length++] = _channelCount;
+    for (uint8_t i = 0; i < _channelCount; i++) {
+        uint8_t nameLength = (uint8_t)strlen(_channels[i].name);
+        buffer[length++] = _channels[i].type;
+        buffer[length++] = nameLength;
+        memcpy(buffer + length, _channels[i].name, nameLength);
+        length += nameLength;
+    }
+    /* スキーマIDはレコード長以降のCRCとし、チャンネルの構成が同じなら同じ値になるようにする */
+    uint16_t id = EJ_Framing::crc16(buffer + 4, length - 4);
+    buffer[2] = (uint8_t)(id & 0xFF);
+    buffer[3] = (uint8_t)(id >> 8);
+    return length;
+}
+
+void EJ_Telemetry::sendBlock(Block &block)
+{
+    uint16_t crc = EJ_Framing::crc16(block.data, block.length);
+    block.data[block.length] = (uint8_t)(crc & 0xFF);
+    block.data[block.length + 1] = (uint8_t)(crc >> 8);
+    size_t length = EJ_Framing::encode(block.data, block.length + EJ_TELEMETRY_CRC_SIZE, _frame);
+    _out->write(_frame, length);
+}
+
+void EJ_Telemetry::sendSchema()
+{
+    uint8_t schema[EJ_TELEMETRY_SCHEMA_SIZE];
+    size_t length = buildSchema(schema);
+    uint16_t crc = EJ_Framing::crc16(schema, length);
+    schema[length++] = (uint8_t)(crc & 0xFF);
+    schema[length++] = (uint8_t)(crc >> 8);
+    _out->write(_frame, EJ_Framing::encode(schema, length, _frame));
+}
+
+void EJ_Telemetry::taskMain(void *parameter)
+{
+    (void)parameter;
+#ifdef ARDUINO_ARCH_ESP32
+    for (;;) {
+        /* ブロックが確定するとsample()から通知される */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(_taskInterval));
+        update();
+    }
+#endif
+}
+
+/* static public method */
+int8_t EJ_Telemetry::addChannel(const char *name, EJ_TelemetryType type, const volatile void *source)
+{
+    if (_running || name == NULL || source == NULL || type >= EJ_TELEMETRY_TYPES
+        || _channelCount >= EJ_TELEMETRY_MAX_CHANNELS) {
+        /*
+        ERRORLOG
+            内容：送信中、引数が不正、またはチャンネルの数がEJ_TELEMETRY_MAX_CHANNELSを超えている
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    Channel &channel = _channels[_channelCount];
+    strncpy(channel.name, name, EJ_TELEMETRY_NAME_LENGTH);
+    channel.name[EJ_TELEMETRY_NAME_LENGTH] = '\0';
+    channel.type = (uint8_t)type;
+    channel.source = source;
+    channel.hook = NULL;
+    channel.context = NULL;
+    return (int8_t)_channelCount++;
+}
+
+int8_t EJ_Telemetry::addChannel(const char *name, EJ_TelemetryHook hook, void *context)
+{
+    if (hook == NULL) {
+        /*
+        ERRORLOG
+            内容：hookがNULL
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return -1;
+    }
+    static const int32_t unused = 0;
+    int8_t index = addChannel(name, EJ_TELEMETRY_INT32, &unused);
+    if (index < 0) {
+        return -1;
+    }
+    _channels[index].source = NULL;
+    _channels[index].hook = hook;
+    _channels[index].context = context;
+    return index;
+}
+
+bool EJ_Telemetry::begin(Print &out)
+{
+    uint16_t recordSize = sizeof(uint32_t);
+    for (uint8_t i = 0; i < _channelCount; i++) {
+        recordSize += TYPE_SIZES[_channels[i].type];
+    }
+    if (_channelCount == 0 || EJ_TELEMETRY_HEADER_SIZE + recordSize + EJ_TELEMETRY_CRC_SIZE > EJ_TELEMETRY_BLOCK_SIZE) {
+        /*
+        ERRORLOG
+            内容：チャンネルがない、または1レコードがEJ_TELEMETRY_BLOCK_SIZEに収まらない
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return false;
+    }
+    _recordSize = recordSize;
+    uint8_t schema[EJ_TELEMETRY_SCHEMA_SIZE];
+    buildSchema(schema);
+    _schemaId = (uint16_t)(schema[2] | (schema[3] << 8));
+    _out = &out;
+    _head = 0;
+    _tail = 0;
+    _blockSequence = 0;
+    _sentBlocks = 0;
+    _samples = 0;
+    _dropped = 0;
+    resetBlock(_blocks[0]);
+    sendSchema();
+    _running = true;
+    return true;
+}
+
+void EJ_Telemetry::end()
+{
+    if (!_running) {
+        return;
+    }
+    stopTask();
+    commit();
+    update();
+    _running = false;
+}
+
+void EJ_Telemetry::sample()
+{
+    if (!_running) {
+        return;
+    }
+    Block &block = _blocks[_head % EJ_TELEMETRY_BLOCKS];
+    uint8_t *record = block.data + block.length;
+    uint32_t timestamp = micros();
+    memcpy(record, &timestamp, sizeof(timestamp));
+    record += sizeof(timestamp);
+    /* ESP32もホストもリトルエンディアンのため、値はそのままコピーする */
+    for (uint8_t i = 0; i < _channelCount; i++) {
+        const Channel &channel = _channels[i];
+        if (channel.hook != NULL) {
+            int32_t value = channel.hook(channel.context);
+            memcpy(record, &value, sizeof(value));
+            record += sizeof(value);
+        } else {
+            uint8_t size = TYPE_SIZES[channel.type];
+            memcpy(record, (const void *)channel.source, size);
+            record += size;
+        }
+    }
+    block.length += _recordSize;
+    block.count++;
+    _samples++;
+    if (block.length + _recordSize + EJ_TELEMETRY_CRC_SIZE > EJ_TELEMETRY_BLOCK_SIZE || block.count == 0xFF) {
+        commit();
+    }
+}
+
+void EJ_Telemetry::commit()
+{
+    uint32_t head = _head;
+    Block &block = _blocks[head % EJ_TELEMETRY_BLOCKS];
+    if (!_running || block.count == 0) {
+        return;
+    }
+    uint16_t sequence = _blockSequence++;
+    block.data[1] = (uint8_t)(_schemaId & 0xFF);
+    block.data[2] = (uint8_t)(_schemaId >> 8);
+    block.data[3] = (uint8_t)(sequence & 0xFF);
+    block.data[4] = (uint8_t)(sequence >> 8);
+    block.data[5] = block.count;
+    /* 追記中のブロックも1つ使うため、送信待ちにできるのはEJ_TELEMETRY_BLOCKS - 1個まで */
+    if (head + 1 - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) >= EJ_TELEMETRY_BLOCKS) {
+        /* 送信が追いついていないため、このブロックを捨てて同じ領域に追記し直す (受信側はブロック番号の欠番で検出する) */
+        __atomic_fetch_add(&_dropped, block.count, __ATOMIC_RELAXED);
+        resetBlock(block);
+        return;
+    }
+    resetBlock(_blocks[(head + 1) % EJ_TELEMETRY_BLOCKS]);
+    __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        xTaskNotifyGive((TaskHandle_t)_task);
+    }
+#endif
+}
+
+size_t EJ_Telemetry::update()
+{
+    if (_out == NULL) {
+        return 0;
+    }
+    size_t sent = 0;
+    uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+    uint32_t tail = _tail;
+    while (tail != head) {
+        if (_sentBlocks % EJ_TELEMETRY_SCHEMA_INTERVAL == EJ_TELEMETRY_SCHEMA_INTERVAL - 1) {
+            sendSchema();
+        }
+        sendBlock(_blocks[tail % EJ_TELEMETRY_BLOCKS]);
+        _sentBlocks++;
+        tail++;
+        __atomic_store_n(&_tail, tail, __ATOMIC_RELEASE);
+        sent++;
+    }
+    return sent;
+}
+
+bool EJ_Telemetry::startTask(uint32_t interval, uint8_t priority, uint8_t core)
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        return false;
+    }
+    _taskInterval = interval > 0 ? interval : 1;
+    TaskHandle_t task = NULL;
+    if (xTaskCreatePinnedToCore(taskMain, "EJ_Telemetry", 3072, NULL, priority, &task, core) != pdPASS) {
+        /*
+        ERRORLOG
+            内容：タスクの生成に失敗した
+        */
+        ERRORLOG(EJ_ERROR_NO_RESOURCE);
+        return false;
+    }
+    _task = task;
+    return true;
+#else
+    (void)interval;
+    (void)priority;
+    (void)core;
+    /*
+    ERRORLOG
+        内容：タスクに対応していないプラットフォーム (update()を使う)
+    */
+    ERRORLOG(EJ_ERROR_UNSUPPORTED);
+    return false;
+#endif
+}
+
+void EJ_Telemetry::stopTask()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (_task != NULL) {
+        vTaskDelete((TaskHandle_t)_task);
+        _task = NULL;
+    }
+#endif
+}
+
+uint16_t EJ_Telemetry::getRecordSize()
+{
+    return _recordSize;
+}
+
+uint32_t EJ_Telemetry::getSampleCount()
+{
+    return _samples;
+}
+
+uint32_t EJ_Telemetry::getDroppedCount()
+{
+    return __atomic_load_n(&_dropped, __ATOMIC_RELAXED);
+}
+
+uint8_t EJ_Telemetry::getTypeSize(uint8_t type)
+{
+    return type < EJ_TELEMETRY_TYPES ? TYPE_SIZES[type] : 0;
+}
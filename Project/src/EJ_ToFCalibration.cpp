@@ -0,0 +1,205 @@
+#include "EJ_ToFCalibration.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*--------------------------
+class EJ_ToFCalibrationStore
+--------------------------*/
+
+/* static member */
+const char* EJ_ToFCalibrationStore::_classname = "EJ_ToFCalibrationStore";
+
+/* public method */
+bool EJ_ToFCalibrationStore::load(uint32_t key, ToFCalibration &calibration)
+{
+    if (!read(key, calibration)) {
+        return false;
+    }
+    if (calibration.version != EJ_TOF_CALIBRATION_VERSION || calibration.key != key || calibration.crc != calcCrc(calibration)) {
+        /*
+        ERRORLOG
+            内容：キャッシュのバージョン、キー、CRCのいずれかが一致しない (古いキャッシュ)
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    return true;
+}
+
+bool EJ_ToFCalibrationStore::save(const ToFCalibration &calibration)
+{
+    ToFCalibration data = calibration;
+    data.version = EJ_TOF_CALIBRATION_VERSION;
+    data.reserved = 0;
+    data.crc = calcCrc(data);
+    if (!write(data)) {
+        /*
+        ERRORLOG
+            内容：キャリブレーションデータの書き込みに失敗した
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    return true;
+}
+
+/* static public method */
+uint32_t EJ_ToFCalibrationStore::makeKey(uint32_t uniqueIdUpper, uint32_t uniqueIdLower)
+{
+    uint32_t words[2] = {uniqueIdUpper, uniqueIdLower};
+    uint32_t hash = 0x811C9DC5;
+    for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t shift = 0; shift < 32; shift += 8) {
+            hash ^= (words[i] >> shift) & 0xFF;
+            hash *= 0x01000193;
+        }
+    }
+    /* 0は固有IDを読み出せなかったことを表すため使わない */
+    return (hash != 0) ? hash : 1;
+}
+
+uint16_t EJ_ToFCalibrationStore::calcCrc(const ToFCalibration &calibration)
+{
+    const uint8_t *data = (const uint8_t *)&calibration.key;
+    size_t size = sizeof(ToFCalibration) - offsetof(ToFCalibration, key);
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+/*-----------------------------
+class EJ_ToFCalibrationNVSStore
+-----------------------------*/
+
+/* static member */
+const char* EJ_ToFCalibrationNVSStore::_classname = "EJ_ToFCalibrationNVSStore";
+
+/* public method */
+EJ_ToFCalibrationNVSStore::EJ_ToFCalibrationNVSStore(const char *name)
+:   _name(name)
+{}
+
+EJ_ToFCalibrationNVSStore::~EJ_ToFCalibrationNVSStore()
+{}
+
+bool EJ_ToFCalibrationNVSStore::erase(uint32_t key)
+{
+    char name[12];
+    snprintf(name, sizeof(name), "c%08lx", (unsigned long)key);
+    Preferences preferences;
+    if (!preferences.begin(_name, false)) {
+        /*
+        ERRORLOG
+            内容：NVSの名前空間を開けなかった
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    bool result = preferences.remove(name);
+    preferences.end();
+    return result;
+}
+
+/* protected method */
+bool EJ_ToFCalibrationNVSStore::read(uint32_t key, ToFCalibration &calibration)
+{
+    char name[12];
+    snprintf(name, sizeof(name), "c%08lx", (unsigned long)key);
+    Preferences preferences;
+    if (!preferences.begin(_name, true)) {
+        return false;
+    }
+    size_t size = 0;
+    if (preferences.getBytesLength(name) == sizeof(ToFCalibration)) {
+        size = preferences.getBytes(name, &calibration, sizeof(ToFCalibration));
+    }
+    preferences.end();
+    return size == sizeof(ToFCalibration);
+}
+
+bool EJ_ToFCalibrationNVSStore::write(const ToFCalibration &calibration)
+{
+    char name[12];
+    snprintf(name, sizeof(name), "c%08lx", (unsigned long)calibration.key);
+    Preferences preferences;
+    if (!preferences.begin(_name, false)) {
+        /*
+        ERRORLOG
+            内容：NVSの名前空間を開けなかった
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    size_t size = preferences.putBytes(name, &calibration, sizeof(ToFCalibration));
+    preferences.end();
+    return size == sizeof(ToFCalibration);
+}
+#endif
+
+/*------------------------------
+class EJ_ToFCalibrationFileStore
+------------------------------*/
+
+/* static member */
+const char* EJ_ToFCalibrationFileStore::_classname = "EJ_ToFCalibrationFileStore";
+
+/* public method */
+EJ_ToFCalibrationFileStore::EJ_ToFCalibrationFileStore(const char *directory)
+:   _directory(directory)
+{}
+
+EJ_ToFCalibrationFileStore::~EJ_ToFCalibrationFileStore()
+{}
+
+bool EJ_ToFCalibrationFileStore::erase(uint32_t key)
+{
+    char path[128];
+    makePath(key, path, sizeof(path));
+    return remove(path) == 0;
+}
+
+/* protected method */
+bool EJ_ToFCalibrationFileStore::read(uint32_t key, ToFCalibration &calibration)
+{
+    char path[128];
+    makePath(key, path, sizeof(path));
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    size_t count = fread(&calibration, sizeof(ToFCalibration), 1, fp);
+    fclose(fp);
+    return count == 1;
+}
+
+bool EJ_ToFCalibrationFileStore::write(const ToFCalibration &calibration)
+{
+    char path[128];
+    makePath(calibration.key, path, sizeof(path));
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        /*
+        ERRORLOG
+            内容：ファイルを開けなかった
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return false;
+    }
+    size_t count = fwrite(&calibration, sizeof(ToFCalibration), 1, fp);
+    fclose(fp);
+    return count == 1;
+}
+
+/* private method */
+void EJ_ToFCalibrationFileStore::makePath(uint32_t key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/tof_%08lx.cal", _directory, (unsigned long)key);
+}
@@ -0,0 +1,183 @@
+#include "EJ_ToFFilter.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* 信頼度の算出に用いるばらつきの基準値 (単位: mm)。四分位範囲がこの値のとき信頼度は半分になる */
+static const uint16_t JITTER_SCALE = 10;
+
+/*----------------
+class EJ_ToFFilter
+----------------*/
+
+/* static member */
+const char* EJ_ToFFilter::_classname = "EJ_ToFFilter";
+
+/* public method */
+EJ_ToFFilter::EJ_ToFFilter(uint8_t window)
+:   _window(1),
+    _validMin(1),
+    _validMax(8189),
+    _trackerEnabled(false),
+    _alpha(0.0f),
+    _beta(0.0f)
+{
+    setWindow(window);
+}
+
+EJ_ToFFilter::~EJ_ToFFilter()
+{}
+
+void EJ_ToFFilter::setWindow(uint8_t window)
+{
+    if (window < 1 || EJ_TOF_FILTER_MAX_WINDOW < window) {
+        /*
+        ERRORLOG
+            内容：無効なウィンドウ長が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        window = constrain(window, 1, EJ_TOF_FILTER_MAX_WINDOW);
+    }
+    _window = window;
+    reset();
+}
+
+void EJ_ToFFilter::setValidRange(uint16_t min, uint16_t max)
+{
+    _validMin = min;
+    _validMax = max;
+}
+
+void EJ_ToFFilter::enableTracker(float alpha, float beta)
+{
+    _alpha = constrain(alpha, 0.0f, 1.0f);
+    _beta = constrain(beta, 0.0f, 1.0f);
+    _trackerEnabled = true;
+    _position = _median;
+    _rate = 0.0f;
+}
+
+void EJ_ToFFilter::disableTracker()
+{
+    _trackerEnabled = false;
+}
+
+void EJ_ToFFilter::reset()
+{
+    _count = 0;
+    _head = 0;
+    _history = 0;
+    _median = 0;
+    _lastTimestamp = 0;
+    _position = 0.0f;
+    _rate = 0.0f;
+}
+
+bool EJ_ToFFilter::push(uint16_t range, uint32_t timestamp, bool deviceValid)
+{
+    _history <<= 1;
+    if (!deviceValid || range < _validMin || _validMax < range) {
+        return false;
+    }
+    _history |= 1;
+    bool first = (_count == 0);
+
+    /* ウィンドウが満杯なら最も古いサンプルをソート済み配列から削除する */
+    if (_count == _window) {
+        uint8_t index = lowerBound(_ring[_head]);
+        memmove(&_sorted[index], &_sorted[index + 1], (_count - index - 1) * sizeof(uint16_t));
+        _count--;
+    }
+    uint8_t index = lowerBound(range);
+    memmove(&_sorted[index + 1], &_sorted[index], (_count - index) * sizeof(uint16_t));
+    _sorted[index] = range;
+    _count++;
+    _ring[_head] = range;
+    _head = (_head + 1) % _window;
+
+    uint16_t previous = _median;
+    if (_count % 2 == 1) {
+        _median = _sorted[_count / 2];
+    } else {
+        _median = (_sorted[_count / 2 - 1] + _sorted[_count / 2]) / 2;
+    }
+
+    float dt = (timestamp - _lastTimestamp) / 1000.0f;
+    _lastTimestamp = timestamp;
+    if (first) {
+        _position = _median;
+        _rate = 0.0f;
+        return true;
+    }
+    if (!_trackerEnabled) {
+        /* 同じ時刻のサンプルでも位置は中央値に合わせ、変化率だけを更新しない */
+        _position = _median;
+        if (dt > 0.0f) {
+            _rate = ((float)_median - previous) / dt;
+        }
+        return true;
+    }
+    if (dt <= 0.0f) {
+        return true;
+    }
+
+    float predicted = _position + _rate * dt;
+    float residual = _median - predicted;
+    _position = predicted + _alpha * residual;
+    _rate += _beta * residual / dt;
+    return true;
+}
+
+uint16_t EJ_ToFFilter::getRange()
+{
+    if (_count == 0) {
+        return 0;
+    }
+    if (_position < 0.0f) {
+        return 0;
+    }
+    return (uint16_t)(_position + 0.5f);
+}
+
+uint16_t EJ_ToFFilter::getMedian()
+{
+    return _median;
+}
+
+float EJ_ToFFilter::getRate()
+{
+    return _rate;
+}
+
+uint8_t EJ_ToFFilter::getConfidence()
+{
+    if (_count == 0) {
+        return 0;
+    }
+    uint32_t mask = (_window >= 32) ? 0xFFFFFFFF : ((1UL << _window) - 1);
+    uint8_t valid = __builtin_popcount(_history & mask);
+    uint16_t spread = _sorted[(_count * 3) / 4] - _sorted[_count / 4];
+    return (uint8_t)((100UL * valid * JITTER_SCALE) / ((uint32_t)_window * (JITTER_SCALE + spread)));
+}
+
+bool EJ_ToFFilter::isValid()
+{
+    return _count > 0;
+}
+
+/* private method */
+uint8_t EJ_ToFFilter::lowerBound(uint16_t value)
+{
+    uint8_t low = 0;
+    uint8_t high = _count;
+    while (low < high) {
+        uint8_t mid = (low + high) / 2;
+        if (_sorted[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,217 @@
+#include "EJ_ToFScanner.h"
+
+#include "EJ_ErrorLog.h"
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/*-----------------
+class EJ_ToFScanner
+-----------------*/
+
+/* static member */
+const char* EJ_ToFScanner::_classname = "EJ_ToFScanner";
+
+/* public method */
+EJ_ToFScanner::EJ_ToFScanner(EJ_ServoMotor *servo, EJ_ToFUnit *tof, int16_t minAngle, int16_t maxAngle, uint8_t step)
+:   _servo(servo),
+    _tof(tof),
+    _minAngle(minAngle),
+    _step(step),
+    _pointCount(0),
+    _back(0),
+    _published(false),
+    _available(false),
+    _sweepCount(0),
+    _settleBase(10),
+    _settlePerDegree(2.0f),
+    _measurementPeriod(33),
+    _running(false),
+    _index(0),
+    _direction(1),
+    _settledAt(0),
+    _ranging(false),
+    _rangingStart(0),
+    _resultPending(false),
+    _resultIndex(0),
+    _resultStart(0),
+    _resultEndsSweep(false),
+    _sweepStart(0),
+    _pointsPerSecond(0.0f)
+{
+    if (_servo == NULL || _tof == NULL || _step == 0 || maxAngle < minAngle) {
+        /*
+        ERRORLOG
+            内容：無効な引数が指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
+    }
+    if ((maxAngle - minAngle) / _step + 1 > EJ_TOFSCANNER_MAX_POINTS) {
+        /*
+        ERRORLOG
+            内容：掃引の点数がEJ_TOFSCANNER_MAX_POINTSを超える範囲とステップが指定された
+        */
+        ERRORLOG(EJ_ERROR_INVALID_ARGUMENT);
+        return;
+    }
+    _pointCount = (maxAngle - minAngle) / _step + 1;
+    for (uint8_t b = 0; b < 2; b++) {
+        for (uint16_t i = 0; i < _pointCount; i++) {
+            _buffers[b][i].angle = angleOf(i);
+            _buffers[b][i].range = 65535;
+            _buffers[b][i].rangeStatus = 0;
+            _buffers[b][i].timestamp = 0;
+        }
+    }
+    _measurementPeriod = (_tof->getMeasurementTimingBudget() + 999) / 1000;
+}
+
+EJ_ToFScanner::~EJ_ToFScanner()
+{}
+
+void EJ_ToFScanner::setSettleModel(uint16_t baseTime, float timePerDegree)
+{
+    _settleBase = baseTime;
+    _settlePerDegree = timePerDegree;
+}
+
+void EJ_ToFScanner::setMeasurementPeriod(uint16_t period)
+{
+    _measurementPeriod = period;
+}
+
+void EJ_ToFScanner::start()
+{
+    if (_pointCount == 0) {
+        /*
+        ERRORLOG
+            内容：無効な引数で生成されたため掃引できない
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return;
+    }
+    _index = 0;
+    _direction = 1;
+    _ranging = false;
+    _resultPending = false;
+    _running = true;
+    _sweepStart = millis();
+    command(_index);
+}
+
+void EJ_ToFScanner::stop()
+{
+    _running = false;
+}
+
+bool EJ_ToFScanner::update()
+{
+    if (!_running) {
+        return false;
+    }
+    /* 測距時間が終われば、結果の読み出しを待たずに次の角度を指令する */
+    if (_ranging && (int32_t)(millis() - _rangingStart) >= (int32_t)_measurementPeriod) {
+        finishRanging();
+    }
+    bool completed = false;
+    if (_tof->poll()) {
+        const ToFMeasurement &measurement = _tof->getMeasurement();
+        /* 測距時間より早く結果が得られた場合もそこで測距時間が終わったとみなす */
+        if (_ranging && (int32_t)(measurement.timestamp - _rangingStart) >= 0) {
+            finishRanging();
+        }
+        /* 整定後に始め直した測距の結果だけを採用し、整定前や移動中の測距の結果は捨てる */
+        if (_resultPending && (int32_t)(measurement.timestamp - _resultStart) >= 0) {
+            _resultPending = false;
+            completed = store(measurement);
+        }
+    }
+    /* 整定したら測距を始め直す。前の点の結果を読み出すまでは始め直さない */
+    if (!_ranging && !_resultPending && (int32_t)(millis() - _settledAt) >= 0 && _tof->restartRanging()) {
+        _ranging = true;
+        _rangingStart = millis();
+    }
+    return completed;
+}
+
+bool EJ_ToFScanner::available()
+{
+    return _available;
+}
+
+const ToFScanPoint *EJ_ToFScanner::getScan(uint16_t &count)
+{
+    if (!_published) {
+        count = 0;
+        return NULL;
+    }
+    _available = false;
+    count = _pointCount;
+    return _buffers[_back ^ 1];
+}
+
+uint32_t EJ_ToFScanner::getSweepCount()
+{
+    return _sweepCount;
+}
+
+float EJ_ToFScanner::getPointsPerSecond()
+{
+    return _pointsPerSecond;
+}
+
+/* private method */
+void EJ_ToFScanner::command(uint16_t index)
+{
+    int16_t angle = angleOf(index);
+    int16_t delta = abs(angle - _servo->read());
+    _servo->write(angle);
+    if (_servo->hasKinematics()) {
+        _settledAt = _servo->getArrivalTime();
+    } else {
+        _settledAt = millis() + _settleBase + (uint32_t)(delta * _settlePerDegree);
+    }
+}
+
+int16_t EJ_ToFScanner::angleOf(uint16_t index)
+{
+    return _minAngle + (int16_t)index * _step;
+}
+
+void EJ_ToFScanner::finishRanging()
+{
+    _ranging = false;
+    _resultPending = true;
+    _resultIndex = _index;
+    _resultStart = _rangingStart;
+    _resultEndsSweep = (_direction > 0 && _index == _pointCount - 1) || (_direction < 0 && _index == 0);
+    if (_resultEndsSweep) {
+        /* 折り返し時は同じ角度を次の掃引の最初の点として測り直す */
+        _direction = -_direction;
+    } else {
+        _index += _direction;
+    }
+    command(_index);
+}
+
+bool EJ_ToFScanner::store(const ToFMeasurement &measurement)
+{
+    ToFScanPoint &point = _buffers[_back][_resultIndex];
+    point.range = measurement.range;
+    point.rangeStatus = measurement.rangeStatus;
+    point.timestamp = measurement.timestamp;
+    if (!_resultEndsSweep) {
+        return false;
+    }
+    /* 裏バッファを公開する */
+    uint32_t now = millis();
+    if (now != _sweepStart) {
+        _pointsPerSecond = _pointCount * 1000.0f / (now - _sweepStart);
+    }
+    _sweepStart = now;
+    _back ^= 1;
+    _published = true;
+    _available = true;
+    _sweepCount++;
+    return true;
+}
@@ -1,18 +1,10 @@
 #include "EJ_ToFUnit.h"
 
-#ifdef M5CORE2
-#include <M5Core2.h>
-#elif M5STICKCPLUS
-#include <M5StickCPlus.h>
-#else
-#undef M5_DEBUG
-#endif
+#include "EJ_ErrorLog.h"
+#include "EJ_Trace.h"
+#include "EJ_SensorLog.h"
 
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
-#else
-#define ERRORLOG() ((void)0)
-#endif
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
 
 /*--------------
 class EJ_ToFUnit
@@ -21,101 +13,508 @@ class EJ_ToFUnit
 /* static member */
 const char* EJ_ToFUnit::_classname = "EJ_ToFUnit";
 
+/* VL53L0X::init()の初期化シーケンスで用いるレジスタ */
+static const uint8_t REG_VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV = 0x89;
+static const uint8_t REG_MSRC_CONFIG_CONTROL = 0x60;
+static const uint8_t REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT = 0x44;
+static const uint8_t REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI = 0x71;
+static const uint8_t REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0 = 0xB0;
+static const uint8_t REG_GLOBAL_CONFIG_REF_EN_START_SELECT = 0xB6;
+static const uint8_t REG_DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD = 0x4E;
+static const uint8_t REG_DYNAMIC_SPAD_REF_EN_START_OFFSET = 0x4F;
+static const uint8_t REG_SYSTEM_INTERRUPT_CONFIG_GPIO = 0x0A;
+static const uint8_t REG_GPIO_HV_MUX_ACTIVE_HIGH = 0x84;
+static const uint8_t REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM = 0x28;
+static const uint8_t REG_VHV_SETTINGS = 0xCB;
+static const uint8_t REG_PHASE_CAL = 0xEE;
+
+/* NVMの固有ID (部品ID) のアドレスと、NVMの読み出しを待つ時間 (単位: ms) */
+static const uint8_t REG_NVM_UNIQUE_ID_UPPER = 0x7B;
+static const uint8_t REG_NVM_UNIQUE_ID_LOWER = 0x7C;
+static const uint32_t NVM_TIMEOUT = 50;
+
+/* VL53L0X_load_tuning_settings()相当のレジスタ書き込み列 ({レジスタ, 値}の組) */
+static const uint8_t TUNING_SETTINGS[][2] = {
+    {0xFF, 0x01}, {0x00, 0x00},
+    {0xFF, 0x00}, {0x09, 0x00}, {0x10, 0x00}, {0x11, 0x00},
+    {0x24, 0x01}, {0x25, 0xFF}, {0x75, 0x00},
+    {0xFF, 0x01}, {0x4E, 0x2C}, {0x48, 0x00}, {0x30, 0x20},
+    {0xFF, 0x00}, {0x30, 0x09}, {0x54, 0x00}, {0x31, 0x04}, {0x32, 0x03}, {0x40, 0x83},
+    {0x46, 0x25}, {0x60, 0x00}, {0x27, 0x00}, {0x50, 0x06}, {0x51, 0x00}, {0x52, 0x96},
+    {0x56, 0x08}, {0x57, 0x30}, {0x61, 0x00}, {0x62, 0x00}, {0x64, 0x00}, {0x65, 0x00},
+    {0x66, 0xA0},
+    {0xFF, 0x01}, {0x22, 0x32}, {0x47, 0x14}, {0x49, 0xFF}, {0x4A, 0x00},
+    {0xFF, 0x00}, {0x7A, 0x0A}, {0x7B, 0x00}, {0x78, 0x21},
+    {0xFF, 0x01}, {0x23, 0x34}, {0x42, 0x00}, {0x44, 0xFF}, {0x45, 0x26}, {0x46, 0x05},
+    {0x40, 0x40}, {0x0E, 0x06}, {0x20, 0x1A}, {0x43, 0x40},
+    {0xFF, 0x00}, {0x34, 0x03}, {0x35, 0x44},
+    {0xFF, 0x01}, {0x31, 0x04}, {0x4B, 0x09}, {0x4C, 0x05}, {0x4D, 0x04},
+    {0xFF, 0x00}, {0x44, 0x00}, {0x45, 0x20}, {0x47, 0x08}, {0x48, 0x28}, {0x67, 0x00},
+    {0x70, 0x04}, {0x71, 0x01}, {0x72, 0xFE}, {0x76, 0x00}, {0x77, 0x00},
+    {0xFF, 0x01}, {0x0D, 0x01},
+    {0xFF, 0x00}, {0x80, 0x01}, {0x01, 0xF8},
+    {0xFF, 0x01}, {0x8E, 0x01}, {0x00, 0x01}, {0xFF, 0x00}, {0x80, 0x00},
+};
+
 /* private method */
-EJ_ToFUnit::EJ_ToFUnit(uint8_t address)
-:   _address(address),
+EJ_ToFUnit::EJ_ToFUnit(uint8_t address, EJ_ToFCalibrationStore *store)
+:   VL53L0X(),
+    _id(0),
+    _address(address),
     _error(true),
-    VL53L0X()
+    _state(STATE_WAIT_READY),
+    _waitStart(0),
+    _available(false),
+    _fullyCalibrated(false),
+    _stopVariable(0),
+    _owner(NULL)
 {
-    if (!VL53L0X::init()) {
-        ERRORLOG();
+    memset(&_measurement, 0, sizeof(_measurement));
+    memset(&_calibration, 0, sizeof(_calibration));
+    if (EJ_SensorLog::isReplaying()) {
+        /* 再生中はセンサにアクセスせず、poll()とread()は記録した測距結果を返す */
+        _error = false;
         return;
     }
+    if (!EJ_I2CBus::lock()) {
+        return;
+    }
+    readStopVariable();
+    /* 固有IDをキーにするため、同じidやアドレスでもセンサを交換すればキャッシュは使われない */
+    uint32_t key = (store != NULL) ? readUniqueKey() : 0;
+    ToFCalibration calibration;
+    bool cached = key != 0 && store->load(key, calibration);
+    if (!cached || !initFromCalibration(calibration)) {
+        if (!VL53L0X::init()) {
+            EJ_I2CBus::unlock();
+            /*
+            ERRORLOG
+                内容：センサの初期化に失敗した
+            */
+            ERRORLOG(EJ_ERROR_HARDWARE);
+            return;
+        }
+        _fullyCalibrated = true;
+    }
+    captureCalibration();
+    _calibration.key = key;
     VL53L0X::setAddress(_address);
     VL53L0X::setTimeout(500);
-    VL53L0X::startContinuous(0);
+    startRanging();
+    restartPolling();
+    EJ_I2CBus::unlock();
     _error = false;
 }
 
-/* public method */
-EJ_ToFUnit::~EJ_ToFUnit()
+bool EJ_ToFUnit::initFromCalibration(const ToFCalibration &calibration)
 {
-    VL53L0X::stopContinuous();
+    if (VL53L0X::readReg(IDENTIFICATION_MODEL_ID) != 0xEE) {
+        /*
+        ERRORLOG
+            内容：センサのモデルIDが一致しない
+        */
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        return false;
+    }
+
+    /* VL53L0X_DataInit() */
+    VL53L0X::writeReg(REG_VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV, VL53L0X::readReg(REG_VHV_CONFIG_PAD_SCL_SDA__EXTSUP_HV) | 0x01);
+    VL53L0X::writeReg(0x88, 0x00);
+    VL53L0X::writeReg(REG_MSRC_CONFIG_CONTROL, VL53L0X::readReg(REG_MSRC_CONFIG_CONTROL) | 0x12);
+    /* 0.25MCPS (9.7固定小数点) */
+    VL53L0X::writeReg16Bit(REG_FINAL_RANGE_CONFIG_MIN_COUNT_RATE_RTN_LIMIT, 32);
+    VL53L0X::writeReg(SYSTEM_SEQUENCE_CONFIG, 0xFF);
+
+    /* VL53L0X_set_reference_spads() (SPAD管理の結果をキャッシュから書き戻す) */
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(REG_DYNAMIC_SPAD_REF_EN_START_OFFSET, 0x00);
+    VL53L0X::writeReg(REG_DYNAMIC_SPAD_NUM_REQUESTED_REF_SPAD, 0x2C);
+    VL53L0X::writeReg(0xFF, 0x00);
+    VL53L0X::writeReg(REG_GLOBAL_CONFIG_REF_EN_START_SELECT, 0xB4);
+    VL53L0X::writeMulti(REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0, calibration.refSpadMap, sizeof(calibration.refSpadMap));
+
+    /* VL53L0X_load_tuning_settings() */
+    for (size_t i = 0; i < sizeof(TUNING_SETTINGS) / sizeof(TUNING_SETTINGS[0]); i++) {
+        VL53L0X::writeReg(TUNING_SETTINGS[i][0], TUNING_SETTINGS[i][1]);
+    }
+
+    /* VL53L0X_SetGpioConfig() */
+    VL53L0X::writeReg(REG_SYSTEM_INTERRUPT_CONFIG_GPIO, 0x04);
+    VL53L0X::writeReg(REG_GPIO_HV_MUX_ACTIVE_HIGH, VL53L0X::readReg(REG_GPIO_HV_MUX_ACTIVE_HIGH) & ~0x10);
+    VL53L0X::writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+
+    /* 測定タイミングバジェットの再計算結果を書き戻す */
+    VL53L0X::writeReg16Bit(REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI, calibration.finalRangeTimeout);
+    VL53L0X::writeReg(SYSTEM_SEQUENCE_CONFIG, calibration.sequenceConfig);
+
+    /* VL53L0X_perform_ref_calibration() (リファレンスキャリブレーションの結果をキャッシュから書き戻す) */
+    selectRefCalibrationPage(true);
+    VL53L0X::writeReg(REG_VHV_SETTINGS, calibration.vhvSettings);
+    VL53L0X::writeReg(REG_PHASE_CAL, (VL53L0X::readReg(REG_PHASE_CAL) & 0x80) | calibration.phaseCal);
+    selectRefCalibrationPage(false);
+
+    _calibration = calibration;
+    setRangeOffset(calibration.offset);
+    return true;
 }
 
-uint16_t EJ_ToFUnit::read()
+void EJ_ToFUnit::captureCalibration()
 {
-    return VL53L0X::readRangeContinuousMillimeters();
+    VL53L0X::readMulti(REG_GLOBAL_CONFIG_SPAD_ENABLES_REF_0, _calibration.refSpadMap, sizeof(_calibration.refSpadMap));
+    _calibration.finalRangeTimeout = VL53L0X::readReg16Bit(REG_FINAL_RANGE_CONFIG_TIMEOUT_MACROP_HI);
+    _calibration.sequenceConfig = VL53L0X::readReg(SYSTEM_SEQUENCE_CONFIG);
+    selectRefCalibrationPage(true);
+    _calibration.vhvSettings = VL53L0X::readReg(REG_VHV_SETTINGS);
+    _calibration.phaseCal = VL53L0X::readReg(REG_PHASE_CAL) & 0xEF;
+    selectRefCalibrationPage(false);
+    /* 12bitの2の補数表現 */
+    int16_t offset = VL53L0X::readReg16Bit(REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM) & 0x0FFF;
+    _calibration.offset = (offset > 2047) ? offset - 4096 : offset;
 }
 
-/*--------------
-class EJ_ToFUnit
---------------*/
+void EJ_ToFUnit::selectRefCalibrationPage(bool select)
+{
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, select ? 0x00 : 0x01);
+    VL53L0X::writeReg(0xFF, 0x00);
+}
 
-/* static member */
-EJ_ToFUnit_Manager* EJ_ToFUnit_Manager::_singleton = NULL;
-const char* EJ_ToFUnit_Manager::_classname = "EJ_ToFUnit_Manager";
+uint32_t EJ_ToFUnit::readUniqueKey()
+{
+    /* NVMの読み出しモードに入る */
+    VL53L0X::writeReg(0x80, 0x01);
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, 0x00);
+    VL53L0X::writeReg(0xFF, 0x06);
+    VL53L0X::writeReg(0x83, VL53L0X::readReg(0x83) | 0x04);
+    VL53L0X::writeReg(0xFF, 0x07);
+    VL53L0X::writeReg(0x81, 0x01);
+    VL53L0X::writeReg(0x80, 0x01);
 
-/* private method */
-EJ_ToFUnit_Manager::EJ_ToFUnit_Manager(size_t maxInstanceSize)
-:   _maxInstanceSize(maxInstanceSize),
-    _instanceList(NULL)
-{
-    _instanceList = new EJ_ToFUnit*[_maxInstanceSize];
-    if (_instanceList == NULL) {
-        /* 
-        ERRORLOG 
-            内容: メモリ確保に失敗した
+    uint32_t upper = 0;
+    uint32_t lower = 0;
+    bool result = readNvm(REG_NVM_UNIQUE_ID_UPPER, upper) && readNvm(REG_NVM_UNIQUE_ID_LOWER, lower);
+
+    /* NVMの読み出しモードを抜ける */
+    VL53L0X::writeReg(0x81, 0x00);
+    VL53L0X::writeReg(0xFF, 0x06);
+    VL53L0X::writeReg(0x83, VL53L0X::readReg(0x83) & (uint8_t)~0x04);
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, 0x01);
+    VL53L0X::writeReg(0xFF, 0x00);
+    VL53L0X::writeReg(0x80, 0x00);
+
+    if (!result) {
+        /*
+        ERRORLOG
+            内容：NVMから固有IDを読み出せなかった (キャリブレーションデータのキャッシュを利用しない)
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_TIMEOUT);
+        return 0;
+    }
+    return EJ_ToFCalibrationStore::makeKey(upper, lower);
+}
+
+bool EJ_ToFUnit::readNvm(uint8_t address, uint32_t &value)
+{
+    VL53L0X::writeReg(0x94, address);
+    VL53L0X::writeReg(0x83, 0x00);
+    uint32_t start = millis();
+    while (VL53L0X::readReg(0x83) == 0x00) {
+        if (millis() - start >= NVM_TIMEOUT) {
+            return false;
+        }
+    }
+    VL53L0X::writeReg(0x83, 0x01);
+    value = VL53L0X::readReg32Bit(0x90);
+    return true;
+}
+
+void EJ_ToFUnit::readStopVariable()
+{
+    VL53L0X::writeReg(0x80, 0x01);
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, 0x00);
+    _stopVariable = VL53L0X::readReg(0x91);
+    VL53L0X::writeReg(0x00, 0x01);
+    VL53L0X::writeReg(0xFF, 0x00);
+    VL53L0X::writeReg(0x80, 0x00);
+}
+
+void EJ_ToFUnit::startRanging()
+{
+    VL53L0X::writeReg(0x80, 0x01);
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, 0x00);
+    VL53L0X::writeReg(0x91, _stopVariable);
+    VL53L0X::writeReg(0x00, 0x01);
+    VL53L0X::writeReg(0xFF, 0x00);
+    VL53L0X::writeReg(0x80, 0x00);
+    /* back-to-backモード */
+    VL53L0X::writeReg(SYSRANGE_START, 0x02);
+}
+
+void EJ_ToFUnit::stopRanging()
+{
+    VL53L0X::writeReg(SYSRANGE_START, 0x01);
+    VL53L0X::writeReg(0xFF, 0x01);
+    VL53L0X::writeReg(0x00, 0x00);
+    VL53L0X::writeReg(0x91, 0x00);
+    VL53L0X::writeReg(0x00, 0x01);
+    VL53L0X::writeReg(0xFF, 0x00);
+}
+
+void EJ_ToFUnit::restartPolling()
+{
+    _state = STATE_WAIT_READY;
+    _waitStart = millis();
+}
+
+bool EJ_ToFUnit::step()
+{
+    switch (_state) {
+    case STATE_WAIT_READY:
+        if ((VL53L0X::readReg(RESULT_INTERRUPT_STATUS) & 0x07) != 0) {
+            _state = STATE_READ_RESULT;
+            return false;
+        }
+        if (VL53L0X::getTimeout() > 0 && (millis() - _waitStart) > VL53L0X::getTimeout()) {
+            /*
+            ERRORLOG
+                内容：測距完了待ちがタイムアウトした
+            */
+            ERRORLOG(EJ_ERROR_TIMEOUT);
+            _measurement.range = 65535;
+            _measurement.rangeStatus = 0;
+            _measurement.timestamp = millis();
+            _available = true;
+            _filter.push(_measurement.range, _measurement.timestamp, false);
+            restartPolling();
+            return true;
+        }
+        return false;
+
+    case STATE_READ_RESULT:
+    {
+        /* 結果レジスタブロック: [0]測距ステータス, [2-3]SPAD数, [6-7]信号レート, [8-9]環境光レート, [10-11]距離 (ビッグエンディアン) */
+        uint8_t buf[12];
+        VL53L0X::readMulti(RESULT_RANGE_STATUS, buf, sizeof(buf));
+        _measurement.rangeStatus = (buf[0] & 0x78) >> 3;
+        _measurement.spadCount = ((uint16_t)buf[2] << 8) | buf[3];
+        _measurement.signalRate = ((uint16_t)buf[6] << 8) | buf[7];
+        _measurement.ambientRate = ((uint16_t)buf[8] << 8) | buf[9];
+        _measurement.range = ((uint16_t)buf[10] << 8) | buf[11];
+        _measurement.timestamp = millis();
+        _available = true;
+        _filter.push(_measurement.range, _measurement.timestamp, _measurement.rangeStatus == RANGE_STATUS_VALID);
+        _state = STATE_CLEAR_INTERRUPT;
+        return true;
+    }
+
+    case STATE_CLEAR_INTERRUPT:
+        VL53L0X::writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+        restartPolling();
+        return false;
+    }
+    return false;
+}
+
+bool EJ_ToFUnit::isOwner()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return _owner == NULL || _owner == (void*)xTaskGetCurrentTaskHandle();
+#else
+    return true;
+#endif
+}
+
+void EJ_ToFUnit::replayMeasurement()
+{
+    uint32_t value = (uint32_t)EJ_SensorLog::replay(EJ_SENSORLOG_TOF, _id);
+    _measurement.range = (uint16_t)(value & 0xFFFF);
+    _measurement.rangeStatus = (uint8_t)(value >> 16);
+    _measurement.signalRate = 0;
+    _measurement.ambientRate = 0;
+    _measurement.spadCount = 0;
+    _measurement.timestamp = millis();
+    _available = true;
+    _filter.push(_measurement.range, _measurement.timestamp, _measurement.rangeStatus == RANGE_STATUS_VALID);
+}
+
+/* public method */
+EJ_ToFUnit::~EJ_ToFUnit()
+{
+    if (_error || EJ_SensorLog::isReplaying() || !EJ_I2CBus::lock()) {
         return;
     }
-    for (size_t i = 0; i < _maxInstanceSize; i++) {
-        _instanceList[i] = NULL;
+    stopRanging();
+    EJ_I2CBus::unlock();
+}
+
+uint16_t EJ_ToFUnit::read()
+{
+    EJ_TRACE_SCOPE("EJ_ToFUnit::read");
+    if (EJ_SensorLog::isReplaying()) {
+        replayMeasurement();
+        return getMeasurement().range;
+    }
+    if (!isOwner()) {
+        /*
+        ERRORLOG
+            内容：測距を進めるタスク以外から呼び出された
+        */
+        ERRORLOG(EJ_ERROR_NOT_OWNER);
+        return 65535;
+    }
+    while (!poll()) {}
+    return getMeasurement().range;
+}
+
+bool EJ_ToFUnit::poll()
+{
+    if (EJ_SensorLog::isReplaying()) {
+        if (!EJ_SensorLog::isDue(EJ_SENSORLOG_TOF, _id)) {
+            return false;
+        }
+        replayMeasurement();
+        return true;
+    }
+    if (!isOwner()) {
+        /*
+        ERRORLOG
+            内容：測距を進めるタスク以外から呼び出された
+        */
+        ERRORLOG(EJ_ERROR_NOT_OWNER);
+        return false;
+    }
+    if (!EJ_I2CBus::lock()) {
+        return false;
+    }
+    bool result = step();
+    EJ_I2CBus::unlock();
+    if (result) {
+        EJ_SensorLog::record(EJ_SENSORLOG_TOF, _id, (int32_t)(_measurement.range | ((uint32_t)_measurement.rangeStatus << 16)));
     }
+    return result;
 }
 
-/* static private method */
-EJ_ToFUnit_Manager* EJ_ToFUnit_Manager::getInstance()
+bool EJ_ToFUnit::restartRanging()
 {
-    if (_singleton == NULL) {
+    if (EJ_SensorLog::isReplaying()) {
+        return true;
+    }
+    if (!isOwner()) {
         /*
-        ERROLOG
-            内容：シングルトンがまだ生成されていない
+        ERRORLOG
+            内容：測距を進めるタスク以外から呼び出された
         */
-        ERRORLOG();
-        return NULL;
+        ERRORLOG(EJ_ERROR_NOT_OWNER);
+        return false;
     }
+    if (!EJ_I2CBus::lock()) {
+        return false;
+    }
+    /* 停止前に完了した測距の割り込みも消してから始め直す */
+    stopRanging();
+    VL53L0X::writeReg(SYSTEM_INTERRUPT_CLEAR, 0x01);
+    startRanging();
+    restartPolling();
+    EJ_I2CBus::unlock();
+    return true;
+}
 
-    return _singleton;
+void EJ_ToFUnit::setOwner(void *task)
+{
+    _owner = task;
 }
 
-/* public method */
-EJ_ToFUnit_Manager::~EJ_ToFUnit_Manager()
-{
-    if (_instanceList != NULL) {
-        for (size_t i = 0; i < _maxInstanceSize; i++) {
-            if (_instanceList[i] != NULL) {
-                delete _instanceList[i];
-                _instanceList[i] = NULL;
-            }
-        }
+bool EJ_ToFUnit::available()
+{
+    return _available;
+}
+
+const ToFMeasurement &EJ_ToFUnit::getMeasurement()
+{
+    _available = false;
+    return _measurement;
+}
+
+uint16_t EJ_ToFUnit::getSignalRate()
+{
+    return _measurement.signalRate;
+}
+
+uint16_t EJ_ToFUnit::getAmbientRate()
+{
+    return _measurement.ambientRate;
+}
+
+uint8_t EJ_ToFUnit::getRangeStatus()
+{
+    return _measurement.rangeStatus;
+}
+
+EJ_ToFUnit::State EJ_ToFUnit::getState()
+{
+    return _state;
+}
+
+EJ_ToFFilter &EJ_ToFUnit::getFilter()
+{
+    return _filter;
+}
+
+uint16_t EJ_ToFUnit::getFilteredRange()
+{
+    return _filter.getRange();
+}
+
+void EJ_ToFUnit::setRangeOffset(int16_t offset)
+{
+    offset = constrain(offset, -2048, 2047);
+    if (!EJ_I2CBus::lock()) {
+        return;
     }
+    VL53L0X::writeReg16Bit(REG_ALGO_PART_TO_PART_RANGE_OFFSET_MM, (uint16_t)offset & 0x0FFF);
+    EJ_I2CBus::unlock();
+    _calibration.offset = offset;
 }
 
+int16_t EJ_ToFUnit::getRangeOffset()
+{
+    return _calibration.offset;
+}
+
+const ToFCalibration &EJ_ToFUnit::getCalibration()
+{
+    return _calibration;
+}
+
+bool EJ_ToFUnit::isFullyCalibrated()
+{
+    return _fullyCalibrated;
+}
+
+/*----------------------
+class EJ_ToFUnit_Manager
+----------------------*/
+
+/* static member */
+const char* EJ_ToFUnit_Manager::_classname = "EJ_ToFUnit_Manager";
+template <>
+const char* EJ_Manager<EJ_ToFUnit, EJ_TOFUNIT_MAX_INSTANCES>::_classname = "EJ_ToFUnit_Manager";
+EJ_ToFCalibrationStore* EJ_ToFUnit_Manager::_calibrationStore = NULL;
+
 /* static public method */
 bool EJ_ToFUnit_Manager::configure(size_t maxInstanceSize)
 {
-    if (_singleton == NULL) {
-        _singleton = new EJ_ToFUnit_Manager(maxInstanceSize);
-        if (_singleton == NULL) {
-            /*
-            ERROLOG
-                内容：メモリ確保に失敗した 
-            */
-            ERRORLOG();
-            return false;
-        }
+    if (maxInstanceSize > EJ_TOFUNIT_MAX_INSTANCES) {
+        /*
+        ERRORLOG
+            内容：最大インスタンス数がEJ_TOFUNIT_MAX_INSTANCESを超えている
+        */
+        ERRORLOG(EJ_ERROR_CAPACITY);
+        return false;
     }
     return true;
 }
@@ -127,65 +526,88 @@ EJ_ToFUnit* EJ_ToFUnit_Manager::createToFUnit(ToFUnitDef tof)
 
 EJ_ToFUnit* EJ_ToFUnit_Manager::createToFUnit(uint8_t id, uint8_t address)
 {
-    EJ_ToFUnit_Manager *manager = EJ_ToFUnit_Manager::getInstance();
-    if (manager == NULL) {
-        /*
-        ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
-        */
-        ERRORLOG();
+    if (contains(id)) {
+        return &at(id);
+    }
+    EJ_ToFUnit *instance = create(id, address, _calibrationStore);
+    if (instance == NULL) {
         return NULL;
     }
-    if (id > manager->_maxInstanceSize) {
+    if (instance->_error) {
         /*
         ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
+            内容：インスタンス生成に失敗した
         */
-        ERRORLOG();
+        ERRORLOG(EJ_ERROR_HARDWARE);
+        destroy(id);
         return NULL;
     }
-    if (manager->_instanceList[id] == NULL) {
-        EJ_ToFUnit *instance = new EJ_ToFUnit(address);
-        if (instance == NULL || instance->_error) {
-            /*
-            ERRORLOG
-                内容：インスタンス生成に失敗した
-            */
-            ERRORLOG();
-            return NULL;
+    instance->_id = id;
+    if (_calibrationStore != NULL && instance->_fullyCalibrated && instance->_calibration.key != 0) {
+        _calibrationStore->save(instance->_calibration);
+    }
+    return instance;
+}
+
+EJ_ToFUnit* EJ_ToFUnit_Manager::getToFUnit(uint8_t id)
+{
+    return get(id);
+}
+
+void EJ_ToFUnit_Manager::update()
+{
+    for (size_t i = 0; i < EJ_TOFUNIT_MAX_INSTANCES; i++) {
+        if (contains(i) && at(i).isOwner()) {
+            at(i).poll();
         }
-        manager->_instanceList[id] = instance;
     }
+}
 
-    return manager->_instanceList[id];
+void EJ_ToFUnit_Manager::setCalibrationStore(EJ_ToFCalibrationStore *store)
+{
+    _calibrationStore = store;
 }
 
-EJ_ToFUnit* EJ_ToFUnit_Manager::getToFUnit(uint8_t id)
+bool EJ_ToFUnit_Manager::saveCalibration(uint8_t id)
 {
-    EJ_ToFUnit_Manager *manager = EJ_ToFUnit_Manager::getInstance();
-    if (manager == NULL) {
+    EJ_ToFUnit *instance = EJ_ToFUnit_Manager::getToFUnit(id);
+    if (instance == NULL) {
         /*
         ERRORLOG
-            内容：マネージャクラスのインスタンス取得に失敗した
+            内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
-        return NULL;
+        ERRORLOG(EJ_ERROR_INVALID_ID);
+        return false;
     }
-    if (id >= manager->_maxInstanceSize) {
+    if (_calibrationStore == NULL) {
         /*
         ERRORLOG
-            内容：最大インスタンス数を超えるidが指定された
+            内容：キャリブレーションデータの保存先が登録されていない
         */
-        ERRORLOG();
-        return NULL;
-    } 
-    if (manager->_instanceList[id] == NULL) {
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return false;
+    }
+    return _calibrationStore->save(instance->_calibration);
+}
+
+bool EJ_ToFUnit_Manager::invalidateCalibration(uint8_t id)
+{
+    EJ_ToFUnit *instance = EJ_ToFUnit_Manager::getToFUnit(id);
+    if (instance == NULL) {
         /*
         ERRORLOG
-            内容：指定されたidのインスタンスが存在しない
+            内容：インスタンス取得に失敗した
         */
-        ERRORLOG();
-        return NULL;
+        ERRORLOG(EJ_ERROR_INVALID_ID);
+        return false;
+    }
+    if (_calibrationStore == NULL) {
+        /*
+        ERRORLOG
+            内容：キャリブレーションデータの保存先が登録されていない
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return false;
     }
-    return manager->_instanceList[id];
+    return _calibrationStore->erase(instance->_calibration.key);
 }
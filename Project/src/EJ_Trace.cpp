@@ -0,0 +1,213 @@
+#include "EJ_Trace.h"
+#include "EJ_ErrorLog.h"
+#ifndef ARDUINO_ARCH_ESP32
+#include <stdio.h>
+#include <time.h>
+#endif
+
+#define ERRORLOG(code) EJ_ErrorLog::record(_classname, code, __LINE__)
+
+/* 瞬間のイベントのduration */
+#define EJ_TRACE_INSTANT_EVENT 0xFFFFFFFFUL
+
+/*------------
+class EJ_Trace
+------------*/
+
+/* static member */
+const char* EJ_Trace::_classname = "EJ_Trace";
+EJ_Trace::Ring EJ_Trace::_rings[EJ_TRACE_CORES];
+bool EJ_Trace::_running = false;
+EJ_TraceCycles EJ_Trace::_startCycles = 0;
+uint64_t EJ_Trace::_startNanoseconds = 0;
+
+/* private method */
+uint8_t EJ_Trace::coreId()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return (uint8_t)xPortGetCoreID();
+#else
+    return 0;
+#endif
+}
+
+uint64_t EJ_Trace::nanoseconds()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return (uint64_t)micros() * 1000ULL;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void EJ_Trace::record(const char *name, EJ_TraceCycles start, uint32_t duration)
+{
+    Ring &ring = _rings[coreId()];
+#ifdef ARDUINO_ARCH_ESP32
+    /* コアごとのサイクルカウンタとmicros()の対応を、32bitの差が符号付きで表せる範囲に保つ */
+    if (!ring.baseValid || (uint32_t)(start - ring.baseCycles) > 0x7FFFFFFFUL) {
+        ring.baseCycles = start;
+        ring.baseMicros = micros();
+        ring.baseValid = true;
+    }
+#endif
+    /* 同じコアのISRに割り込まれても別の枠を使うよう、枠は不可分な加算で確保する */
+    uint32_t index = __atomic_fetch_add(&ring.head, 1, __ATOMIC_RELAXED);
+    Event &event = ring.events[index & (EJ_TRACE_BUFFER_SIZE - 1)];
+    __atomic_store_n(&event.sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event.start = start;
+    event.duration = duration;
+    event.name = name;
+    __atomic_store_n(&event.sequence, index + 1, __ATOMIC_RELEASE);
+}
+
+/* static public method */
+void EJ_Trace::start()
+{
+    _running = false;
+    for (uint8_t core = 0; core < EJ_TRACE_CORES; core++) {
+        Ring &ring = _rings[core];
+        for (uint32_t i = 0; i < EJ_TRACE_BUFFER_SIZE; i++) {
+            ring.events[i].sequence = 0;
+        }
+        ring.head = 0;
+        ring.baseValid = false;
+    }
+    _startNanoseconds = nanoseconds();
+    _startCycles = cycles();
+    __atomic_store_n(&_running, true, __ATOMIC_RELEASE);
+}
+
+void EJ_Trace::stop()
+{
+    __atomic_store_n(&_running, false, __ATOMIC_RELEASE);
+}
+
+void EJ_Trace::complete(const char *name, EJ_TraceCycles start, EJ_TraceCycles end)
+{
+    if (!__atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    EJ_TraceCycles duration = end - start;
+    record(name, start, duration < EJ_TRACE_INSTANT_EVENT ? (uint32_t)duration : EJ_TRACE_INSTANT_EVENT - 1);
+}
+
+void EJ_Trace::instant(const char *name)
+{
+    if (!__atomic_load_n(&_running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    record(name, cycles(), EJ_TRACE_INSTANT_EVENT);
+}
+
+double EJ_Trace::getFrequency()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return (double)getCpuFrequencyMhz() * 1e6;
+#elif defined(__x86_64__) || defined(__i386__)
+    uint64_t elapsed = nanoseconds() - _startNanoseconds;
+    EJ_TraceCycles counted = cycles() - _startCycles;
+    return elapsed > 0 ? (double)counted * 1e9 / (double)elapsed : 1e9;
+#else
+    return 1e9;
+#endif
+}
+
+uint32_t EJ_Trace::getEventCount()
+{
+    uint32_t count = 0;
+    for (uint8_t core = 0; core < EJ_TRACE_CORES; core++) {
+        uint32_t head = __atomic_load_n(&_rings[core].head, __ATOMIC_ACQUIRE);
+        count += head < EJ_TRACE_BUFFER_SIZE ? head : EJ_TRACE_BUFFER_SIZE;
+    }
+    return count;
+}
+
+uint32_t EJ_Trace::getLostCount()
+{
+    uint32_t lost = 0;
+    for (uint8_t core = 0; core < EJ_TRACE_CORES; core++) {
+        uint32_t head = __atomic_load_n(&_rings[core].head, __ATOMIC_ACQUIRE);
+        lost += head > EJ_TRACE_BUFFER_SIZE ? head - EJ_TRACE_BUFFER_SIZE : 0;
+    }
+    return lost;
+}
+
+uint32_t EJ_Trace::exportChrome(Print &out)
+{
+    if (_running) {
+        /*
+        ERRORLOG
+            内容：記録中に書き出そうとした (stop()の後に書き出す)
+        */
+        ERRORLOG(EJ_ERROR_NOT_READY);
+        return 0;
+    }
+    double cyclesPerMicro = getFrequency() * 1e-6;
+    uint32_t exported = 0;
+    out.printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (uint8_t core = 0; core < EJ_TRACE_CORES; core++) {
+        out.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"core%u\"}}",
+                   core == 0 ? "" : ",\n", (unsigned)core, (unsigned)core);
+        const Ring &ring = _rings[core];
+        uint32_t head = ring.head;
+        uint32_t first = head > EJ_TRACE_BUFFER_SIZE ? head - EJ_TRACE_BUFFER_SIZE : 0;
+        for (uint32_t index = first; index < head; index++) {
+            const Event &event = ring.events[index & (EJ_TRACE_BUFFER_SIZE - 1)];
+            if (event.sequence != index + 1) {
+                continue; /* 書き込み中に停止したイベント */
+            }
+#ifdef ARDUINO_ARCH_ESP32
+            double timestamp = ring.baseMicros + (int32_t)(event.start - ring.baseCycles) / cyclesPerMicro;
+#else
+            double timestamp = (double)(int64_t)(event.start - _startCycles) / cyclesPerMicro;
+#endif
+            if (event.duration == EJ_TRACE_INSTANT_EVENT) {
+                out.printf(",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                           event.name, timestamp, (unsigned)core);
+            } else {
+                out.printf(",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                           event.name, timestamp, event.duration / cyclesPerMicro, (unsigned)core);
+            }
+            exported++;
+        }
+    }
+    out.printf("\n]}\n");
+    return exported;
+}
+
+#ifndef ARDUINO_ARCH_ESP32
+/**
+ * @brief ファイルに書き出すPrint (ホストのみ)
+ */
+class EJ_TraceFile : public Print
+{
+public:
+    explicit EJ_TraceFile(FILE *file) : _file(file) {}
+    virtual size_t write(uint8_t c) { return fwrite(&c, 1, 1, _file); }
+    virtual size_t write(const uint8_t *buffer, size_t size) { return fwrite(buffer, 1, size, _file); }
+
+private:
+    FILE *_file;
+};
+
+int32_t EJ_Trace::exportChrome(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        /*
+        ERRORLOG
+            内容：書き出し先のファイルを開けなかった
+        */
+        ERRORLOG(EJ_ERROR_STORAGE);
+        return -1;
+    }
+    EJ_TraceFile out(file);
+    uint32_t exported = exportChrome(out);
+    fclose(file);
+    return (int32_t)exported;
+}
+#endif
@@ -3,13 +3,6 @@
 #include <math.h>
 #include "Elib.h"
 #include "PinAssign.h"
-#ifdef M5_DEBUG
-#define ERRORLOG() M5.Lcd.printf("[ERROR] Class:%s, Line:%d\n", _classname, __LINE__)
-#else
-#define ERRORLOG() ((void)0)
-#endif
-
-const char* _classname = "main";
 
 const int M5_SHUTDOWN_DELAY = 5000; // ms
 
@@ -29,8 +22,16 @@ void setup() {
   }
 
   {
-    EJ_EncoderMotor_Manager::configure(1);
-    motor = EJ_EncoderMotor_Manager::createEncoderMotor(25, 26, 35, 36, -1, 0);
+    EJ_DeviceTable::createAll(DEVICES);
+    motor = EJ_EncoderMotor_Manager::getEncoderMotor(0);
+  }
+
+  { /* デバイスの周期処理をコア1のタスクで固定レートで実行する */
+    EJ_Executive::begin(1000);
+    EJ_Executive::addUpdate<EJ_EncoderMotor_Manager>("motor", 1000);
+    EJ_Executive::addUpdate<EJ_ToFUnit_Manager>("tof", 200);
+    EJ_Executive::addUpdate<EJ_ServoMotor_Manager>("servo", 50);
+    EJ_Executive::start(1);
   }
 }
 
@@ -40,4 +41,8 @@ void loop() {
   motor->reverse();
   delay(2000);
   M5.lcd.println(motor->read());
+#ifdef M5_DEBUG
+  /* ライブラリのエラーは記録だけされるため、描画はloop()の中でまとめて行う */
+  EJ_ErrorLog::drain(M5.Lcd);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+/**
+ * @file           test_main.cpp
+ * @brief          EJ_PCA9685のプリスケーラの計算、変更チャンネルのバースト送信と再送、PCA9685に接続したサーボの出力をEJ_SimPCA9685に対して確かめるホスト向けテスト
+ * @details        pio test -e native -f test_pca9685 で実行する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Elib.h"
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+
+/* パルス幅の許容誤差 (50Hzで1カウント = 4.88us の半分, 単位: us) */
+static const float PULSE_TOLERANCE = 2.5f;
+
+/* テスト内で生成した順にidとI2Cアドレスを割り当てる (生成したインスタンスはtearDown()で破棄する) */
+static uint8_t nextId = 0;
+
+static uint8_t nextAddress()
+{
+    return 0x40 + nextId;
+}
+
+static EJ_PCA9685 *createPCA9685()
+{
+    EJ_PCA9685 *pca = EJ_PCA9685_Manager::createPCA9685(nextId, nextAddress());
+    if (pca != NULL) {
+        nextId++;
+    }
+    return pca;
+}
+
+void setUp()
+{
+    nextId = 0;
+    EJ_HAL::reset();
+    EJ_Sim::begin();
+}
+
+void tearDown()
+{
+    /* サーボは出力先のPCA9685より先に破棄する */
+    EJ_ServoMotor_Manager::clear();
+    EJ_PCA9685_Manager::clear();
+    EJ_Sim::end();
+}
+
+void test_create_without_device_returns_null()
+{
+    /* 応答しないアドレスでは生成に失敗し、idは再利用できる */
+    uint8_t id = nextId;
+    TEST_ASSERT_NULL(createPCA9685());
+    TEST_ASSERT_NULL(EJ_PCA9685_Manager::getPCA9685(id));
+}
+
+void test_prescale_at_50hz()
+{
+    EJ_SimPCA9685 sim(nextAddress());
+    EJ_PCA9685 *pca = createPCA9685();
+    TEST_ASSERT_NOT_NULL(pca);
+
+    /* 25MHz / (4096 * 50Hz) - 1 = 121.07 */
+    TEST_ASSERT_EQUAL_UINT8(121, sim.getPreScale());
+    TEST_ASSERT_FALSE(sim.isSleeping());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, sim.getFrequency(), pca->getFrequency());
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 50.0f, sim.getFrequency());
+}
+
+void test_flush_bursts_dirty_channels()
+{
+    EJ_SimPCA9685 sim(nextAddress());
+    EJ_PCA9685 *pca = createPCA9685();
+    TEST_ASSERT_NOT_NULL(pca);
+    uint32_t before = sim.getTransactionCount();
+
+    /* 連続するチャンネル0~2は1回のバースト、離れたチャンネル5は別のトランザクションで送る */
+    pca->setPulseWidth(0, 1500);
+    pca->setPulseWidth(1, 1500);
+    pca->setPulseWidth(2, 1000);
+    pca->setPulseWidth(5, 2000);
+    TEST_ASSERT_TRUE(pca->isDirty());
+    TEST_ASSERT_TRUE(pca->flush());
+    TEST_ASSERT_EQUAL_UINT32(before + 2, sim.getTransactionCount());
+    TEST_ASSERT_FALSE(pca->isDirty());
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, 1500.0f, sim.getPulseWidth(0));
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, 1500.0f, sim.getPulseWidth(1));
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, 1000.0f, sim.getPulseWidth(2));
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, 2000.0f, sim.getPulseWidth(5));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sim.getPulseWidth(3));
+
+    /* 変更がなければ送信しない。同じ値の書き込みも変更として扱わない */
+    TEST_ASSERT_TRUE(pca->flush());
+    pca->setPulseWidth(1, 1500);
+    TEST_ASSERT_FALSE(pca->isDirty());
+    TEST_ASSERT_TRUE(pca->flush());
+    TEST_ASSERT_EQUAL_UINT32(before + 2, sim.getTransactionCount());
+
+    /* 出力停止はFULL_OFFで送る */
+    pca->setPulseWidth(5, 0);
+    TEST_ASSERT_TRUE(pca->flush());
+    TEST_ASSERT_EQUAL_UINT16(0x1000, sim.getOff(5));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, sim.getPulseWidth(5));
+}
+
+void test_failed_flush_is_retried()
+{
+    EJ_SimPCA9685 sim(nextAddress());
+    EJ_PCA9685 *pca = createPCA9685();
+    TEST_ASSERT_NOT_NULL(pca);
+
+    /* 送信に失敗したチャンネルは変更として残り、次のflush()で再送される */
+    sim.setStalled(true);
+    pca->setPulseWidth(3, 1200);
+    TEST_ASSERT_FALSE(pca->flush());
+    TEST_ASSERT_TRUE(pca->isDirty());
+
+    sim.setStalled(false);
+    uint32_t before = sim.getTransactionCount();
+    TEST_ASSERT_TRUE(pca->flush());
+    TEST_ASSERT_FALSE(pca->isDirty());
+    TEST_ASSERT_EQUAL_UINT32(before + 1, sim.getTransactionCount());
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, 1200.0f, sim.getPulseWidth(3));
+}
+
+void test_expander_servo_is_sent_by_update()
+{
+    EJ_SimPCA9685 sim(nextAddress());
+    uint8_t expander = nextId;
+    TEST_ASSERT_NOT_NULL(createPCA9685());
+    EJ_ServoMotor *servo = EJ_ServoMotor_Manager::createExpanderServo(expander, 7, 0);
+    TEST_ASSERT_NOT_NULL(servo);
+
+    /* write()はシャドウレジスタに書き込むだけで、update()でまとめて送信される */
+    uint32_t before = sim.getTransactionCount();
+    servo->write(90);
+    TEST_ASSERT_EQUAL_UINT32(before, sim.getTransactionCount());
+    EJ_ServoMotor_Manager::update();
+    TEST_ASSERT_EQUAL_UINT32(before + 1, sim.getTransactionCount());
+    TEST_ASSERT_FLOAT_WITHIN(PULSE_TOLERANCE, (544.0f + 2400.0f) / 2.0f, sim.getPulseWidth(7));
+}
+
+void test_duplicate_expander_channel_is_rejected()
+{
+    EJ_SimPCA9685 sim(nextAddress());
+    uint8_t expander = nextId;
+    TEST_ASSERT_NOT_NULL(createPCA9685());
+    TEST_ASSERT_NOT_NULL(EJ_ServoMotor_Manager::createExpanderServo(expander, 4, 0));
+    TEST_ASSERT_NULL(EJ_ServoMotor_Manager::createExpanderServo(expander, 4, 1));
+    TEST_ASSERT_NOT_NULL(EJ_ServoMotor_Manager::createExpanderServo(expander, 5, 1));
+}
+
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_create_without_device_returns_null);
+    RUN_TEST(test_prescale_at_50hz);
+    RUN_TEST(test_flush_bursts_dirty_channels);
+    RUN_TEST(test_failed_flush_is_retried);
+    RUN_TEST(test_expander_servo_is_sent_by_update);
+    RUN_TEST(test_duplicate_expander_channel_is_rejected);
+    EJ_HAL::stop(UNITY_END());
+}
+
+void loop()
+{}
@@ -0,0 +1,163 @@
+/**
+ * @file           test_main.cpp
+ * @brief          EJ_SensorLogで記録したエンコーダとフォトインタラプタの値を再生し、同じ結果になることを確かめるホスト向けテスト
+ * @details        pio test -e native -f test_sensor_log で実行する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Elib.h"
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+
+/* 小型ギヤードモータ相当の物理パラメータ (6V, 2Ω, 1回転360カウント) */
+static const SimDCMotorDef MOTOR_DEF = {6.0f, 2.0f, 0.05f, 2e-5f, 1e-5f, 0.002f, 0.05f, 360.0f};
+
+/* フォトインタラプタの接続ピンと、遮断される時刻 (単位: us) */
+static const uint8_t PHOTO_PIN = 32;
+static const uint64_t INTERRUPT_TIME = 150000;
+
+/* 目標位置 (単位: カウント)。フォトインタラプタが遮断されて先に止まる */
+static const long TARGET = 3600;
+
+/* 1回のシナリオで記録する周期 (1ms) の数 */
+static const size_t SAMPLES = 300;
+
+typedef struct
+{
+    long position;
+    int32_t interrupted;
+} Sample;
+
+/* 記録したログを保持する書き出し先 */
+class LogBuffer : public Print
+{
+public:
+    LogBuffer() : _length(0) {}
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t *buffer, size_t size)
+    {
+        if (_length + size > sizeof(_data)) {
+            return 0;
+        }
+        memcpy(_data + _length, buffer, size);
+        _length += size;
+        return size;
+    }
+    const uint8_t *data() const { return _data; }
+    size_t length() const { return _length; }
+
+private:
+    uint8_t _data[16384];
+    size_t _length;
+};
+
+static LogBuffer logBuffer;
+static Sample recorded[SAMPLES];
+static Sample replayed[SAMPLES];
+
+static void interrupt(void *context)
+{
+    (void)context;
+    EJ_HAL::setPinInput(PHOTO_PIN, HIGH);
+}
+
+/*
+ * 移動を開始し、フォトインタラプタが遮断されたら止める回避ロジックを1ms周期で実行する
+ * reads: 1周期に位置と遮断状態を読む回数 (2回目以降は結果を使わない)
+ */
+static void runScenario(EJ_EncoderMotor *motor, EJ_PhotoInterrupter *photo, uint8_t reads, Sample *trace)
+{
+    memset(trace, 0, sizeof(Sample) * SAMPLES);
+    motor->move(TARGET, 80);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        EJ_EncoderMotor_Manager::update();
+        for (uint8_t r = 1; r < reads; r++) {
+            motor->isTargetReached();
+            photo->isInterrupted();
+        }
+        trace[i].position = motor->read();
+        trace[i].interrupted = photo->isInterrupted() ? 1 : 0;
+        if (trace[i].interrupted) {
+            motor->stop();
+        }
+        EJ_SensorLog::update();
+        delay(1);
+    }
+}
+
+static void record(EJ_EncoderMotor *motor, EJ_PhotoInterrupter *photo)
+{
+    EJ_SimDCMotor plant(25, 26, 27, 34, MOTOR_DEF);
+    EJ_Sim::addPlant(&plant);
+    EJ_Sim::at(INTERRUPT_TIME, interrupt, NULL);
+    TEST_ASSERT_TRUE(EJ_SensorLog::startRecording(logBuffer));
+    runScenario(motor, photo, 1, recorded);
+    EJ_SensorLog::stopRecording();
+    EJ_Sim::end();
+    TEST_ASSERT_EQUAL_UINT32(0, EJ_SensorLog::getDroppedCount());
+}
+
+void setUp()
+{
+    EJ_HAL::reset();
+    EJ_Sim::begin();
+    logBuffer = LogBuffer();
+}
+
+void tearDown()
+{
+    EJ_SensorLog::stopReplay();
+    EJ_EncoderMotor_Manager::clear();
+    EJ_PhotoInterrupter_Manager::clear();
+    EJ_Sim::end();
+}
+
+void test_replay_matches_recording()
+{
+    EJ_EncoderMotor *motor = EJ_EncoderMotor_Manager::createEncoderMotor(25, 26, 34, 35, 27, 0);
+    EJ_PhotoInterrupter *photo = EJ_PhotoInterrupter_Manager::createPhotoInterrupter(PHOTO_PIN, 0);
+    TEST_ASSERT_NOT_NULL(motor);
+    TEST_ASSERT_NOT_NULL(photo);
+    record(motor, photo);
+    /* 記録したシナリオでモーターが動き、途中で遮断されている */
+    TEST_ASSERT_TRUE(recorded[SAMPLES - 1].position > 0);
+    TEST_ASSERT_EQUAL_INT32(0, recorded[0].interrupted);
+    TEST_ASSERT_EQUAL_INT32(1, recorded[SAMPLES - 1].interrupted);
+
+    /* 2回再生しても、記録時と同じ値の並びになる */
+    for (uint8_t run = 0; run < 2; run++) {
+        TEST_ASSERT_TRUE(EJ_SensorLog::startReplay(logBuffer.data(), logBuffer.length()));
+        runScenario(motor, photo, 1, replayed);
+        EJ_SensorLog::stopReplay();
+        TEST_ASSERT_EQUAL_MEMORY(recorded, replayed, sizeof(recorded));
+    }
+}
+
+void test_replay_ignores_extra_reads()
+{
+    EJ_EncoderMotor *motor = EJ_EncoderMotor_Manager::createEncoderMotor(25, 26, 34, 35, 27, 0);
+    EJ_PhotoInterrupter *photo = EJ_PhotoInterrupter_Manager::createPhotoInterrupter(PHOTO_PIN, 0);
+    TEST_ASSERT_NOT_NULL(motor);
+    TEST_ASSERT_NOT_NULL(photo);
+    record(motor, photo);
+
+    /* 回避ロジックが読み出す回数を変えても、値は読み出した時刻で決まるためずれない */
+    TEST_ASSERT_TRUE(EJ_SensorLog::startReplay(logBuffer.data(), logBuffer.length()));
+    runScenario(motor, photo, 3, replayed);
+    TEST_ASSERT_EQUAL_MEMORY(recorded, replayed, sizeof(recorded));
+    TEST_ASSERT_TRUE(EJ_SensorLog::isFinished());
+}
+
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_matches_recording);
+    RUN_TEST(test_replay_ignores_extra_reads);
+    EJ_HAL::stop(UNITY_END());
+}
+
+void loop()
+{}
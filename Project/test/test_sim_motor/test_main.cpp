@@ -0,0 +1,181 @@
+/**
+ * @file           test_main.cpp
+ * @brief          EJ_EncoderMotorをEJ_SimDCMotorにつないだ閉ループのステップ応答をEJ_SimStepResponseで評価するホスト向けテスト
+ * @details        pio test -e native -f test_sim_motor で実行する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Elib.h"
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+
+/* 小型ギヤードモータ相当の物理パラメータ (6V, 2Ω, 1回転360カウント) */
+static const SimDCMotorDef MOTOR_DEF = {6.0f, 2.0f, 0.05f, 2e-5f, 1e-5f, 0.002f, 0.05f, 360.0f};
+
+/* 目標位置 (単位: カウント) */
+static const long TARGET = 360;
+
+/* 比例制御のゲイン (単位: duty / カウント) */
+static const long GAIN = 2;
+
+typedef struct
+{
+    float riseTime;
+    float overshoot;
+    float settlingTime;
+    float steadyStateError;
+} StepMetrics;
+
+static EJ_EncoderMotor *createEncoderMotor()
+{
+    return EJ_EncoderMotor_Manager::createEncoderMotor(25, 26, 34, 35, 27, 0);
+}
+
+/*
+ * 仮想時刻と位置を0から始め、比例制御で目標位置に移動させた1秒間の応答の評価指標を返す
+ * load: 回転を妨げる負荷トルク (単位: N·m)
+ */
+static StepMetrics runProportional(EJ_EncoderMotor *motor, float load)
+{
+    EJ_Sim::begin();
+    EJ_SimDCMotor plant(25, 26, 27, 34, MOTOR_DEF);
+    plant.setLoad(load);
+    EJ_Sim::addPlant(&plant);
+    motor->Encoder::write(0);
+
+    EJ_SimStepResponse response;
+    response.begin(0, TARGET, 0.02f);
+    while (EJ_Sim::now() < 1000000) {
+        long position = motor->read();
+        motor->setPWM(constrain((TARGET - position) * GAIN, -100, 100));
+        response.sample(EJ_Sim::now(), position);
+        delay(1);
+    }
+    motor->setPWM(0);
+
+    StepMetrics metrics;
+    metrics.riseTime = response.getRiseTime();
+    metrics.overshoot = response.getOvershoot();
+    metrics.settlingTime = response.getSettlingTime();
+    metrics.steadyStateError = response.getSteadyStateError();
+    return metrics;
+}
+
+void setUp()
+{
+    EJ_HAL::reset();
+    EJ_Sim::begin();
+}
+
+void tearDown()
+{
+    EJ_EncoderMotor_Manager::clear();
+    EJ_Sim::end();
+}
+
+void test_proportional_step_response()
+{
+    EJ_EncoderMotor *motor = createEncoderMotor();
+    TEST_ASSERT_NOT_NULL(motor);
+    StepMetrics metrics = runProportional(motor, 0.0f);
+
+    /* 0.1秒以内に立ち上がり、オーバーシュート20%未満で0.3秒以内に整定範囲 (2%) に収まる */
+    TEST_ASSERT_TRUE(metrics.riseTime > 0.0f);
+    TEST_ASSERT_TRUE(metrics.riseTime < 0.1f);
+    TEST_ASSERT_TRUE(metrics.overshoot < 0.2f);
+    TEST_ASSERT_TRUE(metrics.settlingTime >= 0.0f);
+    TEST_ASSERT_TRUE(metrics.settlingTime < 0.3f);
+    TEST_ASSERT_FLOAT_WITHIN(TARGET * 0.02f, 0.0f, metrics.steadyStateError);
+}
+
+void test_load_slows_response()
+{
+    EJ_EncoderMotor *motor = createEncoderMotor();
+    TEST_ASSERT_NOT_NULL(motor);
+    StepMetrics free = runProportional(motor, 0.0f);
+    StepMetrics loaded = runProportional(motor, 0.03f);
+
+    /* 負荷があると立ち上がりは遅れるが、整定範囲には収まる */
+    TEST_ASSERT_TRUE(loaded.riseTime > free.riseTime);
+    TEST_ASSERT_TRUE(loaded.settlingTime >= 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(TARGET * 0.02f, 0.0f, loaded.steadyStateError);
+}
+
+void test_runs_deterministically()
+{
+    EJ_EncoderMotor *motor = createEncoderMotor();
+    TEST_ASSERT_NOT_NULL(motor);
+    /* 仮想時刻で実時間の待機をしないため、同じシナリオは常に同じ結果になる */
+    StepMetrics first = runProportional(motor, 0.0f);
+    StepMetrics second = runProportional(motor, 0.0f);
+    TEST_ASSERT_EQUAL_FLOAT(first.riseTime, second.riseTime);
+    TEST_ASSERT_EQUAL_FLOAT(first.overshoot, second.overshoot);
+    TEST_ASSERT_EQUAL_FLOAT(first.settlingTime, second.settlingTime);
+    TEST_ASSERT_EQUAL_FLOAT(first.steadyStateError, second.steadyStateError);
+}
+
+void test_move_stops_at_target()
+{
+    EJ_EncoderMotor *motor = createEncoderMotor();
+    TEST_ASSERT_NOT_NULL(motor);
+    EJ_SimDCMotor plant(25, 26, 27, 34, MOTOR_DEF);
+    EJ_Sim::addPlant(&plant);
+
+    EJ_SimStepResponse response;
+    response.begin(0, TARGET, 0.05f);
+    /* move()は最大出力で動かし、update()で目標位置を通過したらブレーキで止める */
+    motor->move(TARGET, 100);
+    uint64_t stoppedAt = 0;
+    while (EJ_Sim::now() < 1000000) {
+        EJ_EncoderMotor_Manager::update();
+        if (stoppedAt == 0 && !motor->isMoving()) {
+            stoppedAt = EJ_Sim::now();
+        }
+        response.sample(EJ_Sim::now(), motor->read());
+        delay(1);
+    }
+
+    /* 目標位置を越えた所で止まり、惰性の行き過ぎはブレーキで半回転未満に収まる */
+    TEST_ASSERT_TRUE(stoppedAt > 0);
+    TEST_ASSERT_TRUE(motor->read() >= TARGET);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, plant.getVelocity());
+    TEST_ASSERT_TRUE(response.getRiseTime() > 0.0f);
+    TEST_ASSERT_TRUE(response.getOvershoot() < 0.5f);
+}
+
+void test_manual_drive_cancels_move()
+{
+    EJ_EncoderMotor *motor = createEncoderMotor();
+    TEST_ASSERT_NOT_NULL(motor);
+    EJ_SimDCMotor plant(25, 26, 27, 34, MOTOR_DEF);
+    EJ_Sim::addPlant(&plant);
+
+    /* 移動中にsetPWM()で手動の駆動に切り替えると、古い目標位置でupdate()が止めない */
+    motor->move(TARGET, 100);
+    delay(10);
+    motor->setPWM(50);
+    TEST_ASSERT_FALSE(motor->isMoving());
+    while (EJ_Sim::now() < 1000000) {
+        EJ_EncoderMotor_Manager::update();
+        delay(1);
+    }
+    TEST_ASSERT_TRUE(motor->read() > TARGET * 2);
+    TEST_ASSERT_TRUE(plant.getVelocity() > 0.0f);
+}
+
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_proportional_step_response);
+    RUN_TEST(test_load_slows_response);
+    RUN_TEST(test_runs_deterministically);
+    RUN_TEST(test_move_stops_at_target);
+    RUN_TEST(test_manual_drive_cancels_move);
+    EJ_HAL::stop(UNITY_END());
+}
+
+void loop()
+{}
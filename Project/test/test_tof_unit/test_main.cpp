@@ -0,0 +1,245 @@
+/**
+ * @file           test_main.cpp
+ * @brief          EJ_ToFUnitのポーリングの状態遷移、結果レジスタブロックの解釈、固有IDをキーにしたキャリブレーションデータのキャッシュをEJ_SimVL53L0Xに対して確かめるホスト向けテスト
+ * @details        pio test -e native -f test_tof_unit で実行する
+ * @author         IKDnot
+ * @date           2026/10/19
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "Elib.h"
+#include "EJ_Sim.h"
+#include "EJ_SimModels.h"
+
+/* 1回の測距時間 (EJ_SimVL53L0Xの既定値, 単位: us) */
+static const uint32_t PERIOD = 33000;
+
+/* テスト内で生成した順にidとI2Cアドレスを割り当てる (生成したユニットはtearDown()で破棄する) */
+static uint8_t nextId = 0;
+
+static EJ_ToFUnit *createToFUnit()
+{
+    uint8_t id = nextId++;
+    return EJ_ToFUnit_Manager::createToFUnit(id, 0x30 + id);
+}
+
+/* キャリブレーションデータをメモリに保存する保存先 */
+class MemoryCalibrationStore : public EJ_ToFCalibrationStore
+{
+public:
+    MemoryCalibrationStore() : _size(0), _writeCount(0) {}
+
+    virtual bool erase(uint32_t key)
+    {
+        for (size_t i = 0; i < _size; i++) {
+            if (_data[i].key == key) {
+                _data[i] = _data[--_size];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t getSize() { return _size; }
+    uint32_t getWriteCount() { return _writeCount; }
+
+protected:
+    virtual bool read(uint32_t key, ToFCalibration &calibration)
+    {
+        for (size_t i = 0; i < _size; i++) {
+            if (_data[i].key == key) {
+                calibration = _data[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    virtual bool write(const ToFCalibration &calibration)
+    {
+        _writeCount++;
+        erase(calibration.key);
+        if (_size >= 4) {
+            return false;
+        }
+        _data[_size++] = calibration;
+        return true;
+    }
+
+private:
+    ToFCalibration _data[4];
+    size_t _size;
+    uint32_t _writeCount;
+};
+
+/* 測距が1回完了するまで時刻を進める */
+static void waitMeasurement()
+{
+    EJ_Sim::advance(PERIOD);
+}
+
+void setUp()
+{
+    nextId = 0;
+    EJ_HAL::reset();
+    EJ_Sim::begin();
+}
+
+void tearDown()
+{
+    EJ_ToFUnit_Manager::clear();
+    EJ_Sim::end();
+}
+
+void test_poll_state_machine()
+{
+    EJ_SimVL53L0X sensor;
+    sensor.setRange(500);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_WAIT_READY, tof->getState());
+
+    /* 測距が完了するまでは状態が変わらない */
+    TEST_ASSERT_FALSE(tof->poll());
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_WAIT_READY, tof->getState());
+    TEST_ASSERT_FALSE(tof->available());
+
+    /* 完了を検出したら1回のpoll()につき1回のI2Cアクセスで結果の読み出し、割り込みクリアと進む */
+    waitMeasurement();
+    TEST_ASSERT_FALSE(tof->poll());
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_READ_RESULT, tof->getState());
+    TEST_ASSERT_TRUE(tof->poll());
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_CLEAR_INTERRUPT, tof->getState());
+    TEST_ASSERT_TRUE(tof->available());
+    TEST_ASSERT_FALSE(tof->poll());
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_WAIT_READY, tof->getState());
+
+    TEST_ASSERT_EQUAL_UINT16(500, tof->getMeasurement().range);
+    TEST_ASSERT_FALSE(tof->available());
+
+    /* 割り込みがクリアされたので、次の測距が完了するまで新しい結果はない */
+    TEST_ASSERT_FALSE(tof->poll());
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_WAIT_READY, tof->getState());
+}
+
+void test_burst_decode()
+{
+    EJ_SimVL53L0X sensor;
+    sensor.setRange(1234);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    waitMeasurement();
+    while (!tof->poll()) {}
+
+    /* EJ_SimVL53L0Xが結果レジスタブロックに置く値 */
+    const ToFMeasurement &measurement = tof->getMeasurement();
+    TEST_ASSERT_EQUAL_UINT8(EJ_ToFUnit::RANGE_STATUS_VALID, measurement.rangeStatus);
+    TEST_ASSERT_EQUAL_UINT16(0x0A00, measurement.spadCount);
+    TEST_ASSERT_EQUAL_UINT16(0x0180, measurement.signalRate);
+    TEST_ASSERT_EQUAL_UINT16(0x0010, measurement.ambientRate);
+    TEST_ASSERT_EQUAL_UINT16(1234, measurement.range);
+    TEST_ASSERT_EQUAL_UINT32(millis(), measurement.timestamp);
+    TEST_ASSERT_EQUAL_UINT16(0x0180, tof->getSignalRate());
+    TEST_ASSERT_EQUAL_UINT8(EJ_ToFUnit::RANGE_STATUS_VALID, tof->getRangeStatus());
+}
+
+void test_burst_decode_out_of_range()
+{
+    EJ_SimVL53L0X sensor;
+    sensor.setRange(3000);
+    sensor.setMaxRange(2000);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    waitMeasurement();
+    while (!tof->poll()) {}
+
+    const ToFMeasurement &measurement = tof->getMeasurement();
+    TEST_ASSERT_EQUAL_UINT16(8190, measurement.range);
+    TEST_ASSERT_TRUE(measurement.rangeStatus != EJ_ToFUnit::RANGE_STATUS_VALID);
+}
+
+void test_poll_timeout()
+{
+    EJ_SimVL53L0X sensor;
+    sensor.setTimeoutRate(1.0f);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+
+    /* タイムアウト時間 (500ms) を過ぎるまでは待ち続ける */
+    EJ_Sim::advance(400000);
+    TEST_ASSERT_FALSE(tof->poll());
+    EJ_Sim::advance(200000);
+    TEST_ASSERT_TRUE(tof->poll());
+    TEST_ASSERT_EQUAL_UINT16(65535, tof->getMeasurement().range);
+    TEST_ASSERT_EQUAL(EJ_ToFUnit::STATE_WAIT_READY, tof->getState());
+}
+
+void test_read_blocks_until_measurement()
+{
+    EJ_SimVL53L0X sensor;
+    sensor.setRange(750);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+
+    /* read()はpoll()を繰り返し、I2Cの転送時間で仮想時刻が進んで測距が完了する */
+    uint32_t before = sensor.getMeasurementCount();
+    TEST_ASSERT_EQUAL_UINT16(750, tof->read());
+    TEST_ASSERT_TRUE(sensor.getMeasurementCount() > before);
+}
+
+void test_calibration_keyed_by_unique_id()
+{
+    MemoryCalibrationStore store;
+    EJ_ToFUnit_Manager::setCalibrationStore(&store);
+
+    /* キャッシュが無いのでフルキャリブレーションを行い、固有IDのキーで保存する */
+    EJ_SimVL53L0X first;
+    first.setUniqueId(0x4C3F2A00, 0x00001234);
+    EJ_ToFUnit *tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    TEST_ASSERT_TRUE(tof->isFullyCalibrated());
+    uint32_t key = EJ_ToFCalibrationStore::makeKey(0x4C3F2A00, 0x00001234);
+    TEST_ASSERT_EQUAL_UINT32(key, tof->getCalibration().key);
+    TEST_ASSERT_EQUAL_UINT32(1, store.getWriteCount());
+
+    /* 同じセンサは別のidやアドレスで生成してもキャッシュを使い、保存し直さない */
+    EJ_SimVL53L0X same;
+    same.setUniqueId(0x4C3F2A00, 0x00001234);
+    tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    TEST_ASSERT_FALSE(tof->isFullyCalibrated());
+    TEST_ASSERT_EQUAL_UINT32(key, tof->getCalibration().key);
+    TEST_ASSERT_EQUAL_UINT32(1, store.getWriteCount());
+
+    /* 交換したセンサは固有IDが変わるので、フルキャリブレーションを行い別のキーで保存する */
+    EJ_SimVL53L0X replaced;
+    replaced.setUniqueId(0x4C3F2A00, 0x00005678);
+    tof = createToFUnit();
+    TEST_ASSERT_NOT_NULL(tof);
+    TEST_ASSERT_TRUE(tof->isFullyCalibrated());
+    TEST_ASSERT_TRUE(tof->getCalibration().key != key);
+    TEST_ASSERT_EQUAL_UINT32(2, store.getWriteCount());
+    TEST_ASSERT_EQUAL(2, store.getSize());
+
+    /* 削除するとそのセンサのキャッシュだけが無くなる */
+    TEST_ASSERT_TRUE(EJ_ToFUnit_Manager::invalidateCalibration(nextId - 1));
+    TEST_ASSERT_EQUAL(1, store.getSize());
+
+    EJ_ToFUnit_Manager::setCalibrationStore(NULL);
+}
+
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_poll_state_machine);
+    RUN_TEST(test_burst_decode);
+    RUN_TEST(test_burst_decode_out_of_range);
+    RUN_TEST(test_poll_timeout);
+    RUN_TEST(test_read_blocks_until_measurement);
+    RUN_TEST(test_calibration_keyed_by_unique_id);
+    EJ_HAL::stop(UNITY_END());
+}
+
+void loop()
+{}
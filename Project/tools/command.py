@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""EJ_Commandにバイナリコマンドを送信し、応答 (デバイスの状態) を表示する
+
+usage: command.py PORT [--baud 921600] COMMAND...
+       command.py --exec ".pio/build/native_command/program" COMMAND...
+COMMANDは "宛先 id 操作 [引数]" (例: "dcmotor 0 pwm 50" "servo 1 angle 9000" "photo 0 query")
+指定したコマンドは1フレームにまとめて送信し、デバイス側で同時に適用される
+--repeatを指定すると同じフレームを繰り返し送信し、往復時間を報告する
+"""
+import argparse
+import struct
+import sys
+import time
+
+from ejframing import Port, check_crc, cobs_encode, with_crc
+
+FRAME_REQUEST = 0x43
+FRAME_ACK = 0x41
+TARGETS = ["dcmotor", "servo", "encodermotor", "photo"]
+OPERATIONS = ["query", "stop", "pwm", "angle", "target", "position"]
+STATUS = ["ok", "malformed", "invalid device", "invalid operation", "invalid value"]
+
+
+def parse_command(text):
+    words = text.split()
+    if len(words) not in (3, 4):
+        raise ValueError("COMMANDは '宛先 id 操作 [引数]': %r" % text)
+    value = int(words[3], 0) if len(words) == 4 else 0
+    return TARGETS.index(words[0]), int(words[1], 0), OPERATIONS.index(words[2]), value
+
+
+class Client:
+    def __init__(self, port):
+        self.port = port
+        self.sequence = 0
+
+    def send(self, commands, timeout=1.0):
+        """コマンドを1フレームで送信し、(結果, 不正なコマンドの番号, [(宛先, id, 値1, 値2)...]) を返す"""
+        self.sequence = (self.sequence + 1) & 0xFF
+        payload = struct.pack("<BBB", FRAME_REQUEST, self.sequence, len(commands))
+        for command in commands:
+            payload += struct.pack("<BBBi", *command)
+        self.port.write(cobs_encode(with_crc(payload)))
+        for frame in self.port.frames(timeout):
+            body = check_crc(frame)
+            if body is None or body[0] != FRAME_ACK or body[1] != self.sequence:
+                continue  # 破損した応答や古い要求への応答は読み捨てる
+            _, _, status, index, count = struct.unpack_from("<BBBBB", body)
+            states = [struct.unpack_from("<BBii", body, 5 + i * 10) for i in range(count)]
+            return status, index, states
+        raise TimeoutError("no ack for sequence %d" % self.sequence)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?")
+    parser.add_argument("commands", nargs="+", metavar="COMMAND")
+    parser.add_argument("--baud", type=int, help="シリアルポートの通信速度")
+    parser.add_argument("--exec", dest="command", help="擬似端末につないで起動するホスト向けのスケッチ")
+    parser.add_argument("--repeat", type=int, default=1, help="送信する回数")
+    parser.add_argument("--timeout", type=float, default=1.0, help="応答を待つ時間 [s]")
+    args = parser.parse_args()
+    if args.command is not None and args.port is not None:
+        args.commands.insert(0, args.port)  # --execの場合、最初の位置引数もCOMMAND
+        args.port = None
+    if args.port is None and args.command is None:
+        parser.error("PORTか--execのどちらかを指定する")
+
+    commands = [parse_command(text) for text in args.commands]
+    port = Port(args.port, args.baud, args.command)
+    client = Client(port)
+    try:
+        times = []
+        for _ in range(args.repeat):
+            start = time.perf_counter()
+            status, index, states = client.send(commands, args.timeout)
+            times.append(time.perf_counter() - start)
+    finally:
+        port.close()
+    print("status=%s%s" % (STATUS[status] if status < len(STATUS) else status,
+                           "" if index == 0xFF else " command=%d (%s)" % (index, args.commands[index])))
+    for target, id, value1, value2 in states:
+        print("%s %d: %d %d" % (TARGETS[target], id, value1, value2))
+    if args.repeat > 1:
+        times.sort()
+        print("round trip: median=%.3fms max=%.3fms" % (times[len(times) // 2] * 1e3, times[-1] * 1e3))
+    return 0 if status == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,162 @@
+"""ELibのシリアル通信 (EJ_Framing) のホスト側の実装
+
+COBSによるフレーム化、CRC-16/CCITT-FALSE、シリアルポート・擬似端末の入出力を提供する
+"""
+import os
+import select
+import signal
+import subprocess
+import termios
+import tty
+
+BAUDS = {9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400, 57600: termios.B57600,
+         115200: termios.B115200, 230400: termios.B230400, 460800: getattr(termios, "B460800", None),
+         921600: getattr(termios, "B921600", None)}
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    """区切りの0x00を含む符号化したフレームを返す"""
+    out = bytearray([0])
+    code = 0
+    distance = 1
+    for byte in data:
+        if byte == 0:
+            out[code] = distance
+            code = len(out)
+            out.append(0)
+            distance = 1
+        else:
+            out.append(byte)
+            distance += 1
+            if distance == 0xFF:
+                out[code] = distance
+                code = len(out)
+                out.append(0)
+                distance = 1
+    out[code] = distance
+    out.append(0)
+    return bytes(out)
+
+
+def cobs_decode(frame):
+    """区切りの0x00を含まないフレームを復号する。壊れている場合はNoneを返す"""
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        distance = frame[i]
+        if distance == 0 or i + distance > len(frame):
+            return None
+        block = frame[i + 1:i + distance]
+        if 0 in block:
+            return None
+        out += block
+        i += distance
+        if distance != 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def with_crc(payload):
+    crc = crc16(payload)
+    return payload + bytes([crc & 0xFF, crc >> 8])
+
+
+def check_crc(payload):
+    """CRCが一致すればCRCを除いたペイロードを、一致しなければNoneを返す"""
+    if payload is None or len(payload) < 3:
+        return None
+    body = payload[:-2]
+    return body if crc16(body) == payload[-2] | (payload[-1] << 8) else None
+
+
+class Port:
+    """シリアルポート、擬似端末、ファイル、またはスケッチの子プロセスにつながる擬似端末"""
+
+    def __init__(self, path=None, baud=None, command=None):
+        self.process = None
+        self.slave = None
+        if command is not None:
+            # 擬似端末を作り、子プロセス (ホスト向けビルドのスケッチ) のSerialにつなぐ
+            master, slave = os.openpty()
+            tty.setraw(master)
+            tty.setraw(slave)
+            env = dict(os.environ, EJ_SERIAL=os.ttyname(slave))
+            # シェルの子として起動したスケッチも終了させられるよう、プロセスグループを分ける
+            self.process = subprocess.Popen(command, shell=True, env=env, start_new_session=True)
+            # 子プロセスが開くまでの間にスレーブ側が閉じているとマスタ側の読み出しがEIOになるため、自分でも開いておく
+            self.slave = slave
+            self.fd = master
+        else:
+            self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY) if path != "-" else 0
+            if os.isatty(self.fd):
+                tty.setraw(self.fd)
+                if baud is not None:
+                    attributes = termios.tcgetattr(self.fd)
+                    attributes[4] = attributes[5] = BAUDS[baud]
+                    termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        self.buffer = bytearray()
+
+    def read(self, timeout=None):
+        """受信したデータを返す。timeout秒受信がなければb""、終端 (EOF、子プロセスの終了) ならNoneを返す"""
+        waited = 0.0
+        while True:
+            step = 0.1 if self.process is not None else timeout
+            if step is not None and timeout is not None:
+                step = min(step, timeout - waited)
+            ready, _, _ = select.select([self.fd], [], [], step)
+            if ready:
+                try:
+                    data = os.read(self.fd, 4096)
+                except OSError:
+                    data = b""
+                return data if data else None
+            if self.process is not None and self.process.poll() is not None:
+                return None  # 子プロセスが終了し、受信済みのデータも読み終えた
+            if step is not None:
+                waited += step
+                if timeout is not None and waited >= timeout:
+                    return b""
+
+    def write(self, data):
+        view = memoryview(data)
+        while view:
+            view = view[os.write(self.fd, view):]
+
+    def frames(self, timeout=None):
+        """区切りの0x00までを1フレームとして、COBSを復号したペイロード (壊れている場合はNone) を返す"""
+        while True:
+            end = self.buffer.find(0)
+            while end >= 0:
+                frame = bytes(self.buffer[:end])
+                del self.buffer[:end + 1]
+                if frame:
+                    yield cobs_decode(frame)
+                end = self.buffer.find(0)
+            data = self.read(timeout)
+            if not data:
+                return
+            self.buffer += data
+
+    def close(self):
+        if self.process is not None:
+            # 終了しないスケッチ (コマンドの受信など) は終了させる
+            try:
+                os.killpg(self.process.pid, signal.SIGTERM)
+            except ProcessLookupError:
+                pass
+            try:
+                self.process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                os.killpg(self.process.pid, signal.SIGKILL)
+        if self.slave is not None:
+            os.close(self.slave)
+        if self.fd != 0:
+            os.close(self.fd)
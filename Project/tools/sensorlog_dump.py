@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""EJ_SensorLogのログを復号し、CSV (時刻, センサの種類, キー, 値) で出力する
+
+ToFユニットの値は距離 (mm) と測距ステータスに分けて "距離/ステータス" の形で出力する
+
+usage: sensorlog_dump.py LOG [-o out.csv] [--summary]
+--summaryを指定すると、センサごとのレコード数と記録時間だけを表示する
+"""
+import argparse
+import sys
+
+KINDS = ["tof", "encoder", "photointerrupter"]
+DEFINE = 0xFF
+VERSION = 2
+TOF = 0
+
+
+def read_varint(data, offset):
+    value = shift = 0
+    while True:
+        byte = data[offset]
+        offset += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, offset
+        shift += 7
+
+
+def records(data):
+    """(時刻 [us], 種類, キー, 値) を記録順に返す。末尾の不完全なレコードは無視する"""
+    if data[:4] != b"EJRL" or data[4] != VERSION:
+        raise ValueError("not an EJ_SensorLog file")
+    time = int.from_bytes(data[5:9], "little")
+    channels = []
+    offset = 9
+    try:
+        while offset < len(data):
+            tag = data[offset]
+            if tag == DEFINE:
+                channels.append([data[offset + 1], data[offset + 2], 0])
+                offset += 3
+                continue
+            elapsed, offset = read_varint(data, offset + 1)
+            zigzag, offset = read_varint(data, offset)
+            time += elapsed
+            channel = channels[tag]
+            channel[2] = (channel[2] + ((zigzag >> 1) ^ -(zigzag & 1)) + 2**31) % 2**32 - 2**31
+            yield time, channel[0], channel[1], channel[2]
+    except IndexError:
+        pass
+
+
+def format_value(kind, value):
+    if kind == TOF:
+        return "%d/%d" % (value & 0xFFFF, (value >> 16) & 0xFF)
+    return str(value)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("log")
+    parser.add_argument("-o", "--output", help="出力先 (省略時は標準出力)")
+    parser.add_argument("--summary", action="store_true")
+    args = parser.parse_args()
+
+    with open(args.log, "rb") as f:
+        data = f.read()
+    if args.summary:
+        counts = {}
+        first = last = None
+        for time, kind, key, _ in records(data):
+            counts[(kind, key)] = counts.get((kind, key), 0) + 1
+            first = time if first is None else first
+            last = time
+        for (kind, key), count in sorted(counts.items()):
+            print("%-16s key=%-3d records=%d" % (KINDS[kind] if kind < len(KINDS) else kind, key, count))
+        if first is not None:
+            print("duration=%.3fs bytes=%d" % ((last - first) * 1e-6, len(data)))
+        return 0
+    out = open(args.output, "w", encoding="utf-8") if args.output else sys.stdout
+    out.write("time_us,kind,key,value\n")
+    for time, kind, key, value in records(data):
+        out.write("%d,%s,%d,%s\n" % (time, KINDS[kind] if kind < len(KINDS) else kind, key, format_value(kind, value)))
+    if out is not sys.stdout:
+        out.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""CSVのキーフレームからEJ_ServoClipのクリップ (EJKF形式) を作成する
+
+usage: servoclip_encode.py keyframes.csv -o clip.bin [--interval 20] [--quantum Q] [--c-array NAME]
+       servoclip_encode.py --decode clip.bin
+CSVの1行目は "time" とサーボの識別番号、2行目以降は時刻 (ms) と各サーボの角度 (度, 小数可)
+時刻は等間隔でなくてよく、--interval [ms] ごとに線形補間したキーフレームにする
+差分は量子化幅の整数倍 (int8) で表すため、量子化誤差は次のキーフレームに繰り越して累積させない
+--quantumを省略すると、全ての差分が収まる最小の量子化幅 (単位: 0.01度) を選ぶ
+--c-arrayを指定すると、EJ_ServoClip::open()に渡せるCの配列として出力する
+"""
+import argparse
+import csv
+import struct
+import sys
+
+MAGIC = b"EJKF"
+VERSION = 1
+MAX_CHANNELS = 16
+MAX_ANGLE = 18000
+
+
+def read_keyframes(path):
+    """(サーボの識別番号のリスト, [(時刻, [角度 (0.01度), ...]), ...]) を返す"""
+    with open(path, newline="", encoding="utf-8") as f:
+        rows = [row for row in csv.reader(f) if row and not row[0].startswith("#")]
+    if len(rows) < 2:
+        raise ValueError("keyframes are empty")
+    ids = [int(value) for value in rows[0][1:]]
+    if not 1 <= len(ids) <= MAX_CHANNELS:
+        raise ValueError("number of servos must be 1..%d" % MAX_CHANNELS)
+    frames = []
+    for row in rows[1:]:
+        time = float(row[0])
+        angles = [round(float(value) * 100) for value in row[1:]]
+        if len(angles) != len(ids):
+            raise ValueError("row at %gms has %d angles, expected %d" % (time, len(angles), len(ids)))
+        if any(not 0 <= angle <= MAX_ANGLE for angle in angles):
+            raise ValueError("angle out of 0..180 at %gms" % time)
+        if frames and time <= frames[-1][0]:
+            raise ValueError("time must increase (%gms)" % time)
+        frames.append((time, angles))
+    return ids, frames
+
+
+def resample(frames, interval):
+    """intervalごとに線形補間したキーフレームの角度のリストを返す"""
+    start, end = frames[0][0], frames[-1][0]
+    count = int(round((end - start) / interval)) + 1
+    result = []
+    segment = 0
+    for index in range(count):
+        time = min(start + index * interval, end)
+        while segment + 1 < len(frames) - 1 and frames[segment + 1][0] <= time:
+            segment += 1
+        (t0, a0), (t1, a1) = frames[segment], frames[min(segment + 1, len(frames) - 1)]
+        ratio = 0.0 if t1 == t0 else (time - t0) / (t1 - t0)
+        result.append([round(x + (y - x) * ratio) for x, y in zip(a0, a1)])
+    return result
+
+
+def quantize(frames, quantum):
+    """差分を量子化し、(差分のリスト, 最大の復元誤差) を返す。int8に収まらなければNoneを返す"""
+    restored = list(frames[0])
+    deltas = []
+    error = 0
+    for angles in frames[1:]:
+        row = []
+        for channel, angle in enumerate(angles):
+            step = int(round((angle - restored[channel]) / quantum))
+            # 端の角度で丸めた結果が0~180度からはみ出さないようにする
+            if restored[channel] + step * quantum > MAX_ANGLE:
+                step -= 1
+            elif restored[channel] + step * quantum < 0:
+                step += 1
+            if not -128 <= step <= 127:
+                return None
+            restored[channel] += step * quantum
+            error = max(error, abs(angle - restored[channel]))
+            row.append(step)
+        deltas.append(row)
+    return deltas, error
+
+
+def encode(ids, frames, interval, quantum):
+    header = MAGIC + struct.pack("<BBBBHH", VERSION, len(ids), quantum, 0, interval, len(frames))
+    body = bytes(ids) + b"".join(struct.pack("<h", angle) for angle in frames[0])
+    deltas, _ = quantize(frames, quantum)
+    body += b"".join(struct.pack("<%db" % len(row), *row) for row in deltas)
+    return header + body
+
+
+def decode(data):
+    """(サーボの識別番号のリスト, キーフレーム間隔, 量子化幅, キーフレームの角度のリスト) を返す"""
+    if data[:4] != MAGIC or data[4] != VERSION:
+        raise ValueError("not an EJKF clip")
+    count, quantum, _, interval, frame_count = struct.unpack_from("<BBBHH", data, 5)
+    offset = 12
+    ids = list(data[offset:offset + count])
+    offset += count
+    angles = list(struct.unpack_from("<%dh" % count, data, offset))
+    offset += count * 2
+    frames = [list(angles)]
+    for _ in range(frame_count - 1):
+        steps = struct.unpack_from("<%db" % count, data, offset)
+        offset += count
+        angles = [angle + step * quantum for angle, step in zip(angles, steps)]
+        frames.append(angles)
+    return ids, interval, quantum, frames
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input")
+    parser.add_argument("-o", "--output", help="出力先 (省略時は標準出力)")
+    parser.add_argument("--interval", type=int, default=20, help="キーフレーム間隔 (ms, default: 20)")
+    parser.add_argument("--quantum", type=int, help="量子化幅 (0.01度, 1~255)")
+    parser.add_argument("--c-array", metavar="NAME", help="Cの配列として出力する")
+    parser.add_argument("--decode", action="store_true", help="クリップをCSVに戻して表示する")
+    args = parser.parse_args()
+
+    if args.decode:
+        with open(args.input, "rb") as f:
+            ids, interval, quantum, frames = decode(f.read())
+        print("# interval=%dms quantum=%d frames=%d" % (interval, quantum, len(frames)))
+        print(",".join(["time"] + [str(i) for i in ids]))
+        for index, angles in enumerate(frames):
+            print(",".join([str(index * interval)] + ["%.2f" % (angle / 100) for angle in angles]))
+        return 0
+
+    if not 1 <= args.interval <= 65535:
+        parser.error("--interval must be 1..65535")
+    ids, keyframes = read_keyframes(args.input)
+    frames = resample(keyframes, args.interval)
+    if len(frames) > 65535:
+        parser.error("too many keyframes (%d), use a longer --interval" % len(frames))
+    candidates = [args.quantum] if args.quantum else range(1, 256)
+    for quantum in candidates:
+        if not 1 <= quantum <= 255:
+            parser.error("--quantum must be 1..255")
+        result = quantize(frames, quantum)
+        if result is not None:
+            break
+    else:
+        parser.error("deltas do not fit in int8, use a larger --quantum or a shorter --interval")
+    data = encode(ids, frames, args.interval, quantum)
+    sys.stderr.write("servos=%d frames=%d interval=%dms quantum=%d max_error=%.2fdeg bytes=%d\n"
+                     % (len(ids), len(frames), args.interval, quantum, result[1] / 100, len(data)))
+
+    if args.c_array:
+        lines = ["/* servoclip_encode.py %s */" % args.input,
+                 "const uint8_t %s[] = {" % args.c_array]
+        for offset in range(0, len(data), 16):
+            lines.append("    " + ", ".join("0x%02X" % byte for byte in data[offset:offset + 16]) + ",")
+        lines.append("};")
+        text = "\n".join(lines) + "\n"
+        if args.output:
+            with open(args.output, "w", encoding="utf-8") as f:
+                f.write(text)
+        else:
+            sys.stdout.write(text)
+    elif args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+    else:
+        sys.stdout.buffer.write(data)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
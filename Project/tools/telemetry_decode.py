@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""EJ_Telemetryのフレームを受信・復号し、CSVまたはチャンネルごとのバイナリ (列形式) に書き出す
+
+usage: telemetry_decode.py PORT [--baud 921600] [-o out.csv] [--format csv|columns] [--count N] [--timeout 2]
+       telemetry_decode.py --exec ".pio/build/native_telemetry/program" -o out.csv
+PORTはシリアルポート、擬似端末、記録したファイル ("-": 標準入力)
+--execは擬似端末を作ってホスト向けビルドのスケッチを起動し (環境変数EJ_SERIAL)、その出力を復号する
+欠番のブロック (送信が追いつかずに捨てたもの) とCRCエラーは標準エラー出力に報告する
+"""
+import argparse
+import json
+import os
+import struct
+import sys
+
+from ejframing import Port, check_crc, cobs_encode, with_crc
+
+FRAME_SCHEMA = 0x53
+FRAME_DATA = 0x44
+# EJ_TelemetryTypeの順 (名前, structの書式, numpyのdtype)
+TYPES = [("int8", "b", "<i1"), ("uint8", "B", "<u1"), ("int16", "h", "<i2"), ("uint16", "H", "<u2"),
+         ("int32", "i", "<i4"), ("uint32", "I", "<u4"), ("float32", "f", "<f4")]
+TIME = ("uint64", "Q", "<u8")
+
+
+class Schema:
+    def __init__(self, payload):
+        _, self.version, self.id, self.record_size, count = struct.unpack_from("<BBHHB", payload)
+        self.channels = []
+        offset = 7
+        for _ in range(count):
+            kind, length = payload[offset], payload[offset + 1]
+            name = payload[offset + 2:offset + 2 + length].decode("ascii", "replace")
+            self.channels.append((name, TYPES[kind]))
+            offset += 2 + length
+        self.format = "<I" + "".join(kind[1] for _, kind in self.channels)
+        if struct.calcsize(self.format) != self.record_size:
+            raise ValueError("record size mismatch")
+        self.names = [name for name, _ in self.channels]
+
+
+class CsvWriter:
+    def __init__(self, path):
+        self.out = open(path, "w", encoding="utf-8") if path not in (None, "-") else sys.stdout
+        self.schema = None
+
+    def write(self, schema, time, values):
+        if schema is not self.schema:
+            self.out.write(",".join(["time_us"] + schema.names) + "\n")
+            self.schema = schema
+        self.out.write("%d,%s\n" % (time, ",".join(repr(v) if isinstance(v, float) else str(v) for v in values)))
+
+    def close(self):
+        if self.out is not sys.stdout:
+            self.out.close()
+
+
+class ColumnWriter:
+    """チャンネルごとにリトルエンディアンの配列をファイルに書き出す (numpy.fromfile(path, dtype)で読める)"""
+
+    def __init__(self, path):
+        self.root = path or "telemetry"
+        self.schema = None
+        self.files = []
+        self.segment = 0
+
+    def open_segment(self, schema):
+        self.close()
+        directory = os.path.join(self.root, "%02d_%04x" % (self.segment, schema.id))
+        self.segment += 1
+        os.makedirs(directory, exist_ok=True)
+        columns = [("time_us", TIME)] + schema.channels
+        with open(os.path.join(directory, "schema.json"), "w", encoding="utf-8") as f:
+            json.dump({"columns": [{"name": n, "type": t[0], "dtype": t[2]} for n, t in columns]}, f, indent=1)
+        self.files = [(open(os.path.join(directory, "%s.bin" % n), "wb"), "<" + t[1]) for n, t in columns]
+        self.schema = schema
+
+    def write(self, schema, time, values):
+        if schema is not self.schema:
+            self.open_segment(schema)
+        for (f, fmt), value in zip(self.files, [time] + list(values)):
+            f.write(struct.pack(fmt, value))
+
+    def close(self):
+        for f, _ in self.files:
+            f.close()
+        self.files = []
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port", nargs="?")
+    parser.add_argument("--baud", type=int, help="シリアルポートの通信速度")
+    parser.add_argument("--exec", dest="command", help="擬似端末につないで起動するホスト向けのスケッチ")
+    parser.add_argument("-o", "--output", help="出力先 (csv: ファイル、省略時は標準出力 / columns: ディレクトリ)")
+    parser.add_argument("--format", default="csv", choices=["csv", "columns"])
+    parser.add_argument("--count", type=int, help="このレコード数を受信したら終了する")
+    parser.add_argument("--timeout", type=float, help="この秒数受信がなければ終了する")
+    parser.add_argument("--raw", help="受信したフレームをそのまま保存する (あとでPORTに指定して復号し直せる)")
+    args = parser.parse_args()
+    if (args.port is None) == (args.command is None):
+        parser.error("PORTか--execのどちらかを指定する")
+
+    port = Port(args.port, args.baud, args.command)
+    writer = CsvWriter(args.output) if args.format == "csv" else ColumnWriter(args.output)
+    raw = open(args.raw, "wb") if args.raw else None
+    schemas = {}
+    records = frames = errors = dropped = unknown = 0
+    expected = None
+    base = 0
+    previous = None
+    try:
+        for payload in port.frames(args.timeout):
+            body = check_crc(payload)
+            if body is None:
+                errors += 1
+                continue
+            frames += 1
+            if raw is not None:
+                raw.write(cobs_encode(with_crc(body)))
+            if body[0] == FRAME_SCHEMA:
+                schema = Schema(body)
+                schemas.setdefault(schema.id, schema)
+                continue
+            if body[0] != FRAME_DATA or len(body) < 6:
+                continue
+            schema_id, sequence, count = struct.unpack_from("<HHB", body, 1)
+            schema = schemas.get(schema_id)
+            if schema is None:
+                unknown += 1  # スキーマを受信する前のブロック (途中から受信した場合)
+                continue
+            if expected is not None and sequence != expected:
+                dropped += (sequence - expected) & 0xFFFF
+            expected = (sequence + 1) & 0xFFFF
+            for record in struct.iter_unpack(schema.format, body[6:6 + count * schema.record_size]):
+                # micros()は約71分で一巡するため64bitに伸ばす
+                if previous is not None and record[0] < previous:
+                    base += 1 << 32
+                previous = record[0]
+                writer.write(schema, base + record[0], record[1:])
+                records += 1
+            if args.count is not None and records >= args.count:
+                break
+    except KeyboardInterrupt:
+        pass
+    finally:
+        writer.close()
+        if raw is not None:
+            raw.close()
+        port.close()
+    print("records=%d frames=%d crc_errors=%d dropped_blocks=%d before_schema=%d"
+          % (records, frames, errors, dropped, unknown), file=sys.stderr)
+    return 0 if errors == 0 and dropped == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""command.pyをホスト向けのスケッチ (env:native_command) に擬似端末でつなぎ、コマンドの往復を検証する
+
+usage: pio run -e native_command && python3 -m unittest discover -s tools -p "test_*.py"   (Projectディレクトリで実行する)
+環境変数EJ_COMMAND_PROGRAMでスケッチのパスを変更できる
+"""
+import os
+import subprocess
+import sys
+import unittest
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from command import Client, parse_command  # noqa: E402
+from ejframing import Port  # noqa: E402
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+PROGRAM = os.environ.get("EJ_COMMAND_PROGRAM",
+                         os.path.join(TOOLS, "..", ".pio", "build", "native_command", "program"))
+
+
+@unittest.skipUnless(os.path.exists(PROGRAM), "pio run -e native_command でスケッチをビルドする")
+class CommandTest(unittest.TestCase):
+    def run_tool(self, *commands):
+        return subprocess.run([sys.executable, os.path.join(TOOLS, "command.py"), "--exec", PROGRAM] + list(commands),
+                              capture_output=True, text=True, timeout=30)
+
+    def test_batch_is_acked_with_states(self):
+        result = self.run_tool("encodermotor 0 position 1234", "dcmotor 0 pwm 50", "servo 0 angle 9000", "photo 0 query")
+        self.assertEqual(result.returncode, 0, result.stderr)
+        self.assertEqual(result.stdout.splitlines(), [
+            "status=ok",
+            "encodermotor 0: 1234 0",
+            "dcmotor 0: 50 0",
+            "servo 0: 9000 9000",
+            "photo 0: 0 0",
+        ])
+
+    def test_invalid_batch_is_not_applied(self):
+        port = Port(command=PROGRAM)
+        try:
+            client = Client(port)
+            status, index, states = client.send([parse_command("dcmotor 0 pwm 30"), parse_command("dcmotor 0 pwm 500")], 5.0)
+            self.assertEqual((status, index, states), (4, 1, []))
+            # 1つ目のコマンドも適用されていない
+            status, index, states = client.send([parse_command("dcmotor 0 query")], 5.0)
+            self.assertEqual((status, index, states), (0, 0xFF, [(0, 0, 0, 0)]))
+        finally:
+            port.close()
+
+    def test_unknown_device_is_rejected(self):
+        result = self.run_tool("servo 3 angle 9000")
+        self.assertEqual(result.returncode, 1)
+        self.assertEqual(result.stdout.splitlines(), ["status=invalid device command=0 (servo 3 angle 9000)"])
+
+
+if __name__ == "__main__":
+    unittest.main()
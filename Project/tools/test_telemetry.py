@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""telemetry_decode.pyをホスト向けのスケッチ (env:native_telemetry) に擬似端末でつなぎ、スキーマとデータのフレームの復号を検証する
+
+usage: pio run -e native_telemetry && python3 -m unittest discover -s tools -p "test_*.py"   (Projectディレクトリで実行する)
+環境変数EJ_TELEMETRY_PROGRAMでスケッチのパスを変更できる
+"""
+import csv
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+PROGRAM = os.environ.get("EJ_TELEMETRY_PROGRAM",
+                         os.path.join(TOOLS, "..", ".pio", "build", "native_telemetry", "program"))
+
+# スケッチが送信するレコード (1msごとに1秒間、0.5秒でDuty比を60から0にする)
+RECORDS = 1000
+PERIOD_US = 1000
+STEP_END_US = 500000
+
+
+@unittest.skipUnless(os.path.exists(PROGRAM), "pio run -e native_telemetry でスケッチをビルドする")
+class TelemetryTest(unittest.TestCase):
+    def run_tool(self, *options):
+        return subprocess.run([sys.executable, os.path.join(TOOLS, "telemetry_decode.py"), "--exec", PROGRAM] + list(options),
+                              capture_output=True, text=True, timeout=60)
+
+    def test_frames_are_decoded_to_csv(self):
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "log.csv")
+            result = self.run_tool("-o", path)
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertIn("records=%d " % RECORDS, result.stderr)
+            self.assertIn("crc_errors=0 dropped_blocks=0 before_schema=0", result.stderr)
+            with open(path, encoding="utf-8") as f:
+                rows = list(csv.reader(f))
+        self.assertEqual(rows[0], ["time_us", "duty", "position"])
+        rows = [[int(value) for value in row] for row in rows[1:]]
+        self.assertEqual(len(rows), RECORDS)
+        # 仮想時刻で動くため、タイムスタンプは1msずつ正確に進む
+        self.assertEqual([row[0] for row in rows], [i * PERIOD_US for i in range(RECORDS)])
+        self.assertEqual([row[1] for row in rows], [60 if i * PERIOD_US < STEP_END_US else 0 for i in range(RECORDS)])
+        positions = [row[2] for row in rows]
+        self.assertEqual(positions, sorted(positions))
+        self.assertGreater(positions[STEP_END_US // PERIOD_US], 0)
+
+    def test_frames_are_decoded_to_columns(self):
+        with tempfile.TemporaryDirectory() as directory:
+            result = self.run_tool("--format", "columns", "-o", directory)
+            self.assertEqual(result.returncode, 0, result.stderr)
+            segments = os.listdir(directory)
+            self.assertEqual(len(segments), 1)
+            segment = os.path.join(directory, segments[0])
+            with open(os.path.join(segment, "schema.json"), encoding="utf-8") as f:
+                columns = json.load(f)["columns"]
+            self.assertEqual([(c["name"], c["type"]) for c in columns],
+                             [("time_us", "uint64"), ("duty", "int16"), ("position", "int32")])
+            for name, size in (("time_us", 8), ("duty", 2), ("position", 4)):
+                self.assertEqual(os.path.getsize(os.path.join(segment, name + ".bin")), RECORDS * size)
+
+
+if __name__ == "__main__":
+    unittest.main()